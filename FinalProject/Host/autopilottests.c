@@ -0,0 +1,149 @@
+#include <string.h>
+#include "ctest.h"
+#include "Autopilot.h"
+#include "FlowField.h"
+
+static Autopilot_t pilot;
+static GameState_t game;
+
+/**
+  * @brief True if the drone can move straight between two neighbouring cells
+  */
+static bool can_move(const MapData_t *map, uint16_t from, uint16_t to)
+{
+    uint8_t cell_count = map->cell_count;
+    uint8_t row = from / cell_count, col = from % cell_count;
+    uint8_t walls = map->cell_data[row][col];
+
+    if(map->cell_data[to / cell_count][to % cell_count] & MAP_HOLE)
+        return false;
+
+    if(to == from - cell_count)
+        return !(walls & MAP_TOP_WALL) && !(map->cell_data[row - 1][col] & MAP_BOTTOM_WALL);
+    if(to == from + cell_count)
+        return !(walls & MAP_BOTTOM_WALL) && !(map->cell_data[row + 1][col] & MAP_TOP_WALL);
+    if(to == from - 1 && col > 0)
+        return !(walls & MAP_LEFT_WALL) && !(map->cell_data[row][col - 1] & MAP_RIGHT_WALL);
+    if(to == from + 1 && col < cell_count - 1)
+        return !(walls & MAP_RIGHT_WALL) && !(map->cell_data[row][col + 1] & MAP_LEFT_WALL);
+
+    return false;
+}
+
+CTEST(autopilot, test_paths_are_shortest_and_legal) {
+    static MapData_t map;
+    static FlowField_t field;
+    MapConfig_t map_config = {.cell_count = 8, .wall_probability = 300, .hole_probability = 100, .num_waypoints = 4,
+                              .hole_radius = 10, .waypoint_radius = 15};
+    uint32_t state = 7;
+    int compared = 0;
+
+    for(int i = 0; i < 50; i ++)
+    {
+        ASSERT_TRUE(MAP_create(&map, &map_config, MAP_xorshift_random, &state));
+
+        const WaypointData_t *start = &map.waypoint_data[0];
+        const WaypointData_t *goal = &map.waypoint_data[1];
+        uint16_t start_cell = (MAP_CELL_ROW(start->y) * 8) + MAP_CELL_COL(start->x);
+        uint16_t goal_cell = (MAP_CELL_ROW(goal->y) * 8) + MAP_CELL_COL(goal->x);
+
+        FLOW_FIELD_compute(&field, &map, MAP_CELL_ROW(goal->y), MAP_CELL_COL(goal->x));
+        uint8_t flow = FLOW_FIELD_get_cell(&field, start->x, start->y);
+
+        pilot.cell_count = 8;
+        pilot.route_length = 0;
+
+        if(FLOW_FIELD_DIRECTION(flow) == FLOW_NONE)
+        {
+            ASSERT_FALSE(AUTOPILOT_find_path(&pilot, &map, start_cell, goal_cell));
+            continue;
+        }
+
+        ASSERT_TRUE(AUTOPILOT_find_path(&pilot, &map, start_cell, goal_cell));
+        ASSERT_EQUAL(goal_cell, pilot.route[pilot.route_length - 1]);
+
+        // Same length as the breadth first search
+        if(FLOW_FIELD_DISTANCE(flow) < FLOW_FIELD_MAX_DISTANCE)
+        {
+            ASSERT_EQUAL(FLOW_FIELD_DISTANCE(flow), pilot.route_length);
+            compared ++;
+        }
+
+        uint16_t previous = start_cell;
+
+        for(uint32_t step = 0; step < pilot.route_length; step ++)
+        {
+            ASSERT_TRUE(can_move(&map, previous, pilot.route[step]));
+            previous = pilot.route[step];
+        }
+    }
+
+    ASSERT_TRUE(compared > 25);
+}
+
+CTEST(autopilot, test_plan_keeps_turning_points) {
+    memset(&game.map, 0, sizeof(game.map));
+    game.map.cell_count = 6;
+    game.map.num_waypoints = 2;
+    game.map.waypoint_data[0] = (WaypointData_t){.x = MAP_CELL_CENTER_X(0), .y = MAP_CELL_CENTER_Y(0), .number = 0};
+    game.map.waypoint_data[1] = (WaypointData_t){.x = MAP_CELL_CENTER_X(0), .y = MAP_CELL_CENTER_Y(5), .number = 1};
+
+    // Wall under the top row except at its right end
+    for(int col = 0; col < 5; col ++)
+        game.map.cell_data[0][col] |= MAP_BOTTOM_WALL;
+
+    ASSERT_TRUE(AUTOPILOT_plan(&pilot, &game.map, MAP_CELL_CENTER_X(0), MAP_CELL_CENTER_Y(0), 0));
+
+    // Along row 0 to column 5 first, ending in (5, 0)
+    ASSERT_EQUAL(0, pilot.route[0]);
+    ASSERT_EQUAL(5, pilot.route[1]);
+    ASSERT_EQUAL(30, pilot.route[pilot.route_length - 1]);
+
+    for(uint32_t i = 1; i + 1 < pilot.route_length; i ++)
+    {
+        int32_t in = pilot.route[i] - pilot.route[i - 1];
+        int32_t out = pilot.route[i + 1] - pilot.route[i];
+
+        ASSERT_TRUE(in != out);
+    }
+
+    // A waypoint sealed off by walls can't be planned to
+    game.map.cell_data[5][0] |= MAP_TOP_WALL | MAP_RIGHT_WALL;
+    ASSERT_FALSE(AUTOPILOT_plan(&pilot, &game.map, MAP_CELL_CENTER_X(0), MAP_CELL_CENTER_Y(0), 0));
+}
+
+CTEST(autopilot, test_flies_generated_maps) {
+    uint32_t state = 3;
+    int won = 0, planned = 0;
+
+    GAME_default_config(&config);
+    GAME_init(&game, &config);
+
+    for(int i = 0; i < 20; i ++)
+    {
+        ASSERT_TRUE(MAP_create(&game.map, &config.map_config, MAP_xorshift_random, &state));
+        ASSERT_TRUE(GAME_start(&game));
+
+        if(!AUTOPILOT_plan(&pilot, &game.map, game.map.waypoint_data[0].x, game.map.waypoint_data[0].y, 0))
+            continue;
+
+        planned ++;
+
+        while(!game.won && !game.lost)
+        {
+            q16_t angle_x, angle_y;
+
+            AUTOPILOT_steer(&pilot, &game, &angle_x, &angle_y);
+            GAME_advance_clock(&game, config.physics_config.update_period);
+            GAME_step(&game, angle_x, angle_y);
+        }
+
+        // The route never crosses a hole and the tilt stays in range
+        ASSERT_FALSE(game.fell_into_hole);
+        ASSERT_FALSE(game.exceeded_tilt);
+        won += game.won;
+    }
+
+    ASSERT_TRUE(planned > 10);
+    ASSERT_EQUAL(planned, won);
+}
@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <string.h>
+#include "ctest.h"
+#include "CollisionMask.h"
+
+static uint32_t test_random(void *context, uint32_t max)
+{
+    (void) context;
+
+    return rand() % max;
+}
+
+/**
+  * @brief Pixel by pixel reference - true if a playfield pixel is on a wall or in a hole
+  */
+static bool reference_pixel(const MapData_t *map, int32_t x, int32_t y, int32_t hole_radius)
+{
+    for(int32_t i = 0; i < map->cell_count; i ++)
+    {
+        for(int32_t j = 0; j < map->cell_count; j ++)
+        {
+            uint8_t cell = map->cell_data[i][j];
+            int32_t left = j * MAP_CELL_SIZE, top = i * MAP_CELL_SIZE;
+            int32_t right = left + MAP_CELL_SIZE, bottom = top + MAP_CELL_SIZE;
+            bool on_row = x >= left && x <= right;
+            bool on_column = y >= top && y <= bottom;
+
+            if(((cell & MAP_TOP_WALL) && y == top && on_row) || ((cell & MAP_BOTTOM_WALL) && y == bottom && on_row) ||
+               ((cell & MAP_LEFT_WALL) && x == left && on_column) || ((cell & MAP_RIGHT_WALL) && x == right && on_column))
+                return true;
+
+            int32_t dx = x - (left + MAP_CELL_SIZE / 2), dy = y - (top + MAP_CELL_SIZE / 2);
+            if((cell & MAP_HOLE) && dx * dx + dy * dy <= hole_radius * hole_radius)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+static bool reference_disk(const MapData_t *map, int32_t x, int32_t y, int32_t radius, int32_t hole_radius)
+{
+    for(int32_t py = y - radius; py <= y + radius; py ++)
+    {
+        for(int32_t px = x - radius; px <= x + radius; px ++)
+        {
+            if(px < 0 || py < 0 || px >= COLLISION_MASK_WIDTH || py >= COLLISION_MASK_HEIGHT)
+                continue;
+
+            if((px - x) * (px - x) + (py - y) * (py - y) <= radius * radius && reference_pixel(map, px, py, hole_radius))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+CTEST(collision_mask, test_empty_map_is_clear) {
+    static MapData_t map;
+    static CollisionMask_t mask;
+    CollisionDisk_t disk;
+
+    map.cell_count = 6;
+    COLLISION_MASK_bake(&mask, &map, 10);
+    COLLISION_MASK_make_disk(&disk, COLLISION_MASK_MAX_RADIUS);
+
+    for(int32_t y = MAP_ORIGIN_Y; y < MAP_ORIGIN_Y + COLLISION_MASK_HEIGHT; y += 7)
+    {
+        for(int32_t x = MAP_ORIGIN_X; x < MAP_ORIGIN_X + COLLISION_MASK_WIDTH; x += 7)
+            ASSERT_FALSE(COLLISION_MASK_test_disk(&mask, &disk, x, y));
+    }
+}
+
+CTEST(collision_mask, test_disk_touching_wall) {
+    static MapData_t map;
+    static CollisionMask_t mask;
+    CollisionDisk_t disk;
+
+    // Right wall of cell (0, 0) is the column x = 40
+    map.cell_count = 6;
+    map.cell_data[0][0] = MAP_RIGHT_WALL;
+    COLLISION_MASK_bake(&mask, &map, 10);
+    COLLISION_MASK_make_disk(&disk, 5);
+
+    ASSERT_TRUE(COLLISION_MASK_test_disk(&mask, &disk, 35, MAP_ORIGIN_Y + 20));
+    ASSERT_FALSE(COLLISION_MASK_test_disk(&mask, &disk, 34, MAP_ORIGIN_Y + 20));
+    ASSERT_TRUE(COLLISION_MASK_test_disk(&mask, &disk, 45, MAP_ORIGIN_Y + 20));
+    ASSERT_FALSE(COLLISION_MASK_test_disk(&mask, &disk, 46, MAP_ORIGIN_Y + 20));
+}
+
+CTEST(collision_mask, test_matches_pixel_reference) {
+    static MapData_t map;
+    static CollisionMask_t mask;
+    MapConfig_t map_config = {.cell_count = 6, .wall_probability = 300, .hole_probability = 200, .num_waypoints = 4};
+
+    srand(3753);
+
+    for(int m = 0; m < 20; m ++)
+    {
+        MAP_create(&map, &map_config, test_random, NULL);
+
+        // Top and left walls are never generated - add some to cover them too
+        map.cell_data[rand() % 6][rand() % 6] |= MAP_TOP_WALL | MAP_LEFT_WALL;
+
+        COLLISION_MASK_bake(&mask, &map, 10);
+
+        for(int i = 0; i < 500; i ++)
+        {
+            CollisionDisk_t disk;
+            int32_t x = (rand() % 280) - 20, y = (rand() % 280) - 20;
+
+            COLLISION_MASK_make_disk(&disk, rand() % (COLLISION_MASK_MAX_RADIUS + 1));
+
+            ASSERT_EQUAL(reference_disk(&map, x, y, disk.radius, 10),
+                         COLLISION_MASK_test_disk(&mask, &disk, MAP_ORIGIN_X + x, MAP_ORIGIN_Y + y));
+        }
+    }
+}
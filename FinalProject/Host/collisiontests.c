@@ -0,0 +1,204 @@
+#include <stdlib.h>
+#include <math.h>
+#include "ctest.h"
+#include "Collision.h"
+
+#define TO_Q16(value) ((q16_t)lround((value) * 65536.0))
+#define TO_DOUBLE(value) ((value) / 65536.0)
+
+// A contact time can be off by this many pixels of travel
+#define DISTANCE_TOLERANCE 0.05
+
+/**
+  * @brief Double precision reference for a circle swept against a segment
+  */
+static bool reference_sweep(double x, double y, double dx, double dy, double radius,
+                            double x1, double y1, double x2, double y2, double *time)
+{
+    double best = 2;
+    double ex = x2 - x1, ey = y2 - y1;
+    double length = sqrt(ex * ex + ey * ey);
+    double ux = ex / length, uy = ey / length;
+    double distance = (x - x1) * -uy + (y - y1) * ux;
+    double speed = dx * -uy + dy * ux;
+
+    if(distance < 0)
+    {
+        distance = -distance;
+        speed = -speed;
+    }
+
+    // Face
+    if(speed < 0)
+    {
+        double t = distance > radius ? (distance - radius) / -speed : 0;
+        double along = (x + dx * t - x1) * ux + (y + dy * t - y1) * uy;
+
+        if(t <= 1 && along >= 0 && along <= length)
+            best = t;
+    }
+
+    // End points
+    double points[2][2] = {{x1, y1}, {x2, y2}};
+    for(int i = 0; i < 2; i ++)
+    {
+        double qx = x - points[i][0], qy = y - points[i][1];
+        double a = dx * dx + dy * dy;
+        double b = qx * dx + qy * dy;
+        double c = qx * qx + qy * qy - radius * radius;
+
+        if(b >= 0)
+            continue;
+
+        double t = 0;
+        if(c > 0)
+        {
+            double discriminant = b * b - a * c;
+            if(discriminant < 0)
+                continue;
+
+            t = (-b - sqrt(discriminant)) / a;
+        }
+
+        if(t <= 1 && t < best)
+            best = t;
+    }
+
+    *time = best;
+    return best <= 1;
+}
+
+/**
+  * @brief Closest distance between the circle center's path and a segment - used to skip grazing cases
+  */
+static double path_clearance(double x, double y, double dx, double dy, double x1, double y1, double x2, double y2)
+{
+    double closest = INFINITY;
+
+    for(int i = 0; i <= 1000; i ++)
+    {
+        double px = x + dx * i / 1000.0, py = y + dy * i / 1000.0;
+        double ex = x2 - x1, ey = y2 - y1;
+        double t = ((px - x1) * ex + (py - y1) * ey) / (ex * ex + ey * ey);
+
+        t = t < 0 ? 0 : (t > 1 ? 1 : t);
+
+        double distance = hypot(px - (x1 + t * ex), py - (y1 + t * ey));
+        if(distance < closest)
+            closest = distance;
+    }
+
+    return closest;
+}
+
+static bool sweep(double x, double y, double dx, double dy, double radius,
+                  double x1, double y1, double x2, double y2, CollisionHit_t *hit)
+{
+    CollisionSegment_t segment = {TO_Q16(x1), TO_Q16(y1), TO_Q16(x2), TO_Q16(y2)};
+
+    return COLLISION_sweep_circle_segment(TO_Q16(x), TO_Q16(y), TO_Q16(dx), TO_Q16(dy), TO_Q16(radius), &segment, hit);
+}
+
+CTEST(collision, test_head_on_face_hit) {
+    CollisionHit_t hit;
+
+    // Wall at x = 30, circle of radius 5 moving right from x = 10 touches it after 15 of 20 pixels
+    ASSERT_TRUE(sweep(10, 20, 20, 0, 5, 30, 0, 30, 40, &hit));
+    ASSERT_DBL_NEAR_TOL(0.75, TO_DOUBLE(hit.time), 1e-3);
+    ASSERT_DBL_NEAR_TOL(-1.0, TO_DOUBLE(hit.normal_x), 1e-3);
+    ASSERT_DBL_NEAR_TOL(0.0, TO_DOUBLE(hit.normal_y), 1e-3);
+}
+
+CTEST(collision, test_stops_short_of_wall) {
+    CollisionHit_t hit;
+
+    ASSERT_FALSE(sweep(10, 20, 14, 0, 5, 30, 0, 30, 40, &hit));
+}
+
+CTEST(collision, test_parallel_move_misses) {
+    CollisionHit_t hit;
+
+    ASSERT_FALSE(sweep(10, 20, 0, 100, 5, 30, 0, 30, 40, &hit));
+}
+
+CTEST(collision, test_touching_wall_can_slide_and_leave) {
+    CollisionHit_t hit;
+
+    // Touching the wall, sliding along it and moving away are free
+    ASSERT_FALSE(sweep(25, 20, 0, 10, 5, 30, 0, 30, 40, &hit));
+    ASSERT_FALSE(sweep(25, 20, -10, 0, 5, 30, 0, 30, 40, &hit));
+
+    // Pushing into it is a hit right away
+    ASSERT_TRUE(sweep(25, 20, 3, 0, 5, 30, 0, 30, 40, &hit));
+    ASSERT_EQUAL(0, hit.time);
+}
+
+CTEST(collision, test_end_point_hit) {
+    CollisionHit_t hit;
+    double time;
+
+    // Passing just below the bottom end of a vertical wall clips its end point
+    ASSERT_TRUE(sweep(10, 43, 40, 0, 5, 30, 0, 30, 40, &hit));
+    ASSERT_TRUE(reference_sweep(10, 43, 40, 0, 5, 30, 0, 30, 40, &time));
+    ASSERT_DBL_NEAR_TOL(time, TO_DOUBLE(hit.time), 1e-3);
+
+    // Normal points from the end point to the circle
+    ASSERT_DBL_NEAR_TOL(-0.8, TO_DOUBLE(hit.normal_x), 1e-3);
+    ASSERT_DBL_NEAR_TOL(0.6, TO_DOUBLE(hit.normal_y), 1e-3);
+}
+
+CTEST(collision, test_no_tunnelling_up_to_five_cells_per_tick) {
+    // Every speed from 1 pixel to 5 cells per tick, with the wall at every point of the move
+    for(int speed = 1; speed <= 5 * MAP_CELL_SIZE; speed ++)
+    {
+        for(int i = 1; i <= 8; i ++)
+        {
+            double gap = speed * i / 8.0;
+            double x = 200 - 5 - gap;
+            CollisionHit_t hit;
+
+            ASSERT_TRUE(sweep(x, 60, speed, 0, 5, 200, 40, 200, 80, &hit));
+            ASSERT_DBL_NEAR_TOL(gap, TO_DOUBLE(hit.time) * speed, DISTANCE_TOLERANCE);
+            ASSERT_DBL_NEAR_TOL(-1.0, TO_DOUBLE(hit.normal_x), 1e-3);
+
+            // Diagonal moves toward a horizontal wall
+            ASSERT_TRUE(sweep(100, 200 - 5 - gap, speed / 2.0, speed, 5, 0, 200, 240, 200, &hit));
+            ASSERT_DBL_NEAR_TOL(gap / speed, TO_DOUBLE(hit.time), DISTANCE_TOLERANCE / speed);
+            ASSERT_DBL_NEAR_TOL(-1.0, TO_DOUBLE(hit.normal_y), 1e-3);
+        }
+    }
+}
+
+CTEST(collision, test_matches_reference) {
+    srand(3753);
+
+    for(int i = 0; i < 20000; i ++)
+    {
+        double x = rand() % 240, y = 40 + rand() % 240;
+        double dx = (rand() % 401) - 200, dy = (rand() % 401) - 200;
+        double radius = 1 + rand() % 20;
+        double x1 = rand() % 240, y1 = 40 + rand() % 240;
+        double x2 = x1 + (rand() % 81) - 40, y2 = y1 + (rand() % 81) - 40;
+        double time;
+        CollisionHit_t hit;
+
+        if(x1 == x2 && y1 == y2)
+            continue;
+
+        bool expected = reference_sweep(x, y, dx, dy, radius, x1, y1, x2, y2, &time);
+
+        // Moves that just graze the segment can go either way
+        if(fabs(path_clearance(x, y, dx, dy, x1, y1, x2, y2) - radius) < DISTANCE_TOLERANCE)
+            continue;
+
+        ASSERT_EQUAL(expected, sweep(x, y, dx, dy, radius, x1, y1, x2, y2, &hit));
+
+        if(expected)
+        {
+            double move = hypot(dx, dy);
+
+            ASSERT_DBL_NEAR_TOL(time * move, TO_DOUBLE(hit.time) * move, DISTANCE_TOLERANCE);
+            ASSERT_DBL_NEAR_TOL(1.0, hypot(TO_DOUBLE(hit.normal_x), TO_DOUBLE(hit.normal_y)), 1e-3);
+        }
+    }
+}
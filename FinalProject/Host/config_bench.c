@@ -0,0 +1,103 @@
+/*
+ * config_bench.c
+ *
+ * Host benchmark for the two ways the game config can be built. The same source is built as config_bench,
+ * reading the config at run time, and as config_bench_static with CONFIG_STATIC_PROFILE, where the profile in
+ * ConfigProfile.h is compiled in. Both play the same maps and must print the same checksum; the times show
+ * what folding the config into the map, collision and flow field loops is worth.
+ *
+ * Usage:
+ *   config_bench [maps]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Game.h"
+#include "FlowField.h"
+
+#define TICKS_PER_MAP 500
+#define FLOW_FIELDS_PER_MAP 50
+
+static uint32_t bench_random(void *context, uint32_t max)
+{
+    uint32_t *state = context;
+
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state % max;
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+int main(int argc, const char *argv[])
+{
+    static GameState_t game;
+    static FlowField_t field;
+    int maps = argc > 1 ? atoi(argv[1]) : 2000;
+    uint32_t state = 1;
+    uint32_t hash = 0;
+    double start_ns = 0, step_ns = 0, flow_ns = 0;
+    long ticks = 0;
+
+#if !CONFIG_STATIC_PROFILE
+    GAME_default_config(&config);
+#endif
+    GAME_init(&game, &config);
+
+    for(int m = 0; m < maps; m ++)
+    {
+        struct timespec start, end;
+
+        if(!MAP_create(&game.map, &config.map_config, bench_random, &state))
+            return 1;
+
+        // Collision mask and wall grid
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if(!GAME_start(&game))
+            return 1;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        start_ns += elapsed_ns(&start, &end);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < FLOW_FIELDS_PER_MAP; i ++)
+        {
+            const WaypointData_t *target = &game.map.waypoint_data[i % game.map.num_waypoints];
+
+            FLOW_FIELD_compute(&field, &game.map, MAP_CELL_ROW(target->y), MAP_CELL_COL(target->x));
+            hash = (hash * 31) + field.cells[0][0];
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        flow_ns += elapsed_ns(&start, &end);
+
+        // Tilt the board round in a circle, a little off flat
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int t = 0; t < TICKS_PER_MAP && !game.won && !game.lost; t ++, ticks ++)
+        {
+            q16_t angle_x = Q16_FROM_INT(180) + ((t % 40) < 20 ? Q16_FROM_INT(4) : -Q16_FROM_INT(4));
+            q16_t angle_y = Q16_FROM_INT(180) + ((t % 60) < 30 ? Q16_FROM_INT(3) : -Q16_FROM_INT(3));
+
+            GAME_recharge_energy(&game);
+            GAME_advance_clock(&game, CONFIG_PHYSICS_UPDATE_PERIOD(&config));
+            GAME_step(&game, angle_x, angle_y);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        step_ns += elapsed_ns(&start, &end);
+
+        hash = (hash * 31) + (uint32_t)game.entities.pos_x[DRONE_ENTITY];
+        hash = (hash * 31) + (uint32_t)game.entities.pos_y[DRONE_ENTITY];
+    }
+
+    printf("%s config, %d maps\n", CONFIG_STATIC_PROFILE ? "static" : "run time", maps);
+    printf("  game start   %.2f us\n", start_ns / maps / 1000);
+    printf("  flow field   %.2f us\n", flow_ns / (maps * FLOW_FIELDS_PER_MAP) / 1000);
+    printf("  physics tick %.1f ns\n", step_ns / ticks);
+    printf("  checksum %08X\n", hash);
+
+    return 0;
+}
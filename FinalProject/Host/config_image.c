@@ -0,0 +1,197 @@
+/*
+ * config_image.c
+ *
+ * Writes a flash image of the ConfigStore's two sectors holding one config record - GAME_default_config with
+ * the fields given on the command line changed. Configs that GAME_validate_config would pass over at boot are
+ * refused. The record is ConfigData_t as laid out in memory, which is the same for the host and the firmware
+ * as long as the struct only holds fixed size integers and bools.
+ *
+ * The image covers both sectors, so flashing it also erases any record saved on the board since:
+ *   st-flash write config.bin 0x081C0000
+ *
+ * Usage:
+ *   config_image [<field>=<value> ...] <config.bin>
+ *   config_image --list
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "Game.h"
+#include "ConfigStore.h"
+
+#define SECTOR_SIZE (128 * 1024) // CONFIG_STORE_SECTOR_SIZE
+
+#define FIELD(group, name) { #group "." #name, offsetof(struct ConfigData_t, group.name), \
+                             sizeof(((struct ConfigData_t *)0)->group.name) }
+
+typedef struct {
+    const char *name;
+    size_t offset;
+    size_t size;
+} Field_t;
+
+static const Field_t fields[] = {
+    FIELD(map_config, cell_count),
+    FIELD(map_config, wall_probability),
+    FIELD(map_config, hole_probability),
+    FIELD(map_config, num_waypoints),
+    FIELD(map_config, hole_radius),
+    FIELD(map_config, waypoint_radius),
+    FIELD(drone_config, disruptor_max_time),
+    FIELD(drone_config, disruptor_power),
+    FIELD(drone_config, disruptor_min_activation_energy),
+    FIELD(drone_config, max_energy),
+    FIELD(drone_config, recharge_rate),
+    FIELD(drone_config, diameter),
+    FIELD(drone_config, max_velocity),
+    FIELD(physics_config, gravity),
+    FIELD(physics_config, update_period),
+    FIELD(physics_config, angle_gain),
+    FIELD(physics_config, pin_at_center),
+    FIELD(game_config, time_to_complete),
+    FIELD(game_config, hard_edged),
+    FIELD(game_config, reuse_waypoints),
+};
+
+#define FIELD_COUNT (sizeof(fields) / sizeof(fields[0]))
+
+static uint32_t image[2][SECTOR_SIZE / 4];
+
+/**
+  * @brief Flash stand-ins for the store - the image starts erased
+  */
+static bool image_erase(void *context, uint8_t sector)
+{
+    (void) context;
+
+    memset(image[sector], 0xFF, SECTOR_SIZE);
+
+    return true;
+}
+
+static bool image_program(void *context, uintptr_t address, uint32_t word)
+{
+    (void) context;
+
+    *(uint32_t *)address &= word;
+
+    return true;
+}
+
+/**
+  * @brief Set one field from "<field>=<value>"
+  * @retval bool - false if the field is unknown or the value doesn't fit it
+  */
+static bool set_field(struct ConfigData_t *config, const char *assignment)
+{
+    const char *equals = strchr(assignment, '=');
+    char *end;
+
+    if(equals == NULL)
+        return false;
+
+    long long value = strtoll(equals + 1, &end, 0);
+
+    if(*end != '\0' || end == equals + 1)
+        return false;
+
+    for(size_t i = 0; i < FIELD_COUNT; i ++)
+    {
+        if(strlen(fields[i].name) != (size_t)(equals - assignment) ||
+           strncmp(fields[i].name, assignment, equals - assignment) != 0)
+            continue;
+
+        uint8_t *dst = (uint8_t *)config + fields[i].offset;
+
+        if(fields[i].size == 1)
+        {
+            if(value < 0 || value > UINT8_MAX)
+                return false;
+
+            *dst = (uint8_t)value;
+        }
+        else
+        {
+            if(value < INT32_MIN || value > UINT32_MAX)
+                return false;
+
+            uint32_t word = (uint32_t)value;
+            memcpy(dst, &word, sizeof(word));
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+int main(int argc, const char *argv[])
+{
+    if(argc == 2 && strcmp(argv[1], "--list") == 0)
+    {
+        for(size_t i = 0; i < FIELD_COUNT; i ++)
+            printf("%s\n", fields[i].name);
+
+        return 0;
+    }
+
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s [<field>=<value> ...] <config.bin>\n       %s --list\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    GAME_default_config(&config);
+
+    for(int i = 1; i < argc - 1; i ++)
+    {
+        if(!set_field(&config, argv[i]))
+        {
+            fprintf(stderr, "bad field or value: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if(!GAME_validate_config(&config))
+    {
+        fprintf(stderr, "the firmware would not play this config - see GAME_validate_config\n");
+        return 1;
+    }
+
+    ConfigStorePort_t port = {
+        .erase = image_erase,
+        .program = image_program,
+        .context = NULL
+    };
+    ConfigStore_t store;
+
+    memset(image, 0xFF, sizeof(image));
+    CONFIG_STORE_init(&store, &port, (const uint8_t *)image[0], (const uint8_t *)image[1], SECTOR_SIZE);
+
+    if(!CONFIG_STORE_save(&store, CONFIG_VERSION, &config, sizeof(config)))
+    {
+        fprintf(stderr, "config doesn't fit a record\n");
+        return 1;
+    }
+
+    FILE *output = fopen(argv[argc - 1], "wb");
+    if(output == NULL)
+    {
+        perror("output");
+        return 1;
+    }
+
+    if(fwrite(image, sizeof(image), 1, output) != 1)
+    {
+        perror("output");
+        fclose(output);
+        return 1;
+    }
+
+    fclose(output);
+    printf("config version %u, %zu byte record, sequence %u\n", CONFIG_VERSION, sizeof(config), store.sequence);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * config_profile_gen.c
+ *
+ * Writes the game configuration from GAME_default_config as compile time constants, for firmware and host
+ * builds with CONFIG_STATIC_PROFILE set.
+ *
+ * Usage:
+ *   config_profile_gen <output.h>
+ */
+
+#include <stdio.h>
+#include "Game.h"
+
+int main(int argc, const char *argv[])
+{
+    if(argc != 2)
+    {
+        fprintf(stderr, "usage: %s <output.h>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *output = fopen(argv[1], "w");
+    if(output == NULL)
+    {
+        perror("output");
+        return 1;
+    }
+
+    GAME_default_config(&config);
+
+    const MapConfig_t *map = &config.map_config;
+    const DroneConfig_t *drone = &config.drone_config;
+    const PhysicsConfig_t *physics = &config.physics_config;
+    const GameConfig_t *game = &config.game_config;
+
+    fprintf(output, "/*\n * ConfigProfile.h\n *\n * Generated by Host/config_profile_gen from GAME_default_config - do not edit.\n */\n\n");
+    fprintf(output, "#ifndef INC_CONFIGPROFILE_H_\n#define INC_CONFIGPROFILE_H_\n\n");
+    fprintf(output, "#define CONFIG_PROFILE_VERSION %u\n\n", config.version);
+
+    // uint8_t fields are written as plain ints, like they promote to when read from the struct
+
+    fprintf(output, "#define CONFIG_PROFILE_MAP_CELL_COUNT %u\n", map->cell_count);
+    fprintf(output, "#define CONFIG_PROFILE_MAP_WALL_PROBABILITY %uu\n", map->wall_probability);
+    fprintf(output, "#define CONFIG_PROFILE_MAP_HOLE_PROBABILITY %uu\n", map->hole_probability);
+    fprintf(output, "#define CONFIG_PROFILE_MAP_NUM_WAYPOINTS %u\n", map->num_waypoints);
+    fprintf(output, "#define CONFIG_PROFILE_MAP_HOLE_RADIUS %u\n", map->hole_radius);
+    fprintf(output, "#define CONFIG_PROFILE_MAP_WAYPOINT_RADIUS %u\n\n", map->waypoint_radius);
+
+    fprintf(output, "#define CONFIG_PROFILE_DRONE_DISRUPTOR_MAX_TIME %uu\n", drone->disruptor_max_time);
+    fprintf(output, "#define CONFIG_PROFILE_DRONE_DISRUPTOR_POWER %uu\n", drone->disruptor_power);
+    fprintf(output, "#define CONFIG_PROFILE_DRONE_DISRUPTOR_MIN_ACTIVATION_ENERGY %uu\n", drone->disruptor_min_activation_energy);
+    fprintf(output, "#define CONFIG_PROFILE_DRONE_MAX_ENERGY %uu\n", drone->max_energy);
+    fprintf(output, "#define CONFIG_PROFILE_DRONE_RECHARGE_RATE %uu\n", drone->recharge_rate);
+    fprintf(output, "#define CONFIG_PROFILE_DRONE_DIAMETER %uu\n", drone->diameter);
+    fprintf(output, "#define CONFIG_PROFILE_DRONE_MAX_VELOCITY %d\n\n", drone->max_velocity);
+
+    fprintf(output, "#define CONFIG_PROFILE_PHYSICS_GRAVITY %uu\n", physics->gravity);
+    fprintf(output, "#define CONFIG_PROFILE_PHYSICS_UPDATE_PERIOD %uu\n", physics->update_period);
+    fprintf(output, "#define CONFIG_PROFILE_PHYSICS_ANGLE_GAIN %uu\n", physics->angle_gain);
+    fprintf(output, "#define CONFIG_PROFILE_PHYSICS_PIN_AT_CENTER %u\n\n", physics->pin_at_center);
+
+    fprintf(output, "#define CONFIG_PROFILE_GAME_TIME_TO_COMPLETE %uu\n", game->time_to_complete);
+    fprintf(output, "#define CONFIG_PROFILE_GAME_HARD_EDGED %s\n", game->hard_edged ? "true" : "false");
+    fprintf(output, "#define CONFIG_PROFILE_GAME_REUSE_WAYPOINTS %s\n\n", game->reuse_waypoints ? "true" : "false");
+
+    fprintf(output, "// Initializer for the constant config\n");
+    fprintf(output, "#define CONFIG_PROFILE { \\\n");
+    fprintf(output, "    .version = CONFIG_PROFILE_VERSION, \\\n");
+    fprintf(output, "    .map_config = { \\\n");
+    fprintf(output, "        .cell_count = CONFIG_PROFILE_MAP_CELL_COUNT, \\\n");
+    fprintf(output, "        .wall_probability = CONFIG_PROFILE_MAP_WALL_PROBABILITY, \\\n");
+    fprintf(output, "        .hole_probability = CONFIG_PROFILE_MAP_HOLE_PROBABILITY, \\\n");
+    fprintf(output, "        .num_waypoints = CONFIG_PROFILE_MAP_NUM_WAYPOINTS, \\\n");
+    fprintf(output, "        .hole_radius = CONFIG_PROFILE_MAP_HOLE_RADIUS, \\\n");
+    fprintf(output, "        .waypoint_radius = CONFIG_PROFILE_MAP_WAYPOINT_RADIUS \\\n");
+    fprintf(output, "    }, \\\n");
+    fprintf(output, "    .drone_config = { \\\n");
+    fprintf(output, "        .disruptor_max_time = CONFIG_PROFILE_DRONE_DISRUPTOR_MAX_TIME, \\\n");
+    fprintf(output, "        .disruptor_power = CONFIG_PROFILE_DRONE_DISRUPTOR_POWER, \\\n");
+    fprintf(output, "        .disruptor_min_activation_energy = CONFIG_PROFILE_DRONE_DISRUPTOR_MIN_ACTIVATION_ENERGY, \\\n");
+    fprintf(output, "        .max_energy = CONFIG_PROFILE_DRONE_MAX_ENERGY, \\\n");
+    fprintf(output, "        .recharge_rate = CONFIG_PROFILE_DRONE_RECHARGE_RATE, \\\n");
+    fprintf(output, "        .diameter = CONFIG_PROFILE_DRONE_DIAMETER, \\\n");
+    fprintf(output, "        .max_velocity = CONFIG_PROFILE_DRONE_MAX_VELOCITY \\\n");
+    fprintf(output, "    }, \\\n");
+    fprintf(output, "    .physics_config = { \\\n");
+    fprintf(output, "        .gravity = CONFIG_PROFILE_PHYSICS_GRAVITY, \\\n");
+    fprintf(output, "        .update_period = CONFIG_PROFILE_PHYSICS_UPDATE_PERIOD, \\\n");
+    fprintf(output, "        .angle_gain = CONFIG_PROFILE_PHYSICS_ANGLE_GAIN, \\\n");
+    fprintf(output, "        .pin_at_center = CONFIG_PROFILE_PHYSICS_PIN_AT_CENTER \\\n");
+    fprintf(output, "    }, \\\n");
+    fprintf(output, "    .game_config = { \\\n");
+    fprintf(output, "        .time_to_complete = CONFIG_PROFILE_GAME_TIME_TO_COMPLETE, \\\n");
+    fprintf(output, "        .hard_edged = CONFIG_PROFILE_GAME_HARD_EDGED, \\\n");
+    fprintf(output, "        .reuse_waypoints = CONFIG_PROFILE_GAME_REUSE_WAYPOINTS \\\n");
+    fprintf(output, "    } \\\n");
+    fprintf(output, "}\n\n");
+    fprintf(output, "#endif /* INC_CONFIGPROFILE_H_ */\n");
+    fclose(output);
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+#include <string.h>
+#include <stdbool.h>
+#include "ctest.h"
+#include "ConfigStore.h"
+
+#define SECTOR_SIZE 256 // Small, so a few saves fill a sector
+
+// Stand-in for the flash - erasing sets every bit, programming can only clear them. Programming can be made to
+// fail from a given word on, as if the board were reset part way through a save.
+typedef struct {
+    uint32_t sectors[2][SECTOR_SIZE / 4];
+    int erases[2];
+    int programs;
+    int fail_after;             // Programs that succeed before they all fail, -1 for never
+} FakeFlash_t;
+
+static FakeFlash_t flash;
+static ConfigStore_t store;
+
+typedef struct {
+    uint32_t seed;
+    uint16_t values[9];
+} Settings_t;
+
+static bool fake_erase(void *context, uint8_t sector)
+{
+    (void) &context;
+
+    if(flash.fail_after >= 0 && flash.programs >= flash.fail_after)
+        return false;
+
+    memset(flash.sectors[sector], 0xFF, SECTOR_SIZE);
+    flash.erases[sector] ++;
+
+    return true;
+}
+
+static bool fake_program(void *context, uintptr_t address, uint32_t word)
+{
+    uintptr_t start = (uintptr_t)flash.sectors;
+
+    (void) &context;
+
+    if(address % 4 || address < start || address >= start + sizeof(flash.sectors))
+        return false;
+
+    if(flash.fail_after >= 0 && flash.programs >= flash.fail_after)
+        return false;
+
+    flash.programs ++;
+    *(uint32_t *)address &= word;
+
+    return true;
+}
+
+/**
+  * @brief Starts the store over the fake flash, as at boot
+  */
+static void boot(void)
+{
+    ConfigStorePort_t port = {
+        .erase = fake_erase,
+        .program = fake_program,
+        .context = NULL
+    };
+
+    flash.fail_after = -1;
+    CONFIG_STORE_init(&store, &port, (const uint8_t *)flash.sectors[0], (const uint8_t *)flash.sectors[1], SECTOR_SIZE);
+}
+
+static void blank_flash(void)
+{
+    memset(&flash, 0xFF, sizeof(flash.sectors));
+    flash.erases[0] = flash.erases[1] = 0;
+    flash.programs = 0;
+}
+
+static Settings_t settings(uint32_t seed)
+{
+    Settings_t data;
+
+    data.seed = seed;
+    for(int i = 0; i < 9; i ++)
+        data.values[i] = seed * (i + 3);
+
+    return data;
+}
+
+static bool in_flash(const void *pointer)
+{
+    return (const uint8_t *)pointer >= (const uint8_t *)flash.sectors &&
+           (const uint8_t *)pointer < (const uint8_t *)flash.sectors + sizeof(flash.sectors);
+}
+
+CTEST(config_store, test_crc) {
+    // The standard check value
+    ASSERT_EQUAL(0xCBF43926, CONFIG_STORE_crc((const uint8_t *)"123456789", 9));
+    ASSERT_EQUAL(0, CONFIG_STORE_crc(NULL, 0));
+}
+
+CTEST(config_store, test_latest_is_read_in_place) {
+    Settings_t data = settings(7);
+
+    blank_flash();
+    boot();
+    ASSERT_NULL(CONFIG_STORE_find(&store, 1, sizeof(Settings_t)));
+
+    ASSERT_TRUE(CONFIG_STORE_save(&store, 1, &data, sizeof(data)));
+    data = settings(8);
+    ASSERT_TRUE(CONFIG_STORE_save(&store, 1, &data, sizeof(data)));
+
+    // Survives a reset, and is a pointer into flash, not a copy
+    boot();
+    const Settings_t *saved = CONFIG_STORE_find(&store, 1, sizeof(Settings_t));
+
+    ASSERT_NOT_NULL(saved);
+    ASSERT_TRUE(in_flash(saved));
+    ASSERT_EQUAL(0, (uintptr_t)saved % 4);
+    ASSERT_DATA((const unsigned char *)&data, sizeof(data), (const unsigned char *)saved, sizeof(*saved));
+    ASSERT_EQUAL(2, store.sequence);
+}
+
+CTEST(config_store, test_versions_are_kept_apart) {
+    Settings_t data = settings(1);
+    uint8_t old_layout[6] = {1, 2, 3, 4, 5, 6};
+
+    blank_flash();
+    boot();
+
+    ASSERT_TRUE(CONFIG_STORE_save(&store, 1, old_layout, sizeof(old_layout)));
+    ASSERT_TRUE(CONFIG_STORE_save(&store, 2, &data, sizeof(data)));
+
+    // An older build's record isn't taken for this one's, nor one of the right version but another size
+    boot();
+    ASSERT_DATA(old_layout, sizeof(old_layout), (const unsigned char *)CONFIG_STORE_find(&store, 1, sizeof(old_layout)), sizeof(old_layout));
+    ASSERT_EQUAL(data.seed, ((const Settings_t *)CONFIG_STORE_find(&store, 2, sizeof(Settings_t)))->seed);
+    ASSERT_NULL(CONFIG_STORE_find(&store, 1, sizeof(Settings_t)));
+    ASSERT_NULL(CONFIG_STORE_find(&store, 3, sizeof(Settings_t)));
+
+    // A payload that doesn't match its CRC is passed over
+    uint8_t *payload = (uint8_t *)CONFIG_STORE_find(&store, 2, sizeof(Settings_t));
+
+    payload[0] &= 0xFE; // A bit lost from the seed
+    ASSERT_NULL(CONFIG_STORE_find(&store, 2, sizeof(Settings_t)));
+}
+
+CTEST(config_store, test_sectors_wear_evenly) {
+    blank_flash();
+    boot();
+
+    // 40 byte records in 256 byte sectors - a sector takes 6 of them before the other is erased
+    for(uint32_t i = 1; i <= 400; i ++)
+    {
+        Settings_t data = settings(i);
+
+        ASSERT_TRUE(CONFIG_STORE_save(&store, 1, &data, sizeof(data)));
+
+        if(i % 37 == 0)
+            boot();
+
+        ASSERT_EQUAL(i, ((const Settings_t *)CONFIG_STORE_find(&store, 1, sizeof(Settings_t)))->seed);
+    }
+
+    ASSERT_EQUAL(66, flash.erases[0] + flash.erases[1]);
+    ASSERT_TRUE(flash.erases[0] - flash.erases[1] <= 1 && flash.erases[1] - flash.erases[0] <= 1);
+}
+
+CTEST(config_store, test_reset_during_save) {
+    // Reset at every word of a save, including the erase when it starts a new sector - the config after boot
+    // is the one before or the one being saved, never anything else, and the next save works
+    for(int saves = 6; saves <= 7; saves ++)
+    {
+        for(int cut = 0; cut < 20; cut ++)
+        {
+            blank_flash();
+            boot();
+
+            for(uint32_t i = 1; i < (uint32_t)saves; i ++)
+            {
+                Settings_t data = settings(i);
+
+                ASSERT_TRUE(CONFIG_STORE_save(&store, 1, &data, sizeof(data)));
+            }
+
+            Settings_t data = settings(saves);
+
+            flash.fail_after = flash.programs + cut;
+            CONFIG_STORE_save(&store, 1, &data, sizeof(data));
+
+            boot();
+            const Settings_t *saved = CONFIG_STORE_find(&store, 1, sizeof(Settings_t));
+
+            ASSERT_NOT_NULL(saved);
+            ASSERT_TRUE(saved->seed == (uint32_t)saves - 1 || saved->seed == (uint32_t)saves);
+
+            Settings_t expected = settings(saved->seed);
+
+            ASSERT_DATA((const unsigned char *)&expected, sizeof(expected), (const unsigned char *)saved, sizeof(*saved));
+
+            data = settings(100);
+            ASSERT_TRUE(CONFIG_STORE_save(&store, 1, &data, sizeof(data)));
+            ASSERT_EQUAL(100, ((const Settings_t *)CONFIG_STORE_find(&store, 1, sizeof(Settings_t)))->seed);
+        }
+    }
+}
+
+CTEST(config_store, test_failed_word_moves_to_other_sector) {
+    Settings_t data = settings(5);
+
+    blank_flash();
+    boot();
+    ASSERT_TRUE(CONFIG_STORE_save(&store, 1, &data, sizeof(data)));
+
+    // A word that reads back wrong - left set from an earlier, interrupted write. The record goes to the other
+    // sector, and the sector with the previous one isn't erased.
+    flash.sectors[0][11] = 0;
+    data = settings(6);
+    ASSERT_TRUE(CONFIG_STORE_save(&store, 1, &data, sizeof(data)));
+    ASSERT_EQUAL(1, store.active);
+    ASSERT_EQUAL(1, flash.erases[1]);
+    ASSERT_EQUAL(0, flash.erases[0]);
+
+    boot();
+    ASSERT_EQUAL(6, ((const Settings_t *)CONFIG_STORE_find(&store, 1, sizeof(Settings_t)))->seed);
+}
@@ -0,0 +1,115 @@
+/*
+ * entity_bench.c
+ *
+ * Host benchmark for the entity store. Times ENTITY_accelerate plus ENTITY_step for 1, 100 and 10000
+ * entities, once on an open board (every entity takes the free moving path) and once on a generated 6 x 6
+ * maze (entities near walls are swept against them).
+ *
+ * Usage:
+ *   entity_bench [ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Entity.h"
+
+static const uint16_t entity_counts[] = {1, 100, 10000};
+
+static uint32_t bench_random(void *context, uint32_t max)
+{
+    uint32_t *state = context;
+
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state % max;
+}
+
+/**
+  * @brief Runs the store for a number of ticks, tilting the board back and forth, and returns the average
+  *        time per entity per tick in ns
+  */
+static double run(EntityStore_t *store, const CollisionMask_t *mask, WallGrid_t *grid, uint16_t count, int ticks, uint32_t *state)
+{
+    static const EntityConfig_t config = {
+        .radius = Q16_FROM_INT(5),
+        .max_velocity = Q16_FROM_RATIO(2500, 1000),
+        .wall_pass_gain = Q16_FROM_RATIO(10, 3),
+        .min_x = Q16_FROM_INT(5),
+        .min_y = Q16_FROM_INT(45),
+        .max_x = Q16_FROM_INT(233),
+        .max_y = Q16_FROM_INT(275),
+    };
+    struct timespec start, end;
+
+    ENTITY_init(store, &config);
+
+    // Entities start in cell centers, clear of the walls
+    for(uint16_t i = 0; i < count; i ++)
+    {
+        uint32_t cell = bench_random(state, 36);
+
+        ENTITY_add(store, Q16_FROM_INT(MAP_ORIGIN_X + (cell % 6) * MAP_CELL_SIZE + 20),
+                   Q16_FROM_INT(MAP_ORIGIN_Y + (cell / 6) * MAP_CELL_SIZE + 20), 0);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int t = 0; t < ticks; t ++)
+    {
+        q16_t accel = ((t / 64) & 1) ? Q16_FROM_RATIO(1, 4) : -Q16_FROM_RATIO(1, 4);
+
+        ENTITY_accelerate(store, accel, accel / 2);
+        ENTITY_step(store, mask, grid);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / ((double)ticks * count);
+}
+
+int main(int argc, const char *argv[])
+{
+    static EntityStore_t store;
+    static CollisionMask_t mask;
+    static WallGrid_t grid;
+    static MapData_t map;
+    int ticks = argc > 1 ? atoi(argv[1]) : 2000;
+    uint32_t state = 1;
+
+    MapConfig_t map_config = {
+        .cell_count = 6,
+        .wall_probability = 200,
+        .hole_probability = 0,
+        .num_waypoints = 2,
+    };
+
+    printf("entities      open board    6x6 maze     (ns per entity per tick)\n");
+
+    for(unsigned i = 0; i < sizeof(entity_counts) / sizeof(entity_counts[0]); i ++)
+    {
+        uint16_t count = entity_counts[i];
+        // Enough ticks per size that each run takes a similar time
+        int size_ticks = count < 100 ? ticks * 100 : ticks;
+        double open_ns, maze_ns;
+
+        memset(&map, 0, sizeof(map));
+        map.cell_count = 6;
+        COLLISION_MASK_bake(&mask, &map, 10);
+        WALL_GRID_init(&grid, Q16_FROM_INT(MAP_ORIGIN_X), Q16_FROM_INT(MAP_ORIGIN_Y), Q16_FROM_INT(MAP_CELL_SIZE), 6, 6);
+        WALL_GRID_build(&grid);
+        open_ns = run(&store, &mask, &grid, count, size_ticks, &state);
+
+        MAP_create(&map, &map_config, bench_random, &state);
+        COLLISION_MASK_bake(&mask, &map, 10);
+        WALL_GRID_init(&grid, Q16_FROM_INT(MAP_ORIGIN_X), Q16_FROM_INT(MAP_ORIGIN_Y), Q16_FROM_INT(MAP_CELL_SIZE), 6, 6);
+        WALL_GRID_add_map_walls(&grid, &map);
+        WALL_GRID_build(&grid);
+        maze_ns = run(&store, &mask, &grid, count, size_ticks, &state);
+
+        printf("%8u  %12.1f  %12.1f\n", count, open_ns, maze_ns);
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <string.h>
+#include "ctest.h"
+#include "Entity.h"
+
+static const EntityConfig_t test_config = {
+    .radius = Q16_FROM_INT(5),
+    .max_velocity = Q16_FROM_INT(3),
+    .wall_pass_gain = Q16_FROM_RATIO(10, 3),
+    .min_x = Q16_FROM_INT(5),
+    .min_y = Q16_FROM_INT(45),
+    .max_x = Q16_FROM_INT(233),
+    .max_y = Q16_FROM_INT(275),
+};
+
+static CollisionMask_t mask;
+static WallGrid_t grid;
+static MapData_t map;
+
+/**
+  * @brief Bakes a 6 x 6 map into the mask and the wall grid
+  */
+static void build_walls(void)
+{
+    COLLISION_MASK_bake(&mask, &map, 10);
+    WALL_GRID_init(&grid, Q16_FROM_INT(MAP_ORIGIN_X), Q16_FROM_INT(MAP_ORIGIN_Y), Q16_FROM_INT(MAP_CELL_SIZE), 6, 6);
+    WALL_GRID_add_map_walls(&grid, &map);
+    WALL_GRID_build(&grid);
+}
+
+CTEST(entity, test_free_entities_move_by_velocity) {
+    static EntityStore_t store;
+
+    memset(&map, 0, sizeof(map));
+    map.cell_count = 6;
+    build_walls();
+
+    ENTITY_init(&store, &test_config);
+
+    for(int i = 0; i < 4; i ++)
+        ASSERT_EQUAL(i, ENTITY_add(&store, Q16_FROM_INT(60 + 30 * i), Q16_FROM_INT(160), 0));
+
+    ENTITY_accelerate(&store, Q16_ONE, -Q16_HALF);
+    ENTITY_step(&store, &mask, &grid);
+
+    for(int i = 0; i < 4; i ++)
+    {
+        ASSERT_EQUAL(Q16_FROM_INT(60 + 30 * i), store.prev_x[i]);
+        ASSERT_EQUAL(Q16_FROM_INT(61 + 30 * i), store.pos_x[i]);
+        ASSERT_EQUAL(Q16_FROM_INT(160) - Q16_HALF, store.pos_y[i]);
+        ASSERT_FALSE(store.flags[i] & ENTITY_NEAR_HAZARD);
+    }
+}
+
+CTEST(entity, test_velocity_limited_per_axis) {
+    static EntityStore_t store;
+
+    ENTITY_init(&store, &test_config);
+    ENTITY_add(&store, Q16_FROM_INT(100), Q16_FROM_INT(100), 0);
+
+    for(int i = 0; i < 10; i ++)
+        ENTITY_accelerate(&store, Q16_ONE, -Q16_ONE);
+
+    ASSERT_EQUAL(Q16_FROM_INT(3), store.vel_x[0]);
+    ASSERT_EQUAL(Q16_FROM_INT(-3), store.vel_y[0]);
+}
+
+CTEST(entity, test_stops_at_bounds) {
+    static EntityStore_t store;
+
+    memset(&map, 0, sizeof(map));
+    map.cell_count = 6;
+    build_walls();
+
+    ENTITY_init(&store, &test_config);
+    ENTITY_add(&store, Q16_FROM_INT(231), Q16_FROM_INT(160), 0);
+    ENTITY_accelerate(&store, Q16_FROM_INT(3), 0);
+    ENTITY_step(&store, &mask, &grid);
+
+    ASSERT_EQUAL(0, store.vel_x[0]);
+    ASSERT_EQUAL(Q16_FROM_INT(231), store.pos_x[0]);
+}
+
+CTEST(entity, test_slides_along_wall_or_passes_through) {
+    static EntityStore_t store;
+
+    // Wall along the bottom of cell (2, 2) at y = 160
+    memset(&map, 0, sizeof(map));
+    map.cell_count = 6;
+    map.cell_data[2][2] = MAP_BOTTOM_WALL;
+    build_walls();
+
+    ENTITY_init(&store, &test_config);
+    ENTITY_add(&store, Q16_FROM_INT(100), Q16_FROM_INT(153), 0);
+    ENTITY_add(&store, Q16_FROM_INT(100), Q16_FROM_INT(153), ENTITY_PASS_WALLS);
+    ENTITY_accelerate(&store, Q16_ONE, Q16_FROM_INT(3));
+    ENTITY_step(&store, &mask, &grid);
+
+    // Stopped by the wall, still moving along it
+    ASSERT_TRUE(store.flags[0] & ENTITY_NEAR_HAZARD);
+    ASSERT_TRUE(store.pos_y[0] <= Q16_FROM_INT(155));
+    ASSERT_EQUAL(0, store.vel_y[0]);
+    ASSERT_EQUAL(Q16_FROM_INT(101), store.pos_x[0]);
+
+    ASSERT_TRUE(store.pos_y[1] > Q16_FROM_INT(160));
+}
+
+CTEST(entity, test_remove_moves_last_entity) {
+    static EntityStore_t store;
+
+    ENTITY_init(&store, &test_config);
+    ENTITY_add(&store, Q16_FROM_INT(10), Q16_FROM_INT(50), 0);
+    ENTITY_add(&store, Q16_FROM_INT(20), Q16_FROM_INT(50), 0);
+    ENTITY_add(&store, Q16_FROM_INT(30), Q16_FROM_INT(50), ENTITY_PASS_WALLS);
+
+    ENTITY_remove(&store, 0);
+
+    ASSERT_EQUAL(2, store.count);
+    ASSERT_EQUAL(Q16_FROM_INT(30), store.pos_x[0]);
+    ASSERT_EQUAL(ENTITY_PASS_WALLS, store.flags[0]);
+    ASSERT_EQUAL(Q16_FROM_INT(20), store.pos_x[1]);
+}
+
+CTEST(entity, test_reach_past_the_mask_disk_is_rejected) {
+    static EntityStore_t store;
+    EntityConfig_t config = test_config;
+
+    // 5 + 2 * (3 + 1) + 1 = 14 pixels
+    ASSERT_TRUE(ENTITY_init(&store, &config));
+    ASSERT_EQUAL(14, store.reach.radius);
+
+    // 5 + 2 * (13 + 1) + 1 = 34 - past the largest disk, so the broadphase couldn't cover one tick's move
+    config.max_velocity = Q16_FROM_INT(13);
+    ASSERT_FALSE(ENTITY_init(&store, &config));
+
+    // A big entity gets there on its own
+    config = test_config;
+    config.radius = Q16_FROM_INT(24);
+    ASSERT_FALSE(ENTITY_init(&store, &config));
+
+    config.radius = Q16_FROM_INT(22);
+    ASSERT_TRUE(ENTITY_init(&store, &config));
+    ASSERT_EQUAL(COLLISION_MASK_MAX_RADIUS, store.reach.radius);
+}
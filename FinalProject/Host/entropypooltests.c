@@ -0,0 +1,171 @@
+#include <string.h>
+#include <stdbool.h>
+#include "ctest.h"
+#include "EntropyPool.h"
+
+// Stand-in for the TRNG - a counter scrambled into a word per tick. The data ready interrupt only reaches the
+// pool while it is enabled; words made while it is off are overwritten in the data register and lost.
+typedef struct {
+    bool interrupt_enabled;
+    uint32_t counter;
+    int starts, stops;
+    int repeat_every;           // Make every nth word the same as the one before, 0 for never
+} FakeRng_t;
+
+static FakeRng_t rng;
+static EntropyPool_t pool;
+
+static uint32_t fake_word(uint32_t n)
+{
+    n ^= n >> 16;
+    n *= 0x7FEB352D;
+    n ^= n >> 15;
+    n *= 0x846CA68B;
+    n ^= n >> 16;
+
+    return n;
+}
+
+static void fake_start(void *context)
+{
+    (void) &context;
+    rng.interrupt_enabled = true;
+    rng.starts ++;
+}
+
+static void fake_stop(void *context)
+{
+    (void) &context;
+    rng.interrupt_enabled = false;
+    rng.stops ++;
+}
+
+/**
+  * @brief Runs the generator for a number of words - each is passed to the pool's interrupt handler if enabled
+  */
+static void fake_run(int words)
+{
+    static uint32_t previous;
+
+    for(int i = 0; i < words; i ++)
+    {
+        rng.counter ++;
+
+        uint32_t word = (rng.repeat_every && (rng.counter % rng.repeat_every) == 0) ? previous : fake_word(rng.counter);
+
+        previous = word;
+
+        if(rng.interrupt_enabled)
+            ENTROPY_POOL_on_word(&pool, word);
+    }
+}
+
+static void setup(uint32_t seed)
+{
+    EntropyPoolPort_t port = {fake_start, fake_stop, NULL};
+
+    memset(&rng, 0, sizeof(rng));
+    ENTROPY_POOL_init(&pool, &port, seed);
+    ENTROPY_POOL_start(&pool);
+}
+
+CTEST(entropy_pool, test_fills_in_background_and_stops_when_full) {
+    setup(1234);
+    ASSERT_EQUAL(1, rng.starts);
+
+    // The first word only primes the continuous test
+    fake_run(1);
+    ASSERT_EQUAL(0, ENTROPY_POOL_available(&pool));
+
+    fake_run(ENTROPY_POOL_SIZE);
+    ASSERT_EQUAL(ENTROPY_POOL_SIZE, ENTROPY_POOL_available(&pool));
+    ASSERT_FALSE(rng.interrupt_enabled);
+    ASSERT_EQUAL(1, rng.stops);
+
+    // Words from the generator come out in order
+    for(int i = 0; i < ENTROPY_POOL_SIZE; i ++)
+    {
+        ASSERT_EQUAL(fake_word(2 + i), ENTROPY_POOL_take(&pool));
+
+        // Taking a word from a full ring starts the interrupt again, and only once
+        ASSERT_TRUE(rng.interrupt_enabled);
+        ASSERT_EQUAL(2, rng.starts);
+    }
+
+    ASSERT_EQUAL(0, pool.fallbacks);
+}
+
+CTEST(entropy_pool, test_empty_ring_falls_back_without_waiting) {
+    setup(0xC0FFEE);
+
+    // Nothing from the generator yet - the fallback answers straight away, and doesn't repeat itself
+    uint32_t words[64];
+
+    for(int i = 0; i < 64; i ++)
+    {
+        words[i] = ENTROPY_POOL_take(&pool);
+
+        for(int j = 0; j < i; j ++)
+            ASSERT_NOT_EQUAL(words[j], words[i]);
+    }
+
+    ASSERT_EQUAL(64, pool.fallbacks);
+
+    // A different seed gives a different sequence
+    setup(0xC0FFEF);
+    ASSERT_NOT_EQUAL(words[0], ENTROPY_POOL_take(&pool));
+
+    // Once the generator has caught up, words come from it again
+    fake_run(5);
+    ASSERT_EQUAL(4, ENTROPY_POOL_available(&pool));
+    ASSERT_EQUAL(fake_word(2), ENTROPY_POOL_take(&pool));
+    ASSERT_EQUAL(1, pool.fallbacks);
+}
+
+CTEST(entropy_pool, test_repeated_words_are_dropped) {
+    setup(99);
+    rng.repeat_every = 4;
+
+    fake_run(ENTROPY_POOL_SIZE);
+
+    // Words 4, 8, 12 and 16 repeat the one before - dropped, as is the first word
+    ASSERT_EQUAL(4, pool.repeats);
+    ASSERT_EQUAL(ENTROPY_POOL_SIZE - 5, ENTROPY_POOL_available(&pool));
+
+    for(uint32_t n = 2; ENTROPY_POOL_available(&pool) > 0; n ++)
+    {
+        if(n % 4 == 0)
+            continue;
+
+        ASSERT_EQUAL(fake_word(n), ENTROPY_POOL_take(&pool));
+    }
+
+    // After a restart the first word is only used for comparing again
+    ENTROPY_POOL_on_restart(&pool);
+    rng.repeat_every = 0;
+    fake_run(3);
+    ASSERT_EQUAL(2, ENTROPY_POOL_available(&pool));
+    ASSERT_EQUAL(4, pool.repeats);
+}
+
+CTEST(entropy_pool, test_indexes_wrap) {
+    uint32_t expected = 2;
+
+    setup(7);
+    fake_run(1);
+
+    // Far past the 16 bit head and tail - the generator runs ahead of the taker or falls behind it
+    for(int round = 0; round < 40000; round ++)
+    {
+        int made = (round % 3) + 1;
+
+        fake_run(made);
+
+        for(int i = 0; i < made; i ++)
+            ASSERT_EQUAL(fake_word(expected ++), ENTROPY_POOL_take(&pool));
+    }
+
+    ASSERT_EQUAL(0, ENTROPY_POOL_available(&pool));
+    ASSERT_EQUAL(0, pool.fallbacks);
+    ASSERT_TRUE(rng.counter > 65536);
+}
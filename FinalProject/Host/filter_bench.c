@@ -0,0 +1,86 @@
+/*
+ * filter_bench.c
+ *
+ * Host benchmark for the gyro filters. Runs a block of noisy samples through the DC blocker and low pass
+ * the way the gyro task does, and reports time and cycles per sample for each. Cycles come from the time
+ * stamp counter on x86 hosts - on the board, sample_gyro times the same chain with the DWT cycle counter.
+ *
+ * Usage:
+ *   filter_bench [samples] [block]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Filter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0
+#endif
+
+#define MAX_BLOCK 256
+
+static double elapsed(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, const char *argv[])
+{
+    long sample_count = argc > 1 ? atol(argv[1]) : 10000000;
+    int block_size = argc > 2 ? atoi(argv[2]) : 10;
+    static int16_t input[MAX_BLOCK], output[MAX_BLOCK];
+    struct timespec start, end;
+    Biquad_t biquad;
+    DcBlocker_t blocker;
+    int32_t checksum = 0;
+
+    if(block_size < 1 || block_size > MAX_BLOCK)
+    {
+        fprintf(stderr, "block is 1 to %d samples\n", MAX_BLOCK);
+        return 1;
+    }
+
+    srand(1);
+
+    for(int i = 0; i < block_size; i ++)
+        input[i] = (rand() % 4001) - 2000;
+
+    long blocks = sample_count / block_size;
+
+    FILTER_biquad_init(&biquad, &gyro_low_pass_coefficients);
+    FILTER_dc_blocker_init(&blocker, gyro_dc_block_pole);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long long start_cycles = CYCLES();
+    for(long n = 0; n < blocks; n ++)
+    {
+        FILTER_dc_blocker_process(&blocker, input, output, block_size);
+        checksum += output[n % block_size];
+    }
+    unsigned long long dc_cycles = CYCLES() - start_cycles;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double dc_time = elapsed(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    start_cycles = CYCLES();
+    for(long n = 0; n < blocks; n ++)
+    {
+        FILTER_biquad_process(&biquad, input, output, block_size);
+        checksum += output[n % block_size];
+    }
+    unsigned long long biquad_cycles = CYCLES() - start_cycles;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double biquad_time = elapsed(&start, &end);
+
+    double samples = (double)blocks * block_size;
+
+    printf("%.0f samples in blocks of %d (checksum %d)\n", samples, block_size, checksum);
+    printf("DC blocker: %.2f ns/sample, %.1f cycles/sample\n", dc_time * 1e9 / samples, dc_cycles / samples);
+    printf("Low pass:   %.2f ns/sample, %.1f cycles/sample\n", biquad_time * 1e9 / samples, biquad_cycles / samples);
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * filter_design.c
+ *
+ * Designs the gyro filters used by Filter.c from the FILTER_GYRO_ parameters in Filter.h - a Butterworth
+ * low pass biquad by the bilinear transform (RBJ cookbook) and a one pole DC blocker - and writes their
+ * Q2.30 coefficients.
+ *
+ * Usage:
+ *   filter_design <output.c>
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "Filter.h"
+
+static long to_q30(double value)
+{
+    return lround(value * (1L << FILTER_COEFFICIENT_SHIFT));
+}
+
+int main(int argc, const char *argv[])
+{
+    if(argc != 2)
+    {
+        fprintf(stderr, "usage: %s <output.c>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *output = fopen(argv[1], "w");
+    if(output == NULL)
+    {
+        perror("output");
+        return 1;
+    }
+
+    // Low pass
+    double w0 = 2.0 * M_PI * FILTER_GYRO_LOW_PASS_HZ / FILTER_GYRO_SAMPLE_RATE_HZ;
+    double alpha = sin(w0) / (2.0 * FILTER_GYRO_LOW_PASS_Q);
+    double a0 = 1.0 + alpha;
+    double b0 = ((1.0 - cos(w0)) / 2.0) / a0;
+    double b1 = (1.0 - cos(w0)) / a0;
+    double a1 = (-2.0 * cos(w0)) / a0;
+    double a2 = (1.0 - alpha) / a0;
+
+    // DC blocker - pole at the cut-off
+    double pole = exp(-2.0 * M_PI * FILTER_GYRO_DC_BLOCK_HZ / FILTER_GYRO_SAMPLE_RATE_HZ);
+
+    fprintf(output, "/*\n * FilterCoefficients.c\n *\n * Generated by Host/filter_design - do not edit.\n */\n\n");
+    fprintf(output, "#include \"Filter.h\"\n\n");
+    fprintf(output, "// Butterworth low pass, %g Hz at %d Hz\n", FILTER_GYRO_LOW_PASS_HZ, FILTER_GYRO_SAMPLE_RATE_HZ);
+    fprintf(output, "const BiquadCoefficients_t gyro_low_pass_coefficients = {\n");
+    fprintf(output, "    .b0 = %ld,\n    .b1 = %ld,\n    .b2 = %ld,\n", to_q30(b0), to_q30(b1), to_q30(b0));
+    fprintf(output, "    .a1 = %ld,\n    .a2 = %ld\n};\n\n", to_q30(a1), to_q30(a2));
+    fprintf(output, "// DC blocker, %g Hz at %d Hz\n", FILTER_GYRO_DC_BLOCK_HZ, FILTER_GYRO_SAMPLE_RATE_HZ);
+    fprintf(output, "const int32_t gyro_dc_block_pole = %ld;\n", to_q30(pole));
+    fclose(output);
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <math.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <complex.h>
+#include "ctest.h"
+#include "Filter.h"
+
+#define RATE        FILTER_GYRO_SAMPLE_RATE_HZ
+#define AMPLITUDE   8000
+#define BLOCK       10      // Samples per call, about what a FIFO burst brings
+
+/**
+  * @brief Gain the quantised biquad coefficients give at a frequency
+  */
+static double biquad_gain(const BiquadCoefficients_t *c, double hz)
+{
+    double complex z = cexp(-I * 2.0 * M_PI * hz / RATE);
+    double scale = 1 << FILTER_COEFFICIENT_SHIFT;
+    double complex numerator = (c->b0 + (c->b1 * z) + (c->b2 * z * z)) / scale;
+    double complex denominator = 1.0 + ((c->a1 * z) + (c->a2 * z * z)) / scale;
+
+    return cabs(numerator / denominator);
+}
+
+/**
+  * @brief Gain the quantised DC blocker pole gives at a frequency
+  */
+static double dc_blocker_gain(int32_t pole, double hz)
+{
+    double complex z = cexp(-I * 2.0 * M_PI * hz / RATE);
+
+    return cabs((1.0 - z) / (1.0 - (pole / (double)(1 << FILTER_COEFFICIENT_SHIFT)) * z));
+}
+
+/**
+  * @brief Runs a sine through a filter in blocks and measures the amplitude once it has settled
+  */
+static double measure_gain(bool low_pass, double hz, double offset, int settle)
+{
+    Biquad_t biquad;
+    DcBlocker_t blocker;
+    int16_t block[BLOCK];
+    double peak = 0;
+    int period = (int)ceil(RATE / hz);
+    int total = settle + (4 * period);
+
+    FILTER_biquad_init(&biquad, &gyro_low_pass_coefficients);
+    FILTER_dc_blocker_init(&blocker, gyro_dc_block_pole);
+
+    for(int n = 0; n < total; n += BLOCK)
+    {
+        for(int i = 0; i < BLOCK; i ++)
+            block[i] = lround(offset + AMPLITUDE * sin(2.0 * M_PI * hz * (n + i) / RATE));
+
+        if(low_pass)
+            FILTER_biquad_process(&biquad, block, block, BLOCK);
+        else
+            FILTER_dc_blocker_process(&blocker, block, block, BLOCK);
+
+        for(int i = 0; i < BLOCK; i ++)
+        {
+            if(n + i >= settle && abs(block[i]) > peak)
+                peak = abs(block[i]);
+        }
+    }
+
+    return peak / AMPLITUDE;
+}
+
+CTEST(filter, test_low_pass_response) {
+    const double frequencies[] = {0.5, 2, 5, 8, FILTER_GYRO_LOW_PASS_HZ, 20, 40, 80};
+
+    // Matches the design at every frequency - the sampled peak of a sine is at most a little under its
+    // amplitude, so allow for that plus rounding
+    for(unsigned i = 0; i < sizeof(frequencies) / sizeof(frequencies[0]); i ++)
+    {
+        double expected = biquad_gain(&gyro_low_pass_coefficients, frequencies[i]);
+        double measured = measure_gain(true, frequencies[i], 0, 2 * RATE);
+
+        ASSERT_DBL_NEAR_TOL(expected, measured, 0.02 * expected + 4.0 / AMPLITUDE);
+    }
+
+    // Butterworth - flat passband, 3 dB down at the cut-off, then falling away
+    ASSERT_DBL_NEAR_TOL(1.0, biquad_gain(&gyro_low_pass_coefficients, 0), 1e-6);
+    ASSERT_DBL_NEAR_TOL(1.0, biquad_gain(&gyro_low_pass_coefficients, 2), 0.01);
+    ASSERT_DBL_NEAR_TOL(M_SQRT1_2, biquad_gain(&gyro_low_pass_coefficients, FILTER_GYRO_LOW_PASS_HZ), 0.01);
+    ASSERT_TRUE(biquad_gain(&gyro_low_pass_coefficients, 40) < 0.1);
+    ASSERT_TRUE(biquad_gain(&gyro_low_pass_coefficients, 80) < 0.01);
+}
+
+CTEST(filter, test_low_pass_settles_on_dc) {
+    Biquad_t biquad;
+    int16_t block[BLOCK];
+
+    FILTER_biquad_init(&biquad, &gyro_low_pass_coefficients);
+
+    // A held rate comes out unchanged - no offset from rounding in the feedback
+    for(int n = 0; n < 50; n ++)
+    {
+        for(int i = 0; i < BLOCK; i ++)
+            block[i] = -1234;
+
+        FILTER_biquad_process(&biquad, block, block, BLOCK);
+    }
+
+    for(int i = 0; i < BLOCK; i ++)
+        ASSERT_EQUAL(-1234, block[i]);
+}
+
+CTEST(filter, test_dc_blocker_response) {
+    const double frequencies[] = {0.5, 2, 10, 50};
+
+    // An offset is removed and the motion passes through
+    for(unsigned i = 0; i < sizeof(frequencies) / sizeof(frequencies[0]); i ++)
+    {
+        double expected = dc_blocker_gain(gyro_dc_block_pole, frequencies[i]);
+        double measured = measure_gain(false, frequencies[i], 500, 60 * RATE);
+
+        ASSERT_DBL_NEAR_TOL(expected, measured, 0.02 * expected + 4.0 / AMPLITUDE);
+        ASSERT_TRUE(expected > 0.99);
+    }
+
+    ASSERT_DBL_NEAR_TOL(M_SQRT1_2, dc_blocker_gain(gyro_dc_block_pole, FILTER_GYRO_DC_BLOCK_HZ), 0.01);
+}
+
+CTEST(filter, test_dc_blocker_removes_bias) {
+    DcBlocker_t blocker;
+    int16_t block[BLOCK];
+
+    FILTER_dc_blocker_init(&blocker, gyro_dc_block_pole);
+
+    // A constant bias decays to nothing within a couple of time constants
+    for(int n = 0; n < (20 * RATE) / BLOCK; n ++)
+    {
+        for(int i = 0; i < BLOCK; i ++)
+            block[i] = 300;
+
+        FILTER_dc_blocker_process(&blocker, block, block, BLOCK);
+    }
+
+    for(int i = 0; i < BLOCK; i ++)
+        ASSERT_TRUE(abs(block[i]) <= 1);
+}
+
+CTEST(filter, test_blocks_match_one_call_and_saturate) {
+    static int16_t input[200];
+    int16_t whole[200], pieces[200];
+    Biquad_t a, b;
+    DcBlocker_t c, d;
+
+    // Full scale steps - the filters overshoot, and saturate instead of wrapping
+    for(int i = 0; i < 200; i ++)
+        input[i] = (i / 25) % 2 ? INT16_MAX : INT16_MIN;
+
+    FILTER_biquad_init(&a, &gyro_low_pass_coefficients);
+    FILTER_biquad_init(&b, &gyro_low_pass_coefficients);
+    FILTER_biquad_process(&a, input, whole, 200);
+
+    for(int i = 0, size = 1; i < 200; i += size, size = (size % 7) + 1)
+        FILTER_biquad_process(&b, &input[i], &pieces[i], (i + size > 200) ? 200 - i : size);
+
+    ASSERT_DATA((unsigned char *)whole, sizeof(whole), (unsigned char *)pieces, sizeof(pieces));
+
+    for(int i = 30; i < 200; i ++)
+        ASSERT_TRUE((whole[i] > 0) == (input[i] > 0) || (i % 25) < 5);
+
+    FILTER_dc_blocker_init(&c, gyro_dc_block_pole);
+    FILTER_dc_blocker_init(&d, gyro_dc_block_pole);
+    FILTER_dc_blocker_process(&c, input, whole, 200);
+
+    for(int i = 0, size = 3; i < 200; i += size, size = (size % 11) + 1)
+        FILTER_dc_blocker_process(&d, &input[i], &pieces[i], (i + size > 200) ? 200 - i : size);
+
+    ASSERT_DATA((unsigned char *)whole, sizeof(whole), (unsigned char *)pieces, sizeof(pieces));
+
+    // The rising step is twice full scale - it clips at the top instead of wrapping round
+    ASSERT_EQUAL(INT16_MAX, whole[25]);
+    ASSERT_EQUAL(INT16_MIN, whole[50]);
+}
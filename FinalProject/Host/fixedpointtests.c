@@ -0,0 +1,100 @@
+#include "ctest.h"
+#include "FixedPoint.h"
+
+// Smallest Q16.16 step
+#define ULP 1
+
+CTEST(fixed_point, test_mul_rounds_half_up) {
+    ASSERT_EQUAL(Q16_FROM_INT(6), FIXED_mul(Q16_FROM_INT(2), Q16_FROM_INT(3)));
+    ASSERT_EQUAL(-Q16_FROM_INT(6), FIXED_mul(-Q16_FROM_INT(2), Q16_FROM_INT(3)));
+    ASSERT_EQUAL(Q16_FROM_RATIO(3, 4), FIXED_mul(Q16_HALF, Q16_FROM_RATIO(3, 2)));
+
+    // Half a step rounds up - toward +infinity for negative products too
+    ASSERT_EQUAL(ULP, FIXED_mul(ULP, Q16_HALF));
+    ASSERT_EQUAL(0, FIXED_mul(-ULP, Q16_HALF));
+    ASSERT_EQUAL(2 * ULP, FIXED_mul(3 * ULP, Q16_HALF));
+    ASSERT_EQUAL(-ULP, FIXED_mul(-3 * ULP, Q16_HALF));
+
+    // Under half a step rounds toward the nearest
+    ASSERT_EQUAL(0, FIXED_mul(ULP, Q16_HALF - 1));
+    ASSERT_EQUAL(0, FIXED_mul(-ULP, Q16_HALF - 1));
+    ASSERT_EQUAL(-ULP, FIXED_mul(-ULP, Q16_HALF + 1));
+}
+
+CTEST(fixed_point, test_div_truncates_toward_zero) {
+    ASSERT_EQUAL(Q16_FROM_INT(3), FIXED_div(Q16_FROM_INT(6), Q16_FROM_INT(2)));
+    ASSERT_EQUAL(Q16_HALF, FIXED_div(Q16_ONE, Q16_FROM_INT(2)));
+
+    // 1 / 3 = 21845.33 steps, -1 / 3 = -21845.33
+    ASSERT_EQUAL(21845, FIXED_div(Q16_ONE, Q16_FROM_INT(3)));
+    ASSERT_EQUAL(-21845, FIXED_div(-Q16_ONE, Q16_FROM_INT(3)));
+    ASSERT_EQUAL(-21845, FIXED_div(Q16_ONE, -Q16_FROM_INT(3)));
+
+    // 2 / 3 = 43690.67 steps - not rounded up
+    ASSERT_EQUAL(43690, FIXED_div(Q16_FROM_INT(2), Q16_FROM_INT(3)));
+    ASSERT_EQUAL(-43690, FIXED_div(-Q16_FROM_INT(2), Q16_FROM_INT(3)));
+
+    ASSERT_EQUAL(Q16_FROM_INT(-4), FIXED_reciprocal(-Q16_FROM_RATIO(1, 4)));
+}
+
+CTEST(fixed_point, test_add_and_sub_saturate_at_both_limits) {
+    ASSERT_EQUAL(Q16_MAX, FIXED_add(Q16_MAX, ULP));
+    ASSERT_EQUAL(Q16_MAX, FIXED_add(Q16_MAX, Q16_MAX));
+    ASSERT_EQUAL(Q16_MIN, FIXED_add(Q16_MIN, -ULP));
+    ASSERT_EQUAL(Q16_MIN, FIXED_add(Q16_MIN, Q16_MIN));
+    ASSERT_EQUAL(-ULP, FIXED_add(Q16_MAX, Q16_MIN));
+
+    ASSERT_EQUAL(Q16_MAX, FIXED_sub(Q16_MAX, -ULP));
+    ASSERT_EQUAL(Q16_MAX, FIXED_sub(0, Q16_MIN));
+    ASSERT_EQUAL(Q16_MIN, FIXED_sub(Q16_MIN, ULP));
+    ASSERT_EQUAL(Q16_MIN, FIXED_sub(-Q16_FROM_INT(2), Q16_MAX));
+
+    ASSERT_EQUAL(Q16_MAX, FIXED_abs(Q16_MIN));
+    ASSERT_EQUAL(Q16_MAX, FIXED_abs(-Q16_MAX));
+}
+
+CTEST(fixed_point, test_mul_and_div_saturate_at_both_limits) {
+    ASSERT_EQUAL(Q16_MAX, FIXED_mul(Q16_MAX, Q16_FROM_INT(2)));
+    ASSERT_EQUAL(Q16_MAX, FIXED_mul(Q16_MIN, Q16_MIN));
+    ASSERT_EQUAL(Q16_MAX, FIXED_mul(Q16_MIN, -Q16_ONE));
+    ASSERT_EQUAL(Q16_MIN, FIXED_mul(Q16_MAX, -Q16_FROM_INT(2)));
+    ASSERT_EQUAL(Q16_MIN, FIXED_mul(Q16_MIN, Q16_FROM_INT(2)));
+    ASSERT_EQUAL(Q16_MIN, FIXED_mul(Q16_MIN, Q16_ONE));
+
+    ASSERT_EQUAL(Q16_MAX, FIXED_div(Q16_MAX, Q16_HALF));
+    ASSERT_EQUAL(Q16_MAX, FIXED_div(Q16_MIN, -Q16_ONE));
+    ASSERT_EQUAL(Q16_MIN, FIXED_div(Q16_MIN, Q16_HALF));
+    ASSERT_EQUAL(Q16_MIN, FIXED_div(Q16_MAX, -Q16_HALF));
+
+    // Division by zero goes to the limit on the side of the dividend
+    ASSERT_EQUAL(Q16_MAX, FIXED_div(Q16_ONE, 0));
+    ASSERT_EQUAL(Q16_MAX, FIXED_div(0, 0));
+    ASSERT_EQUAL(Q16_MIN, FIXED_div(-ULP, 0));
+    ASSERT_EQUAL(Q16_MAX, FIXED_reciprocal(0));
+}
+
+CTEST(fixed_point, test_round_to_int_on_negatives) {
+    ASSERT_EQUAL(-1, Q16_ROUND_TO_INT(-Q16_ONE));
+    ASSERT_EQUAL(-1, Q16_ROUND_TO_INT(-Q16_FROM_RATIO(5, 4)));
+    ASSERT_EQUAL(-2, Q16_ROUND_TO_INT(-Q16_FROM_RATIO(7, 4)));
+    ASSERT_EQUAL(0, Q16_ROUND_TO_INT(-Q16_FROM_RATIO(1, 4)));
+
+    // Halves round up, so -1.5 goes to -1 and -0.5 to 0, where Q16_TO_INT takes them down
+    ASSERT_EQUAL(-1, Q16_ROUND_TO_INT(-Q16_FROM_RATIO(3, 2)));
+    ASSERT_EQUAL(0, Q16_ROUND_TO_INT(-Q16_HALF));
+    ASSERT_EQUAL(-1, Q16_ROUND_TO_INT(-Q16_HALF - ULP));
+    ASSERT_EQUAL(-2, Q16_TO_INT(-Q16_FROM_RATIO(3, 2)));
+    ASSERT_EQUAL(-1, Q16_TO_INT(-ULP));
+
+    ASSERT_EQUAL(2, Q16_ROUND_TO_INT(Q16_FROM_RATIO(3, 2)));
+    ASSERT_EQUAL(-32768, Q16_ROUND_TO_INT(Q16_MIN));
+}
+
+CTEST(fixed_point, test_q15_saturates) {
+    ASSERT_EQUAL(Q15_MAX, FIXED_q15_mul(Q15_MIN, Q15_MIN));
+    ASSERT_EQUAL(Q15_MIN + 1, FIXED_q15_mul(Q15_MIN, Q15_MAX));
+    ASSERT_EQUAL(Q15_MAX, FIXED_q16_to_q15(Q16_FROM_INT(2)));
+    ASSERT_EQUAL(Q15_MIN, FIXED_q16_to_q15(-Q16_FROM_INT(2)));
+    ASSERT_EQUAL(Q15_MIN, FIXED_q16_to_q15(-Q16_ONE));
+    ASSERT_EQUAL(-Q16_ONE, FIXED_q15_to_q16(Q15_MIN));
+}
@@ -0,0 +1,72 @@
+/*
+ * flow_field_bench.c
+ *
+ * Host benchmark for FLOW_FIELD_compute. For map sizes up to 64 x 64 it generates maps with the
+ * firmware's generator and reports the average time to rebuild the field toward a waypoint.
+ *
+ * Usage:
+ *   flow_field_bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Map.h"
+#include "FlowField.h"
+
+#define MAPS_PER_SIZE 16
+
+static const uint8_t cell_counts[] = {6, 8, 16, 32, 48, 64};
+
+static uint32_t bench_random(void *context, uint32_t max)
+{
+    uint32_t *state = context;
+
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state % max;
+}
+
+int main(int argc, const char *argv[])
+{
+    static MapData_t map;
+    static FlowField_t field;
+    int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+    uint32_t state = 1;
+    volatile uint8_t sink = 0;
+
+    for(unsigned i = 0; i < sizeof(cell_counts); i ++)
+    {
+        MapConfig_t map_config = {
+            .cell_count = cell_counts[i],
+            .wall_probability = 200,
+            .hole_probability = 50,
+            .num_waypoints = 2,
+        };
+        double total_ns = 0;
+
+        for(int m = 0; m < MAPS_PER_SIZE; m ++)
+        {
+            struct timespec start, end;
+
+            MAP_create(&map, &map_config, bench_random, &state);
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for(int j = 0; j < iterations; j ++)
+            {
+                FLOW_FIELD_compute(&field, &map, MAP_CELL_ROW(map.waypoint_data[1].y), MAP_CELL_COL(map.waypoint_data[1].x));
+                sink += field.cells[0][0];
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            total_ns += (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+        }
+
+        printf("%2ux%-2u flow field computed in %.1f us\n", cell_counts[i], cell_counts[i],
+               total_ns / (MAPS_PER_SIZE * iterations) / 1000);
+    }
+
+    return 0;
+}
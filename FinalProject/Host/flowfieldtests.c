@@ -0,0 +1,133 @@
+#include <string.h>
+#include "ctest.h"
+#include "FlowField.h"
+
+static MapData_t map;
+static FlowField_t field;
+
+#define DISTANCE(row, col)  FLOW_FIELD_DISTANCE(field.cells[row][col])
+#define DIRECTION(row, col) FLOW_FIELD_DIRECTION(field.cells[row][col])
+
+/**
+  * @brief Empty map of cell_count x cell_count cells
+  */
+static void clear_map(uint8_t cell_count)
+{
+    memset(&map, 0, sizeof(map));
+    map.cell_count = cell_count;
+}
+
+/**
+  * @brief Wall between a cell and the one below it, set from both sides like the map generator does
+  */
+static void wall_below(int row, int col)
+{
+    map.cell_data[row][col] |= MAP_BOTTOM_WALL;
+    map.cell_data[row + 1][col] |= MAP_TOP_WALL;
+}
+
+static void wall_right(int row, int col)
+{
+    map.cell_data[row][col] |= MAP_RIGHT_WALL;
+    map.cell_data[row][col + 1] |= MAP_LEFT_WALL;
+}
+
+CTEST(flow_field, test_routes_around_walls_and_holes) {
+    /* Target T in the corner, a wall under the first three cells of row 1 and a hole H
+     *   T . . .
+     *   . . . .
+     *   -------
+     *   . . . .
+     *   . . . H
+     */
+    clear_map(4);
+    wall_below(1, 0);
+    wall_below(1, 1);
+    wall_below(1, 2);
+    map.cell_data[3][3] |= MAP_HOLE;
+
+    FLOW_FIELD_compute(&field, &map, 0, 0);
+
+    ASSERT_EQUAL(FLOW_TARGET, DIRECTION(0, 0));
+    ASSERT_EQUAL(0, DISTANCE(0, 0));
+
+    // Above the wall the route is straight
+    ASSERT_EQUAL(1, DISTANCE(1, 0));
+    ASSERT_EQUAL(FLOW_UP, DIRECTION(1, 0));
+    ASSERT_EQUAL(3, DISTANCE(0, 3));
+    ASSERT_EQUAL(FLOW_LEFT, DIRECTION(0, 3));
+    ASSERT_EQUAL(4, DISTANCE(1, 3));
+
+    // Below it every route goes through the gap in column 3
+    ASSERT_EQUAL(5, DISTANCE(2, 3));
+    ASSERT_EQUAL(FLOW_UP, DIRECTION(2, 3));
+    ASSERT_EQUAL(6, DISTANCE(2, 2));
+    ASSERT_EQUAL(FLOW_RIGHT, DIRECTION(2, 2));
+    ASSERT_EQUAL(8, DISTANCE(2, 0));
+    ASSERT_EQUAL(FLOW_RIGHT, DIRECTION(2, 0));
+    ASSERT_EQUAL(7, DISTANCE(3, 2));
+    ASSERT_EQUAL(FLOW_UP, DIRECTION(3, 2));
+    ASSERT_EQUAL(9, DISTANCE(3, 0));
+
+    // Holes are never entered
+    ASSERT_EQUAL(FLOW_NONE, field.cells[3][3]);
+
+    // Pixel lookups land on the cell bytes, and off the map is FLOW_NONE
+    ASSERT_EQUAL(field.cells[2][3], FLOW_FIELD_get_cell(&field, MAP_CELL_CENTER_X(3), MAP_CELL_CENTER_Y(2)));
+    ASSERT_EQUAL(FLOW_NONE, FLOW_FIELD_get_cell(&field, MAP_CELL_CENTER_X(4), MAP_CELL_CENTER_Y(0)));
+    ASSERT_EQUAL(FLOW_NONE, FLOW_FIELD_get_cell(&field, MAP_CELL_CENTER_X(0), MAP_ORIGIN_Y - 1));
+}
+
+CTEST(flow_field, test_walled_off_cells_have_no_route) {
+    clear_map(3);
+
+    // Box in the centre cell
+    wall_below(0, 1);
+    wall_below(1, 1);
+    wall_right(1, 0);
+    wall_right(1, 1);
+
+    FLOW_FIELD_compute(&field, &map, 2, 2);
+
+    ASSERT_EQUAL(FLOW_NONE, field.cells[1][1]);
+    ASSERT_EQUAL(FLOW_TARGET, DIRECTION(2, 2));
+    ASSERT_EQUAL(4, DISTANCE(0, 0));
+
+    // A wall set on one side only still blocks
+    clear_map(2);
+    map.cell_data[0][0] |= MAP_RIGHT_WALL;
+    map.cell_data[1][0] |= MAP_TOP_WALL;
+
+    FLOW_FIELD_compute(&field, &map, 0, 1);
+
+    ASSERT_EQUAL(FLOW_NONE, field.cells[0][0]);
+    ASSERT_EQUAL(FLOW_RIGHT, DIRECTION(1, 0));
+    ASSERT_EQUAL(2, DISTANCE(1, 0));
+}
+
+CTEST(flow_field, test_distance_saturates) {
+    // 8 x 8 serpentine - walls between rows, with the gap at alternating ends, so the far end is 63 cells away
+    clear_map(8);
+
+    for(int row = 0; row < 7; row ++)
+    {
+        for(int col = 0; col < 8; col ++)
+        {
+            if(col != ((row % 2 == 0) ? 7 : 0))
+                wall_below(row, col);
+        }
+    }
+
+    FLOW_FIELD_compute(&field, &map, 0, 0);
+
+    ASSERT_EQUAL(7, DISTANCE(0, 7));
+    ASSERT_EQUAL(8, DISTANCE(1, 7));
+    ASSERT_EQUAL(FLOW_UP, DIRECTION(1, 7));
+    ASSERT_EQUAL(30, DISTANCE(3, 1));
+    ASSERT_EQUAL(FLOW_FIELD_MAX_DISTANCE, DISTANCE(3, 0));
+    ASSERT_EQUAL(FLOW_FIELD_MAX_DISTANCE, DISTANCE(7, 0));
+
+    // Directions still lead along the path past the cap
+    ASSERT_EQUAL(FLOW_RIGHT, DIRECTION(7, 6));
+    ASSERT_EQUAL(FLOW_UP, DIRECTION(7, 7));
+}
@@ -0,0 +1,203 @@
+/*
+ * game_sim.c
+ *
+ * Headless game simulator. Plays the firmware's game rules (Game.c) against a virtual clock as fast as
+ * the host can run them, with the board angle and button driven by a script. When a game ends a new map
+ * is generated and play continues. Prints how the games ended, a checksum of every game's final state
+ * (so a physics or collision change that alters gameplay shows up as a different checksum) and the
+ * number of physics ticks simulated per second.
+ *
+ * Script lines are "<ms> <angle x> <angle y> <button>", in game time with angles in degrees (180 is flat).
+ * Each line holds until the next one; the script restarts with every game. Without a script the board is
+ * tilted around in slow circles with the disruptor fired every few seconds.
+ *
+ * With "autopilot" in place of the script, every game is flown by the autopilot (Autopilot.c) along its
+ * planned route, and the slowest physics tick is reported as well - for soak runs that catch gameplay and
+ * timing regressions.
+ *
+ * Usage:
+ *   game_sim [ticks] [seed] [script | autopilot]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Game.h"
+#include "Autopilot.h"
+
+#define MAX_SCRIPT_LINES 1024
+
+typedef struct {
+    uint32_t time;      // ms into the game
+    q16_t angle_x;      // Degrees
+    q16_t angle_y;
+    bool button;
+} ScriptLine_t;
+
+static ScriptLine_t script[MAX_SCRIPT_LINES];
+static int script_length;
+
+static bool load_script(const char *path)
+{
+    FILE *input = fopen(path, "r");
+    double time, angle_x, angle_y;
+    int button;
+
+    if(input == NULL)
+    {
+        perror("script");
+        return false;
+    }
+
+    while(script_length < MAX_SCRIPT_LINES && fscanf(input, "%lf %lf %lf %d", &time, &angle_x, &angle_y, &button) == 4)
+    {
+        script[script_length ++] = (ScriptLine_t){(uint32_t)time, (q16_t)(angle_x * Q16_ONE), (q16_t)(angle_y * Q16_ONE), button != 0};
+    }
+
+    fclose(input);
+
+    return script_length > 0;
+}
+
+/**
+  * @brief Board angle and button at a point in the game
+  */
+static void script_input(uint32_t time, q16_t *angle_x, q16_t *angle_y, bool *button)
+{
+    if(script_length == 0)
+    {
+        // 12 degree circles every 4 s, the disruptor held for half a second every 7 s
+        q16_t phase = Q16_FROM_RATIO(time % 4000, 4000) * 360;
+
+        *angle_x = Q16_FROM_INT(180) + 12 * SINE_TABLE_sin(phase);
+        *angle_y = Q16_FROM_INT(180) + 12 * SINE_TABLE_sin(phase + Q16_FROM_INT(90));
+        *button = (time % 7000) < 500;
+        return;
+    }
+
+    int line = 0;
+
+    while(line + 1 < script_length && script[line + 1].time <= time)
+        line ++;
+
+    *angle_x = script[line].angle_x;
+    *angle_y = script[line].angle_y;
+    *button = script[line].button;
+}
+
+static uint32_t checksum_add(uint32_t hash, uint32_t value)
+{
+    for(int i = 0; i < 4; i ++)
+    {
+        hash ^= (value >> (8 * i)) & 0xFF;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+int main(int argc, const char *argv[])
+{
+    static GameState_t game;
+    static Autopilot_t pilot;
+    long ticks = argc > 1 ? atol(argv[1]) : 2000000;
+    uint32_t state = argc > 2 ? (uint32_t)atol(argv[2]) : 1;
+    uint32_t period, hash = 2166136261u;
+    long games = 0, won = 0, holes = 0, timeouts = 0, tilts = 0, unplanned = 0;
+    bool button = false;
+    bool autopilot = argc > 3 && strcmp(argv[3], "autopilot") == 0;
+    double slowest_tick = 0;
+    struct timespec start, end, tick_start, tick_end;
+
+    if(argc > 3 && !autopilot && !load_script(argv[3]))
+        return 1;
+
+    if(state == 0)
+        state = 1;
+
+    GAME_default_config(&config);
+    GAME_init(&game, &config);
+    period = config.physics_config.update_period;
+
+    if(!MAP_create(&game.map, &config.map_config, MAP_xorshift_random, &state) || !GAME_start(&game))
+        return 1;
+
+    if(autopilot && !AUTOPILOT_plan(&pilot, &game.map, game.map.waypoint_data[0].x, game.map.waypoint_data[0].y, 0))
+        unplanned ++;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(long tick = 0; tick < ticks; tick ++)
+    {
+        q16_t angle_x, angle_y;
+        bool pressed;
+
+        if(autopilot)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &tick_start);
+            AUTOPILOT_steer(&pilot, &game, &angle_x, &angle_y);
+            pressed = false;
+        }
+        else
+        {
+            script_input(game.time, &angle_x, &angle_y, &pressed);
+        }
+
+        if(pressed != button)
+        {
+            GAME_set_button(&game, pressed);
+            button = pressed;
+        }
+
+        // Energy and the clock move on with each tick, as on the board
+        GAME_advance_energy(&game, period);
+        GAME_advance_clock(&game, period);
+        GAME_step(&game, angle_x, angle_y);
+
+        if(autopilot)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &tick_end);
+
+            double seconds = (tick_end.tv_sec - tick_start.tv_sec) + (tick_end.tv_nsec - tick_start.tv_nsec) / 1e9;
+
+            if(seconds > slowest_tick)
+                slowest_tick = seconds;
+        }
+
+        if(game.won || game.lost)
+        {
+            games ++;
+            won += game.won;
+            holes += game.fell_into_hole;
+            timeouts += game.ran_out_of_time;
+            tilts += game.exceeded_tilt;
+
+            hash = checksum_add(hash, game.time);
+            hash = checksum_add(hash, game.current_waypoint);
+            hash = checksum_add(hash, game.entities.pos_x[DRONE_ENTITY]);
+            hash = checksum_add(hash, game.entities.pos_y[DRONE_ENTITY]);
+            hash = checksum_add(hash, (game.won << 0) | (game.fell_into_hole << 1) | (game.ran_out_of_time << 2) | (game.exceeded_tilt << 3));
+
+            if(!MAP_create(&game.map, &config.map_config, MAP_xorshift_random, &state) || !GAME_start(&game))
+                return 1;
+
+            button = false;
+
+            if(autopilot && !AUTOPILOT_plan(&pilot, &game.map, game.map.waypoint_data[0].x, game.map.waypoint_data[0].y, 0))
+                unplanned ++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%ld ticks (%.1f hours of play), %ld games\n", ticks, ticks * period / 3.6e6, games);
+    printf("won %ld, fell into hole %ld, out of time %ld, exceeded tilt %ld\n", won, holes, timeouts, tilts);
+    printf("checksum %08X\n", hash);
+    printf("%.0f ticks/s (including map generation)\n", ticks / seconds);
+
+    if(autopilot)
+        printf("autopilot: %ld maps without a route, slowest tick %.1f us\n", unplanned, slowest_tick * 1e6);
+
+    return 0;
+}
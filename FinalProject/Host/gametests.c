@@ -0,0 +1,248 @@
+#include <string.h>
+#include "ctest.h"
+#include "Game.h"
+
+static GameState_t game;
+
+/**
+  * @brief Open 6 x 6 map with waypoints in cells (0, 0) and (0, 3)
+  */
+static void start_open_map(void)
+{
+    GAME_default_config(&config);
+    GAME_init(&game, &config);
+
+    memset(&game.map, 0, sizeof(game.map));
+    game.map.cell_count = 6;
+    game.map.num_waypoints = 2;
+    game.map.waypoint_data[0] = (WaypointData_t){.x = 20, .y = 60, .number = 0};
+    game.map.waypoint_data[1] = (WaypointData_t){.x = 140, .y = 60, .number = 1};
+    game.map.cell_data[0][0] = MAP_WAYPOINT;
+    game.map.cell_data[0][3] = MAP_WAYPOINT;
+    game.map.waypoint_number[0][0] = 0;
+    game.map.waypoint_number[0][3] = 1;
+
+    ASSERT_TRUE(GAME_start(&game));
+}
+
+CTEST(game, test_tilt_rolls_drone_to_waypoint) {
+    uint32_t events = 0;
+
+    start_open_map();
+
+    // Tilting the board's y angle moves the drone along screen x
+    for(int tick = 0; tick < 200 && !game.won; tick ++)
+        events |= GAME_step(&game, Q16_FROM_INT(180), Q16_FROM_INT(200));
+
+    ASSERT_TRUE(game.won);
+    ASSERT_FALSE(game.lost);
+    ASSERT_TRUE(events & GAME_EVENT_WAYPOINT_REACHED);
+    ASSERT_TRUE(events & GAME_EVENT_WON);
+}
+
+CTEST(game, test_small_tilt_counts_as_flat) {
+    start_open_map();
+
+    // angle_gain is a half, so 10 degrees on the board is 5 degrees of tilt - still flat
+    ASSERT_EQUAL(0, GAME_get_board_gravity_ratio(&game, Q16_FROM_INT(190)));
+    ASSERT_EQUAL(0, GAME_get_board_gravity_ratio(&game, Q16_FROM_INT(170)));
+
+    q16_t right = GAME_get_board_gravity_ratio(&game, Q16_FROM_INT(190) + Q16_FROM_RATIO(1, 10));
+    q16_t left = GAME_get_board_gravity_ratio(&game, Q16_FROM_INT(170) - Q16_FROM_RATIO(1, 10));
+
+    ASSERT_TRUE(right > 0);
+    ASSERT_EQUAL(-right, left);
+
+    // The pull starts from nothing at the edge - 0.05 degrees past it is no more than sin(0.1 degrees) of gravity
+    ASSERT_TRUE(right <= FIXED_mul(SINE_TABLE_sin(Q16_FROM_RATIO(1, 10)), game.gravity_gain));
+
+    // Held just inside the dead zone the drone stays on its waypoint
+    q16_t x = game.entities.pos_x[DRONE_ENTITY];
+    q16_t y = game.entities.pos_y[DRONE_ENTITY];
+
+    for(int tick = 0; tick < 100; tick ++)
+        GAME_step(&game, Q16_FROM_INT(170), Q16_FROM_INT(190));
+
+    ASSERT_EQUAL(x, game.entities.pos_x[DRONE_ENTITY]);
+    ASSERT_EQUAL(y, game.entities.pos_y[DRONE_ENTITY]);
+    ASSERT_FALSE(game.lost);
+}
+
+CTEST(game, test_clock_stops_once_game_is_over) {
+    start_open_map();
+
+    for(int tick = 0; tick < 200 && !game.won; tick ++)
+        GAME_step(&game, Q16_FROM_INT(180), Q16_FROM_INT(200));
+
+    ASSERT_TRUE(game.won);
+    uint32_t time = game.time;
+
+    // Time running out after a win doesn't turn it into a loss, or end the game a second time
+    ASSERT_EQUAL(0, GAME_advance_clock(&game, config.game_config.time_to_complete));
+    ASSERT_FALSE(game.lost);
+    ASSERT_FALSE(game.ran_out_of_time);
+    ASSERT_EQUAL(time, game.time);
+
+    // Nor does a lost game report it again
+    ASSERT_TRUE(GAME_start(&game));
+    ASSERT_EQUAL(GAME_EVENT_LOST, GAME_advance_clock(&game, config.game_config.time_to_complete));
+    ASSERT_EQUAL(0, GAME_advance_clock(&game, 1));
+}
+
+CTEST(game, test_start_rejects_what_the_mask_cannot_cover) {
+    start_open_map();
+
+    // A 40 pixel drone reaches 20 + 2 * (2 + 1) + 1 = 27 pixels in a tick - fits
+    config.drone_config.diameter = 40;
+    ASSERT_TRUE(GAME_start(&game));
+
+    // 50 pixels reaches 32 - the broadphase would skip walls and holes it can hit
+    config.drone_config.diameter = 50;
+    ASSERT_FALSE(GAME_start(&game));
+
+    // So does a fast drone
+    config.drone_config.diameter = 10;
+    config.drone_config.max_velocity = 13000;
+    ASSERT_FALSE(GAME_start(&game));
+
+    // Holes drawn bigger than the mask's largest disk
+    config.drone_config.max_velocity = 2500;
+    config.map_config.hole_radius = COLLISION_MASK_MAX_RADIUS + 1;
+    ASSERT_FALSE(GAME_start(&game));
+
+    GAME_default_config(&config);
+}
+
+CTEST(game, test_validate_config_passes_only_what_the_firmware_can_play) {
+    struct ConfigData_t saved;
+
+    GAME_default_config(&saved);
+    ASSERT_TRUE(GAME_validate_config(&saved));
+
+    // Saved by a build with another layout
+    saved.version = CONFIG_VERSION + 1;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+
+    // Maps the screen and the level pack aren't laid out for
+    GAME_default_config(&saved);
+    saved.map_config.cell_count = 5;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+    saved.map_config.cell_count = MAP_MAX_CELL_COUNT + 1;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+
+    // No time between physics ticks
+    GAME_default_config(&saved);
+    saved.physics_config.update_period = 0;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+    saved.physics_config.update_period = 1;
+    ASSERT_TRUE(GAME_validate_config(&saved));
+
+    GAME_default_config(&saved);
+    saved.map_config.num_waypoints = 0;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+    saved.map_config.num_waypoints = GAME_MAP_MAX_WAYPOINTS + 1;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+
+    // What GAME_start would reject - a hole or drone reach past the mask's largest disk
+    GAME_default_config(&saved);
+    saved.map_config.hole_radius = COLLISION_MASK_MAX_RADIUS + 1;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+
+    GAME_default_config(&saved);
+    saved.drone_config.diameter = 40;
+    ASSERT_TRUE(GAME_validate_config(&saved));
+    saved.drone_config.diameter = 50;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+    saved.drone_config.diameter = UINT32_MAX;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+
+    GAME_default_config(&saved);
+    saved.drone_config.max_velocity = 13000;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+    saved.drone_config.max_velocity = -1;
+    ASSERT_FALSE(GAME_validate_config(&saved));
+}
+
+CTEST(game, test_hole_loses_unless_disruptor_active) {
+    start_open_map();
+    game.map.cell_data[0][1] = MAP_HOLE;
+    ASSERT_TRUE(GAME_start(&game));
+
+    for(int tick = 0; tick < 200 && !game.lost; tick ++)
+        GAME_step(&game, Q16_FROM_INT(180), Q16_FROM_INT(200));
+
+    ASSERT_TRUE(game.lost);
+    ASSERT_TRUE(game.fell_into_hole);
+
+    // Flying over it with the disruptor
+    ASSERT_TRUE(GAME_start(&game));
+    GAME_set_button(&game, true);
+
+    for(int tick = 0; tick < 200 && !game.won && !game.lost; tick ++)
+        GAME_step(&game, Q16_FROM_INT(180), Q16_FROM_INT(200));
+
+    ASSERT_TRUE(game.won);
+}
+
+CTEST(game, test_time_limit_and_tilt_limit) {
+    start_open_map();
+
+    ASSERT_EQUAL(0, GAME_advance_clock(&game, config.game_config.time_to_complete - 1));
+    ASSERT_EQUAL(GAME_EVENT_LOST, GAME_advance_clock(&game, 1));
+    ASSERT_TRUE(game.ran_out_of_time);
+
+    // Stepping does nothing once the game is over
+    ASSERT_EQUAL(0, GAME_step(&game, Q16_FROM_INT(180), Q16_FROM_INT(200)));
+
+    // angle_gain halves the board angle, so 150 degrees of tilt is past the limit
+    ASSERT_TRUE(GAME_start(&game));
+    ASSERT_TRUE(GAME_step(&game, Q16_FROM_INT(180 + 150), Q16_FROM_INT(180)) & GAME_EVENT_LOST);
+    ASSERT_TRUE(game.exceeded_tilt);
+}
+
+CTEST(game, test_energy_locks_and_unlocks_disruptor) {
+    uint32_t events = 0;
+
+    start_open_map();
+    GAME_set_button(&game, true);
+    ASSERT_TRUE(game.disruptor_active);
+
+    // 100 mJ per drain - 15000 mJ runs out after 150
+    for(int i = 0; i < 150; i ++)
+        events |= GAME_drain_energy(&game);
+
+    ASSERT_EQUAL(0, game.drone_energy);
+    ASSERT_TRUE(events & GAME_EVENT_ENERGY_EMPTY);
+    ASSERT_TRUE(events & GAME_EVENT_DISRUPTOR_LOCKED);
+    ASSERT_FALSE(game.disruptor_can_be_activated);
+
+    GAME_set_button(&game, false);
+    GAME_set_button(&game, true);
+    ASSERT_FALSE(game.disruptor_active);
+
+    // 10 mJ per recharge - back to the 6000 mJ minimum after 600
+    GAME_set_button(&game, false);
+    for(int i = 0; i < 599; i ++)
+        ASSERT_FALSE(GAME_recharge_energy(&game) & GAME_EVENT_DISRUPTOR_READY);
+
+    ASSERT_TRUE(GAME_recharge_energy(&game) & GAME_EVENT_DISRUPTOR_READY);
+    ASSERT_TRUE(game.disruptor_can_be_activated);
+}
+
+CTEST(game, test_energy_advances_with_the_tick) {
+    start_open_map();
+
+    // One drain or recharge per GAME_ENERGY_PERIOD of the tick, whichever the button asks for
+    GAME_set_button(&game, true);
+    ASSERT_EQUAL(0, GAME_advance_energy(&game, 5 * GAME_ENERGY_PERIOD));
+    ASSERT_EQUAL(15000 - (5 * 100), game.drone_energy);
+
+    GAME_set_button(&game, false);
+    GAME_advance_energy(&game, 5 * GAME_ENERGY_PERIOD);
+    ASSERT_EQUAL(15000 - (5 * 100) + (5 * 10), game.drone_energy);
+
+    // Over once the game is
+    game.lost = true;
+    ASSERT_EQUAL(0, GAME_advance_energy(&game, 5 * GAME_ENERGY_PERIOD));
+    ASSERT_EQUAL(15000 - (5 * 100) + (5 * 10), game.drone_energy);
+}
@@ -0,0 +1,216 @@
+#include <stdlib.h>
+#include <string.h>
+#include "ctest.h"
+#include "GyroRate.h"
+
+static GyroRate_t axis;
+
+/**
+  * @brief Noise that averages to zero over a window - a fixed sequence, so the tests don't depend on rand
+  */
+static int16_t noise(int n)
+{
+    static const int8_t pattern[8] = {3, -12, 7, 12, -5, -9, 11, -7};
+
+    return pattern[n % 8];
+}
+
+/**
+  * @brief Feeds samples through the axis in batches and returns the sum of the corrected samples.
+  *        Each sample is offset + rate plus noise, with offset in 1/100 counts.
+  */
+static int64_t feed(int count, int32_t offset_hundredths, int32_t rate, int batch)
+{
+    static int n;
+    int16_t samples[64];
+    int64_t sum = 0;
+
+    for(int done = 0; done < count; done += batch)
+    {
+        int size = (count - done < batch) ? count - done : batch;
+
+        for(int i = 0; i < size; i ++, n ++)
+        {
+            // Offsets a fraction of a count out show up as whole counts now and then, like the real thing
+            int32_t exact = (offset_hundredths * (n + 1)) / 100 - (offset_hundredths * n) / 100;
+
+            samples[i] = exact + rate + noise(n);
+        }
+
+        GYRO_RATE_correct(&axis, samples, size);
+
+        for(int i = 0; i < size; i ++)
+            sum += samples[i];
+    }
+
+    return sum;
+}
+
+/**
+  * @brief The board being moved about - a swing far wider than the noise
+  */
+static void shake(int count)
+{
+    int16_t samples[1];
+
+    for(int i = 0; i < count; i ++)
+    {
+        samples[0] = (i % 16) < 8 ? 500 : -500;
+        GYRO_RATE_correct(&axis, samples, 1);
+    }
+}
+
+CTEST(gyro_rate, test_calibrates_on_still_samples) {
+    GYRO_RATE_init(&axis);
+
+    // Reads zero until calibrated
+    ASSERT_EQUAL(0, feed(GYRO_RATE_CALIBRATION_WINDOWS * GYRO_RATE_WINDOW - 1, 13725, 0, 10));
+    ASSERT_FALSE(axis.calibrated);
+
+    feed(1, 13725, 0, 1);
+    ASSERT_TRUE(axis.calibrated);
+    ASSERT_EQUAL(0, axis.restarts);
+
+    // 137.25 counts - the average of the calibration samples, to within the noise pattern's average
+    ASSERT_DBL_NEAR_TOL(137.25, axis.bias / 65536.0, 0.05);
+
+    // Still samples come out as noise around zero, and sum to nothing over time
+    int64_t sum = feed(1900, 13725, 0, 10);
+
+    ASSERT_TRUE(llabs(sum) < 100);
+}
+
+CTEST(gyro_rate, test_movement_restarts_calibration) {
+    GYRO_RATE_init(&axis);
+
+    feed(2 * GYRO_RATE_WINDOW, -4000, 0, 16);
+
+    // Picked up and moved - the windows that had been collected are thrown away
+    shake(GYRO_RATE_WINDOW);
+    ASSERT_EQUAL(1, axis.restarts);
+    ASSERT_FALSE(axis.calibrated);
+
+    feed(GYRO_RATE_CALIBRATION_WINDOWS * GYRO_RATE_WINDOW, -4000, 0, 16);
+    ASSERT_TRUE(axis.calibrated);
+    ASSERT_DBL_NEAR_TOL(-40.0, axis.bias / 65536.0, 0.05);
+}
+
+CTEST(gyro_rate, test_tracks_drift_but_not_turns) {
+    GYRO_RATE_init(&axis);
+
+    feed(GYRO_RATE_CALIBRATION_WINDOWS * GYRO_RATE_WINDOW, 2000, 0, 10);
+
+    // The offset creeps up 10 counts as the sensor warms - the bias follows it
+    for(int step = 1; step <= 10; step ++)
+        feed(8 * GYRO_RATE_WINDOW, 2000 + (step * 100), 0, 10);
+
+    feed(32 * GYRO_RATE_WINDOW, 3000, 0, 10);
+    ASSERT_DBL_NEAR_TOL(30.0, axis.bias / 65536.0, 0.1);
+    uint32_t updates = axis.updates;
+
+    // A slow steady turn is smooth enough to look still, but too far off the bias to be taken for it
+    int64_t turned = feed(40 * GYRO_RATE_WINDOW, 3000, GYRO_RATE_TRACK_LIMIT + 6, 10);
+
+    ASSERT_EQUAL(updates, axis.updates);
+    ASSERT_DBL_NEAR_TOL(30.0, axis.bias / 65536.0, 0.5);
+    ASSERT_DBL_NEAR_TOL((GYRO_RATE_TRACK_LIMIT + 6) * 40.0 * GYRO_RATE_WINDOW, (double)turned, 40.0 * GYRO_RATE_WINDOW * 0.5);
+
+    // Moving about doesn't move the bias
+    shake(10 * GYRO_RATE_WINDOW);
+    ASSERT_EQUAL(updates, axis.updates);
+}
+
+CTEST(gyro_rate, test_fractional_bias_is_carried) {
+    int16_t samples[40];
+
+    GYRO_RATE_init(&axis);
+    axis.calibrated = true;
+    axis.bias = 65536 / 4; // A quarter of a count
+
+    // Swinging either side of zero, so the windows aren't still and the bias stays put. Each corrected
+    // sample is a quarter count low, which rounds away on its own - carried, it adds up to a count every four.
+    int64_t sum = 0;
+
+    for(int batch = 0; batch < 10; batch ++)
+    {
+        for(int i = 0; i < 40; i ++)
+            samples[i] = (i % 2) ? 100 : -100;
+
+        GYRO_RATE_correct(&axis, samples, 40);
+
+        for(int i = 0; i < 40; i ++)
+            sum += samples[i];
+    }
+
+    ASSERT_EQUAL(-100, sum);
+}
+
+CTEST(gyro_rate, test_scale_carries_remainder) {
+    GYRO_RATE_init(&axis);
+
+    // 7 * 1000 / 3800 is 1.84 - rounding each batch on its own would give 2 every time
+    int32_t total = 0;
+
+    for(int i = 0; i < 3800; i ++)
+        total += GYRO_RATE_scale(&axis, 7, 1000, 3800);
+
+    ASSERT_EQUAL(7000, total);
+
+    // The same samples drained in batches of 5 and of 20 integrate to the same rate
+    GyroRate_t fine, coarse;
+    int32_t fine_total = 0, coarse_total = 0;
+
+    GYRO_RATE_init(&fine);
+    GYRO_RATE_init(&coarse);
+
+    for(int i = 0; i < 1000; i ++)
+    {
+        fine_total += GYRO_RATE_scale(&fine, -37, 1000, 3800);
+
+        if(i % 4 == 3)
+            coarse_total += GYRO_RATE_scale(&coarse, -4 * 37, 1000, 3800);
+    }
+
+    ASSERT_EQUAL(fine_total, coarse_total);
+    ASSERT_EQUAL(-9737, fine_total);
+
+    // Out of range saturates without winding up a remainder
+    ASSERT_EQUAL(INT16_MAX, GYRO_RATE_scale(&axis, INT32_MAX / 1000, 1000, 1));
+    ASSERT_EQUAL(0, axis.remainder);
+}
+
+CTEST(gyro_rate, test_calibration_falls_back_to_quietest_window) {
+    int16_t samples[GYRO_RATE_WINDOW];
+
+    GYRO_RATE_init(&axis);
+
+    // Never still - every window swings wider than the still band. The wider the swing the further its mean is
+    // off the 50 count offset, so only the quietest window's mean is the offset.
+    for(int window = 0; window < GYRO_RATE_CALIBRATION_TIMEOUT; window ++)
+    {
+        int amplitude = (window == 5) ? GYRO_RATE_STILL_BAND / 2 + 1 : GYRO_RATE_STILL_BAND / 2 + 10 + window;
+        int shift = amplitude - (GYRO_RATE_STILL_BAND / 2 + 1);
+
+        ASSERT_FALSE(axis.calibrated);
+
+        for(int i = 0; i < GYRO_RATE_WINDOW; i ++)
+            samples[i] = 50 + shift + ((i % 16) < 8 ? amplitude : -amplitude);
+
+        GYRO_RATE_correct(&axis, samples, GYRO_RATE_WINDOW);
+    }
+
+    ASSERT_TRUE(axis.calibrated);
+    ASSERT_TRUE(axis.timed_out);
+    ASSERT_DBL_NEAR_TOL(50.0, axis.bias / 65536.0, 0.01);
+
+    // Once still, tracking takes over as usual
+    feed(32 * GYRO_RATE_WINDOW, 5200, 0, 16);
+    ASSERT_TRUE(axis.updates > 0);
+    ASSERT_DBL_NEAR_TOL(52.0, axis.bias / 65536.0, 0.1);
+
+    // A board that does keep still calibrates the usual way
+    GYRO_RATE_init(&axis);
+    feed(GYRO_RATE_CALIBRATION_WINDOWS * GYRO_RATE_WINDOW, 5000, 0, 16);
+    ASSERT_TRUE(axis.calibrated);
+    ASSERT_FALSE(axis.timed_out);
+}
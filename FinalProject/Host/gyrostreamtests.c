@@ -0,0 +1,359 @@
+#include <string.h>
+#include "ctest.h"
+#include "GyroStream.h"
+
+// Stand-in for the L3GD20 on SPI with DMA - queues samples in a FIFO and raises the watermark interrupt on its
+// rising edge. A burst takes the samples out of the FIFO as it starts, and the level read answers with the
+// level when the test completes the DMA.
+typedef struct {
+    GyroSample_t fifo[GYRO_FIFO_DEPTH];
+    uint8_t level;
+    bool overrun;
+    uint8_t watermark;
+
+    bool selected;
+    bool busy;                  // DMA transfer in flight
+    const uint8_t *tx;
+    uint8_t *rx;
+    uint16_t size;
+    int fail_starts;            // Transfers to refuse before taking one again
+
+    uint32_t overlaps;          // Transfers started while one was in flight, or without the chip selected
+    uint32_t notifications;
+} FakeGyro_t;
+
+static FakeGyro_t gyro;
+static GyroStream_t stream;
+
+static bool fake_start_transfer(void *context, const uint8_t *tx, uint8_t *rx, uint16_t size)
+{
+    FakeGyro_t *device = context;
+
+    if(device->busy || !device->selected)
+        device->overlaps ++;
+
+    if(device->fail_starts > 0)
+    {
+        device->fail_starts --;
+        return false;
+    }
+
+    device->busy = true;
+    device->tx = tx;
+    device->rx = rx;
+    device->size = size;
+
+    if(tx[0] == GYRO_STREAM_SAMPLES_COMMAND)
+    {
+        uint8_t count = (size - 1) / GYRO_SAMPLE_SIZE;
+
+        if(count > device->level)
+            count = device->level;
+
+        for(uint8_t i = 0; i < count; i ++)
+        {
+            uint8_t *data = &rx[1 + (i * GYRO_SAMPLE_SIZE)];
+
+            data[0] = device->fifo[i].x & 0xFF;
+            data[1] = (uint16_t)device->fifo[i].x >> 8;
+            data[2] = device->fifo[i].y & 0xFF;
+            data[3] = (uint16_t)device->fifo[i].y >> 8;
+            data[4] = device->fifo[i].z & 0xFF;
+            data[5] = (uint16_t)device->fifo[i].z >> 8;
+        }
+
+        memmove(device->fifo, &device->fifo[count], (device->level - count) * sizeof(GyroSample_t));
+        device->level -= count;
+        device->overrun = false;
+    }
+
+    return true;
+}
+
+static void fake_chip_select(void *context, bool selected)
+{
+    ((FakeGyro_t *)context)->selected = selected;
+}
+
+static bool fake_watermark_pending(void *context)
+{
+    FakeGyro_t *device = context;
+
+    return device->level >= device->watermark;
+}
+
+static void fake_notify(void *context)
+{
+    ((FakeGyro_t *)context)->notifications ++;
+}
+
+static const GyroStreamPort_t fake_port = {
+    .start_transfer = fake_start_transfer,
+    .chip_select = fake_chip_select,
+    .watermark_pending = fake_watermark_pending,
+    .notify = fake_notify,
+    .context = &gyro
+};
+
+/**
+  * @brief Sets up the stand-in and a stream on it
+  */
+static void setup(uint8_t watermark)
+{
+    memset(&gyro, 0, sizeof(gyro));
+    gyro.watermark = watermark;
+    GYRO_STREAM_init(&stream, &fake_port);
+}
+
+/**
+  * @brief The gyro takes a sample - the oldest is overwritten when the FIFO is full
+  */
+static void push_sample(int16_t value)
+{
+    if(gyro.level == GYRO_FIFO_DEPTH)
+    {
+        memmove(gyro.fifo, &gyro.fifo[1], (GYRO_FIFO_DEPTH - 1) * sizeof(GyroSample_t));
+        gyro.level --;
+        gyro.overrun = true;
+    }
+
+    gyro.fifo[gyro.level ++] = (GyroSample_t){.x = value, .y = -value, .z = value / 2};
+
+    if(gyro.level == gyro.watermark)
+        GYRO_STREAM_on_watermark(&stream);
+}
+
+/**
+  * @brief The DMA transfer in flight finishes - the gyro answers the command and the interrupt fires
+  */
+static void complete_transfer(void)
+{
+    ASSERT_TRUE(gyro.busy);
+    ASSERT_TRUE(gyro.selected);
+
+    gyro.busy = false;
+    gyro.rx[0] = 0;
+
+    if(gyro.tx[0] == GYRO_STREAM_LEVEL_COMMAND)
+    {
+        ASSERT_EQUAL(2, gyro.size);
+        gyro.rx[1] = (gyro.level >= gyro.watermark ? GYRO_FIFO_WATERMARK : 0) | (gyro.overrun ? GYRO_FIFO_OVERRUN : 0) |
+                     (gyro.level == 0 ? GYRO_FIFO_EMPTY : 0) | (gyro.level & GYRO_FIFO_LEVEL_MASK);
+    }
+    else
+    {
+        ASSERT_EQUAL(GYRO_STREAM_SAMPLES_COMMAND, gyro.tx[0]);
+        ASSERT_EQUAL(0, (gyro.size - 1) % GYRO_SAMPLE_SIZE);
+    }
+
+    GYRO_STREAM_on_transfer_complete(&stream);
+}
+
+CTEST(gyro_stream, test_reads_samples_on_watermark) {
+    GyroSample_t samples[GYRO_FIFO_DEPTH];
+
+    setup(10);
+
+    // Nothing happens below the watermark
+    for(int i = 0; i < 9; i ++)
+        push_sample(-300 + (i * 70));
+
+    ASSERT_FALSE(gyro.busy);
+
+    // Level, then every sample in one burst
+    push_sample(330);
+    ASSERT_EQUAL(GYRO_STREAM_READING_LEVEL, stream.state);
+    complete_transfer();
+    ASSERT_EQUAL(GYRO_STREAM_READING_SAMPLES, stream.state);
+    ASSERT_EQUAL(0, gyro.notifications);
+    complete_transfer();
+
+    ASSERT_EQUAL(GYRO_STREAM_IDLE, stream.state);
+    ASSERT_FALSE(gyro.selected);
+    ASSERT_EQUAL(1, gyro.notifications);
+    ASSERT_EQUAL(2, stream.transfers);
+    ASSERT_EQUAL(0, gyro.overlaps);
+
+    ASSERT_EQUAL(10, GYRO_STREAM_take(&stream, samples, GYRO_FIFO_DEPTH));
+
+    for(int i = 0; i < 10; i ++)
+    {
+        int16_t value = -300 + (i * 70);
+
+        ASSERT_EQUAL(value, samples[i].x);
+        ASSERT_EQUAL(-value, samples[i].y);
+        ASSERT_EQUAL(value / 2, samples[i].z);
+    }
+
+    ASSERT_EQUAL(0, GYRO_STREAM_take(&stream, samples, GYRO_FIFO_DEPTH));
+}
+
+CTEST(gyro_stream, test_samples_during_a_transfer_are_read_next) {
+    GyroSample_t samples[GYRO_FIFO_DEPTH];
+
+    setup(4);
+
+    for(int i = 0; i < 4; i ++)
+        push_sample(i);
+
+    complete_transfer();
+
+    // The FIFO fills back past the watermark while the burst runs - its edge is caught by the stream
+    for(int i = 4; i < 8; i ++)
+        push_sample(i);
+
+    ASSERT_TRUE(stream.pending);
+    complete_transfer();
+    ASSERT_EQUAL(GYRO_STREAM_READING_LEVEL, stream.state);
+
+    // Three more while the level is read - all seven come out in the burst, and the level is back under
+    // the watermark so the stream goes idle
+    for(int i = 8; i < 11; i ++)
+        push_sample(i);
+
+    complete_transfer();
+    complete_transfer();
+
+    ASSERT_EQUAL(GYRO_STREAM_IDLE, stream.state);
+    ASSERT_EQUAL(0, gyro.level);
+    ASSERT_EQUAL(2, gyro.notifications);
+    ASSERT_EQUAL(0, gyro.overlaps);
+
+    ASSERT_EQUAL(11, GYRO_STREAM_take(&stream, samples, GYRO_FIFO_DEPTH));
+
+    for(int i = 0; i < 11; i ++)
+        ASSERT_EQUAL(i, samples[i].x);
+
+    // An edge that was missed - the line still being high after a read starts the next one
+    for(int i = 0; i < 4; i ++)
+        push_sample(i);
+
+    complete_transfer();
+
+    for(int i = 4; i < 8; i ++)
+        push_sample(i);
+
+    stream.pending = false;
+    complete_transfer();
+
+    ASSERT_EQUAL(GYRO_STREAM_READING_LEVEL, stream.state);
+}
+
+CTEST(gyro_stream, test_overrun_and_slow_consumer) {
+    GyroSample_t samples[GYRO_FIFO_DEPTH];
+
+    setup(10);
+
+    // The level read is held up long enough for the FIFO to overrun
+    for(int i = 0; i < 40; i ++)
+        push_sample(i);
+
+    complete_transfer();
+    complete_transfer();
+
+    ASSERT_EQUAL(1, stream.overruns);
+    ASSERT_EQUAL(GYRO_FIFO_DEPTH, stream.sample_count);
+
+    // Nothing taken - the next batch has no room
+    for(int i = 40; i < 50; i ++)
+        push_sample(i);
+
+    complete_transfer();
+    complete_transfer();
+
+    ASSERT_EQUAL(10, stream.lost);
+    ASSERT_EQUAL(2, gyro.notifications);
+
+    // Oldest kept first - the 8 overwritten in the gyro are gone, a partial take keeps the rest in order
+    ASSERT_EQUAL(5, GYRO_STREAM_take(&stream, samples, 5));
+    ASSERT_EQUAL(8, samples[0].x);
+    ASSERT_EQUAL(GYRO_FIFO_DEPTH - 5, GYRO_STREAM_take(&stream, samples, GYRO_FIFO_DEPTH));
+    ASSERT_EQUAL(13, samples[0].x);
+    ASSERT_EQUAL(39, samples[GYRO_FIFO_DEPTH - 6].x);
+}
+
+CTEST(gyro_stream, test_recovers_from_transfer_errors) {
+    GyroSample_t samples[GYRO_FIFO_DEPTH];
+
+    setup(5);
+
+    // The level read can't be started
+    gyro.fail_starts = 1;
+
+    for(int i = 0; i < 5; i ++)
+        push_sample(i);
+
+    ASSERT_EQUAL(1, stream.errors);
+    ASSERT_EQUAL(GYRO_STREAM_IDLE, stream.state);
+    ASSERT_FALSE(gyro.selected);
+
+    // The line is still high, so the next sample's interrupt reads them all
+    push_sample(5);
+    GYRO_STREAM_on_watermark(&stream);
+    complete_transfer();
+    complete_transfer();
+    ASSERT_EQUAL(6, GYRO_STREAM_take(&stream, samples, GYRO_FIFO_DEPTH));
+    ASSERT_EQUAL(5, samples[5].x);
+
+    // The burst fails on the bus - its samples are gone, and the stream waits for the next watermark
+    for(int i = 10; i < 15; i ++)
+        push_sample(i);
+
+    complete_transfer();
+    ASSERT_EQUAL(GYRO_STREAM_READING_SAMPLES, stream.state);
+
+    gyro.busy = false;
+    GYRO_STREAM_on_transfer_error(&stream);
+    ASSERT_EQUAL(2, stream.errors);
+    ASSERT_EQUAL(GYRO_STREAM_IDLE, stream.state);
+    ASSERT_FALSE(gyro.selected);
+
+    for(int i = 20; i < 25; i ++)
+        push_sample(i);
+
+    complete_transfer();
+    complete_transfer();
+
+    ASSERT_EQUAL(5, GYRO_STREAM_take(&stream, samples, GYRO_FIFO_DEPTH));
+    ASSERT_EQUAL(20, samples[0].x);
+    ASSERT_EQUAL(0, gyro.overlaps);
+}
+
+CTEST(gyro_stream, test_failed_starts_wait_for_a_poll) {
+    GyroSample_t samples[GYRO_FIFO_DEPTH];
+
+    setup(5);
+
+    // Every start fails for a while - the level read is left pending instead of retried from the interrupt
+    gyro.fail_starts = 1000;
+
+    for(int i = 0; i < 5; i ++)
+        push_sample(i);
+
+    ASSERT_EQUAL(1, stream.errors);
+    ASSERT_TRUE(stream.pending);
+    ASSERT_EQUAL(GYRO_STREAM_IDLE, stream.state);
+
+    // The line stays high, so there is no edge to retry from - each poll tries once more
+    push_sample(5);
+    GYRO_STREAM_poll(&stream);
+    GYRO_STREAM_poll(&stream);
+    ASSERT_EQUAL(3, stream.errors);
+    ASSERT_EQUAL(1000 - 3, gyro.fail_starts);
+    ASSERT_FALSE(gyro.selected);
+
+    // Once a start goes through the read catches up
+    gyro.fail_starts = 0;
+    GYRO_STREAM_poll(&stream);
+    complete_transfer();
+    complete_transfer();
+
+    ASSERT_EQUAL(6, GYRO_STREAM_take(&stream, samples, GYRO_FIFO_DEPTH));
+    ASSERT_EQUAL(5, samples[5].x);
+    ASSERT_FALSE(stream.pending);
+
+    // Nothing to read - a poll starts nothing
+    GYRO_STREAM_poll(&stream);
+    ASSERT_EQUAL(GYRO_STREAM_IDLE, stream.state);
+    ASSERT_EQUAL(0, gyro.overlaps);
+}
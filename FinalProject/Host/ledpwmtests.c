@@ -0,0 +1,220 @@
+#include <string.h>
+#include <stdbool.h>
+#include "ctest.h"
+#include "LedPwm.h"
+
+#define GREEN_PIN 0x2000
+#define RED_PIN 0x4000
+
+// Model of the timer - a free running 16 bit counter with a compare register and interrupt enable per channel,
+// and the GPIO output register the leds are on
+typedef struct {
+    uint16_t counter;
+    uint16_t compare[LED_PWM_CHANNELS];
+    bool enabled[LED_PWM_CHANNELS];
+    uint32_t output;
+    int writes;
+    bool locked;
+
+    // Measured while running
+    uint32_t on_ticks[LED_PWM_CHANNELS];
+    uint32_t edges[LED_PWM_CHANNELS];
+} FakeTimer_t;
+
+static FakeTimer_t timer;
+static LedPwm_t pwm;
+
+static const uint16_t pins[LED_PWM_CHANNELS] = {GREEN_PIN, RED_PIN};
+
+static void fake_write(void *context, uint32_t bsrr)
+{
+    (void) &context;
+
+    timer.output |= bsrr & 0xFFFF;
+    timer.output &= ~(bsrr >> 16);
+    timer.writes ++;
+}
+
+static void fake_start(void *context, uint8_t channel, uint16_t delay)
+{
+    (void) &context;
+    ASSERT_TRUE(timer.locked);
+
+    timer.compare[channel] = timer.counter + delay;
+    timer.enabled[channel] = true;
+}
+
+static void fake_stop(void *context, uint8_t channel)
+{
+    (void) &context;
+    ASSERT_TRUE(timer.locked);
+
+    timer.enabled[channel] = false;
+}
+
+static uint32_t fake_lock(void *context)
+{
+    (void) &context;
+    timer.locked = true;
+
+    return 0;
+}
+
+static void fake_unlock(void *context, uint32_t state)
+{
+    (void) &context;
+    (void) state;
+    timer.locked = false;
+}
+
+static void start(void)
+{
+    LedPwmPort_t port = {
+        .write = fake_write,
+        .start = fake_start,
+        .stop = fake_stop,
+        .lock = fake_lock,
+        .unlock = fake_unlock,
+        .context = NULL
+    };
+
+    memset(&timer, 0, sizeof(timer));
+    timer.counter = 60000; // Wraps early on
+    LED_PWM_init(&pwm, &port, GREEN_PIN, RED_PIN);
+}
+
+/**
+  * @brief Runs the timer - each tick the counter moves on, a matching compare interrupt is taken and reloaded
+  *        the way the handler does, then the pins are sampled
+  */
+static void run(uint32_t ticks)
+{
+    memset(timer.on_ticks, 0, sizeof(timer.on_ticks));
+
+    for(uint32_t t = 0; t < ticks; t ++)
+    {
+        timer.counter ++;
+
+        for(uint8_t channel = 0; channel < LED_PWM_CHANNELS; channel ++)
+        {
+            if(timer.enabled[channel] && timer.counter == timer.compare[channel])
+            {
+                uint32_t before = timer.output & pins[channel];
+
+                timer.compare[channel] += LED_PWM_on_compare(&pwm, channel);
+                timer.edges[channel] += (timer.output & pins[channel]) != before;
+            }
+        }
+
+        for(uint8_t channel = 0; channel < LED_PWM_CHANNELS; channel ++)
+            timer.on_ticks[channel] += (timer.output & pins[channel]) != 0;
+    }
+}
+
+CTEST(led_pwm, test_green_duty_levels) {
+    // 100 ms is ten green periods
+    for(uint8_t level = 0; level <= LED_PWM_GREEN_LEVELS; level ++)
+    {
+        start();
+        LED_PWM_set_level(&pwm, level);
+        run(LED_PWM_MS(100));
+
+        ASSERT_EQUAL(level * LED_PWM_MS(10), timer.on_ticks[LED_PWM_GREEN]);
+        ASSERT_EQUAL(0, timer.on_ticks[LED_PWM_RED]);
+
+        // Woken only at the edges - two a period, none when the led is held on or off
+        bool steady = level == 0 || level == LED_PWM_GREEN_LEVELS;
+
+        ASSERT_EQUAL(steady ? 0 : 20, pwm.wakeups);
+        ASSERT_EQUAL(steady ? 0 : 20, timer.edges[LED_PWM_GREEN]);
+        ASSERT_EQUAL(steady, !timer.enabled[LED_PWM_GREEN]);
+    }
+}
+
+CTEST(led_pwm, test_red_blink) {
+    start();
+
+    // On for the first half of the period, the odd tick off
+    LED_PWM_set_blink(&pwm, 7);
+    run(7 * 100);
+    ASSERT_EQUAL(3 * 100, timer.on_ticks[LED_PWM_RED]);
+    ASSERT_EQUAL(200, pwm.wakeups);
+
+    // A slow blink - still two wake ups a blink
+    start();
+    LED_PWM_set_blink(&pwm, LED_PWM_MS(600));
+    run(LED_PWM_MS(600) * 5);
+    ASSERT_EQUAL(LED_PWM_MS(300) * 5, timer.on_ticks[LED_PWM_RED]);
+    ASSERT_EQUAL(10, pwm.wakeups);
+
+    // Too short to blink - off
+    LED_PWM_set_blink(&pwm, 1);
+    ASSERT_FALSE(timer.enabled[LED_PWM_RED]);
+    run(100);
+    ASSERT_EQUAL(0, timer.on_ticks[LED_PWM_RED]);
+}
+
+CTEST(led_pwm, test_both_leds_over_a_game) {
+    start();
+
+    // One second with the energy draining - the level and blink rate are set every 10 ms like the disruptor
+    // task does, but the tables only change when they do. The old timer callbacks woke up 2000 times a second.
+    uint32_t green_on = 0, red_on = 0;
+
+    for(int step = 0; step < 100; step ++)
+    {
+        uint8_t level = 6 - (step / 20);
+        uint16_t period = (step < 50) ? 0 : LED_PWM_MS(100 - step);
+
+        LED_PWM_set_level(&pwm, level);
+        LED_PWM_set_blink(&pwm, period);
+
+        if(step == 10)
+        {
+            // Setting what is already set doesn't touch the pins or the timer
+            int writes = timer.writes;
+            uint16_t compare = timer.compare[LED_PWM_GREEN];
+
+            LED_PWM_set_level(&pwm, level);
+            LED_PWM_set_blink(&pwm, period);
+            ASSERT_EQUAL(writes, timer.writes);
+            ASSERT_EQUAL(compare, timer.compare[LED_PWM_GREEN]);
+        }
+
+        run(LED_PWM_MS(10));
+
+        green_on += timer.on_ticks[LED_PWM_GREEN];
+        red_on += timer.on_ticks[LED_PWM_RED];
+    }
+
+    // 20 steps at each of 6, 5, 4, 3, 2 tenths - each change lands at the next edge, so the four changes may
+    // each be up to a tenth of a period out
+    ASSERT_DBL_NEAR_TOL((6 + 5 + 4 + 3 + 2) * 20 * LED_PWM_MS(1), (double)green_on, 4 * LED_PWM_MS(1));
+    ASSERT_TRUE(red_on > LED_PWM_MS(200) && red_on < LED_PWM_MS(300));
+    ASSERT_TRUE(pwm.wakeups < 300); // 200 green edges, and the red ones as it blinks faster
+}
+
+CTEST(led_pwm, test_changes_take_effect_at_the_next_edge) {
+    start();
+    LED_PWM_set_level(&pwm, 3);
+    run(LED_PWM_MS(5));
+
+    // Mid period, while off - the new duty starts with the next period, without restarting the timer
+    uint16_t compare = timer.compare[LED_PWM_GREEN];
+
+    LED_PWM_set_level(&pwm, 8);
+    ASSERT_EQUAL(compare, timer.compare[LED_PWM_GREEN]);
+    run(LED_PWM_MS(5));
+    run(LED_PWM_MS(100));
+    ASSERT_EQUAL(8 * LED_PWM_MS(1) * 10, timer.on_ticks[LED_PWM_GREEN]);
+
+    // Held on, then back to a duty cycle - starts a period straight away
+    LED_PWM_set_level(&pwm, LED_PWM_GREEN_LEVELS);
+    ASSERT_FALSE(timer.enabled[LED_PWM_GREEN]);
+    ASSERT_EQUAL(GREEN_PIN, timer.output & GREEN_PIN);
+
+    LED_PWM_set_level(&pwm, 1);
+    ASSERT_TRUE(timer.enabled[LED_PWM_GREEN]);
+    run(LED_PWM_MS(100));
+    ASSERT_EQUAL(LED_PWM_MS(1) * 10, timer.on_ticks[LED_PWM_GREEN]);
+}
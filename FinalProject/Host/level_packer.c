@@ -0,0 +1,260 @@
+/*
+ * level_packer.c
+ *
+ * Host tool that builds a level pack from a text level description (see levels.txt) and writes it
+ * out as a C source file for the firmware. With --bench it instead decodes every level of the pack
+ * repeatedly and reports the decode latency per level.
+ *
+ * Usage:
+ *   level_packer <levels.txt> <LevelPackData.c>
+ *   level_packer --bench <levels.txt>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "LevelPack.h"
+
+#define MAX_LEVELS          256
+#define MAX_PACK_SIZE       (LEVEL_PACK_HEADER_SIZE + MAX_LEVELS * (LEVEL_PACK_INDEX_ENTRY_SIZE + 2 * LEVEL_PACK_ARENA_SIZE))
+#define BENCH_ITERATIONS    10000
+
+static uint8_t pack[MAX_PACK_SIZE];
+
+/**
+  * @brief Write a little endian value into the pack
+  */
+static void write_u16(uint8_t *dst, uint16_t value)
+{
+    dst[0] = value & 0xFF;
+    dst[1] = value >> 8;
+}
+
+static void write_u32(uint8_t *dst, uint32_t value)
+{
+    for(int i = 0; i < 4; i ++)
+        dst[i] = (value >> (8 * i)) & 0xFF;
+}
+
+/**
+  * @brief Parse the level description and build the pack
+  * @param FILE *input - level description
+  * @retval uint32_t - size of the pack, exits on malformed input
+  */
+static uint32_t build_pack(FILE *input)
+{
+    static uint8_t levels[MAX_LEVELS][LEVEL_PACK_MAX_CELL_COUNT * LEVEL_PACK_MAX_CELL_COUNT];
+    static uint8_t waypoints[MAX_LEVELS][2 * LEVEL_PACK_MAX_WAYPOINTS];
+    static uint8_t cell_counts[MAX_LEVELS];
+    static uint8_t waypoint_counts[MAX_LEVELS];
+
+    char line[1024];
+    int level_count = 0;
+    int line_number = 0;
+
+    while(fgets(line, sizeof(line), input))
+    {
+        line_number ++;
+
+        unsigned cell_count;
+        if(sscanf(line, "level %u", &cell_count) != 1)
+            continue;
+
+        if(level_count == MAX_LEVELS || cell_count == 0 || cell_count > LEVEL_PACK_MAX_CELL_COUNT)
+        {
+            fprintf(stderr, "line %d: bad level\n", line_number);
+            exit(1);
+        }
+
+        uint8_t *level = levels[level_count];
+        cell_counts[level_count] = cell_count;
+
+        // Cell rows
+        for(unsigned row = 0; row < cell_count; row ++)
+        {
+            if(!fgets(line, sizeof(line), input))
+            {
+                fprintf(stderr, "line %d: missing cell row\n", line_number);
+                exit(1);
+            }
+            line_number ++;
+
+            char *cursor = line;
+            for(unsigned col = 0; col < cell_count; col ++)
+            {
+                char *end;
+                unsigned long cell = strtoul(cursor, &end, 16);
+
+                if(end == cursor || cell > 0x1F)
+                {
+                    fprintf(stderr, "line %d: bad cell\n", line_number);
+                    exit(1);
+                }
+
+                level[row * cell_count + col] = (uint8_t)cell;
+                cursor = end;
+            }
+        }
+
+        // Waypoints
+        if(!fgets(line, sizeof(line), input) || strncmp(line, "waypoints", 9) != 0)
+        {
+            fprintf(stderr, "line %d: missing waypoints\n", line_number);
+            exit(1);
+        }
+        line_number ++;
+
+        int num_waypoints = 0;
+        char *token = strtok(line + 9, " \t\r\n");
+
+        while(token)
+        {
+            unsigned row, col;
+
+            if(num_waypoints == LEVEL_PACK_MAX_WAYPOINTS || sscanf(token, "%u,%u", &row, &col) != 2 || row >= cell_count || col >= cell_count)
+            {
+                fprintf(stderr, "line %d: bad waypoint '%s'\n", line_number, token);
+                exit(1);
+            }
+
+            waypoints[level_count][2 * num_waypoints] = row;
+            waypoints[level_count][2 * num_waypoints + 1] = col;
+
+            num_waypoints ++;
+            token = strtok(NULL, " \t\r\n");
+        }
+
+        waypoint_counts[level_count] = num_waypoints;
+        level_count ++;
+    }
+
+    // Header
+    write_u32(pack, LEVEL_PACK_MAGIC);
+    pack[4] = LEVEL_PACK_VERSION;
+    pack[5] = 0;
+    write_u16(pack + 6, level_count);
+
+    // Index and payloads
+    uint32_t offset = LEVEL_PACK_HEADER_SIZE + level_count * LEVEL_PACK_INDEX_ENTRY_SIZE;
+
+    for(int i = 0; i < level_count; i ++)
+    {
+        static uint8_t payload[LEVEL_PACK_ARENA_SIZE];
+        uint32_t level_size = LEVEL_PACK_LEVEL_SIZE(cell_counts[i], waypoint_counts[i]);
+
+        LEVEL_PACK_cells_to_payload(levels[i], cell_counts[i], waypoints[i], waypoint_counts[i], payload);
+        uint32_t compressed_size = LEVEL_PACK_encode(payload, level_size, pack + offset, MAX_PACK_SIZE - offset);
+
+        if(compressed_size == 0 || compressed_size > 0xFFFF)
+        {
+            fprintf(stderr, "level %d: does not fit in the pack\n", i);
+            exit(1);
+        }
+
+        uint8_t *entry = pack + LEVEL_PACK_HEADER_SIZE + i * LEVEL_PACK_INDEX_ENTRY_SIZE;
+        write_u32(entry, offset);
+        write_u16(entry + 4, compressed_size);
+        entry[6] = cell_counts[i];
+        entry[7] = waypoint_counts[i];
+
+        fprintf(stderr, "level %d: %ux%u, %u cell bytes -> %u bytes\n", i, cell_counts[i], cell_counts[i],
+                cell_counts[i] * cell_counts[i] + 2 * waypoint_counts[i], compressed_size);
+
+        offset += compressed_size;
+    }
+
+    return offset;
+}
+
+/**
+  * @brief Write the pack as a C source file
+  */
+static void write_source(FILE *output, uint32_t size)
+{
+    fprintf(output, "/*\n * LevelPackData.c\n *\n * Generated by Host/level_packer from Host/levels.txt - do not edit.\n */\n\n");
+    fprintf(output, "#include \"LevelPack.h\"\n\n");
+    fprintf(output, "const uint32_t level_pack_size = %u;\n\n", size);
+    fprintf(output, "const uint8_t level_pack_data[] = {");
+
+    for(uint32_t i = 0; i < size; i ++)
+    {
+        if(i % 12 == 0)
+            fprintf(output, "\n   ");
+
+        fprintf(output, " 0x%02X,", pack[i]);
+    }
+
+    fprintf(output, "\n};\n");
+}
+
+/**
+  * @brief Decode every level of the pack repeatedly and report the latency per level
+  */
+static void bench_pack(uint32_t size)
+{
+    if(!LEVEL_PACK_is_valid(pack, size))
+    {
+        fprintf(stderr, "pack is invalid\n");
+        exit(1);
+    }
+
+    for(int i = 0; i < LEVEL_PACK_get_level_count(pack); i ++)
+    {
+        LevelData_t level;
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int j = 0; j < BENCH_ITERATIONS; j ++)
+        {
+            if(!LEVEL_PACK_load(pack, i, &level))
+            {
+                fprintf(stderr, "level %d: decode failed\n", i);
+                exit(1);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / BENCH_ITERATIONS;
+        printf("level %d: %ux%u decoded in %.1f ns\n", i, level.cell_count, level.cell_count, ns);
+    }
+}
+
+int main(int argc, const char *argv[])
+{
+    bool bench = argc == 3 && strcmp(argv[1], "--bench") == 0;
+
+    if(argc != 3)
+    {
+        fprintf(stderr, "usage: %s <levels.txt> <LevelPackData.c>\n       %s --bench <levels.txt>\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    FILE *input = fopen(bench ? argv[2] : argv[1], "r");
+    if(input == NULL)
+    {
+        perror("levels");
+        return 1;
+    }
+
+    uint32_t size = build_pack(input);
+    fclose(input);
+
+    if(bench)
+    {
+        bench_pack(size);
+        return 0;
+    }
+
+    FILE *output = fopen(argv[2], "w");
+    if(output == NULL)
+    {
+        perror("output");
+        return 1;
+    }
+
+    write_source(output, size);
+    fclose(output);
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include <string.h>
+#include "ctest.h"
+#include "LevelPack.h"
+
+#define BUFFER_SIZE 1024
+
+static uint8_t source[BUFFER_SIZE];
+static uint8_t packed[2 * BUFFER_SIZE];
+static uint8_t unpacked[BUFFER_SIZE];
+
+/**
+  * @brief Encode and decode a buffer, and check what comes back is what went in
+  */
+static void assert_round_trip(const uint8_t *data, uint32_t size)
+{
+    uint32_t packed_size = LEVEL_PACK_encode(data, size, packed, sizeof(packed));
+
+    ASSERT_TRUE(packed_size > 0);
+    ASSERT_EQUAL(size, LEVEL_PACK_decode(packed, packed_size, unpacked, size));
+    ASSERT_DATA(data, size, unpacked, size);
+}
+
+/**
+  * @brief Pack with one 6 x 6 level, built the way Host/level_packer builds one
+  */
+static uint32_t build_pack(uint8_t *pack, const uint8_t *cells, const uint8_t *waypoint_cells, uint8_t num_waypoints)
+{
+    uint8_t payload[LEVEL_PACK_LEVEL_SIZE(6, LEVEL_PACK_MAX_WAYPOINTS)];
+    uint32_t offset = LEVEL_PACK_HEADER_SIZE + LEVEL_PACK_INDEX_ENTRY_SIZE;
+
+    LEVEL_PACK_cells_to_payload(cells, 6, waypoint_cells, num_waypoints, payload);
+    uint32_t compressed_size = LEVEL_PACK_encode(payload, LEVEL_PACK_LEVEL_SIZE(6, num_waypoints), pack + offset, BUFFER_SIZE - offset);
+
+    pack[0] = LEVEL_PACK_MAGIC & 0xFF;
+    pack[1] = (LEVEL_PACK_MAGIC >> 8) & 0xFF;
+    pack[2] = (LEVEL_PACK_MAGIC >> 16) & 0xFF;
+    pack[3] = LEVEL_PACK_MAGIC >> 24;
+    pack[4] = LEVEL_PACK_VERSION;
+    pack[5] = 0;
+    pack[6] = 1;
+    pack[7] = 0;
+
+    uint8_t *entry = pack + LEVEL_PACK_HEADER_SIZE;
+    entry[0] = offset;
+    entry[1] = entry[2] = entry[3] = 0;
+    entry[4] = compressed_size & 0xFF;
+    entry[5] = compressed_size >> 8;
+    entry[6] = 6;
+    entry[7] = num_waypoints;
+
+    return offset + compressed_size;
+}
+
+CTEST(level_pack, test_packbits_round_trip) {
+    // Zeros - runs longer than one control byte can repeat
+    memset(source, 0, sizeof(source));
+    assert_round_trip(source, sizeof(source));
+
+    // No two bytes alike - literals longer than one control byte can carry
+    for(int i = 0; i < BUFFER_SIZE; i ++)
+        source[i] = (uint8_t)(i * 7);
+    assert_round_trip(source, sizeof(source));
+
+    // Runs of two between literals, and single bytes
+    for(int i = 0; i < BUFFER_SIZE; i ++)
+        source[i] = (uint8_t)((i / 2) % 3 == 0 ? 0xAA : i);
+    assert_round_trip(source, sizeof(source));
+    assert_round_trip(source, 1);
+    assert_round_trip(source, 129);
+
+    // Runs of exactly 128 and 129
+    memset(source, 0x55, 128);
+    memset(source + 128, 0x66, 129);
+    assert_round_trip(source, 257);
+
+    // Sparse, like the wall bitsets
+    memset(source, 0, sizeof(source));
+    for(int i = 0; i < BUFFER_SIZE; i += 37)
+        source[i] = (uint8_t)(i | 1);
+    assert_round_trip(source, sizeof(source));
+
+    // Nothing in, nothing out
+    ASSERT_EQUAL(0, LEVEL_PACK_encode(source, 0, packed, sizeof(packed)));
+    ASSERT_EQUAL(0, LEVEL_PACK_decode(packed, 0, unpacked, sizeof(unpacked)));
+}
+
+CTEST(level_pack, test_packbits_rejects_malformed_streams) {
+    // A literal run cut short
+    const uint8_t truncated_literal[] = {4, 'a', 'b', 'c'};
+    ASSERT_EQUAL(0, LEVEL_PACK_decode(truncated_literal, sizeof(truncated_literal), unpacked, sizeof(unpacked)));
+
+    // A repeat with no byte to repeat
+    const uint8_t truncated_run[] = {0, 'a', 0xFE};
+    ASSERT_EQUAL(0, LEVEL_PACK_decode(truncated_run, sizeof(truncated_run), unpacked, sizeof(unpacked)));
+
+    // More output than the buffer holds, as a run and as literals
+    const uint8_t long_run[] = {129, 'x'};
+    ASSERT_EQUAL(0, LEVEL_PACK_decode(long_run, sizeof(long_run), unpacked, 127));
+    ASSERT_EQUAL(128, LEVEL_PACK_decode(long_run, sizeof(long_run), unpacked, 128));
+
+    const uint8_t literals[] = {2, 'a', 'b', 'c'};
+    ASSERT_EQUAL(0, LEVEL_PACK_decode(literals, sizeof(literals), unpacked, 2));
+
+    // 128 is skipped
+    const uint8_t no_op[] = {128, 0, 'a', 128};
+    ASSERT_EQUAL(1, LEVEL_PACK_decode(no_op, sizeof(no_op), unpacked, sizeof(unpacked)));
+    ASSERT_EQUAL('a', unpacked[0]);
+
+    // Encoding into a buffer that is too small
+    memset(source, 0, 300);
+    ASSERT_EQUAL(0, LEVEL_PACK_encode(source, 300, packed, 5));
+}
+
+CTEST(level_pack, test_load_round_trip) {
+    static uint8_t pack[BUFFER_SIZE];
+    uint8_t cells[36] = {0};
+    const uint8_t waypoint_cells[] = {0, 0, 2, 3, 5, 5};
+    LevelData_t level;
+
+    cells[2] = 0x02;
+    cells[7] = 0x08;
+    cells[15] = 0x10; // Under the waypoint at (2, 3)
+    cells[17] = 0x10;
+    cells[35] = 0x0A;
+
+    uint32_t size = build_pack(pack, cells, waypoint_cells, 3);
+
+    ASSERT_TRUE(LEVEL_PACK_is_valid(pack, size));
+    ASSERT_EQUAL(1, LEVEL_PACK_get_level_count(pack));
+    ASSERT_TRUE(LEVEL_PACK_load(pack, 0, &level));
+    ASSERT_FALSE(LEVEL_PACK_load(pack, 1, &level));
+
+    ASSERT_EQUAL(6, level.cell_count);
+    ASSERT_EQUAL(3, level.num_waypoints);
+    ASSERT_DATA(waypoint_cells, sizeof(waypoint_cells), level.waypoint_cells, 2 * level.num_waypoints);
+
+    // Walls and holes come back, and a waypoint replaces the hole in its cell
+    ASSERT_EQUAL(0x20, level.cell_data[0]);
+    ASSERT_EQUAL(0x02, level.cell_data[2]);
+    ASSERT_EQUAL(0x08, level.cell_data[7]);
+    ASSERT_EQUAL(0x20, level.cell_data[15]);
+    ASSERT_EQUAL(0x10, level.cell_data[17]);
+    ASSERT_EQUAL(0x2A, level.cell_data[35]);
+}
+
+CTEST(level_pack, test_is_valid_rejects_bad_packs) {
+    static uint8_t pack[BUFFER_SIZE];
+    uint8_t cells[36] = {0};
+    const uint8_t waypoint_cells[] = {0, 0};
+    uint8_t *entry = pack + LEVEL_PACK_HEADER_SIZE;
+
+    uint32_t size = build_pack(pack, cells, waypoint_cells, 1);
+    ASSERT_TRUE(LEVEL_PACK_is_valid(pack, size));
+
+    // Cut short, inside the header, the index and the payload
+    ASSERT_FALSE(LEVEL_PACK_is_valid(pack, LEVEL_PACK_HEADER_SIZE - 1));
+    ASSERT_FALSE(LEVEL_PACK_is_valid(pack, LEVEL_PACK_HEADER_SIZE + 4));
+    ASSERT_FALSE(LEVEL_PACK_is_valid(pack, size - 1));
+
+    // Offset so large that offset + compressed_size wraps around to fit the size
+    entry[0] = entry[1] = entry[2] = entry[3] = 0xFF;
+    ASSERT_FALSE(LEVEL_PACK_is_valid(pack, size));
+
+    entry[0] = 0xFF - 1;
+    entry[1] = entry[2] = entry[3] = 0xFF;
+    entry[4] = 2;
+    entry[5] = 0;
+    ASSERT_FALSE(LEVEL_PACK_is_valid(pack, size));
+
+    // Bad magic, version and level dimensions
+    size = build_pack(pack, cells, waypoint_cells, 1);
+    pack[0] ^= 1;
+    ASSERT_FALSE(LEVEL_PACK_is_valid(pack, size));
+
+    size = build_pack(pack, cells, waypoint_cells, 1);
+    pack[4] = LEVEL_PACK_VERSION + 1;
+    ASSERT_FALSE(LEVEL_PACK_is_valid(pack, size));
+
+    size = build_pack(pack, cells, waypoint_cells, 1);
+    entry[6] = 0;
+    ASSERT_FALSE(LEVEL_PACK_is_valid(pack, size));
+    entry[6] = LEVEL_PACK_MAX_CELL_COUNT + 1;
+    ASSERT_FALSE(LEVEL_PACK_is_valid(pack, size));
+
+    size = build_pack(pack, cells, waypoint_cells, 1);
+    entry[7] = LEVEL_PACK_MAX_WAYPOINTS + 1;
+    ASSERT_FALSE(LEVEL_PACK_is_valid(pack, size));
+}
@@ -0,0 +1,24 @@
+#include <stdio.h>
+
+#define CTEST_MAIN
+
+#define CTEST_SEGFAULT
+#define CTEST_COLOR_OK
+
+#include "ctest.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+/// Host unit tests for the hardware independent game modules in ../Src
+///
+/// @Makefie
+/// 1. type 'make tests' in command line for the tests to be built
+/// 2. type './tests' to run the unit tests, or './tests <suite>' to run a single suite
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, const char *argv[])
+{
+    int result = ctest_main(argc, argv);
+
+    printf("\nRan all of the tests associated with the game modules\n");
+    return result;
+}
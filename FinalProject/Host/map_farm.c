@@ -0,0 +1,357 @@
+/*
+ * map_farm.c
+ *
+ * Host tool for tuning map generation. For every combination of wall_probability, hole_probability
+ * and num_waypoints it generates maps with the same code as the firmware (MAP_create) across a pool
+ * of worker threads, solves each map and writes a difficulty histogram per parameter set.
+ *
+ * A map is solved by following the flow field (FlowField.c) from each waypoint to the next, so walls
+ * and holes block movement exactly as the firmware's route hints see them. Its difficulty is the path length in cells plus HOLE_WEIGHT for every step that ends
+ * next to a hole. Maps that cannot be completed are counted separately.
+ *
+ * The histogram CSV has one row per non-empty difficulty bin of a set, after a summary row with difficulty -1
+ * whose count is the number of unsolvable maps - every set gets at least that row.
+ *
+ * Results are streamed: histograms are written as soon as a parameter set is done and the optional
+ * per-map CSV is flushed from small per-thread buffers, so memory use does not grow with the number
+ * of maps. Every map is seeded from (seed, parameter set, map index), so the output does not depend
+ * on the number of threads.
+ *
+ * Usage:
+ *   map_farm [-t threads] [-n maps per set] [-s seed] [-c cell count]
+ *            [-w first:last:step] [-h first:last:step] [-p first:last:step]
+ *            [-o histogram.csv] [-m maps.csv]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "Map.h"
+#include "FlowField.h"
+
+#define CHUNK_SIZE          4096        // Maps claimed by a worker at a time
+#define DIFFICULTY_BINS     4096        // Last bin also counts every harder map
+#define HOLE_WEIGHT         2
+#define MAP_BUFFER_SIZE     (64 * 1024) // Per-thread buffer for the per-map CSV
+
+typedef struct {
+    uint32_t first, last, step;
+} Range_t;
+
+typedef struct {
+    bool solvable;
+    uint32_t path_length;               // Cells moved through to reach every waypoint in order
+    uint32_t hole_steps;                // Steps that end in a cell next to a hole
+    uint32_t difficulty;
+} MapSolution_t;
+
+typedef struct {
+    uint64_t unsolvable;
+    uint64_t bins[DIFFICULTY_BINS];
+} Histogram_t;
+
+typedef struct {
+    pthread_t thread;
+    char buffer[MAP_BUFFER_SIZE];
+    size_t buffer_used;
+} Worker_t;
+
+// Work shared with the pool
+static MapConfig_t set_config;
+static uint32_t set_index;
+static uint64_t maps_per_set = 100000;
+static uint64_t seed = 1;
+static atomic_uint_fast64_t next_chunk;
+static Histogram_t set_histogram;
+static pthread_mutex_t histogram_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t map_file_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_barrier_t start_barrier, end_barrier;
+static bool quit;
+static FILE *map_file;
+
+/**
+  * @brief splitmix64 - spreads the map coordinates into a well mixed seed
+  */
+static uint64_t mix(uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+/**
+  * @brief xorshift32 random source for MAP_create
+  */
+static uint32_t farm_random(void *context, uint32_t max)
+{
+    uint32_t *state = context;
+
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state % max;
+}
+
+/**
+  * @brief True if any of the four neighbours of a cell is a hole
+  */
+static bool next_to_hole(const MapData_t *map, int row, int col)
+{
+    return (row > 0 && (map->cell_data[row - 1][col] & MAP_HOLE)) ||
+           (row < map->cell_count - 1 && (map->cell_data[row + 1][col] & MAP_HOLE)) ||
+           (col > 0 && (map->cell_data[row][col - 1] & MAP_HOLE)) ||
+           (col < map->cell_count - 1 && (map->cell_data[row][col + 1] & MAP_HOLE));
+}
+
+/**
+  * @brief Follow the flow field toward every waypoint in order
+  */
+static MapSolution_t solve_map(const MapData_t *map)
+{
+    static _Thread_local FlowField_t field;
+
+    MapSolution_t solution = {.solvable = true};
+
+    for(int w = 1; w < map->num_waypoints; w ++)
+    {
+        FLOW_FIELD_compute(&field, map, MAP_CELL_ROW(map->waypoint_data[w].y), MAP_CELL_COL(map->waypoint_data[w].x));
+
+        int row = MAP_CELL_ROW(map->waypoint_data[w - 1].y);
+        int col = MAP_CELL_COL(map->waypoint_data[w - 1].x);
+
+        while(FLOW_FIELD_DIRECTION(field.cells[row][col]) != FLOW_TARGET)
+        {
+            switch(FLOW_FIELD_DIRECTION(field.cells[row][col]))
+            {
+                case FLOW_UP:    row --; break;
+                case FLOW_DOWN:  row ++; break;
+                case FLOW_LEFT:  col --; break;
+                case FLOW_RIGHT: col ++; break;
+                default:
+                    solution.solvable = false;
+                    return solution;
+            }
+
+            solution.path_length ++;
+
+            if(next_to_hole(map, row, col))
+                solution.hole_steps ++;
+        }
+    }
+
+    solution.difficulty = solution.path_length + HOLE_WEIGHT * solution.hole_steps;
+
+    return solution;
+}
+
+/**
+  * @brief Write a worker's per-map buffer to the per-map CSV
+  */
+static void flush_maps(Worker_t *worker)
+{
+    pthread_mutex_lock(&map_file_mutex);
+    fwrite(worker->buffer, 1, worker->buffer_used, map_file);
+    pthread_mutex_unlock(&map_file_mutex);
+
+    worker->buffer_used = 0;
+}
+
+/**
+  * @brief Pool thread - generates and solves chunks of maps of the current parameter set
+  */
+static void *worker_function(void *arg)
+{
+    Worker_t *worker = arg;
+    static _Thread_local MapData_t map;
+    static _Thread_local Histogram_t histogram;
+
+    while(1)
+    {
+        pthread_barrier_wait(&start_barrier);
+
+        if(quit)
+            break;
+
+        memset(&histogram, 0, sizeof(histogram));
+
+        uint64_t chunk;
+        while((chunk = atomic_fetch_add(&next_chunk, 1)) * CHUNK_SIZE < maps_per_set)
+        {
+            uint64_t first = chunk * CHUNK_SIZE;
+            uint64_t last = first + CHUNK_SIZE < maps_per_set ? first + CHUNK_SIZE : maps_per_set;
+
+            for(uint64_t m = first; m < last; m ++)
+            {
+                uint32_t state = (uint32_t)mix(seed ^ mix(((uint64_t)set_index << 40) ^ m)) | 1;
+
+                MAP_create(&map, &set_config, farm_random, &state);
+                MapSolution_t solution = solve_map(&map);
+
+                if(!solution.solvable)
+                    histogram.unsolvable ++;
+                else
+                    histogram.bins[solution.difficulty < DIFFICULTY_BINS ? solution.difficulty : DIFFICULTY_BINS - 1] ++;
+
+                if(map_file)
+                {
+                    if(worker->buffer_used > MAP_BUFFER_SIZE - 128)
+                        flush_maps(worker);
+
+                    worker->buffer_used += snprintf(worker->buffer + worker->buffer_used, MAP_BUFFER_SIZE - worker->buffer_used,
+                                                    "%u,%llu,%d,%u,%u,%u\n", set_index, (unsigned long long)m, solution.solvable,
+                                                    solution.path_length, solution.hole_steps, solution.difficulty);
+                }
+            }
+        }
+
+        pthread_mutex_lock(&histogram_mutex);
+        set_histogram.unsolvable += histogram.unsolvable;
+        for(int i = 0; i < DIFFICULTY_BINS; i ++)
+            set_histogram.bins[i] += histogram.bins[i];
+        pthread_mutex_unlock(&histogram_mutex);
+
+        if(map_file)
+            flush_maps(worker);
+
+        pthread_barrier_wait(&end_barrier);
+    }
+
+    return NULL;
+}
+
+/**
+  * @brief Parse a first:last:step range
+  */
+static Range_t parse_range(const char *text)
+{
+    Range_t range = {0, 0, 1};
+
+    int fields = sscanf(text, "%u:%u:%u", &range.first, &range.last, &range.step);
+
+    if(fields == 1)
+        range.last = range.first;
+
+    if(fields < 1 || range.step == 0 || range.last < range.first)
+    {
+        fprintf(stderr, "bad range '%s'\n", text);
+        exit(1);
+    }
+
+    return range;
+}
+
+int main(int argc, char *argv[])
+{
+    Range_t walls = {50, 300, 50};
+    Range_t holes = {50, 300, 50};
+    Range_t waypoints = {2, 4, 1};
+    uint32_t cell_count = 6;
+    long thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    FILE *histogram_file = stdout;
+    int option;
+
+    while((option = getopt(argc, argv, "t:n:s:c:w:h:p:o:m:")) != -1)
+    {
+        switch(option)
+        {
+            case 't': thread_count = atol(optarg); break;
+            case 'n': maps_per_set = strtoull(optarg, NULL, 0); break;
+            case 's': seed = strtoull(optarg, NULL, 0); break;
+            case 'c': cell_count = atoi(optarg); break;
+            case 'w': walls = parse_range(optarg); break;
+            case 'h': holes = parse_range(optarg); break;
+            case 'p': waypoints = parse_range(optarg); break;
+            case 'o': histogram_file = fopen(optarg, "w"); break;
+            case 'm': map_file = fopen(optarg, "w"); break;
+            default:
+                fprintf(stderr, "usage: %s [-t threads] [-n maps] [-s seed] [-c cell count] [-w|-h|-p first:last:step] [-o histogram.csv] [-m maps.csv]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(histogram_file == NULL || (optind < argc) || thread_count < 1 || cell_count < 1 || cell_count > MAP_MAX_CELL_COUNT ||
+       waypoints.last > MAP_MAX_WAYPOINTS || waypoints.last > cell_count * cell_count)
+    {
+        fprintf(stderr, "bad arguments (at most %d cells per side and %d waypoints)\n", MAP_MAX_CELL_COUNT, MAP_MAX_WAYPOINTS);
+        return 1;
+    }
+
+    fprintf(histogram_file, "wall_probability,hole_probability,num_waypoints,maps,unsolvable,difficulty,count\n");
+    if(map_file)
+        fprintf(map_file, "set,map,solvable,path_length,hole_steps,difficulty\n");
+
+    Worker_t *workers = calloc(thread_count, sizeof(Worker_t));
+    pthread_barrier_init(&start_barrier, NULL, thread_count + 1);
+    pthread_barrier_init(&end_barrier, NULL, thread_count + 1);
+
+    for(long i = 0; i < thread_count; i ++)
+        pthread_create(&workers[i].thread, NULL, worker_function, &workers[i]);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    uint64_t total_maps = 0;
+
+    for(uint32_t w = walls.first; w <= walls.last; w += walls.step)
+    {
+        for(uint32_t h = holes.first; h <= holes.last; h += holes.step)
+        {
+            for(uint32_t p = waypoints.first; p <= waypoints.last; p += waypoints.step)
+            {
+                set_config = (MapConfig_t){
+                    .cell_count = cell_count,
+                    .wall_probability = w,
+                    .hole_probability = h,
+                    .num_waypoints = p,
+                };
+                memset(&set_histogram, 0, sizeof(set_histogram));
+                atomic_store(&next_chunk, 0);
+
+                pthread_barrier_wait(&start_barrier);
+                pthread_barrier_wait(&end_barrier);
+
+                // Summary row first, so a set where no map could be solved still shows up
+                fprintf(histogram_file, "%u,%u,%u,%llu,%llu,-1,%llu\n", w, h, p, (unsigned long long)maps_per_set,
+                        (unsigned long long)set_histogram.unsolvable, (unsigned long long)set_histogram.unsolvable);
+
+                for(int i = 0; i < DIFFICULTY_BINS; i ++)
+                {
+                    if(set_histogram.bins[i])
+                        fprintf(histogram_file, "%u,%u,%u,%llu,%llu,%d,%llu\n", w, h, p, (unsigned long long)maps_per_set,
+                                (unsigned long long)set_histogram.unsolvable, i, (unsigned long long)set_histogram.bins[i]);
+                }
+                fflush(histogram_file);
+
+                total_maps += maps_per_set;
+                set_index ++;
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    quit = true;
+    pthread_barrier_wait(&start_barrier);
+
+    for(long i = 0; i < thread_count; i ++)
+        pthread_join(workers[i].thread, NULL);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(stderr, "%llu maps in %u parameter sets on %ld threads: %.2f s, %.0f maps/s\n",
+            (unsigned long long)total_maps, set_index, thread_count, seconds, total_maps / seconds);
+
+    if(map_file)
+        fclose(map_file);
+    if(histogram_file != stdout)
+        fclose(histogram_file);
+
+    free(workers);
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <math.h>
+#include "ctest.h"
+#include "Map.h"
+
+#define RANDOM_MAPS 40
+
+// Scanned area - a margin past the map on every side
+#define SCAN_MIN_X (MAP_ORIGIN_X - 25)
+#define SCAN_MIN_Y (MAP_ORIGIN_Y - 25)
+#define SCAN_MAX_X (MAP_ORIGIN_X + (6 * MAP_CELL_SIZE) + 25)
+#define SCAN_MAX_Y (MAP_ORIGIN_Y + (6 * MAP_CELL_SIZE) + 25)
+
+static MapData_t map;
+
+/**
+  * @brief The lookup the cell search replaced - square root of the distance to every hole
+  */
+static bool reference_is_over_hole(int32_t x, int32_t y, uint32_t radius)
+{
+    for(int i = 0; i < map.num_holes; i ++)
+    {
+        int32_t x_distance = x - map.hole_data[i].x;
+        int32_t y_distance = y - (int32_t)map.hole_data[i].y;
+
+        if(sqrt((x_distance * x_distance) + (y_distance * y_distance)) < radius)
+            return true;
+    }
+
+    return false;
+}
+
+static int8_t reference_get_waypoint(int32_t x, int32_t y, uint32_t radius)
+{
+    for(int i = 0; i < map.num_waypoints; i ++)
+    {
+        int32_t x_distance = x - map.waypoint_data[i].x;
+        int32_t y_distance = y - map.waypoint_data[i].y;
+
+        if(sqrt((x_distance * x_distance) + (y_distance * y_distance)) < radius)
+            return map.waypoint_data[i].number;
+    }
+
+    return -1;
+}
+
+CTEST(map, test_cell_lookups_match_brute_force) {
+    // Denser than the game's maps, so most cells have a hole next to them
+    MapConfig_t map_config = {
+        .cell_count = 6,
+        .wall_probability = 150,
+        .hole_probability = 400,
+        .num_waypoints = 4,
+    };
+    // Up to half a cell - a bigger radius would reach past the neighbouring cells the lookups search
+    const uint32_t radii[] = {1, 10, 15, MAP_CELL_SIZE / 2};
+    uint32_t seed = 1;
+    int mismatches = 0;
+
+    for(int i = 0; i < RANDOM_MAPS; i ++)
+    {
+        ASSERT_TRUE(MAP_create(&map, &map_config, MAP_xorshift_random, &seed));
+
+        for(uint32_t r = 0; r < sizeof(radii) / sizeof(radii[0]); r ++)
+        {
+            for(int32_t y = SCAN_MIN_Y; y < SCAN_MAX_Y; y ++)
+            {
+                for(int32_t x = SCAN_MIN_X; x < SCAN_MAX_X; x ++)
+                {
+                    mismatches += MAP_is_over_hole(&map, x, y, radii[r]) != reference_is_over_hole(x, y, radii[r]);
+                    mismatches += MAP_get_waypoint(&map, x, y, radii[r]) != reference_get_waypoint(x, y, radii[r]);
+                }
+            }
+        }
+    }
+
+    ASSERT_EQUAL(0, mismatches);
+}
+
+CTEST(map, test_load_level_rejects_waypoints_off_the_grid) {
+    uint8_t cells[4 * 4] = {0};
+    uint8_t waypoint_cells[2 * 2] = {0, 0, 3, 3};
+    LevelData_t level = {4, 2, cells, waypoint_cells};
+
+    ASSERT_TRUE(MAP_load_level(&map, &level));
+    ASSERT_EQUAL(2, map.num_waypoints);
+    ASSERT_EQUAL(1, map.waypoint_number[3][3]);
+
+    // A row or column past the level's grid - still inside MapData_t's arrays, but not this level's
+    waypoint_cells[2] = 4;
+    ASSERT_FALSE(MAP_load_level(&map, &level));
+
+    waypoint_cells[2] = 3;
+    waypoint_cells[3] = 200;
+    ASSERT_FALSE(MAP_load_level(&map, &level));
+}
@@ -0,0 +1,224 @@
+#include <string.h>
+#include "ctest.h"
+#include "Recorder.h"
+
+static Recorder_t recorder;
+static uint8_t log_data[RECORDER_BUFFER_SIZE];
+
+/**
+  * @brief Drains the recorder into log_data
+  */
+static uint32_t take_log(void)
+{
+    return RECORDER_read(&recorder, log_data, sizeof(log_data));
+}
+
+CTEST(recorder, test_round_trip) {
+    static const int16_t samples[][2] = {{0, 0}, {3, -4}, {2, -1}, {100, -100}, {-32768, 32767}, {32767, -32768}, {5, 5}};
+    RecordReader_t reader;
+    RecordEvent_t event;
+
+    RECORDER_init(&recorder);
+    ASSERT_TRUE(RECORDER_start(&recorder, 0xDEADBEEF, -1));
+
+    for(int i = 0; i < 7; i ++)
+    {
+        // i ticks before every sample - covers 0, 1 and a run of several
+        for(int tick = 0; tick < i * 5; tick ++)
+            RECORDER_tick(&recorder);
+
+        ASSERT_TRUE(RECORDER_gyro(&recorder, samples[i][0], samples[i][1]));
+
+        if(i == 3)
+            ASSERT_TRUE(RECORDER_button(&recorder, true));
+    }
+
+    RECORDER_tick(&recorder);
+    ASSERT_TRUE(RECORDER_start(&recorder, 7, 2));
+
+    RECORDER_reader_init(&reader, log_data, take_log());
+
+    ASSERT_TRUE(RECORDER_next(&reader, &event));
+    ASSERT_EQUAL(RECORD_START, event.type);
+    ASSERT_EQUAL(0xDEADBEEF, event.seed);
+    ASSERT_EQUAL(-1, event.level);
+
+    for(int i = 0; i < 7; i ++)
+    {
+        for(int tick = 0; tick < i * 5; tick ++)
+        {
+            ASSERT_TRUE(RECORDER_next(&reader, &event));
+            ASSERT_EQUAL(RECORD_TICK, event.type);
+        }
+
+        ASSERT_TRUE(RECORDER_next(&reader, &event));
+        ASSERT_EQUAL(RECORD_GYRO, event.type);
+        ASSERT_EQUAL(samples[i][0], event.rate_x);
+        ASSERT_EQUAL(samples[i][1], event.rate_y);
+
+        if(i == 3)
+        {
+            ASSERT_TRUE(RECORDER_next(&reader, &event));
+            ASSERT_EQUAL(RECORD_BUTTON, event.type);
+            ASSERT_TRUE(event.pressed);
+        }
+    }
+
+    ASSERT_TRUE(RECORDER_next(&reader, &event));
+    ASSERT_EQUAL(RECORD_TICK, event.type);
+
+    ASSERT_TRUE(RECORDER_next(&reader, &event));
+    ASSERT_EQUAL(RECORD_START, event.type);
+    ASSERT_EQUAL(7, event.seed);
+    ASSERT_EQUAL(2, event.level);
+
+    ASSERT_FALSE(RECORDER_next(&reader, &event));
+}
+
+CTEST(recorder, test_under_two_bytes_per_sample) {
+    uint32_t state = 12345;
+    int32_t rate_x = 0, rate_y = 0;
+    int samples = 3000; // A minute of play at the firmware's 20 ms gyro period
+
+    RECORDER_init(&recorder);
+    RECORDER_start(&recorder, 1, -1);
+
+    for(int i = 0; i < samples; i ++)
+    {
+        int32_t target = 0;
+
+        // Board held still with a little noise, tilted in a slow sweep every 2 s
+        if(i % 100 < 25)
+            target = 40 * ((i % 100 < 12) ? (i % 100) : (25 - (i % 100)));
+
+        uint32_t noise = MAP_xorshift_random(&state, 25);
+
+        rate_x = target + (int32_t)(noise % 5) - 2;
+        rate_y = (int32_t)(noise / 5) - 2;
+
+        ASSERT_TRUE(RECORDER_gyro(&recorder, rate_x, rate_y));
+
+        // 50 ms physics ticks - one every 2.5 samples
+        if(i % 5 == 1 || i % 5 == 3)
+            RECORDER_tick(&recorder);
+    }
+
+    RECORDER_flush(&recorder);
+
+    ASSERT_TRUE(recorder.head - recorder.tail < 2 * samples);
+    ASSERT_EQUAL(0, recorder.dropped);
+}
+
+CTEST(recorder, test_full_buffer_drops_whole_records) {
+    RecordReader_t reader;
+    RecordEvent_t event;
+    static int16_t kept[RECORDER_BUFFER_SIZE];
+    uint32_t accepted = 0;
+    int16_t last_x = 0;
+
+    RECORDER_init(&recorder);
+    RECORDER_start(&recorder, 1, -1);
+
+    // Alternating big jumps - several bytes each, so the buffer doesn't fill up exactly
+    for(int i = 0; i < RECORDER_BUFFER_SIZE; i ++)
+    {
+        int16_t rate = (i & 1) ? 1000 : -1000;
+
+        if(RECORDER_gyro(&recorder, rate, 0))
+            kept[accepted ++] = rate;
+    }
+
+    ASSERT_TRUE(recorder.dropped > 0);
+    ASSERT_TRUE(recorder.head - recorder.tail <= RECORDER_BUFFER_SIZE);
+
+    // Everything that was kept decodes to the samples given
+    RECORDER_reader_init(&reader, log_data, take_log());
+    ASSERT_TRUE(RECORDER_next(&reader, &event));
+    ASSERT_EQUAL(RECORD_START, event.type);
+
+    for(uint32_t i = 0; i < accepted; i ++)
+    {
+        ASSERT_TRUE(RECORDER_next(&reader, &event));
+        ASSERT_EQUAL(RECORD_GYRO, event.type);
+        ASSERT_EQUAL(kept[i], event.rate_x);
+        last_x = event.rate_x;
+    }
+
+    ASSERT_FALSE(RECORDER_next(&reader, &event));
+    ASSERT_EQUAL(reader.size, reader.position);
+
+    // Reading out made room - later records are relative to the last one kept
+    ASSERT_TRUE(RECORDER_gyro(&recorder, last_x + 1, 0));
+    RECORDER_reader_init(&reader, log_data, take_log());
+    reader.last_x = last_x;
+    ASSERT_TRUE(RECORDER_next(&reader, &event));
+    ASSERT_EQUAL(last_x + 1, event.rate_x);
+}
+
+CTEST(recorder, test_replay_matches_recorded_game) {
+    static GameState_t live, replayed;
+    RecordReader_t reader;
+    RecordEvent_t event;
+    q16_t angle_x = Q16_FROM_INT(INITIAL_BOARD_ANGLE), angle_y = Q16_FROM_INT(INITIAL_BOARD_ANGLE);
+    uint32_t seed = 99, random_state, events;
+    int ticks = 0;
+
+    GAME_default_config(&config);
+    GAME_init(&live, &config);
+    GAME_init(&replayed, &config);
+
+    random_state = seed;
+    ASSERT_TRUE(MAP_create(&live.map, &config.map_config, MAP_xorshift_random, &random_state));
+    ASSERT_TRUE(GAME_start(&live));
+
+    RECORDER_init(&recorder);
+    RECORDER_start(&recorder, seed, -1);
+
+    // Play the game the way the firmware does - gyro samples and button edges between physics ticks
+    for(int sample = 0; sample < 2000 && !live.won && !live.lost; sample ++)
+    {
+        int16_t rate_x = (sample % 400 < 200) ? 40 : -40;
+        int16_t rate_y = (sample % 300 < 150) ? 30 : -30;
+
+        RECORDER_gyro(&recorder, rate_x, rate_y);
+        GAME_integrate_gyro(&angle_x, &angle_y, rate_x, rate_y);
+
+        if(sample % 97 == 0)
+        {
+            GAME_set_button(&live, !live.button_pressed);
+            RECORDER_button(&recorder, live.button_pressed);
+        }
+
+        if(sample % 5 == 1 || sample % 5 == 3)
+        {
+            RECORDER_tick(&recorder);
+
+            GAME_advance_energy(&live, config.physics_config.update_period);
+            GAME_advance_clock(&live, config.physics_config.update_period);
+            GAME_step(&live, angle_x, angle_y);
+            ticks ++;
+        }
+    }
+
+    ASSERT_EQUAL(0, recorder.dropped);
+
+    // Replay from the log alone
+    RECORDER_reader_init(&reader, log_data, take_log());
+    ASSERT_TRUE(RECORDER_next(&reader, &event));
+    ASSERT_EQUAL(RECORD_START, event.type);
+
+    random_state = event.seed;
+    ASSERT_TRUE(MAP_create(&replayed.map, &config.map_config, MAP_xorshift_random, &random_state));
+    ASSERT_TRUE(GAME_start(&replayed));
+
+    while(RECORDER_replay_tick(&reader, &replayed, &events))
+        ticks --;
+
+    ASSERT_EQUAL(0, ticks);
+    ASSERT_EQUAL(live.time, replayed.time);
+    ASSERT_EQUAL(live.drone_energy, replayed.drone_energy);
+    ASSERT_EQUAL(live.entities.pos_x[DRONE_ENTITY], replayed.entities.pos_x[DRONE_ENTITY]);
+    ASSERT_EQUAL(live.entities.pos_y[DRONE_ENTITY], replayed.entities.pos_y[DRONE_ENTITY]);
+    ASSERT_EQUAL(live.won, replayed.won);
+    ASSERT_EQUAL(live.lost, replayed.lost);
+}
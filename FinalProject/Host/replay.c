@@ -0,0 +1,183 @@
+/*
+ * replay.c
+ *
+ * Plays back an input log recorded by the firmware through the same game rules (Game.c), so a bug seen on
+ * the board can be stepped through on the host. The log is the recorder's buffer dumped from RAM, e.g.
+ * from gdb: dump binary memory game.log &recorder.buffer[0] &recorder.buffer[recorder.head]
+ *
+ * Prints how the game ended and a checksum of its final state; with -v, the drone's position every tick.
+ * Given a second file name, also writes the log as Src/ReplayLogData.c for the firmware's REPLAY_LOG mode.
+ *
+ * Usage:
+ *   replay [-v] <log> [ReplayLogData.c]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Recorder.h"
+
+#define MAX_LOG_SIZE (1 << 20)
+
+static uint8_t log_data[MAX_LOG_SIZE];
+
+static uint32_t checksum_add(uint32_t hash, uint32_t value)
+{
+    for(int i = 0; i < 4; i ++)
+    {
+        hash ^= (value >> (8 * i)) & 0xFF;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static bool write_c_file(const char *path, const uint8_t *data, uint32_t size)
+{
+    FILE *output = fopen(path, "w");
+
+    if(output == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    fprintf(output, "/*\n * ReplayLogData.c\n *\n * Generated by Host/replay from a recorded log - do not edit. Played back when REPLAY_LOG is 1.\n */\n\n");
+    fprintf(output, "#include \"Recorder.h\"\n\n");
+    fprintf(output, "const uint32_t replay_log_size = %u;\n\n", size);
+    fprintf(output, "const uint8_t replay_log_data[] = {");
+
+    for(uint32_t i = 0; i < size; i ++)
+    {
+        if(i % 12 == 0)
+            fprintf(output, "\n   ");
+
+        fprintf(output, " 0x%02X,", data[i]);
+    }
+
+    // An empty array isn't valid C
+    if(size == 0)
+        fprintf(output, "\n    0x00");
+
+    fprintf(output, "\n};\n");
+    fclose(output);
+
+    return true;
+}
+
+/**
+  * @brief Rebuilds the map a start record describes and starts a game on it
+  */
+static bool start_game(GameState_t *game, const RecordEvent_t *start)
+{
+    if(start->level >= 0)
+    {
+        LevelData_t level;
+
+        if(!LEVEL_PACK_load(level_pack_data, start->level, &level) || !MAP_load_level(&game->map, &level))
+        {
+            fprintf(stderr, "level %d: not in the level pack\n", start->level);
+            return false;
+        }
+    }
+    else
+    {
+        uint32_t random_state = start->seed;
+
+        if(!MAP_create(&game->map, &config.map_config, MAP_xorshift_random, &random_state))
+            return false;
+    }
+
+    return GAME_start(game);
+}
+
+int main(int argc, const char *argv[])
+{
+    static GameState_t game;
+    static RecordReader_t reader;
+    bool verbose = false;
+    int arg = 1;
+
+    if(arg < argc && strcmp(argv[arg], "-v") == 0)
+    {
+        verbose = true;
+        arg ++;
+    }
+
+    if(arg >= argc)
+    {
+        fprintf(stderr, "usage: %s [-v] <log> [ReplayLogData.c]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *input = fopen(argv[arg], "rb");
+
+    if(input == NULL)
+    {
+        perror(argv[arg]);
+        return 1;
+    }
+
+    uint32_t size = fread(log_data, 1, MAX_LOG_SIZE, input);
+    fclose(input);
+
+    if(arg + 1 < argc && !write_c_file(argv[arg + 1], log_data, size))
+        return 1;
+
+    GAME_default_config(&config);
+    GAME_init(&game, &config);
+    RECORDER_reader_init(&reader, log_data, size);
+
+    RecordEvent_t start;
+    uint32_t games = 0;
+
+    // One game per start record
+    while(RECORDER_next(&reader, &start))
+    {
+        uint32_t hash = 2166136261u;
+        uint32_t ticks = 0, events;
+
+        if(start.type != RECORD_START)
+        {
+            fprintf(stderr, "byte %u: expected a game start\n", reader.position);
+            return 1;
+        }
+
+        if(!start_game(&game, &start))
+            return 1;
+
+        printf("game %u: %s %u\n", games, start.level >= 0 ? "level" : "seed", start.level >= 0 ? (uint32_t)start.level : start.seed);
+
+        while(RECORDER_replay_tick(&reader, &game, &events))
+        {
+            ticks ++;
+
+            if(verbose)
+                printf("%6u %7.2f %7.2f  angle %7.2f %7.2f  energy %5d%s%s\n", game.time,
+                       game.entities.pos_x[DRONE_ENTITY] / 65536.0, game.entities.pos_y[DRONE_ENTITY] / 65536.0,
+                       reader.angle_x / 65536.0, reader.angle_y / 65536.0, (int)game.drone_energy,
+                       game.disruptor_active ? " disruptor" : "", (events & GAME_EVENT_WAYPOINT_REACHED) ? " waypoint" : "");
+        }
+
+        hash = checksum_add(hash, game.time);
+        hash = checksum_add(hash, game.current_waypoint);
+        hash = checksum_add(hash, game.entities.pos_x[DRONE_ENTITY]);
+        hash = checksum_add(hash, game.entities.pos_y[DRONE_ENTITY]);
+
+        printf("%u ticks, %s%s%s%s, checksum %08X\n", ticks,
+               game.won ? "won" : game.lost ? "lost" : "unfinished",
+               game.fell_into_hole ? " - fell into hole" : "",
+               game.ran_out_of_time ? " - out of time" : "",
+               game.exceeded_tilt ? " - exceeded tilt" : "", hash);
+
+        games ++;
+    }
+
+    if(reader.position != size)
+    {
+        fprintf(stderr, "byte %u: corrupt record\n", reader.position);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * sine_table_gen.c
+ *
+ * Generates the sine table used by SineTable.c - one Q16.16 entry per degree over a full turn, with the
+ * first entry repeated at the end so interpolation never wraps.
+ *
+ * Usage:
+ *   sine_table_gen <output.c>
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "SineTable.h"
+
+int main(int argc, const char *argv[])
+{
+    if(argc != 2)
+    {
+        fprintf(stderr, "usage: %s <output.c>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *output = fopen(argv[1], "w");
+    if(output == NULL)
+    {
+        perror("output");
+        return 1;
+    }
+
+    fprintf(output, "/*\n * SineTableData.c\n *\n * Generated by Host/sine_table_gen - do not edit.\n */\n\n");
+    fprintf(output, "#include \"SineTable.h\"\n\n");
+    fprintf(output, "// sin(i degrees) in Q16.16\n");
+    fprintf(output, "const q16_t sine_table[SINE_TABLE_SIZE] = {");
+
+    for(int i = 0; i < SINE_TABLE_SIZE; i ++)
+    {
+        // Exact zeros and ones instead of rounding noise at the axes
+        double value = (i % 180 == 0) ? 0.0 : sin(i * SINE_TABLE_STEP_DEGREES * M_PI / 180.0);
+
+        if(i % 8 == 0)
+            fprintf(output, "\n   ");
+
+        fprintf(output, " %6ld,", lround(value * Q16_ONE));
+    }
+
+    fprintf(output, "\n};\n");
+    fclose(output);
+
+    return 0;
+}
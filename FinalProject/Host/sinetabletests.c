@@ -0,0 +1,34 @@
+#include <math.h>
+#include "ctest.h"
+#include "SineTable.h"
+
+CTEST(sine_table, test_matches_libm) {
+    // Every 1/64 of a degree over more than a turn either way
+    for(q16_t angle = Q16_FROM_INT(-400); angle <= Q16_FROM_INT(400); angle += Q16_ONE / 64)
+    {
+        double expected = sin((angle / 65536.0) * M_PI / 180.0);
+
+        ASSERT_DBL_NEAR_TOL(expected, SINE_TABLE_sin(angle) / 65536.0, 1e-4);
+    }
+}
+
+CTEST(sine_table, test_exact_at_axes) {
+    ASSERT_EQUAL(0, SINE_TABLE_sin(0));
+    ASSERT_EQUAL(Q16_ONE, SINE_TABLE_sin(Q16_FROM_INT(90)));
+    ASSERT_EQUAL(0, SINE_TABLE_sin(Q16_FROM_INT(180)));
+    ASSERT_EQUAL(-Q16_ONE, SINE_TABLE_sin(Q16_FROM_INT(-90)));
+    ASSERT_EQUAL(-Q16_ONE, SINE_TABLE_sin(Q16_FROM_INT(270)));
+}
+
+CTEST(sine_table, test_odd_and_monotonic_near_level) {
+    q16_t previous = SINE_TABLE_sin(Q16_FROM_INT(-90));
+
+    for(q16_t angle = Q16_FROM_INT(-90); angle <= Q16_FROM_INT(90); angle += Q16_ONE / 16)
+    {
+        q16_t sine = SINE_TABLE_sin(angle);
+
+        ASSERT_EQUAL(-sine, SINE_TABLE_sin(-angle));
+        ASSERT_TRUE(sine >= previous);
+        previous = sine;
+    }
+}
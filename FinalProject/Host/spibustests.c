@@ -0,0 +1,320 @@
+#include <string.h>
+#include "ctest.h"
+#include "SpiBus.h"
+
+// Stand-in for SPI5 - logs what the bus does to it as a string, one letter per operation:
+//   C<n> configure for device n, S<n>/D<n> select/deselect device n, T start a background transfer,
+//   B blocking transfer, W wait for the bus
+typedef struct {
+    char log[256];
+    bool busy;                  // Background transfer in flight
+    const uint8_t *tx;
+    uint8_t *rx;
+    uint16_t size;
+    int fail_starts;            // Background transfers to refuse before taking one again
+    int selected;               // Devices selected at once - must never go above 1
+    int most_selected;
+    int locks;                  // Lock depth
+} FakeSpi_t;
+
+static FakeSpi_t spi;
+static SpiBus_t bus;
+// The first and last share a prescaler, like the LCD and the gyro
+static SpiDevice_t devices[3] = {{NULL, 1, 16}, {NULL, 2, 4}, {NULL, 3, 16}};
+
+static void note(char op, const SpiDevice_t *device)
+{
+    size_t length = strlen(spi.log);
+
+    spi.log[length] = op;
+
+    if(device != NULL)
+        spi.log[length + 1] = (char)('0' + (device - devices));
+}
+
+static void fake_configure(void *context, const SpiDevice_t *device)
+{
+    (void) &context;
+    note('C', device);
+}
+
+static void fake_chip_select(void *context, const SpiDevice_t *device, bool selected)
+{
+    (void) &context;
+    note(selected ? 'S' : 'D', device);
+
+    spi.selected += selected ? 1 : -1;
+
+    if(spi.selected > spi.most_selected)
+        spi.most_selected = spi.selected;
+}
+
+static bool fake_start_transfer(void *context, const uint8_t *tx, uint8_t *rx, uint16_t size)
+{
+    (void) &context;
+    note('T', NULL);
+
+    if(spi.fail_starts > 0)
+    {
+        spi.fail_starts --;
+        return false;
+    }
+
+    spi.busy = true;
+    spi.tx = tx;
+    spi.rx = rx;
+    spi.size = size;
+
+    return true;
+}
+
+static bool fake_transfer(void *context, const uint8_t *tx, uint8_t *rx, uint16_t size)
+{
+    (void) &context;
+    note('B', NULL);
+
+    // Loop back what is sent
+    if(rx != NULL)
+    {
+        for(uint16_t i = 0; i < size; i ++)
+            rx[i] = tx != NULL ? tx[i] : 0;
+    }
+
+    return !spi.busy;
+}
+
+static uint32_t fake_lock(void *context)
+{
+    (void) &context;
+
+    return spi.locks ++;
+}
+
+static void fake_unlock(void *context, uint32_t state)
+{
+    (void) &context;
+
+    spi.locks = state;
+}
+
+static void fake_wait(void *context);
+
+static const SpiBusPort_t fake_port = {
+    .configure = fake_configure,
+    .chip_select = fake_chip_select,
+    .start_transfer = fake_start_transfer,
+    .transfer = fake_transfer,
+    .lock = fake_lock,
+    .unlock = fake_unlock,
+    .wait = fake_wait,
+    .context = &spi
+};
+
+/**
+  * @brief The background transfer in flight finishes - the interrupt fires
+  */
+static void complete_transfer(bool ok)
+{
+    ASSERT_TRUE(spi.busy);
+
+    spi.busy = false;
+
+    if(spi.rx != NULL)
+        memset(spi.rx, 0xA5, spi.size);
+
+    SPI_BUS_on_transfer_complete(&bus, ok);
+}
+
+/**
+  * @brief A task waiting for the bus - the transfer in flight finishes while it waits
+  */
+static void fake_wait(void *context)
+{
+    (void) &context;
+    note('W', NULL);
+    complete_transfer(true);
+}
+
+/**
+  * @brief A transaction's done callback - records which transaction finished and how
+  */
+typedef struct {
+    int done;
+    bool ok;
+    const SpiTransaction_t *chain; // Submitted from the done callback
+} Completion_t;
+
+static void on_done(void *context, bool ok)
+{
+    Completion_t *completion = context;
+
+    completion->done ++;
+    completion->ok = ok;
+
+    if(completion->chain != NULL)
+        SPI_BUS_submit(&bus, completion->chain);
+}
+
+static void setup(void)
+{
+    memset(&spi, 0, sizeof(spi));
+    SPI_BUS_init(&bus, &fake_port);
+}
+
+CTEST(spi_bus, test_reconfigures_only_on_prescaler_change) {
+    uint8_t tx[2] = {0x8F, 0};
+    uint8_t rx[2];
+
+    setup();
+
+    ASSERT_TRUE(SPI_BUS_transfer(&bus, &devices[0], tx, rx, 2));
+    ASSERT_TRUE(SPI_BUS_transfer(&bus, &devices[0], tx, rx, 2));
+    ASSERT_TRUE(SPI_BUS_transfer(&bus, &devices[1], tx, NULL, 2));
+    ASSERT_TRUE(SPI_BUS_transfer(&bus, &devices[0], tx, rx, 2));
+
+    ASSERT_STR("C0S0BD0S0BD0C1S1BD1C0S0BD0", spi.log);
+    ASSERT_EQUAL(3, bus.reconfigurations);
+    ASSERT_EQUAL(4, bus.transactions);
+
+    // Switching between devices at the same prescaler leaves the peripheral alone
+    memset(spi.log, 0, sizeof(spi.log));
+    ASSERT_TRUE(SPI_BUS_transfer(&bus, &devices[2], tx, rx, 2));
+    ASSERT_TRUE(SPI_BUS_transfer(&bus, &devices[0], tx, rx, 2));
+    ASSERT_TRUE(SPI_BUS_transfer(&bus, &devices[2], tx, rx, 2));
+
+    ASSERT_STR("S2BD2S0BD0S2BD2", spi.log);
+    ASSERT_EQUAL(3, bus.reconfigurations);
+    ASSERT_EQUAL(7, bus.transactions);
+    ASSERT_EQUAL(0x8F, rx[0]);
+    ASSERT_EQUAL(0, spi.locks);
+}
+
+CTEST(spi_bus, test_queued_transactions_run_in_order) {
+    uint8_t rx[3][4];
+    Completion_t completions[3] = {0};
+    SpiTransaction_t transactions[3];
+
+    setup();
+
+    for(int i = 0; i < 3; i ++)
+        transactions[i] = (SpiTransaction_t){&devices[i == 2], NULL, rx[i], 4, on_done, &completions[i]};
+
+    // The first starts straight away, the others wait for it
+    ASSERT_TRUE(SPI_BUS_submit(&bus, &transactions[0]));
+    ASSERT_TRUE(SPI_BUS_submit(&bus, &transactions[1]));
+    ASSERT_STR("C0S0T", spi.log);
+
+    // The second is chained on from the first's interrupt, then submits the third from its own
+    completions[1].chain = &transactions[2];
+    complete_transfer(true);
+    ASSERT_EQUAL(1, completions[0].done);
+    ASSERT_TRUE(completions[0].ok);
+    ASSERT_EQUAL(0, completions[1].done);
+    complete_transfer(true);
+    complete_transfer(false);
+
+    ASSERT_STR("C0S0TD0S0TD0C1S1TD1", spi.log);
+    ASSERT_EQUAL(1, completions[2].done);
+    ASSERT_FALSE(completions[2].ok);
+    ASSERT_EQUAL(0xA5, rx[1][3]);
+    ASSERT_EQUAL(3, bus.transactions);
+    ASSERT_EQUAL(1, bus.errors);
+    ASSERT_EQUAL(1, spi.most_selected);
+    ASSERT_FALSE(spi.busy);
+}
+
+CTEST(spi_bus, test_blocking_transaction_holds_chip_select) {
+    uint8_t command = 0x2A;
+    uint8_t params[4] = {0, 0, 0, 239};
+    uint8_t rx[6];
+    Completion_t completion = {0};
+    SpiTransaction_t transaction = {&devices[1], NULL, rx, 6, on_done, &completion};
+
+    setup();
+
+    // A command and its parameters under one chip select - a transaction queued meanwhile waits
+    SPI_BUS_acquire(&bus, &devices[0]);
+    ASSERT_TRUE(SPI_BUS_exchange(&bus, &command, NULL, 1));
+    ASSERT_TRUE(SPI_BUS_submit(&bus, &transaction));
+    ASSERT_TRUE(SPI_BUS_exchange(&bus, params, NULL, 4));
+    ASSERT_FALSE(spi.busy);
+    SPI_BUS_release(&bus);
+
+    ASSERT_STR("C0S0BBD0C1S1T", spi.log);
+    ASSERT_TRUE(spi.busy);
+
+    // A blocking transaction waits for the queued one in flight
+    SPI_BUS_transfer(&bus, &devices[0], &command, NULL, 1);
+
+    ASSERT_STR("C0S0BBD0C1S1TWD1C0S0BD0", spi.log);
+    ASSERT_EQUAL(1, completion.done);
+    ASSERT_EQUAL(1, spi.most_selected);
+    ASSERT_EQUAL(0, spi.selected);
+    ASSERT_EQUAL(3, bus.transactions);
+}
+
+CTEST(spi_bus, test_full_queue_and_failed_start) {
+    uint8_t rx[2];
+    Completion_t completion = {0};
+    SpiTransaction_t transaction = {&devices[0], NULL, rx, 2, on_done, &completion};
+
+    setup();
+
+    // A failed start is returned by the submit, without the done callback, and leaves the bus free
+    spi.fail_starts = 1;
+    ASSERT_FALSE(SPI_BUS_submit(&bus, &transaction));
+    ASSERT_EQUAL(0, completion.done);
+    ASSERT_EQUAL(1, bus.errors);
+    ASSERT_NULL((void *)bus.active);
+    ASSERT_EQUAL(0, spi.selected);
+
+    // One in flight and a queue's worth waiting behind it, then no room
+    SPI_BUS_acquire(&bus, &devices[0]);
+
+    for(int i = 0; i < SPI_BUS_QUEUE_SIZE; i ++)
+        ASSERT_TRUE(SPI_BUS_submit(&bus, &transaction));
+
+    ASSERT_FALSE(SPI_BUS_submit(&bus, &transaction));
+    ASSERT_EQUAL(1, bus.queue_full);
+
+    SPI_BUS_release(&bus);
+
+    for(int i = 0; i < SPI_BUS_QUEUE_SIZE; i ++)
+        complete_transfer(true);
+
+    ASSERT_EQUAL(SPI_BUS_QUEUE_SIZE, completion.done);
+    ASSERT_FALSE(spi.busy);
+    ASSERT_EQUAL(0, spi.locks);
+}
+
+CTEST(spi_bus, test_failed_starts_dont_recurse) {
+    uint8_t rx[2][2];
+    Completion_t completions[2] = {0};
+    SpiTransaction_t transactions[2];
+
+    setup();
+
+    for(int i = 0; i < 2; i ++)
+        transactions[i] = (SpiTransaction_t){&devices[0], NULL, rx[i], 2, on_done, &completions[i]};
+
+    // The second resubmits itself when done, like the gyro stream retrying a read after an error
+    completions[1].chain = &transactions[1];
+
+    ASSERT_TRUE(SPI_BUS_submit(&bus, &transactions[0]));
+    ASSERT_TRUE(SPI_BUS_submit(&bus, &transactions[1]));
+
+    // Every start from here on fails. The second is told once from the first's interrupt, and its resubmit
+    // fails back to it rather than calling it again.
+    spi.fail_starts = 1000;
+    complete_transfer(true);
+
+    ASSERT_EQUAL(1, completions[0].done);
+    ASSERT_TRUE(completions[0].ok);
+    ASSERT_EQUAL(1, completions[1].done);
+    ASSERT_FALSE(completions[1].ok);
+    ASSERT_EQUAL(1000 - 2, spi.fail_starts);
+    ASSERT_EQUAL(2, bus.errors);
+    ASSERT_NULL((void *)bus.active);
+    ASSERT_EQUAL(0, spi.selected);
+    ASSERT_EQUAL(0, spi.locks);
+}
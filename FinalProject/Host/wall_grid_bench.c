@@ -0,0 +1,109 @@
+/*
+ * wall_grid_bench.c
+ *
+ * Host benchmark for the WallGrid broadphase. Builds a grid of 10k random segments and reports swept
+ * circle queries per second through the grid and by testing every segment.
+ *
+ * Usage:
+ *   wall_grid_bench [segments] [queries]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "WallGrid.h"
+
+#define FIELD_SIZE      1280    // Pixels
+#define BUCKET_SIZE     32      // Pixels
+#define SEGMENT_LENGTH  24      // Largest segment extent per axis in pixels
+#define MOVE_LENGTH     8       // Largest move per axis in pixels
+#define RADIUS          5
+
+static q16_t random_q16(int32_t min, int32_t max)
+{
+    return Q16_FROM_INT(min) + (q16_t)(((int64_t)rand() * Q16_FROM_INT(max - min)) / RAND_MAX);
+}
+
+static double elapsed(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, const char *argv[])
+{
+    static WallGrid_t grid;
+    int segment_count = argc > 1 ? atoi(argv[1]) : 10000;
+    int query_count = argc > 2 ? atoi(argv[2]) : 200000;
+    struct timespec start, end;
+    CollisionHit_t hit;
+
+    srand(1);
+
+    if(!WALL_GRID_init(&grid, 0, 0, Q16_FROM_INT(BUCKET_SIZE), FIELD_SIZE / BUCKET_SIZE, FIELD_SIZE / BUCKET_SIZE))
+        return 1;
+
+    for(int i = 0; i < segment_count; i ++)
+    {
+        q16_t x = random_q16(0, FIELD_SIZE), y = random_q16(0, FIELD_SIZE);
+        CollisionSegment_t segment = {x, y, x + random_q16(-SEGMENT_LENGTH, SEGMENT_LENGTH), y + random_q16(-SEGMENT_LENGTH, SEGMENT_LENGTH)};
+
+        if(!WALL_GRID_add_segment(&grid, &segment))
+        {
+            fprintf(stderr, "grid holds at most %d segments\n", WALL_GRID_MAX_SEGMENTS);
+            return 1;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if(!WALL_GRID_build(&grid))
+    {
+        fprintf(stderr, "bucket lists don't fit\n");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("%d segments, %dx%d buckets, %u entries, built in %.2f ms\n", segment_count, grid.columns, grid.rows,
+           grid.bucket_start[grid.columns * grid.rows], elapsed(&start, &end) * 1e3);
+
+    // Same queries for both
+    q16_t (*queries)[4] = malloc(sizeof(*queries) * query_count);
+    for(int i = 0; i < query_count; i ++)
+    {
+        queries[i][0] = random_q16(0, FIELD_SIZE);
+        queries[i][1] = random_q16(0, FIELD_SIZE);
+        queries[i][2] = random_q16(-MOVE_LENGTH, MOVE_LENGTH);
+        queries[i][3] = random_q16(-MOVE_LENGTH, MOVE_LENGTH);
+    }
+
+    int grid_hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < query_count; i ++)
+        grid_hits += WALL_GRID_sweep_circle(&grid, queries[i][0], queries[i][1], queries[i][2], queries[i][3], Q16_FROM_INT(RADIUS), &hit);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double grid_seconds = elapsed(&start, &end);
+    printf("grid:        %10.0f queries/s (%d hits)\n", query_count / grid_seconds, grid_hits);
+
+    // Every segment on a subset of the queries - it is much slower
+    int brute_count = query_count / 100;
+    int brute_hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < brute_count; i ++)
+    {
+        bool found = false;
+
+        for(int s = 0; s < grid.segment_count && !found; s ++)
+            found = COLLISION_sweep_circle_segment(queries[i][0], queries[i][1], queries[i][2], queries[i][3], Q16_FROM_INT(RADIUS), &grid.segments[s], &hit);
+
+        brute_hits += found;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double brute_seconds = elapsed(&start, &end);
+    printf("every segment: %8.0f queries/s\n", brute_count / brute_seconds);
+    printf("speedup: %.0fx\n", (query_count / grid_seconds) / (brute_count / brute_seconds));
+
+    free(queries);
+
+    return 0;
+}
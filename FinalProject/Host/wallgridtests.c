@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include "ctest.h"
+#include "WallGrid.h"
+
+#define TEST_SEGMENTS 300
+
+static q16_t random_q16(int32_t min, int32_t max)
+{
+    return Q16_FROM_INT(min) + (q16_t)(((int64_t)rand() * Q16_FROM_INT(max - min)) / RAND_MAX);
+}
+
+CTEST(wall_grid, test_shared_map_walls_added_once) {
+    static MapData_t map;
+    static WallGrid_t grid;
+
+    map.cell_count = 6;
+    map.cell_data[0][0] = MAP_BOTTOM_WALL | MAP_RIGHT_WALL;
+    map.cell_data[1][0] = MAP_TOP_WALL;
+    map.cell_data[0][1] = MAP_LEFT_WALL;
+    map.cell_data[5][5] = MAP_BOTTOM_WALL;
+
+    ASSERT_TRUE(WALL_GRID_init(&grid, Q16_FROM_INT(MAP_ORIGIN_X), Q16_FROM_INT(MAP_ORIGIN_Y), Q16_FROM_INT(MAP_CELL_SIZE), 6, 6));
+    ASSERT_TRUE(WALL_GRID_add_map_walls(&grid, &map));
+    ASSERT_EQUAL(3, grid.segment_count);
+    ASSERT_TRUE(WALL_GRID_build(&grid));
+
+    // The wall below cell (0, 0) stops a drone dropping from its center
+    CollisionHit_t hit;
+    ASSERT_TRUE(WALL_GRID_sweep_circle(&grid, Q16_FROM_INT(20), Q16_FROM_INT(60), 0, Q16_FROM_INT(30), Q16_FROM_INT(5), &hit));
+    ASSERT_EQUAL(Q16_FROM_RATIO(15, 30), hit.time);
+    ASSERT_EQUAL(-Q16_ONE, hit.normal_y);
+
+    // The bottom edge of the map is a wall as well
+    ASSERT_TRUE(WALL_GRID_sweep_circle(&grid, Q16_FROM_INT(220), Q16_FROM_INT(260), 0, Q16_FROM_INT(30), Q16_FROM_INT(5), &hit));
+}
+
+CTEST(wall_grid, test_map_first_wall) {
+    static MapData_t map;
+    static WallGrid_t grid;
+
+    map.cell_count = 6;
+
+    // Right walls on cells (0, 2) and (0, 4)
+    map.cell_data[0][2] = MAP_RIGHT_WALL;
+    map.cell_data[0][4] = MAP_RIGHT_WALL;
+
+    ASSERT_TRUE(WALL_GRID_init(&grid, Q16_FROM_INT(MAP_ORIGIN_X), Q16_FROM_INT(MAP_ORIGIN_Y), Q16_FROM_INT(MAP_CELL_SIZE), 6, 6));
+    ASSERT_TRUE(WALL_GRID_add_map_walls(&grid, &map));
+    ASSERT_TRUE(WALL_GRID_build(&grid));
+
+    CollisionHit_t hit;
+
+    // From the center of cell (0, 0), a 150 pixel move to the right stops at the first wall (x = 120), not
+    // the second or the map's edge
+    ASSERT_TRUE(WALL_GRID_sweep_circle(&grid, Q16_FROM_INT(20), Q16_FROM_INT(60), Q16_FROM_INT(150), 0, Q16_FROM_INT(5), &hit));
+    ASSERT_EQUAL(Q16_FROM_RATIO(120 - 5 - 20, 150), hit.time);
+    ASSERT_EQUAL(-Q16_ONE, hit.normal_x);
+
+    // Moving the other way from the same point there is nothing to hit
+    ASSERT_FALSE(WALL_GRID_sweep_circle(&grid, Q16_FROM_INT(20), Q16_FROM_INT(60), Q16_FROM_INT(-15), 0, Q16_FROM_INT(5), &hit));
+
+    // A row lower there are no walls short of the map's edge
+    ASSERT_FALSE(WALL_GRID_sweep_circle(&grid, Q16_FROM_INT(20), Q16_FROM_INT(100), Q16_FROM_INT(150), 0, Q16_FROM_INT(5), &hit));
+}
+
+CTEST(wall_grid, test_empty_grid_has_no_hits) {
+    static WallGrid_t grid;
+    CollisionHit_t hit;
+
+    ASSERT_TRUE(WALL_GRID_init(&grid, 0, 0, Q16_FROM_INT(32), 8, 8));
+    ASSERT_TRUE(WALL_GRID_build(&grid));
+    ASSERT_FALSE(WALL_GRID_sweep_circle(&grid, Q16_FROM_INT(100), Q16_FROM_INT(100), Q16_FROM_INT(50), Q16_FROM_INT(50), Q16_FROM_INT(5), &hit));
+}
+
+CTEST(wall_grid, test_rejects_too_many_buckets) {
+    static WallGrid_t grid;
+
+    ASSERT_FALSE(WALL_GRID_init(&grid, 0, 0, Q16_FROM_INT(1), WALL_GRID_MAX_BUCKETS, 2));
+}
+
+CTEST(wall_grid, test_matches_brute_force) {
+    static WallGrid_t grid;
+
+    srand(3753);
+
+    // 10 x 10 buckets of 32 pixels, with some segments sticking out of the grid
+    ASSERT_TRUE(WALL_GRID_init(&grid, 0, 0, Q16_FROM_INT(32), 10, 10));
+
+    for(int i = 0; i < TEST_SEGMENTS; i ++)
+    {
+        q16_t x = random_q16(-20, 340), y = random_q16(-20, 340);
+        CollisionSegment_t segment = {x, y, x + random_q16(-30, 30), y + random_q16(-30, 30)};
+
+        ASSERT_TRUE(WALL_GRID_add_segment(&grid, &segment));
+    }
+
+    ASSERT_TRUE(WALL_GRID_build(&grid));
+
+    for(int i = 0; i < 5000; i ++)
+    {
+        q16_t x = random_q16(-30, 350), y = random_q16(-30, 350);
+        q16_t dx = random_q16(-60, 60), dy = random_q16(-60, 60);
+        q16_t radius = random_q16(1, 20);
+        CollisionHit_t grid_hit, hit, best = {0};
+        bool expected = false;
+
+        for(int s = 0; s < grid.segment_count; s ++)
+        {
+            if(COLLISION_sweep_circle_segment(x, y, dx, dy, radius, &grid.segments[s], &hit) && (!expected || hit.time < best.time))
+            {
+                best = hit;
+                expected = true;
+            }
+        }
+
+        ASSERT_EQUAL(expected, WALL_GRID_sweep_circle(&grid, x, y, dx, dy, radius, &grid_hit));
+
+        if(expected)
+            ASSERT_EQUAL(best.time, grid_hit.time);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * Autopilot.h
+ *
+ * Plays the game without a human, for long unattended runs. AUTOPILOT_plan runs an A* search over the
+ * map's cells from the drone to every remaining waypoint in turn and keeps the route's turning points;
+ * AUTOPILOT_steer then works out, every physics tick, the board angle that moves the drone to the next
+ * turning point. All search state is preallocated in Autopilot_t - nothing is allocated at run time.
+ */
+
+#ifndef INC_AUTOPILOT_H_
+#define INC_AUTOPILOT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FixedPoint.h"
+#include "Map.h"
+#include "Game.h"
+
+#define AUTOPILOT_MAX_CELLS (MAP_MAX_CELL_COUNT * MAP_MAX_CELL_COUNT)
+
+// Every leg visits each cell at most once
+#define AUTOPILOT_MAX_ROUTE (MAP_MAX_WAYPOINTS * AUTOPILOT_MAX_CELLS)
+
+// Steering
+#define AUTOPILOT_MAX_TILT          Q16_FROM_INT(20)        // Physics tilt in degrees, well inside MAX_TILT_ANGLE
+#define AUTOPILOT_MAX_SPEED         Q16_FROM_RATIO(9, 4)    // Pixels per tick
+#define AUTOPILOT_POSITION_GAIN     Q16_FROM_RATIO(1, 8)    // Speed toward the target per pixel away from it
+#define AUTOPILOT_VELOCITY_GAIN     Q16_FROM_RATIO(1, 2)    // Acceleration per pixel per tick of speed error
+#define AUTOPILOT_ARRIVE_RADIUS     Q16_FROM_INT(6)         // Turning point reached within this many pixels
+
+typedef struct {
+    // A* search over cell indices (row * cell_count + col)
+    uint16_t cost[AUTOPILOT_MAX_CELLS];             // Steps from the start of the leg
+    uint16_t estimate[AUTOPILOT_MAX_CELLS];         // cost + distance left to the goal
+    uint16_t parent[AUTOPILOT_MAX_CELLS];
+    uint16_t heap_position[AUTOPILOT_MAX_CELLS];    // Where every open cell is in heap
+    uint8_t state[AUTOPILOT_MAX_CELLS];             // Not seen, open or closed
+    uint16_t heap[AUTOPILOT_MAX_CELLS];             // Open cells, binary min heap on estimate
+    uint16_t heap_count;
+
+    // Route through the remaining waypoints
+    uint8_t cell_count;
+    uint16_t route[AUTOPILOT_MAX_ROUTE];            // Cell indices - turning points once planned
+    uint32_t route_length;
+    uint32_t route_index;                           // Turning point being steered to
+} Autopilot_t;
+
+bool AUTOPILOT_find_path(Autopilot_t *pilot, const MapData_t *map, uint16_t start, uint16_t goal);
+bool AUTOPILOT_plan(Autopilot_t *pilot, const MapData_t *map, int32_t x, int32_t y, uint8_t first_waypoint);
+void AUTOPILOT_steer(Autopilot_t *pilot, const GameState_t *game, q16_t *board_angle_x, q16_t *board_angle_y);
+
+#endif /* INC_AUTOPILOT_H_ */
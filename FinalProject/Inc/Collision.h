@@ -0,0 +1,39 @@
+/*
+ * Collision.h
+ *
+ * Continuous (swept) collision between the drone, a moving circle, and wall segments. Instead of testing
+ * where the drone ends up after a tick, the whole move is tested, so a fast drone can't skip over a wall
+ * between two physics updates. All math is Q16.16 fixed point.
+ */
+
+#ifndef INC_COLLISION_H_
+#define INC_COLLISION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FixedPoint.h"
+#include "Map.h"
+
+// Moves are tested in steps of at most this many pixels per axis, which keeps every intermediate
+// product inside 64 bits. Longer moves are split automatically.
+#define COLLISION_MAX_STEP          Q16_FROM_INT(MAP_CELL_SIZE)
+
+// Largest supported circle radius
+#define COLLISION_MAX_RADIUS        Q16_FROM_INT(MAP_CELL_SIZE / 2)
+
+// Wall segment, in pixels
+typedef struct {
+    q16_t x1, y1;
+    q16_t x2, y2;
+} CollisionSegment_t;
+
+// First contact of a swept circle
+typedef struct {
+    q16_t time;         // Fraction of the move completed at first contact, 0 to Q16_ONE
+    q16_t normal_x;     // Unit contact normal - points from the wall toward the circle
+    q16_t normal_y;
+} CollisionHit_t;
+
+bool COLLISION_sweep_circle_segment(q16_t x, q16_t y, q16_t dx, q16_t dy, q16_t radius, const CollisionSegment_t *segment, CollisionHit_t *hit);
+
+#endif /* INC_COLLISION_H_ */
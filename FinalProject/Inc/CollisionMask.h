@@ -0,0 +1,39 @@
+/*
+ * CollisionMask.h
+ *
+ * One bit per pixel occupancy mask of the playfield. Walls and holes are baked into the mask once per
+ * map, after which "is anything under this disk" is a handful of AND-and-test operations on 32 bit
+ * words, whatever the wall layout. The game uses it as a fast path: when nothing is within reach of
+ * the drone, the swept wall test and the hole lookup are skipped.
+ */
+
+#ifndef INC_COLLISIONMASK_H_
+#define INC_COLLISIONMASK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Map.h"
+
+// Playfield size in pixels - the part of the screen below the status bar
+#define COLLISION_MASK_WIDTH    240
+#define COLLISION_MASK_HEIGHT   240
+#define COLLISION_MASK_WORDS    ((COLLISION_MASK_WIDTH + 31) / 32)     // 32 bit words per row
+
+// Largest disk that can be tested
+#define COLLISION_MASK_MAX_RADIUS 31
+
+typedef struct {
+    uint32_t rows[COLLISION_MASK_HEIGHT][COLLISION_MASK_WORDS];       // Bit x % 32 of word x / 32 is pixel x
+} CollisionMask_t;
+
+// Disk footprint - half width of every row, precomputed once per radius
+typedef struct {
+    uint8_t radius;
+    uint8_t half_width[(2 * COLLISION_MASK_MAX_RADIUS) + 1];
+} CollisionDisk_t;
+
+void COLLISION_MASK_make_disk(CollisionDisk_t *disk, uint8_t radius);
+void COLLISION_MASK_bake(CollisionMask_t *mask, const MapData_t *map, uint8_t hole_radius);
+bool COLLISION_MASK_test_disk(const CollisionMask_t *mask, const CollisionDisk_t *disk, int32_t x, int32_t y);
+
+#endif /* INC_COLLISIONMASK_H_ */
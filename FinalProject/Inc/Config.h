@@ -2,6 +2,18 @@
 #define CONFIG_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+// 1 - build for the profile in ConfigProfile.h (make profile in Host): config is constant and the CONFIG_
+// accessors below are compile time constants, so the compiler can fold them into the map and collision loops.
+// 0 - config is filled in at run time by GAME_default_config.
+#ifndef CONFIG_STATIC_PROFILE
+#define CONFIG_STATIC_PROFILE 0
+#endif
+
+// Layout of struct ConfigData_t - bump it when the struct or the defaults change, so configs saved to flash by
+// an older build are passed over
+#define CONFIG_VERSION 1
 
 //----------------------------------------------------------------
 // Data structure declarations
@@ -31,7 +43,7 @@
 // Physics config
 [[maybe_unused]] typedef struct {
     uint32_t gravity;                                    // kg*cm / s^2
-    uint32_t update_frequency;                           // Hz
+    uint32_t update_period;                              // ms between physics ticks
     uint32_t angle_gain;                                 // 0 - 1000 (1000 means physics angle is equivalent to gyro angle)
     uint8_t pin_at_center;                               // Pin either the drone or the map at the center of the screen
 } PhysicsConfig_t;
@@ -43,7 +55,7 @@
 } GameConfig_t;
 
 // Overall config
-[[maybe_unused]] static struct ConfigData_t {
+struct ConfigData_t {
 
     uint8_t version;
 
@@ -52,12 +64,44 @@
     PhysicsConfig_t physics_config;
     GameConfig_t game_config;
 
-} config;
+};
 
 
 //----------------------------------------------------------------
-// Default data values
+// The config - defined once, in Config.c
 //----------------------------------------------------------------
 
+#if CONFIG_STATIC_PROFILE
+#include "ConfigProfile.h"
+
+extern const struct ConfigData_t config;
+
+#define CONFIG_MAP_CELL_COUNT(data)                     CONFIG_PROFILE_MAP_CELL_COUNT
+#define CONFIG_MAP_HOLE_RADIUS(data)                    CONFIG_PROFILE_MAP_HOLE_RADIUS
+#define CONFIG_MAP_WAYPOINT_RADIUS(data)                CONFIG_PROFILE_MAP_WAYPOINT_RADIUS
+#define CONFIG_DRONE_DIAMETER(data)                     CONFIG_PROFILE_DRONE_DIAMETER
+#define CONFIG_DRONE_MAX_VELOCITY(data)                 CONFIG_PROFILE_DRONE_MAX_VELOCITY
+#define CONFIG_DRONE_MAX_ENERGY(data)                   CONFIG_PROFILE_DRONE_MAX_ENERGY
+#define CONFIG_DRONE_DISRUPTOR_POWER(data)              CONFIG_PROFILE_DRONE_DISRUPTOR_POWER
+#define CONFIG_DRONE_DISRUPTOR_MIN_ACTIVATION_ENERGY(data) CONFIG_PROFILE_DRONE_DISRUPTOR_MIN_ACTIVATION_ENERGY
+#define CONFIG_DRONE_RECHARGE_RATE(data)                CONFIG_PROFILE_DRONE_RECHARGE_RATE
+#define CONFIG_PHYSICS_UPDATE_PERIOD(data)              CONFIG_PROFILE_PHYSICS_UPDATE_PERIOD
+#define CONFIG_GAME_TIME_TO_COMPLETE(data)              CONFIG_PROFILE_GAME_TIME_TO_COMPLETE
+#else
+extern struct ConfigData_t config;
+
+#define CONFIG_MAP_CELL_COUNT(data)                     ((data)->map_config.cell_count)
+#define CONFIG_MAP_HOLE_RADIUS(data)                    ((data)->map_config.hole_radius)
+#define CONFIG_MAP_WAYPOINT_RADIUS(data)                ((data)->map_config.waypoint_radius)
+#define CONFIG_DRONE_DIAMETER(data)                     ((data)->drone_config.diameter)
+#define CONFIG_DRONE_MAX_VELOCITY(data)                 ((data)->drone_config.max_velocity)
+#define CONFIG_DRONE_MAX_ENERGY(data)                   ((data)->drone_config.max_energy)
+#define CONFIG_DRONE_DISRUPTOR_POWER(data)              ((data)->drone_config.disruptor_power)
+#define CONFIG_DRONE_DISRUPTOR_MIN_ACTIVATION_ENERGY(data) ((data)->drone_config.disruptor_min_activation_energy)
+#define CONFIG_DRONE_RECHARGE_RATE(data)                ((data)->drone_config.recharge_rate)
+#define CONFIG_PHYSICS_UPDATE_PERIOD(data)              ((data)->physics_config.update_period)
+#define CONFIG_GAME_TIME_TO_COMPLETE(data)              ((data)->game_config.time_to_complete)
+#endif
+
 
 #endif
\ No newline at end of file
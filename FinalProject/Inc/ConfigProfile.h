@@ -0,0 +1,69 @@
+/*
+ * ConfigProfile.h
+ *
+ * Generated by Host/config_profile_gen from GAME_default_config - do not edit.
+ */
+
+#ifndef INC_CONFIGPROFILE_H_
+#define INC_CONFIGPROFILE_H_
+
+#define CONFIG_PROFILE_VERSION 1
+
+#define CONFIG_PROFILE_MAP_CELL_COUNT 6
+#define CONFIG_PROFILE_MAP_WALL_PROBABILITY 150u
+#define CONFIG_PROFILE_MAP_HOLE_PROBABILITY 150u
+#define CONFIG_PROFILE_MAP_NUM_WAYPOINTS 4
+#define CONFIG_PROFILE_MAP_HOLE_RADIUS 10
+#define CONFIG_PROFILE_MAP_WAYPOINT_RADIUS 15
+
+#define CONFIG_PROFILE_DRONE_DISRUPTOR_MAX_TIME 1000u
+#define CONFIG_PROFILE_DRONE_DISRUPTOR_POWER 10000u
+#define CONFIG_PROFILE_DRONE_DISRUPTOR_MIN_ACTIVATION_ENERGY 6000u
+#define CONFIG_PROFILE_DRONE_MAX_ENERGY 15000u
+#define CONFIG_PROFILE_DRONE_RECHARGE_RATE 1000u
+#define CONFIG_PROFILE_DRONE_DIAMETER 10u
+#define CONFIG_PROFILE_DRONE_MAX_VELOCITY 2500
+
+#define CONFIG_PROFILE_PHYSICS_GRAVITY 980u
+#define CONFIG_PROFILE_PHYSICS_UPDATE_PERIOD 50u
+#define CONFIG_PROFILE_PHYSICS_ANGLE_GAIN 500u
+#define CONFIG_PROFILE_PHYSICS_PIN_AT_CENTER 1
+
+#define CONFIG_PROFILE_GAME_TIME_TO_COMPLETE 30000u
+#define CONFIG_PROFILE_GAME_HARD_EDGED true
+#define CONFIG_PROFILE_GAME_REUSE_WAYPOINTS false
+
+// Initializer for the constant config
+#define CONFIG_PROFILE { \
+    .version = CONFIG_PROFILE_VERSION, \
+    .map_config = { \
+        .cell_count = CONFIG_PROFILE_MAP_CELL_COUNT, \
+        .wall_probability = CONFIG_PROFILE_MAP_WALL_PROBABILITY, \
+        .hole_probability = CONFIG_PROFILE_MAP_HOLE_PROBABILITY, \
+        .num_waypoints = CONFIG_PROFILE_MAP_NUM_WAYPOINTS, \
+        .hole_radius = CONFIG_PROFILE_MAP_HOLE_RADIUS, \
+        .waypoint_radius = CONFIG_PROFILE_MAP_WAYPOINT_RADIUS \
+    }, \
+    .drone_config = { \
+        .disruptor_max_time = CONFIG_PROFILE_DRONE_DISRUPTOR_MAX_TIME, \
+        .disruptor_power = CONFIG_PROFILE_DRONE_DISRUPTOR_POWER, \
+        .disruptor_min_activation_energy = CONFIG_PROFILE_DRONE_DISRUPTOR_MIN_ACTIVATION_ENERGY, \
+        .max_energy = CONFIG_PROFILE_DRONE_MAX_ENERGY, \
+        .recharge_rate = CONFIG_PROFILE_DRONE_RECHARGE_RATE, \
+        .diameter = CONFIG_PROFILE_DRONE_DIAMETER, \
+        .max_velocity = CONFIG_PROFILE_DRONE_MAX_VELOCITY \
+    }, \
+    .physics_config = { \
+        .gravity = CONFIG_PROFILE_PHYSICS_GRAVITY, \
+        .update_period = CONFIG_PROFILE_PHYSICS_UPDATE_PERIOD, \
+        .angle_gain = CONFIG_PROFILE_PHYSICS_ANGLE_GAIN, \
+        .pin_at_center = CONFIG_PROFILE_PHYSICS_PIN_AT_CENTER \
+    }, \
+    .game_config = { \
+        .time_to_complete = CONFIG_PROFILE_GAME_TIME_TO_COMPLETE, \
+        .hard_edged = CONFIG_PROFILE_GAME_HARD_EDGED, \
+        .reuse_waypoints = CONFIG_PROFILE_GAME_REUSE_WAYPOINTS \
+    } \
+}
+
+#endif /* INC_CONFIGPROFILE_H_ */
@@ -0,0 +1,60 @@
+/*
+ * ConfigStore.h
+ *
+ * Append-only store of versioned config records in two flash sectors. Each record is a header and the config
+ * bytes as they are in memory, so the latest one is used in place - CONFIG_STORE_find returns a pointer into
+ * flash, nothing is copied or decoded.
+ *
+ *   - Records are appended to the active sector. When it is full the other sector is erased and the new record
+ *     starts it, so the two sectors take turns being erased and wear evenly.
+ *   - A record is only valid once its magic word is programmed, which is done last, and its CRC matches. A
+ *     record cut short by a reset is skipped; the one before it is still the latest.
+ *   - Every record has a sequence number one higher than the last, which tells which sector is active.
+ *
+ * The store doesn't touch the HAL - flash is read through the sector pointers and erased and programmed through
+ * ConfigStorePort_t, so it runs the same on the host against emulated flash.
+ */
+
+#ifndef INC_CONFIGSTORE_H_
+#define INC_CONFIGSTORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CONFIG_STORE_MAGIC 0x43464731 // "CFG1"
+#define CONFIG_STORE_ERASED 0xFFFFFFFF
+#define CONFIG_STORE_MAX_SIZE 1024 // Largest record payload in bytes
+
+typedef struct {
+    uint32_t magic;         // CONFIG_STORE_MAGIC once the record is complete - programmed last
+    uint32_t sequence;      // One higher than the record before it
+    uint16_t version;       // Layout version of the payload
+    uint16_t size;          // Payload bytes - the next record starts at the next word after the payload
+    uint32_t crc;           // CRC-32 of the payload
+} ConfigRecord_t;
+
+typedef struct {
+    bool (*erase)(void *context, uint8_t sector);                   // Sets the whole sector to 0xFF
+    bool (*program)(void *context, uintptr_t address, uint32_t word); // Clears bits of one aligned word
+    void *context;
+} ConfigStorePort_t;
+
+typedef struct {
+    ConfigStorePort_t port;
+    const uint8_t *sectors[2];  // Memory mapped, word aligned
+    uint32_t sector_size;
+
+    uint8_t active;             // Sector records are appended to
+    uint32_t end;               // Offset of the next record in the active sector
+    uint32_t sequence;          // Sequence number of the latest record, 0 if there are none
+
+    uint32_t erases;            // Sectors erased since init
+} ConfigStore_t;
+
+void CONFIG_STORE_init(ConfigStore_t *store, const ConfigStorePort_t *port, const uint8_t *sector_0,
+                       const uint8_t *sector_1, uint32_t sector_size);
+const void *CONFIG_STORE_find(const ConfigStore_t *store, uint16_t version, uint16_t size);
+bool CONFIG_STORE_save(ConfigStore_t *store, uint16_t version, const void *data, uint16_t size);
+uint32_t CONFIG_STORE_crc(const uint8_t *data, uint32_t size);
+
+#endif /* INC_CONFIGSTORE_H_ */
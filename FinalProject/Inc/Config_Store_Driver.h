@@ -0,0 +1,27 @@
+/*
+ * Config_Store_Driver.h
+ *
+ * HAL port for the ConfigStore - the last two sectors of flash bank 2. The code runs from bank 1, so erasing
+ * and programming these doesn't stall it. Nothing else may be linked into them.
+ */
+
+#ifndef INC_CONFIG_STORE_DRIVER_H_
+#define INC_CONFIG_STORE_DRIVER_H_
+
+#include "stm32f4xx_hal.h"
+#include "ConfigStore.h"
+#include "Config.h"
+
+#define CONFIG_STORE_SECTOR_0 FLASH_SECTOR_22
+#define CONFIG_STORE_SECTOR_1 FLASH_SECTOR_23
+#define CONFIG_STORE_SECTOR_0_ADDRESS 0x081C0000
+#define CONFIG_STORE_SECTOR_1_ADDRESS 0x081E0000
+#define CONFIG_STORE_SECTOR_SIZE (128 * 1024)
+
+extern ConfigStore_t config_store;
+
+void Config_Store_Init(void);
+const struct ConfigData_t *Config_Store_Load(void);
+bool Config_Store_Save(const struct ConfigData_t *data);
+
+#endif /* INC_CONFIG_STORE_DRIVER_H_ */
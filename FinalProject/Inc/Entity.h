@@ -0,0 +1,62 @@
+/*
+ * Entity.h
+ *
+ * Store for every moving body on the board - the drone, balls, moving obstacles. The store is laid out
+ * as a struct of arrays: each property of every entity is kept in its own array, so a pass over one
+ * property (add gravity to every velocity, add every velocity to its position) walks contiguous memory
+ * and is a simple loop the compiler can unroll or vectorise.
+ *
+ * Entities are packed into indices 0 to count - 1. Removing one moves the last entity into its place, so
+ * the passes never have to skip holes.
+ */
+
+#ifndef INC_ENTITY_H_
+#define INC_ENTITY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FixedPoint.h"
+#include "CollisionMask.h"
+#include "WallGrid.h"
+
+#ifndef ENTITY_MAX_COUNT
+#define ENTITY_MAX_COUNT 8
+#endif
+
+// Entity flags
+#define ENTITY_PASS_WALLS       0x01    // Pushed through walls instead of sliding along them
+#define ENTITY_NEAR_HAZARD      0x02    // Set by ENTITY_step - a wall or hole was within reach this tick
+
+// Walls an entity can slide along in one tick (two for a corner)
+#define ENTITY_MAX_WALL_CONTACTS 2
+
+// Shared by every entity in a store
+typedef struct {
+    q16_t radius;                       // Pixels
+    q16_t max_velocity;                 // Pixels per tick, per axis
+    q16_t wall_pass_gain;               // Move multiplier for ENTITY_PASS_WALLS entities hitting a wall
+    q16_t min_x, min_y, max_x, max_y;   // Where the center can go - velocity toward an edge stops there
+} EntityConfig_t;
+
+typedef struct {
+    EntityConfig_t config;
+    CollisionDisk_t reach;              // Everything an entity can touch within one tick
+
+    uint16_t count;
+    q16_t pos_x[ENTITY_MAX_COUNT];      // Screen position in pixels
+    q16_t pos_y[ENTITY_MAX_COUNT];
+    q16_t vel_x[ENTITY_MAX_COUNT];      // Screen velocity in pixels per tick
+    q16_t vel_y[ENTITY_MAX_COUNT];
+    q16_t prev_x[ENTITY_MAX_COUNT];     // Position before the last tick - for render interpolation
+    q16_t prev_y[ENTITY_MAX_COUNT];
+    uint8_t flags[ENTITY_MAX_COUNT];
+} EntityStore_t;
+
+int32_t ENTITY_reach(const EntityConfig_t *config);
+bool ENTITY_init(EntityStore_t *store, const EntityConfig_t *config);
+int32_t ENTITY_add(EntityStore_t *store, q16_t x, q16_t y, uint8_t flags);
+void ENTITY_remove(EntityStore_t *store, uint16_t index);
+void ENTITY_accelerate(EntityStore_t *store, q16_t accel_x, q16_t accel_y);
+void ENTITY_step(EntityStore_t *store, const CollisionMask_t *mask, WallGrid_t *grid);
+
+#endif /* INC_ENTITY_H_ */
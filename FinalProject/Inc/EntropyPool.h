@@ -0,0 +1,58 @@
+/*
+ * EntropyPool.h
+ *
+ * Buffers words from the true random number generator so they can be taken without waiting on it. The TRNG
+ * only has a new word every 40 of its clocks; its interrupt pushes each one into a ring here, and is stopped
+ * while the ring is full. Taking a word never waits - if the ring has run dry the word comes from a xorshift
+ * generator instead, seeded from the TRNG and stirred with every word taken from the ring.
+ *
+ * Each word is compared with the one before it and dropped if they match, and the first word after the
+ * generator is (re)started is only kept for the comparison - the continuous test the reference manual asks for.
+ *
+ * The ring is lock free with one producer and one consumer: ENTROPY_POOL_on_word runs in the RNG interrupt and
+ * only moves head, ENTROPY_POOL_take runs in a task and only moves tail. The interrupt is reached through
+ * EntropyPoolPort_t, so the pool runs the same on the host against a stand-in generator.
+ */
+
+#ifndef INC_ENTROPYPOOL_H_
+#define INC_ENTROPYPOOL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Words buffered - must be a power of two
+#ifndef ENTROPY_POOL_SIZE
+#define ENTROPY_POOL_SIZE 16
+#endif
+
+typedef struct {
+    void (*start)(void *context);   // Enable the data ready interrupt
+    void (*stop)(void *context);    // Disable it - called from the interrupt when the ring is full
+    void *context;
+} EntropyPoolPort_t;
+
+typedef struct {
+    EntropyPoolPort_t port;
+
+    volatile uint32_t words[ENTROPY_POOL_SIZE];
+    volatile uint16_t head;         // Next word written, by the interrupt - free running
+    volatile uint16_t tail;         // Next word taken, by the task - free running
+    volatile bool running;          // Data ready interrupt enabled
+
+    uint32_t last;                  // Last word from the generator, for the continuous test
+    bool primed;                    // last is valid
+
+    uint32_t fallback;              // xorshift state, never 0
+
+    uint32_t repeats;               // Words dropped for matching the one before
+    uint32_t fallbacks;             // Words taken while the ring was empty
+} EntropyPool_t;
+
+void ENTROPY_POOL_init(EntropyPool_t *pool, const EntropyPoolPort_t *port, uint32_t seed);
+void ENTROPY_POOL_start(EntropyPool_t *pool);
+void ENTROPY_POOL_on_word(EntropyPool_t *pool, uint32_t word);
+void ENTROPY_POOL_on_restart(EntropyPool_t *pool);
+uint32_t ENTROPY_POOL_take(EntropyPool_t *pool);
+uint16_t ENTROPY_POOL_available(const EntropyPool_t *pool);
+
+#endif /* INC_ENTROPYPOOL_H_ */
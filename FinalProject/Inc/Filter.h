@@ -0,0 +1,55 @@
+/*
+ * Filter.h
+ *
+ * Fixed point IIR filters for the gyro - a biquad (second order section) and a DC blocker. Each call runs a
+ * whole block of samples, so a FIFO burst is filtered in one go with the state kept in registers.
+ *
+ * Coefficients are Q2.30 and are designed offline by Host/filter_design into FilterCoefficients.c
+ * (make filters) from the FILTER_GYRO_ parameters below. The filter state keeps FILTER_STATE_SHIFT fraction
+ * bits below the 16 bit samples, so the rounding of the feedback path doesn't turn into a DC error at low
+ * cut-offs. Samples saturate instead of wrapping.
+ */
+
+#ifndef INC_FILTER_H_
+#define INC_FILTER_H_
+
+#include <stdint.h>
+
+#define FILTER_COEFFICIENT_SHIFT 30 // Q2.30 - coefficients from -2 to 2
+#define FILTER_STATE_SHIFT       8  // Fraction bits kept below a sample in the filter state
+
+// Gyro filter design - regenerate FilterCoefficients.c after changing these
+#define FILTER_GYRO_SAMPLE_RATE_HZ  190     // Must match GYRO_DATA_RATE_HZ
+#define FILTER_GYRO_LOW_PASS_HZ     12.0    // Butterworth low pass cut-off - tilting the board is well below this
+#define FILTER_GYRO_LOW_PASS_Q      0.70710678
+#define FILTER_GYRO_DC_BLOCK_HZ     0.05    // DC blocker cut-off - a high pass, so it isn't run ahead of the angle
+                                            // integrator: a held turn would decay with a time constant of
+                                            // 1 / (2 pi 0.05 Hz) = 3.2 s and the tilt would creep back. The
+                                            // zero rate offset is tracked by GyroRate instead
+
+typedef struct {
+    int32_t b0, b1, b2;     // Feed forward, Q2.30
+    int32_t a1, a2;         // Feedback, Q2.30 - y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+} BiquadCoefficients_t;
+
+typedef struct {
+    const BiquadCoefficients_t *coefficients;
+    int32_t x1, x2;         // Last inputs
+    int32_t y1, y2;         // Last outputs, with FILTER_STATE_SHIFT fraction bits
+} Biquad_t;
+
+typedef struct {
+    int32_t pole;           // Q2.30, just under 1 - y[n] = x[n] - x[n-1] + pole y[n-1]
+    int32_t x1;             // Last input
+    int32_t y1;             // Last output, with FILTER_STATE_SHIFT fraction bits
+} DcBlocker_t;
+
+extern const BiquadCoefficients_t gyro_low_pass_coefficients;
+extern const int32_t gyro_dc_block_pole;
+
+void FILTER_biquad_init(Biquad_t *filter, const BiquadCoefficients_t *coefficients);
+void FILTER_biquad_process(Biquad_t *filter, const int16_t *input, int16_t *output, uint16_t count);
+void FILTER_dc_blocker_init(DcBlocker_t *filter, int32_t pole);
+void FILTER_dc_blocker_process(DcBlocker_t *filter, const int16_t *input, int16_t *output, uint16_t count);
+
+#endif /* INC_FILTER_H_ */
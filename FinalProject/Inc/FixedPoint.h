@@ -0,0 +1,46 @@
+/*
+ * FixedPoint.h
+ *
+ * Q16.16 and Q1.15 fixed point math. The core runs with the FPU disabled, so the game loop uses these
+ * instead of float/double. Every operation saturates instead of wrapping on overflow.
+ */
+
+#ifndef INC_FIXEDPOINT_H_
+#define INC_FIXEDPOINT_H_
+
+#include <stdint.h>
+
+typedef int32_t q16_t;  // 16 integer bits, 16 fraction bits
+typedef int16_t q15_t;  // -1 to 1 - 1/32768
+
+#define Q16_SHIFT   16
+#define Q16_ONE     ((q16_t)1 << Q16_SHIFT)
+#define Q16_HALF    (Q16_ONE / 2)
+#define Q16_MAX     INT32_MAX
+#define Q16_MIN     INT32_MIN
+
+#define Q15_SHIFT   15
+#define Q15_ONE     INT16_MAX   // Closest value to 1
+#define Q15_MAX     INT16_MAX
+#define Q15_MIN     INT16_MIN
+
+// Conversions - integer arguments must fit in 16 bits
+#define Q16_FROM_INT(i)             ((q16_t)((uint32_t)(int32_t)(i) << Q16_SHIFT))
+#define Q16_TO_INT(q)               ((int32_t)(q) >> Q16_SHIFT)                         // Rounds toward -infinity
+#define Q16_ROUND_TO_INT(q)         ((int32_t)((q) + Q16_HALF) >> Q16_SHIFT)
+#define Q16_FROM_RATIO(num, den)    ((q16_t)((((int64_t)(num) * Q16_ONE) + ((den) / 2)) / (den)))   // num / den, rounded
+
+q16_t FIXED_add(q16_t a, q16_t b);
+q16_t FIXED_sub(q16_t a, q16_t b);
+q16_t FIXED_mul(q16_t a, q16_t b);
+q16_t FIXED_div(q16_t a, q16_t b);
+q16_t FIXED_abs(q16_t a);
+q16_t FIXED_sqrt(q16_t a);
+q16_t FIXED_sqrt_q32(int64_t a);
+q16_t FIXED_reciprocal(q16_t a);
+
+q15_t FIXED_q15_mul(q15_t a, q15_t b);
+q15_t FIXED_q16_to_q15(q16_t a);
+q16_t FIXED_q15_to_q16(q15_t a);
+
+#endif /* INC_FIXEDPOINT_H_ */
@@ -0,0 +1,48 @@
+/*
+ * FlowField.h
+ *
+ * Per-cell route to a target cell, built by a breadth first search over the map's walls. Every cell
+ * stores, in one byte, the direction of the next cell on a shortest path to the target and the
+ * number of cells left to travel. Holes are never entered. The field only changes when the target
+ * changes, so the drone's route can then be looked up in constant time every tick.
+ */
+
+#ifndef INC_FLOWFIELD_H_
+#define INC_FLOWFIELD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Map.h"
+
+/* Cell byte
+ * 0b00000111  - Direction of the next cell on the route (FLOW_*)
+ * 0b11111000  - Cells left to the target, saturates at FLOW_FIELD_MAX_DISTANCE
+*/
+#define FLOW_FIELD_DIRECTION_MASK   0x07
+#define FLOW_FIELD_DISTANCE_SHIFT   3
+#define FLOW_FIELD_MAX_DISTANCE     31
+
+#define FLOW_FIELD_DIRECTION(cell)  ((cell) & FLOW_FIELD_DIRECTION_MASK)
+#define FLOW_FIELD_DISTANCE(cell)   ((cell) >> FLOW_FIELD_DISTANCE_SHIFT)
+
+// Directions
+#define FLOW_NONE       0   // Target can't be reached from this cell (or the position is off the map)
+#define FLOW_UP         1
+#define FLOW_DOWN       2
+#define FLOW_LEFT       3
+#define FLOW_RIGHT      4
+#define FLOW_TARGET     5   // This is the target cell
+
+typedef struct {
+    uint8_t cell_count;
+    uint8_t target_row;
+    uint8_t target_col;
+    uint8_t cells[MAP_MAX_CELL_COUNT][MAP_MAX_CELL_COUNT];     // One cell byte per map cell
+
+    uint16_t queue[MAP_MAX_CELL_COUNT * MAP_MAX_CELL_COUNT];   // Ring queue of cell indices used by the search
+} FlowField_t;
+
+void FLOW_FIELD_compute(FlowField_t *field, const MapData_t *map, uint8_t target_row, uint8_t target_col);
+uint8_t FLOW_FIELD_get_cell(const FlowField_t *field, int32_t x, int32_t y);
+
+#endif /* INC_FLOWFIELD_H_ */
@@ -0,0 +1,108 @@
+/*
+ * Game.h
+ *
+ * Game rules - drone physics, waypoints, holes, the disruptor's energy and the time limit. Nothing in here
+ * touches hardware or the RTOS: every function works on the GameState_t it is given and reports what
+ * happened through GAME_EVENT_ flags, so the firmware's tasks and timers drive LEDs and timers from the
+ * events while the host simulator steps the same code against a virtual clock.
+ */
+
+#ifndef INC_GAME_H_
+#define INC_GAME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Config.h"
+#include "FixedPoint.h"
+#include "SineTable.h"
+#include "Map.h"
+#include "CollisionMask.h"
+#include "WallGrid.h"
+#include "Entity.h"
+
+#define GAME_UPDATE_PERIOD 50 // Physics tick every 50 ms
+#define GAME_ENERGY_PERIOD 10 // Disruptor energy drains or recharges every 10 ms
+
+// Maps the firmware plays - 6 cells of MAP_CELL_SIZE fill the screen, and the level pack is built for them.
+// Host tools play bigger maps with configs of their own.
+#define GAME_MAP_CELL_COUNT 6
+#define GAME_MAP_MAX_WAYPOINTS 4
+
+// Velocities are configured in milli-pixels per game tick
+#define MILLI_PIXELS_TO_Q16(value) Q16_FROM_RATIO(value, 1000)
+
+// Board is initially assumed to be at 180 degrees or flat
+#define INITIAL_BOARD_ANGLE 180
+
+// Gyro angle change per sample for one LSB of angular rate - 70 mdps/LSB integrated over 10 ms
+#define GYRO_DEGREES_PER_LSB Q16_FROM_RATIO(7, 10000)
+
+// Tilt past this (after angle_gain) and the drone falls off the board
+#define MAX_TILT_ANGLE Q16_FROM_INT(70)
+
+// Tilt up to this (after angle_gain) counts as flat - what is left of the gyro's drift and a hand's tremor
+// don't roll the drone
+#define FLAT_TILT_ANGLE Q16_FROM_INT(5)
+
+// Extra wall penetration per tick while the disruptor is active (was velocity / 300 with velocity in milli-pixels)
+#define DISRUPTOR_WALL_SPEED_GAIN Q16_FROM_RATIO(10, 3)
+
+// The drone is always the first entity
+#define DRONE_ENTITY 0
+
+// Events returned by the GAME_ functions
+#define GAME_EVENT_WAYPOINT_REACHED     0x01    // current_waypoint moved on
+#define GAME_EVENT_WON                  0x02
+#define GAME_EVENT_LOST                 0x04
+#define GAME_EVENT_ENERGY_EMPTY         0x08    // Nothing left to drain
+#define GAME_EVENT_ENERGY_FULL          0x10    // Nothing left to recharge
+#define GAME_EVENT_DISRUPTOR_LOCKED     0x20    // Energy is below the minimum to activate the disruptor
+#define GAME_EVENT_DISRUPTOR_READY      0x40    // Energy is back above the minimum
+
+enum PinAtCenter {
+    DRONE,
+    MAZE
+};
+
+typedef struct {
+    const struct ConfigData_t *config;
+
+    // Physics config as Q16.16 factors - worked out once in GAME_init
+    q16_t tilt_gain;                    // angle_gain / 1000
+    q16_t gravity_gain;                 // Acceleration in pixels per tick squared at 90 degrees of tilt
+
+    MapData_t map;                      // Walls, holes and waypoints of the map being played
+    CollisionMask_t collision_mask;     // Wall and hole pixels of the playfield
+    WallGrid_t wall_grid;               // Wall segments of the map, bucketed per cell
+    EntityStore_t entities;             // Position and velocity of the drone and every other moving body
+
+    uint8_t current_waypoint;           // The waypoint the player must reach next
+    int32_t drone_energy;               // mJ
+    bool button_pressed;
+    bool disruptor_active;
+    bool disruptor_can_be_activated;
+
+    uint32_t time;                      // ms played
+    bool won;
+    bool lost;
+    bool fell_into_hole;
+    bool ran_out_of_time;
+    bool exceeded_tilt;
+} GameState_t;
+
+void GAME_default_config(struct ConfigData_t *config);
+bool GAME_validate_config(const struct ConfigData_t *config);
+void GAME_init(GameState_t *game, const struct ConfigData_t *config);
+bool GAME_start(GameState_t *game);
+
+void GAME_integrate_gyro(q16_t *angle_x, q16_t *angle_y, int16_t rate_x, int16_t rate_y);
+q16_t GAME_get_board_gravity_ratio(GameState_t *game, q16_t angle);
+uint32_t GAME_step(GameState_t *game, q16_t board_angle_x, q16_t board_angle_y);
+uint32_t GAME_advance_clock(GameState_t *game, uint32_t ms);
+
+void GAME_set_button(GameState_t *game, bool pressed);
+uint32_t GAME_drain_energy(GameState_t *game);
+uint32_t GAME_recharge_energy(GameState_t *game);
+uint32_t GAME_advance_energy(GameState_t *game, uint32_t ms);
+
+#endif /* INC_GAME_H_ */
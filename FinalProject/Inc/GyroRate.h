@@ -0,0 +1,78 @@
+/*
+ * GyroRate.h
+ *
+ * Zero rate offset removal and rate scaling for one gyro axis - anything left in the rate is integrated into
+ * the board angle, so an offset of a fraction of a count still drifts the board over a game.
+ *
+ *   - Calibration: the first GYRO_RATE_CALIBRATION_WINDOWS still windows are averaged into the bias. Any
+ *     movement restarts it. Until it is done the corrected rate is zero. A board that is never still long
+ *     enough - held in a shaky hand, or on a vibrating table - takes the mean of the quietest window seen
+ *     once GYRO_RATE_CALIBRATION_TIMEOUT windows have gone by, so the game still gets a tilt.
+ *   - Tracking: after that, every still window whose mean is close to the bias pulls the bias a little
+ *     towards it, following the offset as the sensor warms up. A window is still when its samples span no
+ *     more than the sensor noise; a slow steady turn is told apart by its mean being too far off the bias.
+ *   - The bias is kept in Q16.16 and the fraction that doesn't fit a 16 bit sample is carried to the next
+ *     one, and so is the remainder when a batch is scaled to a rate - nothing is lost to rounding, so the
+ *     integrated angle doesn't depend on how often the FIFO is drained.
+ */
+
+#ifndef INC_GYRORATE_H_
+#define INC_GYRORATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef GYRO_RATE_WINDOW_SHIFT
+#define GYRO_RATE_WINDOW_SHIFT 6 // 64 samples per still window - about a third of a second at 190 Hz
+#endif
+#define GYRO_RATE_WINDOW (1 << GYRO_RATE_WINDOW_SHIFT)
+
+#ifndef GYRO_RATE_CALIBRATION_WINDOWS
+#define GYRO_RATE_CALIBRATION_WINDOWS 4 // Still windows averaged at start up
+#endif
+
+#ifndef GYRO_RATE_CALIBRATION_TIMEOUT
+#define GYRO_RATE_CALIBRATION_TIMEOUT 32 // Windows before falling back to the quietest one - about 11 s at 190 Hz
+#endif
+
+#ifndef GYRO_RATE_STILL_BAND
+#define GYRO_RATE_STILL_BAND 60 // Counts a still window's samples may span - a little over the sensor noise
+#endif
+
+#ifndef GYRO_RATE_TRACK_LIMIT
+#define GYRO_RATE_TRACK_LIMIT 24 // Counts a still window's mean may be off the bias to be tracked
+#endif
+
+#ifndef GYRO_RATE_TRACK_SHIFT
+#define GYRO_RATE_TRACK_SHIFT 3 // Each tracked window moves the bias 1/8 of the way to its mean
+#endif
+
+typedef struct {
+    int32_t bias;                   // Zero rate offset, Q16.16 counts
+    bool calibrated;
+
+    // Window being collected
+    int32_t window_sum;
+    int16_t window_min, window_max;
+    uint16_t window_count;
+
+    // Calibration
+    int32_t calibration_sum;
+    uint16_t calibration_windows;
+    uint16_t calibration_attempts;  // Windows closed while uncalibrated, still or not
+    int32_t quietest_sum;           // Sum of the window with the smallest span so far
+    int32_t quietest_span;
+
+    int32_t residual;               // Fraction of the bias carried to the next sample, Q16.16
+    int64_t remainder;              // Left over from the last scaled rate
+
+    uint32_t restarts;              // Calibrations restarted by movement
+    bool timed_out;                 // Calibrated from the quietest window - never still for long enough
+    uint32_t updates;               // Windows tracked into the bias
+} GyroRate_t;
+
+void GYRO_RATE_init(GyroRate_t *axis);
+void GYRO_RATE_correct(GyroRate_t *axis, int16_t *samples, uint16_t count);
+int16_t GYRO_RATE_scale(GyroRate_t *axis, int32_t sum, int32_t multiplier, int32_t divisor);
+
+#endif /* INC_GYRORATE_H_ */
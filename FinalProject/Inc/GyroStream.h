@@ -0,0 +1,83 @@
+/*
+ * GyroStream.h
+ *
+ * Interrupt driven reads of the L3GD20's FIFO. The FIFO watermark interrupt starts a DMA transfer that reads
+ * the FIFO level, its completion starts a second one that bursts every queued XYZ sample out, and the
+ * completion of that wakes the task that uses them. Nothing waits on the SPI bus - the CPU only runs the
+ * two interrupt handlers. The state machine doesn't touch the HAL; the SPI, DMA and chip select are reached
+ * through GyroStreamPort_t, so it runs the same on the host against a stand-in device.
+ *
+ * GYRO_STREAM_on_watermark and GYRO_STREAM_on_transfer_ handlers are called from interrupts of the same
+ * priority, so they never preempt each other. GYRO_STREAM_take and GYRO_STREAM_poll run in a task with those
+ * interrupts masked. The watermark interrupt is edge triggered, so a read that couldn't be started is left
+ * pending rather than retried from the interrupt - GYRO_STREAM_poll picks it up if nothing else does.
+ */
+
+#ifndef INC_GYROSTREAM_H_
+#define INC_GYROSTREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GYRO_FIFO_DEPTH 32 // XYZ samples
+#define GYRO_SAMPLE_SIZE 6 // Bytes - X, Y and Z, low byte first
+
+//FIFO_SRC fields
+#define GYRO_FIFO_WATERMARK (1 << 7) // Level reached the FIFO_CTRL watermark
+#define GYRO_FIFO_OVERRUN (1 << 6) // FIFO full, oldest sample overwritten
+#define GYRO_FIFO_EMPTY (1 << 5)
+#define GYRO_FIFO_LEVEL_MASK 0x1F
+
+// Commands - read FIFO_SRC, and read from OUT_X_L with auto-increment. With the FIFO enabled the address rolls
+// back from OUT_Z_H to OUT_X_L, so each 6 bytes pop the next sample.
+#define GYRO_STREAM_LEVEL_COMMAND (0x80 | 0x2F)
+#define GYRO_STREAM_SAMPLES_COMMAND (0x80 | 0x40 | 0x28)
+
+#define GYRO_STREAM_IDLE            0
+#define GYRO_STREAM_READING_LEVEL   1
+#define GYRO_STREAM_READING_SAMPLES 2
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} GyroSample_t;
+
+typedef struct {
+    bool (*start_transfer)(void *context, const uint8_t *tx, uint8_t *rx, uint16_t size); // Full duplex, in the background
+    void (*chip_select)(void *context, bool selected);
+    bool (*watermark_pending)(void *context); // Interrupt line still high
+    void (*notify)(void *context); // New samples - wakes the task that takes them
+    void *context;
+} GyroStreamPort_t;
+
+typedef struct {
+    GyroStreamPort_t port;
+    volatile uint8_t state;                             // GYRO_STREAM_
+    volatile bool pending;                              // Watermark came in during a transfer, or a start failed
+
+    // Transfer buffers - a command byte, then the data
+    uint8_t tx[1 + (GYRO_FIFO_DEPTH * GYRO_SAMPLE_SIZE)];
+    uint8_t rx[1 + (GYRO_FIFO_DEPTH * GYRO_SAMPLE_SIZE)];
+    uint8_t transfer_count;                             // Samples being read
+
+    // Samples read and not taken yet, oldest first
+    GyroSample_t samples[GYRO_FIFO_DEPTH];
+    volatile uint8_t sample_count;
+
+    uint32_t transfers;                                 // DMA transfers started
+    uint32_t overruns;                                  // Reads that found the FIFO overrun
+    uint32_t lost;                                      // Samples dropped because they weren't taken in time
+    uint32_t errors;                                    // Transfers that couldn't be started or failed
+} GyroStream_t;
+
+uint8_t GYRO_STREAM_fifo_level(uint8_t fifo_src, bool *overrun);
+void GYRO_STREAM_decode(const uint8_t *data, GyroSample_t *samples, uint8_t count);
+void GYRO_STREAM_init(GyroStream_t *stream, const GyroStreamPort_t *port);
+void GYRO_STREAM_on_watermark(GyroStream_t *stream);
+void GYRO_STREAM_on_transfer_complete(GyroStream_t *stream);
+void GYRO_STREAM_on_transfer_error(GyroStream_t *stream);
+void GYRO_STREAM_poll(GyroStream_t *stream);
+uint8_t GYRO_STREAM_take(GyroStream_t *stream, GyroSample_t *samples, uint8_t max_samples);
+
+#endif /* INC_GYROSTREAM_H_ */
@@ -11,6 +11,8 @@
 #include "stm32f4xx_hal.h"
 #include <stdio.h>
 #include "cmsis_os.h"
+#include "GyroStream.h"
+#include "SPI_Bus_Driver.h"
 
 #define USE_MX_INIT 1
 
@@ -27,9 +29,32 @@
 //Gyro Config Regs
 #define WHO_AM_I_REG 0x0F
 #define	CTRL_REG1 0x20
+#define CTRL_REG3 0x22
 #define CTRL_REG4 0x23 // 0b00100011 - full scale is 2000, sensitivity is 70 mdps
 #define CTRL_REG5 0x24
 #define FIFO_CTRL_REG 0x2E
+#define FIFO_SRC_REG 0x2F
+
+//CTRL_REG1 fields
+#define GYRO_ODR_95HZ (0 << 6)
+#define GYRO_ODR_190HZ (1 << 6)
+#define GYRO_ODR_380HZ (2 << 6)
+#define GYRO_ODR_760HZ (3 << 6)
+#define GYRO_BANDWIDTH(n) (((n) & 0x3) << 4) // Low pass cut-off, 0 (lowest) to 3 - depends on the ODR
+#define GYRO_POWER_ON (1 << 3)
+#define GYRO_Z_AXIS (1 << 2)
+#define GYRO_Y_AXIS (1 << 1)
+#define GYRO_X_AXIS (1 << 0)
+
+//CTRL_REG3 fields
+#define GYRO_INT2_WATERMARK (1 << 2) // FIFO watermark on the INT2 pin
+
+//CTRL_REG5 fields
+#define GYRO_FIFO_ENABLE (1 << 6)
+
+//FIFO_CTRL fields
+#define GYRO_FIFO_STREAM_MODE (2 << 5)
+#define GYRO_FIFO_WATERMARK_MASK 0x1F
 
 
 
@@ -40,29 +65,41 @@
 #define OUT_X_H 0x29
 #define OUT_Y_L 0x2A
 #define OUT_Y_H 0x2B
-//#define OUT_Z_L 0x2C
-//#define OUT_Z_H 0x2D
+#define OUT_Z_L 0x2C
+#define OUT_Z_H 0x2D
 
 
 //CS Info
 #define CS_PORT GPIOC
 #define CS_PIN GPIO_PIN_1
 
-#define TIMEOUT 20000 //20000 ms = 20s
+//INT2 Info - FIFO watermark interrupt
+#define INT2_PORT GPIOA
+#define INT2_PIN GPIO_PIN_2
+#define INT2_IRQ_NUMBER EXTI2_IRQn
+
+//SPI - 84 MHz / 16 = 5.25 MHz, the L3GD20 takes up to 10 MHz
+#define GYRO_SPI_PRESCALER SPI_BAUDRATEPRESCALER_16
+
+//Time from power on until the gyro can be configured
+#define GYRO_POWER_ON_TIME 100 // ms
 
 
 void Gyro_Init();
+void Gyro_Init_FIFO(uint8_t data_rate, uint8_t bandwidth, uint8_t axes);
 void Gyro_Power_On();
 void Gyro_Reboot();
 int16_t Gyro_Get_Velocity_Y();
 int16_t Gyro_Get_Velocity_X();
 void Gyro_Config_Regs();
+void Gyro_Config_FIFO(uint8_t data_rate, uint8_t bandwidth, uint8_t axes);
+uint8_t Gyro_Read_FIFO(GyroSample_t *samples, uint8_t max_samples);
+void Gyro_Init_Stream(GyroStream_t *stream, uint8_t watermark, void (*notify)(void *context), void *context);
+uint32_t Gyro_Get_FIFO_Overruns();
+uint8_t Gyro_Read_Reg(uint8_t reg);
+void Gyro_Write_Reg(uint8_t reg, uint8_t value);
+void Gyro_Transfer(const uint8_t *tx_buff, uint8_t *rx_buff, uint16_t size);
 void Gyro_HAL_Check();
-void Gyro_Slave_Enable();
-void Gyro_Slave_Disable();
-
-void Gyro_Receive_Data(uint8_t *rx_buff);
-void Gyro_Transmit_Data(uint8_t *tx_buff);
 
 
 
@@ -11,6 +11,7 @@
 #include "stm32f4xx_hal.h"
 #include "fonts.h"
 #include "cmsis_os.h"
+#include "SPI_Bus_Driver.h"
 #define LCD_PIXEL_FORMAT_1     LTDC_PIXEL_FORMAT_RGB565
 
 #define LCD_COLOR_WHITE         0xFFFF
@@ -121,7 +122,8 @@ void QuickDemo(void);
  #define DISCOVERY_SPI_SCK_PIN                  GPIO_PIN_7                 /* PF.07 */
  #define DISCOVERY_SPI_MISO_PIN                 GPIO_PIN_8                 /* PF.08 */
  #define DISCOVERY_SPI_MOSI_PIN                 GPIO_PIN_9                 /* PF.09 */
- #define SPI_TIMEOUT_MAX              ((uint32_t)0x1000)
+ /* ILI9341 takes up to 10 MHz for writes and 6.66 MHz for reads - 84 MHz / 16 = 5.25 MHz */
+ #define LCD_SPI_PRESCALER                      SPI_BAUDRATEPRESCALER_16
 
 
 
@@ -270,7 +272,9 @@ void     ili9341_Display_Off(void);
 /* LCD IO functions */
 void     LCD_IO_Init(void);
 void     LCD_IO_WriteData(uint16_t RegValue);
+void     LCD_IO_WriteMultipleData(const uint8_t *data, uint16_t count);
 void     LCD_IO_WriteReg(uint8_t Reg);
+void     LCD_IO_WriteCommand(uint8_t Reg, const uint8_t *params, uint16_t count);
 uint32_t LCD_IO_ReadData(uint16_t RegValue, uint8_t ReadSize);
 void     LCD_Delay (uint32_t delay);
 #endif /* INC_LCD_DRIVER_H_ */
@@ -0,0 +1,27 @@
+/*
+ * LED_PWM_Driver.h
+ *
+ * HAL port for LedPwm - TIM3 counts at LED_PWM_TICK_HZ with compare channel 1 for the green led and channel 2
+ * for the red one. The channels only raise interrupts; the led pins (PG13 and PG14) have no timer output, so
+ * the interrupt writes them through GPIOG's BSRR.
+ */
+
+#ifndef INC_LED_PWM_DRIVER_H_
+#define INC_LED_PWM_DRIVER_H_
+
+#include "stm32f4xx_hal.h"
+#include "LedPwm.h"
+
+#define LED_PWM_TIMER TIM3
+#define LED_PWM_IRQ_NUMBER TIM3_IRQn
+#define LED_PWM_IRQ_PRIORITY 12 // Only writes the led pins - nothing waits on it
+
+#define LED_PWM_GPIO_PORT GPIOG
+#define LED_PWM_GREEN_PIN GPIO_PIN_13
+#define LED_PWM_RED_PIN GPIO_PIN_14
+
+extern LedPwm_t led_pwm;
+
+void LED_PWM_Init(void);
+
+#endif /* INC_LED_PWM_DRIVER_H_ */
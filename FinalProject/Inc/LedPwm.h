@@ -0,0 +1,61 @@
+/*
+ * LedPwm.h
+ *
+ * Software PWM for the status leds, driven by one hardware timer's compare interrupts. Each led has a two
+ * entry table - ticks on and the GPIO word that turns it on, ticks off and the word that turns it off - and its
+ * compare interrupt only fires at an edge: it writes the word for the phase starting and returns the ticks to
+ * the next edge. Nothing in the interrupt touches the RTOS.
+ *
+ * The tables are only rewritten when a led's duty or blink rate changes. A led held on or off has its
+ * interrupt stopped, so a full or empty energy bar costs nothing.
+ *
+ * The timer is reached through LedPwmPort_t, so the module runs the same on the host against a timer model.
+ */
+
+#ifndef INC_LEDPWM_H_
+#define INC_LEDPWM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LED_PWM_TICK_HZ 10000 // Timer counts per second
+#define LED_PWM_MS(ms) ((ms) * (LED_PWM_TICK_HZ / 1000))
+
+#define LED_PWM_GREEN_PERIOD LED_PWM_MS(10) // 100 Hz, too fast to see flicker
+#define LED_PWM_GREEN_LEVELS 10 // Duty steps of the green led - level 0 is off, LED_PWM_GREEN_LEVELS is fully on
+
+// Channels - one timer compare channel each
+#define LED_PWM_GREEN 0
+#define LED_PWM_RED 1
+#define LED_PWM_CHANNELS 2
+
+typedef struct {
+    void (*write)(void *context, uint32_t bsrr);                    // Set and reset pins, as a GPIO BSRR word
+    void (*start)(void *context, uint8_t channel, uint16_t delay);  // First compare interrupt delay ticks from now
+    void (*stop)(void *context, uint8_t channel);                   // Disable a channel's compare interrupt
+    uint32_t (*lock)(void *context);                                // Mask the compare interrupts
+    void (*unlock)(void *context, uint32_t state);
+    void *context;
+} LedPwmPort_t;
+
+typedef struct {
+    volatile uint16_t ticks[2];     // Ticks on, then off - 0 on holds the led off, 0 off holds it on
+    uint32_t bsrr[2];               // GPIO words that turn the led on and off
+    volatile uint8_t phase;         // 0 while on, 1 while off
+    bool running;                   // Compare interrupt enabled
+} LedPwmChannel_t;
+
+typedef struct {
+    LedPwmPort_t port;
+    LedPwmChannel_t channels[LED_PWM_CHANNELS];
+
+    uint32_t wakeups;               // Compare interrupts taken
+} LedPwm_t;
+
+void LED_PWM_init(LedPwm_t *pwm, const LedPwmPort_t *port, uint16_t green_pin, uint16_t red_pin);
+void LED_PWM_set(LedPwm_t *pwm, uint8_t channel, uint16_t on_ticks, uint16_t off_ticks);
+void LED_PWM_set_level(LedPwm_t *pwm, uint8_t level);
+void LED_PWM_set_blink(LedPwm_t *pwm, uint16_t period);
+uint16_t LED_PWM_on_compare(LedPwm_t *pwm, uint8_t channel);
+
+#endif /* INC_LEDPWM_H_ */
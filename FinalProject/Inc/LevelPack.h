@@ -0,0 +1,77 @@
+/*
+ * LevelPack.h
+ *
+ * Container for pre-built levels stored in flash. A pack is a small header, an index table with one
+ * entry per level, and a PackBits (RLE) compressed payload per level. A level is only decompressed
+ * when it is started, and always into the same fixed scratch arena.
+ *
+ * Pack layout (all fields little endian):
+ *
+ *   Header  - 8 bytes
+ *      uint32_t magic              LEVEL_PACK_MAGIC
+ *      uint8_t  version            LEVEL_PACK_VERSION
+ *      uint8_t  reserved
+ *      uint16_t level_count
+ *
+ *   Index   - 8 bytes per level
+ *      uint32_t offset             Offset of the compressed payload from the start of the pack
+ *      uint16_t compressed_size    Size of the compressed payload in bytes
+ *      uint8_t  cell_count         Number of cells in each row and column
+ *      uint8_t  num_waypoints      Number of waypoints in the level
+ *
+ *   Payload - decompresses to LEVEL_PACK_PLANE_COUNT wall/hole bitsets followed by num_waypoints
+ *             (row, col) byte pairs in waypoint order. Bitset p holds bit (1 << p) of every cell,
+ *             one bit per cell in row major order, LSB first. Walls are sparse, so the bitsets are
+ *             mostly zero bytes and compress well.
+ */
+
+#ifndef INC_LEVELPACK_H_
+#define INC_LEVELPACK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LEVEL_PACK_MAGIC            0x4B50564C // "LVPK"
+#define LEVEL_PACK_VERSION          1
+
+#define LEVEL_PACK_HEADER_SIZE      8
+#define LEVEL_PACK_INDEX_ENTRY_SIZE 8
+
+#define LEVEL_PACK_MAX_CELL_COUNT   64 // Largest map a pack can describe
+#define LEVEL_PACK_MAX_WAYPOINTS    16
+#define LEVEL_PACK_PLANE_COUNT      5  // Top, bottom, left and right walls, holes
+
+#define LEVEL_PACK_PLANE_SIZE(cell_count)   ((((cell_count) * (cell_count)) + 7) / 8)
+#define LEVEL_PACK_LEVEL_SIZE(cell_count, num_waypoints) \
+    ((LEVEL_PACK_PLANE_COUNT * LEVEL_PACK_PLANE_SIZE(cell_count)) + (2 * (num_waypoints)))
+
+// Scratch arena large enough for the biggest level a pack can hold - the decompressed payload plus
+// the cell bytes expanded from it
+#define LEVEL_PACK_ARENA_SIZE       (LEVEL_PACK_LEVEL_SIZE(LEVEL_PACK_MAX_CELL_COUNT, LEVEL_PACK_MAX_WAYPOINTS) + \
+                                     (LEVEL_PACK_MAX_CELL_COUNT * LEVEL_PACK_MAX_CELL_COUNT))
+
+// A decoded level - pointers reference the scratch arena and stay valid until the next load
+typedef struct {
+    uint8_t cell_count;                 // Number of cells in each row and column
+    uint8_t num_waypoints;              // Number of waypoints in the level
+    const uint8_t *cell_data;           // cell_count * cell_count cell bytes, row major, waypoint bits set
+    const uint8_t *waypoint_cells;      // num_waypoints (row, col) pairs in waypoint order
+} LevelData_t;
+
+// Level pack built by the host packer (Host/level_packer) - see LevelPackData.c
+extern const uint8_t level_pack_data[];
+extern const uint32_t level_pack_size;
+
+bool LEVEL_PACK_is_valid(const uint8_t *pack, uint32_t size);
+uint16_t LEVEL_PACK_get_level_count(const uint8_t *pack);
+bool LEVEL_PACK_load(const uint8_t *pack, uint16_t index, LevelData_t *level);
+
+// Convert between cell bytes and the payload layout - the payload buffer must be LEVEL_PACK_LEVEL_SIZE bytes
+void LEVEL_PACK_cells_to_payload(const uint8_t *cells, uint8_t cell_count, const uint8_t *waypoint_cells, uint8_t num_waypoints, uint8_t *payload);
+void LEVEL_PACK_payload_to_cells(const uint8_t *payload, uint8_t cell_count, uint8_t num_waypoints, uint8_t *cells);
+
+// PackBits codec - return the number of bytes written, or 0 if the output does not fit
+uint32_t LEVEL_PACK_encode(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size);
+uint32_t LEVEL_PACK_decode(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size);
+
+#endif /* INC_LEVELPACK_H_ */
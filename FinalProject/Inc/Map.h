@@ -0,0 +1,104 @@
+/*
+ * Map.h
+ *
+ * Map data and map generation. Nothing in here touches hardware or global state - every function
+ * works on the MapData_t it is given and draws random numbers through the supplied MapRandom_t, so
+ * maps can be generated concurrently (and on the host).
+ */
+
+#ifndef INC_MAP_H_
+#define INC_MAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Config.h"
+#include "LevelPack.h"
+
+// Largest map the data structure can hold - the firmware plays 6 x 6 maps, host tools build bigger ones
+#ifndef MAP_MAX_CELL_COUNT
+#define MAP_MAX_CELL_COUNT 6
+#endif
+
+#ifndef MAP_MAX_WAYPOINTS
+#define MAP_MAX_WAYPOINTS 4
+#endif
+
+#define MAP_MAX_HOLES (MAP_MAX_CELL_COUNT * MAP_MAX_CELL_COUNT)
+
+// Cells in each row and column of a map - a constant with CONFIG_STATIC_PROFILE, where every map is the profile's size
+#if CONFIG_STATIC_PROFILE
+#define MAP_CELL_COUNT(map) CONFIG_PROFILE_MAP_CELL_COUNT
+#else
+#define MAP_CELL_COUNT(map) ((map)->cell_count)
+#endif
+
+// Map geometry in pixels
+#define MAP_CELL_SIZE 40
+#define MAP_ORIGIN_X 0
+#define MAP_ORIGIN_Y 40
+
+#define MAP_CELL_CENTER_X(col) (MAP_ORIGIN_X + ((col) * MAP_CELL_SIZE) + (MAP_CELL_SIZE / 2))
+#define MAP_CELL_CENTER_Y(row) (MAP_ORIGIN_Y + ((row) * MAP_CELL_SIZE) + (MAP_CELL_SIZE / 2))
+
+// Cell containing a pixel - only meaningful for pixels inside the map
+#define MAP_CELL_COL(x) (((x) - MAP_ORIGIN_X) / MAP_CELL_SIZE)
+#define MAP_CELL_ROW(y) (((y) - MAP_ORIGIN_Y) / MAP_CELL_SIZE)
+
+/* Cell data bits
+ * 0b00000001  - Top wall
+ * 0b00000010  - Bottom wall
+ * 0b00000100  - Left wall
+ * 0b00001000  - Right wall
+ * 0b00010000  - Hole
+ * 0b00100000  - Waypoint
+*/
+#define MAP_TOP_WALL    0x01
+#define MAP_BOTTOM_WALL 0x02
+#define MAP_LEFT_WALL   0x04
+#define MAP_RIGHT_WALL  0x08
+#define MAP_HOLE        0x10
+#define MAP_WAYPOINT    0x20
+
+// This data structure will be used to represent holes within the game
+// Collision detection will use this data
+typedef struct {
+    uint16_t x; // X position of hole center
+    uint32_t y; // Y position of hole center
+} HoleData_t;
+
+// This data structure will be used to represent waypoints within the game
+// Collision detection will use this data
+// Waypoints are numbered incrementally starting from 0 (start)
+typedef struct {
+    int16_t x;         // X position of hole center
+    int16_t y;         // Y position of hole center
+    uint8_t number;    // Index of this waypoint
+    bool reached;         // True if this waypoint has been reached previously - false initially
+} WaypointData_t;
+
+// A complete map
+typedef struct {
+    uint8_t cell_count;                                             // Number of cells in each row and column
+    uint8_t cell_data[MAP_MAX_CELL_COUNT][MAP_MAX_CELL_COUNT];      // Wall, hole and waypoint bits of every cell
+
+    HoleData_t hole_data[MAP_MAX_HOLES];                            // Center of every hole in the map
+    uint16_t num_holes;
+
+    WaypointData_t waypoint_data[MAP_MAX_WAYPOINTS];                // Waypoints in the order they must be reached
+    uint8_t num_waypoints;
+    uint8_t waypoint_number[MAP_MAX_CELL_COUNT][MAP_MAX_CELL_COUNT]; // Waypoint in each cell with MAP_WAYPOINT set
+} MapData_t;
+
+// Source of random numbers for map generation - returns a value from 0 to max - 1
+typedef uint32_t (*MapRandom_t)(void *context, uint32_t max);
+
+bool MAP_create(MapData_t *map, const MapConfig_t *map_config, MapRandom_t random, void *random_context);
+uint32_t MAP_xorshift_random(void *context, uint32_t max);
+bool MAP_load_level(MapData_t *map, const LevelData_t *level);
+void MAP_create_hole_data(MapData_t *map);
+
+// Point lookups - radius must be at most MAP_CELL_SIZE
+bool MAP_is_over_hole(const MapData_t *map, int32_t x, int32_t y, uint32_t radius);
+int8_t MAP_get_waypoint(const MapData_t *map, int32_t x, int32_t y, uint32_t radius);
+
+#endif /* INC_MAP_H_ */
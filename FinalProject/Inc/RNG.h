@@ -2,6 +2,9 @@
  * This is code interfaces with the random number generator on the STM32 board.
  * All it is responsible for is generating a random initial position and random
  * initial velocity for the ball. 
+ *
+ * The generator fills an EntropyPool from its interrupt, so RNG_get_random_number never waits on it. Take
+ * numbers from one task at a time.
 */
 
 #ifndef RNG_H
@@ -10,6 +13,9 @@
 #include <stdint.h>
 #include "stm32f429xx.h" // RNG is access macro
 
+#define RNG_IRQ_PRIORITY 14 // Only fills the pool - nothing waits on it
+#define RNG_POLL_LIMIT 1000 // Status reads to wait for the seed word at start up - a word takes about 1 us
+
 void RNG_enable();
 void RNG_disable();
 void RNG_reset();
@@ -0,0 +1,89 @@
+/*
+ * Recorder.h
+ *
+ * Input recorder - logs every input the game reads (gyro samples, button edges, physics ticks and the
+ * seed the map was generated from) into a RAM ring buffer, so a game can be played back exactly on the
+ * target or on the host. Gyro samples are stored as the change from the previous sample; most fit in a
+ * single byte together with a following physics tick.
+ *
+ * Record bytes:
+ *   0txxxyyy                   Gyro sample, change in x and y from -4 to 3. t - a physics tick ran first
+ *   1000nnnn                   n + 1 physics ticks
+ *   1001000p                   Button edge, p - pressed
+ *   1010000t <dx> <dy>         Gyro sample with a bigger change, zigzag varints. t as above
+ *   11111111 <seed> <level>    Game start, varints. level is 0 for a random map, otherwise level index + 1
+ *
+ * Records are only ever added whole - if the buffer is full the record is dropped and counted.
+ */
+
+#ifndef INC_RECORDER_H_
+#define INC_RECORDER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FixedPoint.h"
+#include "Game.h"
+
+// Ring buffer size in bytes - must be a power of two
+#ifndef RECORDER_BUFFER_SIZE
+#define RECORDER_BUFFER_SIZE 8192
+#endif
+
+// Longest record - start marker and two 5 byte varints
+#define RECORDER_MAX_RECORD_SIZE 11
+
+// Decoded record types
+#define RECORD_GYRO     0
+#define RECORD_TICK     1
+#define RECORD_BUTTON   2
+#define RECORD_START    3
+
+typedef struct {
+    uint8_t buffer[RECORDER_BUFFER_SIZE];
+    uint32_t head;                      // Bytes written - free running, wraps through the buffer
+    uint32_t tail;                      // Bytes read out
+    uint32_t dropped;                   // Records that didn't fit
+
+    int16_t last_x, last_y;             // Last gyro sample written
+    uint32_t pending_ticks;             // Physics ticks not written yet
+} Recorder_t;
+
+typedef struct {
+    uint8_t type;                       // RECORD_
+    int16_t rate_x, rate_y;             // RECORD_GYRO - raw angular rate
+    bool pressed;                       // RECORD_BUTTON
+    uint32_t seed;                      // RECORD_START - map seed
+    int32_t level;                      // RECORD_START - level index, -1 for a random map
+} RecordEvent_t;
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t size;
+    uint32_t position;
+
+    int16_t last_x, last_y;             // Last gyro sample decoded
+    uint32_t pending_ticks;             // Ticks decoded but not returned yet
+    bool gyro_pending;                  // Gyro sample decoded but not returned yet - it follows the ticks
+
+    q16_t angle_x, angle_y;             // Board angle rebuilt from the gyro samples - degrees
+} RecordReader_t;
+
+// Recording - not thread safe, callers serialise access
+void RECORDER_init(Recorder_t *recorder);
+bool RECORDER_start(Recorder_t *recorder, uint32_t seed, int32_t level);
+bool RECORDER_gyro(Recorder_t *recorder, int16_t rate_x, int16_t rate_y);
+void RECORDER_tick(Recorder_t *recorder);
+bool RECORDER_button(Recorder_t *recorder, bool pressed);
+bool RECORDER_flush(Recorder_t *recorder);
+uint32_t RECORDER_read(Recorder_t *recorder, uint8_t *output, uint32_t max);
+
+// Playback
+void RECORDER_reader_init(RecordReader_t *reader, const uint8_t *data, uint32_t size);
+bool RECORDER_next(RecordReader_t *reader, RecordEvent_t *event);
+bool RECORDER_replay_tick(RecordReader_t *reader, GameState_t *game, uint32_t *events);
+
+// Log played back by the firmware in replay mode - Src/ReplayLogData.c
+extern const uint8_t replay_log_data[];
+extern const uint32_t replay_log_size;
+
+#endif /* INC_RECORDER_H_ */
@@ -0,0 +1,32 @@
+/*
+ * SPI_Bus_Driver.h
+ *
+ * SPI5 on the discovery board, shared by the LCD and the gyro through one SpiBus_t. Queued transactions run
+ * by DMA; blocking ones use the HAL's polled transfers.
+ */
+
+#ifndef INC_SPI_BUS_DRIVER_H_
+#define INC_SPI_BUS_DRIVER_H_
+
+#include "stm32f4xx_hal.h"
+#include "cmsis_os.h"
+#include "SpiBus.h"
+
+#define SPI_BUS_TIMEOUT 100 // ms for a blocking transfer
+
+#define SPI_BUS_IRQ_PRIORITY 6 // DMA streams - must not be above configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+
+//SPI5 DMA - DMA2 channel 2, stream 3 receives and stream 4 transmits
+#define SPI_BUS_DMA_CHANNEL DMA_CHANNEL_2
+#define SPI_BUS_DMA_RX_STREAM DMA2_Stream3
+#define SPI_BUS_DMA_TX_STREAM DMA2_Stream4
+#define SPI_BUS_DMA_RX_IRQ_NUMBER DMA2_Stream3_IRQn
+#define SPI_BUS_DMA_TX_IRQ_NUMBER DMA2_Stream4_IRQn
+
+extern SpiBus_t spi5_bus;
+extern DMA_HandleTypeDef hdma_spi5_rx;
+extern DMA_HandleTypeDef hdma_spi5_tx;
+
+void SPI_Bus_Init(void);
+
+#endif /* INC_SPI_BUS_DRIVER_H_ */
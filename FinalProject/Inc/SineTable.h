@@ -0,0 +1,21 @@
+/*
+ * SineTable.h
+ *
+ * Sine of an angle in degrees from a lookup table with linear interpolation - no floating point and no
+ * branches. The table is generated by Host/sine_table_gen into SineTableData.c (make sine).
+ */
+
+#ifndef INC_SINETABLE_H_
+#define INC_SINETABLE_H_
+
+#include <stdint.h>
+#include "FixedPoint.h"
+
+#define SINE_TABLE_STEP_DEGREES 1                                   // Degrees between entries
+#define SINE_TABLE_SIZE         ((360 / SINE_TABLE_STEP_DEGREES) + 1)   // Full turn plus the wrap around entry
+
+extern const q16_t sine_table[SINE_TABLE_SIZE];
+
+q16_t SINE_TABLE_sin(q16_t degrees);
+
+#endif /* INC_SINETABLE_H_ */
@@ -0,0 +1,82 @@
+/*
+ * SpiBus.h
+ *
+ * Arbitrates one SPI peripheral shared by several devices. Each device brings its own chip select and clock
+ * prescaler; the bus is only reconfigured when a transaction needs a different prescaler than the last one.
+ *
+ * Two ways onto the bus:
+ *   - Queued transactions (SPI_BUS_submit), run in the background one after another. Safe to submit from an
+ *     interrupt - the gyro's FIFO reads are queued from its watermark interrupt.
+ *   - Blocking transactions between SPI_BUS_acquire and SPI_BUS_release, for a task. The chip select stays
+ *     low for the whole transaction however many SPI_BUS_exchange calls it takes; queued transactions wait
+ *     until it is released.
+ *
+ * The bus doesn't touch the HAL - the peripheral is reached through SpiBusPort_t, so it runs the same on the
+ * host against a stand-in.
+ */
+
+#ifndef INC_SPIBUS_H_
+#define INC_SPIBUS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Queued transactions waiting for the bus - must be a power of two
+#ifndef SPI_BUS_QUEUE_SIZE
+#define SPI_BUS_QUEUE_SIZE 8
+#endif
+
+typedef struct {
+    void *cs_port;                  // Chip select, passed back to the port
+    uint16_t cs_pin;
+    uint32_t prescaler;             // Clock prescaler, passed back to the port
+} SpiDevice_t;
+
+typedef struct {
+    const SpiDevice_t *device;
+    const uint8_t *tx;              // NULL to send zeros
+    uint8_t *rx;                    // NULL to drop what is received
+    uint16_t size;
+    void (*done)(void *context, bool ok); // Called from the transfer complete interrupt
+    void *context;
+} SpiTransaction_t;
+
+typedef struct {
+    void (*configure)(void *context, const SpiDevice_t *device);
+    void (*chip_select)(void *context, const SpiDevice_t *device, bool selected);
+    bool (*start_transfer)(void *context, const uint8_t *tx, uint8_t *rx, uint16_t size); // In the background
+    bool (*transfer)(void *context, const uint8_t *tx, uint8_t *rx, uint16_t size); // Blocking
+    uint32_t (*lock)(void *context); // Masks the bus's interrupts, returns what unlock needs to restore them
+    void (*unlock)(void *context, uint32_t state);
+    void (*wait)(void *context); // Lets other work run while waiting for the bus
+    void *context;
+} SpiBusPort_t;
+
+typedef struct {
+    SpiBusPort_t port;
+
+    const SpiTransaction_t *queue[SPI_BUS_QUEUE_SIZE];
+    uint32_t head;                  // Transactions submitted - free running
+    uint32_t tail;                  // Transactions started
+
+    const SpiTransaction_t *volatile active; // Queued transaction in flight
+    volatile bool claimed;          // A blocking transaction holds the bus
+    const SpiDevice_t *claimed_device;
+    bool configured;                // The peripheral has been set up for a device
+    uint32_t prescaler;             // Prescaler it was set up with
+
+    uint32_t transactions;          // Queued and blocking transactions finished
+    uint32_t reconfigurations;
+    uint32_t queue_full;            // Submissions turned away
+    uint32_t errors;                // Transfers that couldn't be started or failed
+} SpiBus_t;
+
+void SPI_BUS_init(SpiBus_t *bus, const SpiBusPort_t *port);
+bool SPI_BUS_submit(SpiBus_t *bus, const SpiTransaction_t *transaction);
+void SPI_BUS_on_transfer_complete(SpiBus_t *bus, bool ok);
+void SPI_BUS_acquire(SpiBus_t *bus, const SpiDevice_t *device);
+bool SPI_BUS_exchange(SpiBus_t *bus, const uint8_t *tx, uint8_t *rx, uint16_t size);
+void SPI_BUS_release(SpiBus_t *bus);
+bool SPI_BUS_transfer(SpiBus_t *bus, const SpiDevice_t *device, const uint8_t *tx, uint8_t *rx, uint16_t size);
+
+#endif /* INC_SPIBUS_H_ */
@@ -0,0 +1,61 @@
+/*
+ * WallGrid.h
+ *
+ * Wall store made of arbitrary line segments - cell walls, diagonal walls or any other obstacle - with a
+ * uniform grid broadphase. The playfield is divided into square buckets; every bucket lists the indices
+ * of the segments whose bounding box overlaps it. The lists of all buckets are stored back to back in a
+ * single array (bucket i owns entries bucket_start[i] to bucket_start[i + 1] - 1), so a query only reads
+ * the few buckets around the drone and runs the exact swept test on those candidates alone.
+ *
+ * Usage: WALL_GRID_init, then WALL_GRID_add_segment / WALL_GRID_add_map_walls, then WALL_GRID_build
+ * before querying.
+ */
+
+#ifndef INC_WALLGRID_H_
+#define INC_WALLGRID_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FixedPoint.h"
+#include "Collision.h"
+#include "Map.h"
+
+// Capacity - by default every edge of the largest map and one bucket per cell
+#ifndef WALL_GRID_MAX_SEGMENTS
+#define WALL_GRID_MAX_SEGMENTS  (2 * MAP_MAX_CELL_COUNT * (MAP_MAX_CELL_COUNT + 1))
+#endif
+
+#ifndef WALL_GRID_MAX_BUCKETS
+#define WALL_GRID_MAX_BUCKETS   (MAP_MAX_CELL_COUNT * MAP_MAX_CELL_COUNT)
+#endif
+
+#ifndef WALL_GRID_MAX_ENTRIES
+#define WALL_GRID_MAX_ENTRIES   (4 * WALL_GRID_MAX_SEGMENTS)
+#endif
+
+typedef struct {
+    // Bucket layout
+    q16_t origin_x, origin_y;                               // Top left corner of bucket (0, 0) in pixels
+    q16_t bucket_size;                                      // Width and height of a bucket in pixels
+    uint16_t columns, rows;
+
+    // Segments
+    uint16_t segment_count;
+    CollisionSegment_t segments[WALL_GRID_MAX_SEGMENTS];
+
+    // Bucket lists
+    uint32_t bucket_start[WALL_GRID_MAX_BUCKETS + 1];       // First entry of every bucket, plus the end of the last one
+    uint16_t entries[WALL_GRID_MAX_ENTRIES];                // Segment indices
+
+    // Each segment is only tested once per query, even if it is in several of the buckets read
+    uint16_t query_stamp;
+    uint16_t segment_stamp[WALL_GRID_MAX_SEGMENTS];
+} WallGrid_t;
+
+bool WALL_GRID_init(WallGrid_t *grid, q16_t origin_x, q16_t origin_y, q16_t bucket_size, uint16_t columns, uint16_t rows);
+bool WALL_GRID_add_segment(WallGrid_t *grid, const CollisionSegment_t *segment);
+bool WALL_GRID_add_map_walls(WallGrid_t *grid, const MapData_t *map);
+bool WALL_GRID_build(WallGrid_t *grid);
+bool WALL_GRID_sweep_circle(WallGrid_t *grid, q16_t x, q16_t y, q16_t dx, q16_t dy, q16_t radius, CollisionHit_t *hit);
+
+#endif /* INC_WALLGRID_H_ */
@@ -7,6 +7,139 @@
 
 #include "ApplicationCode.h"
 
+[[maybe_unused]] static const struct ConfigData_t *game_config; // Saved config in flash, or config if none was saved
+[[maybe_unused]] static GameState_t game; // Map, drone, energy and outcome of the game being played
+[[maybe_unused]] static FlowField_t flow_field; // Route from every cell to the current waypoint
+[[maybe_unused]] static uint32_t flow_field_cycles; // CPU cycles spent on the last flow field update
+
+// Gyro data
+[[maybe_unused]] static q16_t gyro_angle_x = Q16_FROM_INT(INITIAL_BOARD_ANGLE); // Degrees
+[[maybe_unused]] static q16_t gyro_angle_y = Q16_FROM_INT(INITIAL_BOARD_ANGLE); // Degrees
+[[maybe_unused]] static GyroRate_t gyro_rate_x, gyro_rate_y; // Zero rate offset calibration and tracking
+[[maybe_unused]] static Biquad_t gyro_low_pass_x, gyro_low_pass_y; // Remove noise above the tilt motion
+[[maybe_unused]] static uint32_t gyro_filter_cycles; // CPU cycles spent filtering the last batch of samples
+[[maybe_unused]] static uint32_t gyro_filter_samples; // Samples in the last batch - cycles per sample is the ratio
+
+[[maybe_unused]] static uint8_t button_state; // 0 if not pressed, 1 if pressed
+
+[[maybe_unused]] static uint32_t physics_tick_time; // Kernel tick the last physics tick was due at
+[[maybe_unused]] static uint32_t game_tick_overruns; // Game task wake ups that found more than one physics tick due
+[[maybe_unused]] static uint32_t game_ticks_dropped; // Physics ticks skipped after falling more than GAME_MAX_CATCH_UP_TICKS behind
+[[maybe_unused]] static uint32_t physics_step_cycles; // CPU cycles spent on the last physics tick
+[[maybe_unused]] static uint32_t physics_step_cycles_max; // CPU cycles spent on the slowest physics tick
+
+[[maybe_unused]] static Autopilot_t autopilot; // Route through the map when AUTOPILOT is 1
+[[maybe_unused]] static uint32_t autopilot_games; // Games the autopilot has finished
+[[maybe_unused]] static uint32_t autopilot_wins;
+[[maybe_unused]] static uint32_t autopilot_unplanned; // Maps the autopilot found no route through
+
+[[maybe_unused]] static Recorder_t recorder; // Inputs of the game being played - dump buffer up to head to replay it
+[[maybe_unused]] static RecordReader_t replay_reader; // Position in replay_log_data when REPLAY_LOG is 1
+
+[[maybe_unused]] static uint16_t current_level; // Level index within the level pack
+
+// Next level - built in the background while the result screen shows, then swapped in
+[[maybe_unused]] static GameState_t next_game; // Map baked and drone placed, ready to play
+[[maybe_unused]] static FlowField_t next_flow_field;
+[[maybe_unused]] static Autopilot_t level_validator; // Checks every waypoint of a generated map can be reached
+[[maybe_unused]] static uint32_t next_level_seed; // Map seed of next_game
+[[maybe_unused]] static int32_t next_level_index; // Level pack index of next_game, -1 for a generated map
+[[maybe_unused]] static volatile bool next_level_ready; // next_game is complete
+[[maybe_unused]] static volatile bool next_level_requested; // The player asked for the next level
+[[maybe_unused]] static uint32_t next_level_request_time; // Kernel tick the next level was asked for
+[[maybe_unused]] static uint32_t next_level_prepare_cycles; // CPU cycles the worker spent on the last level
+[[maybe_unused]] static uint32_t next_level_rejected; // Generated maps thrown away for a waypoint that can't be reached
+[[maybe_unused]] static uint32_t level_swap_cycles; // CPU cycles spent swapping the last level in
+[[maybe_unused]] static uint32_t time_to_playable; // ms from asking for the next level to playing it
+[[maybe_unused]] static uint32_t level_decode_cycles; // CPU cycles spent decoding the current level
+[[maybe_unused]] static uint32_t level_decode_overruns; // Number of levels that took longer than LEVEL_DECODE_BUDGET_US to decode
+
+// Boot phases - CPU cycles from the start of ApplicationInit, 0 until the phase is reached
+[[maybe_unused]] static uint32_t boot_init_cycles; // RTOS objects created, before the kernel starts
+[[maybe_unused]] static uint32_t boot_kernel_start_cycles; // Boot thread first runs
+[[maybe_unused]] static uint32_t boot_panel_ready_cycles; // LTDC and ILI9341 configured
+[[maybe_unused]] static uint32_t boot_gyro_ready_cycles; // Gyro configured and streaming
+[[maybe_unused]] static uint32_t boot_first_frame_cycles; // First game frame drawn
+[[maybe_unused]] static uint32_t time_to_first_frame; // us from the start of ApplicationInit to the first frame
+
+// Boot task - above the game's tasks so bring-up runs as soon as the kernel starts
+[[maybe_unused]] static osThreadId_t boot_task;
+[[maybe_unused]] static const osThreadAttr_t boot_task_attributes = {
+    .name = "boot_task",
+    .priority = osPriorityAboveNormal,
+    .stack_size = 512
+};
+
+// LCD display task
+[[maybe_unused]] static osThreadId_t lcd_display_task;
+[[maybe_unused]] static const osThreadAttr_t lcd_display_task_attributes = {
+    .name = "lcd_display_task",
+    .priority = osPriorityNormal
+};
+
+// Disruptor task
+[[maybe_unused]] static osThreadId_t disruptor_task;
+[[maybe_unused]] static const osThreadAttr_t disruptor_task_attributes = {
+    .name = "disruptor_task",
+    .priority = osPriorityNormal
+};
+
+// Button task
+[[maybe_unused]] static osThreadId_t button_task;
+[[maybe_unused]] static const osThreadAttr_t button_task_attributes = {
+    .name = "button_task",
+    .priority = osPriorityNormal
+};
+
+// Gyro angle task
+[[maybe_unused]] static GyroStream_t gyro_stream; // Samples read by DMA, for GYRO_ASYNC
+[[maybe_unused]] static osThreadId_t gyro_angle_task;
+[[maybe_unused]] static const osThreadAttr_t gyro_angle_task_attributes = {
+    .name = "gyro_angle_task",
+    .priority = osPriorityNormal,
+    .stack_size = 1024 // A FIFO's worth of samples and rates, and Gyro_Read_FIFO's buffer without GYRO_ASYNC
+};
+
+// Game task
+[[maybe_unused]] static osThreadId_t game_task;
+[[maybe_unused]] static const osThreadAttr_t game_task_attributes = {
+    .name = "game_task",
+    .priority = osPriorityNormal,
+    .stack_size = 1024
+};
+
+// Level worker task - below the game's tasks so it only runs when they are idle
+[[maybe_unused]] static osThreadId_t level_worker_task;
+[[maybe_unused]] static const osThreadAttr_t level_worker_task_attributes = {
+    .name = "level_worker_task",
+    .priority = osPriorityBelowNormal,
+    .stack_size = 1024
+};
+
+// Gyro angle mutex
+[[maybe_unused]] static osMutexId_t gyro_angle_mutex;
+[[maybe_unused]] static const osMutexAttr_t gyro_angle_mutex_attributes = {
+    .name = "gyro_angle_mutex"
+};
+
+// Drone position mutex
+[[maybe_unused]] static osMutexId_t drone_position_mutex;
+[[maybe_unused]] static const osMutexAttr_t drone_position_mutex_attributes = {
+    .name = "drone_position_mutex"
+};
+
+// Disruptor energy event flag group
+[[maybe_unused]] static osEventFlagsId_t energy_event;
+[[maybe_unused]] static const osEventFlagsAttr_t energy_event_attributes = {
+    .name = "energy_event"
+};
+
+// Button press semaphore 
+[[maybe_unused]] static osSemaphoreId_t button_semaphore;
+[[maybe_unused]] static const osSemaphoreAttr_t button_semaphore_attributes = {
+    .name = "button_semaphore"
+};
+
 /**
   * @brief Initialize application to default state - define RTOS structures
   * @param None
@@ -14,31 +147,51 @@
   */
 void ApplicationInit(void)
 {
-    LTCD__Init();
-    LTCD_Layer_Init(0);
-    Gyro_Init();
+    // Boot phases are timed from here
+    APPLICATION_enable_cycle_counter();
+
+    // The board is calibrated from the first still samples - it doesn't tilt until then
+    GYRO_RATE_init(&gyro_rate_x);
+    GYRO_RATE_init(&gyro_rate_y);
+    FILTER_biquad_init(&gyro_low_pass_x, &gyro_low_pass_coefficients);
+    FILTER_biquad_init(&gyro_low_pass_y, &gyro_low_pass_coefficients);
 
     // Enable RNG peripheral
     RNG_enable();
 
+    // Energy leds - off until the first game begins
+    LED_PWM_Init();
+
+#if !REPLAY_LOG
     APPLICATION_enable_button_interrupts();
+#endif
 
     APPLICATION_configure_settings();
-    APPLICATION_create_map();
+    GAME_init(&game, game_config);
+    GAME_init(&next_game, game_config);
 
-    drone_energy = 15000;
+#if REPLAY_LOG
+    if(!APPLICATION_start_replay())
+        while(1);
+#elif USE_LEVEL_PACK
+    if(!LEVEL_PACK_is_valid(level_pack_data, level_pack_size))
+        while(1);
 
-    // Drone spawns on first waypoint
-    drone_position_x = waypoint_data[0].x;
-    drone_position_y = waypoint_data[0].y;
+    if(!APPLICATION_load_level(current_level))
+        while(1);
+#else
+    // Never 0 - xorshift would get stuck
+    APPLICATION_create_map(RNG_get_random_number(UINT32_MAX) | 1);
+#endif
 
-	[[maybe_unused]] static osStatus_t init_status;
+    APPLICATION_update_flow_field();
 
-    // Create the lcd display thread
-    lcd_display_task = osThreadNew(lcd_display_task_function, (void *)0, &lcd_display_task_attributes);
+    // Create the boot thread - brings up the panel and gyro once the kernel is running, then starts the
+    // threads that use them
+    boot_task = osThreadNew(boot_task_function, (void *)0, &boot_task_attributes);
 
-    if(lcd_display_task == NULL)
-    	while(1);
+    if(boot_task == NULL)
+        while(1);
 
 
     // Create the disruptor thread
@@ -55,64 +208,15 @@ void ApplicationInit(void)
     	while(1);
 
 
-    // Create gyro angle thread
-    gyro_angle_task = osThreadNew(gyro_angle_task_function, (void *)0, &gyro_angle_task_attributes);
+#if !REPLAY_LOG
+    // Create the level worker thread - a replay only plays the recorded game
+    level_worker_task = osThreadNew(level_worker_task_function, (void *)0, &level_worker_task_attributes);
 
-    if(gyro_angle_task == NULL)
-        while(1);
-
-
-    // Create the led output thread
-    led_output_task = osThreadNew(led_output_task_function, (void *)0, &led_output_task_attributes);
-
-    if(led_output_task == NULL)
-        while(1);
-
-    // Create game thread
-    game_task = osThreadNew(game_task_function, (void *)0, &game_task_attributes);
-
-    if(game_task == NULL)
+    if(level_worker_task == NULL)
         while(1);
+#endif
         
 
-    // Energy recharge timer initialization
-    energy_recharge_timer = osTimerNew(energy_recharge_timer_callback, osTimerPeriodic, (void *)0, &energy_recharge_timer_attributes);
-    
-    if(energy_recharge_timer == NULL)
-        while(1);
-
-    // Energy depletion timer initialization
-    energy_depletion_timer = osTimerNew(energy_depletion_timer_callback, osTimerPeriodic, (void *)0, &energy_depletion_timer_attributes);
-    
-    if(energy_depletion_timer == NULL)
-        while(1);
-
-    // =================================================================================================
-    /* Green led pwm timer initialization */
-    //
-    green_led_pwm_timer = osTimerNew(green_led_pwm_timer_callback, osTimerPeriodic, (void *)0, &green_led_pwm_timer_attributes);
-
-    if(green_led_pwm_timer == NULL)
-        while(1);
-
-    init_status = osTimerStart(green_led_pwm_timer, 1U);
-
-    // =================================================================================================
-    /* Red led timer initialization */
-    //
-    red_led_timer = osTimerNew(red_led_timer_callback, osTimerPeriodic, (void *)0, &red_led_timer_attributes);
-
-    if(red_led_timer == NULL)
-        while(1);
-
-    // =================================================================================================
-    /* Game timer initialization */
-    //
-    game_timer = osTimerNew(game_timer_callback, osTimerPeriodic, (void *)0, &game_timer_attributes);
-
-    if(game_timer == NULL)
-        while(1);
-
     // =================================================================================================
     /* Gyro angle data mutex initialization */
     //
@@ -140,63 +244,99 @@ void ApplicationInit(void)
         while(1);
 
 
-    // =================================================================================================
-    /* Led event flag group initialization */
-    //
-    led_event = osEventFlagsNew(&led_event_attributes);
+    // Button semaphore
+    button_semaphore = osSemaphoreNew(1, 0, &button_semaphore_attributes);
 
-    if(led_event == NULL)
+    if(button_semaphore == NULL)
         while(1);
 
+    boot_init_cycles = DWT->CYCCNT;
+}
 
-    // Button semaphore
-    button_semaphore = osSemaphoreNew(1, 0, &button_semaphore_attributes);
+/**
+  * @brief Function for boot thread - brings up the gyro and the panel after the kernel has started, so their
+  *        waits sleep instead of spinning and overlap each other: the gyro is powered on first and the panel
+  *        sequence runs while it settles. Each device's threads are started as soon as it is ready, and the
+  *        game thread - whose first physics tick starts the game clock - once both are. The thread then exits.
+  *        Boot phases are recorded in the boot_ statics.
+  * @param void *arg - pointer to argument array
+  * @retval None
+  */
+void boot_task_function(void *arg)
+{
+    (void) &arg; // Remove warnings
+    [[maybe_unused]] osStatus_t status;
+    uint32_t gyro_power_on_time;
 
-    if(button_semaphore == NULL)
+    boot_kernel_start_cycles = DWT->CYCCNT;
+
+    // Gyro power on - it can't be configured for GYRO_POWER_ON_TIME
+    SPI_Bus_Init();
+    Gyro_Power_On();
+    gyro_power_on_time = osKernelGetTickCount();
+
+    // Panel
+    LTCD__Init();
+    LTCD_Layer_Init(0);
+    boot_panel_ready_cycles = DWT->CYCCNT;
+
+    lcd_display_task = osThreadNew(lcd_display_task_function, (void *)0, &lcd_display_task_attributes);
+
+    if(lcd_display_task == NULL)
         while(1);
 
+    // Gyro configuration, once it has settled
+    status = osDelayUntil(gyro_power_on_time + GYRO_POWER_ON_TIME);
+    Gyro_Config_FIFO(GYRO_DATA_RATE, GYRO_BANDWIDTH_SETTING, GYRO_X_AXIS | GYRO_Y_AXIS);
 
-    // Start game tick timer
-    init_status = osTimerStart(game_timer, 1U);
+#if !REPLAY_LOG
+    // Create gyro angle thread - a replay takes the board angle from the log instead
+    gyro_angle_task = osThreadNew(gyro_angle_task_function, (void *)0, &gyro_angle_task_attributes);
+
+    if(gyro_angle_task == NULL)
+        while(1);
+
+#if GYRO_ASYNC
+    // The gyro task is woken with new samples from here on
+    Gyro_Init_Stream(&gyro_stream, GYRO_WATERMARK, APPLICATION_notify_gyro_samples, (void *)0);
+#endif
+#endif
+    boot_gyro_ready_cycles = DWT->CYCCNT;
+
+    // Create game thread - the game clock starts with its first tick
+    game_task = osThreadNew(game_task_function, (void *)0, &game_task_attributes);
+
+    if(game_task == NULL)
+        while(1);
+
+    osThreadExit();
 }
 
 /**
-  * @brief 
-  * @param 
-  * @retval 
+  * @brief Picks the config to play with - the latest one saved in flash, used in place, if GAME_validate_config
+  *        passes it. If none of this CONFIG_VERSION has been saved the defaults are, for the next boot. With CONFIG_STATIC_PROFILE the
+  *        config is already the profile.
+  * @retval None
   */
 void APPLICATION_configure_settings(void)
 {
+#if CONFIG_STATIC_PROFILE
+    game_config = &config;
+#else
+    Config_Store_Init();
+    game_config = Config_Store_Load();
+
+    // A record that doesn't check out is left in flash, but the defaults are played
+    if(game_config == NULL || !GAME_validate_config(game_config))
+    {
+        GAME_default_config(&config);
 
-    config.version = 1;
-
-    // Game config
-    config.game_config.time_to_complete = 30000; // 30 sec
-    config.game_config.hard_edged = true;
-    config.game_config.reuse_waypoints = false; // All waypoints must be reached
-
-    // Map config
-    config.map_config.cell_count = 6;
-    config.map_config.wall_probability = 150;  // - 150 / 1000 = 15 %
-    config.map_config.hole_probability = 150;  // - 150 / 1000 = 15 %
-    config.map_config.num_waypoints = 4; 
-    config.map_config.hole_radius = 10;        // Pixels
-    config.map_config.waypoint_radius = 15;    // Pixels
-
-    // Drone config
-    config.drone_config.disruptor_max_time = 1000;                        
-    config.drone_config.disruptor_power = 10000;                           
-    config.drone_config.disruptor_min_activation_energy = 6000;           
-    config.drone_config.max_energy = 15000;                                
-    config.drone_config.recharge_rate = 1000;                             
-    config.drone_config.diameter = 10;
-    config.drone_config.max_velocity = 2500;
-
-    // Physics config
-    config.physics_config.gravity = 980;
-    config.physics_config.update_frequency = 50;
-    config.physics_config.angle_gain = 500;
-    config.physics_config.pin_at_center = MAZE; // This does not actually affect the configuration in this version
+        if(game_config == NULL)
+            Config_Store_Save(&config);
+
+        game_config = &config;
+    }
+#endif
 }
 
 
@@ -226,195 +366,367 @@ void APPLICATION_sample_button(void)
 }
 
 /**
-  * @brief Sample gyroscope and record rotation rate in gyro_rotation variable
+  * @brief Drains the gyroscope FIFO and integrates the rotation into the board angle. The samples are summed
+  *        and scaled to the rate one sample every GYRO_RATE_PERIOD would have read, so the tilt response
+  *        and the recorded log don't depend on the gyro's data rate or how often the FIFO is drained - the
+  *        zero rate offset is taken off each sample, and what rounding leaves over is carried to the next batch.
+  *        With GYRO_FILTER each axis is filtered first, the whole batch in one call.
   * @retval None
   */
 void APPLICATION_sample_gyro(void)
 {
-    int16_t gyro_velocity_x = Gyro_Get_Velocity_X(); 
-    int16_t gyro_velocity_y = Gyro_Get_Velocity_Y();
+    GyroSample_t samples[GYRO_FIFO_DEPTH];
+    int16_t rates_x[GYRO_FIFO_DEPTH], rates_y[GYRO_FIFO_DEPTH];
+    uint8_t count;
+    int32_t sum_x = 0, sum_y = 0;
+
+#if GYRO_ASYNC
+    // Read by the stream's interrupts - keep them out while taking the samples
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    count = GYRO_STREAM_take(&gyro_stream, samples, GYRO_FIFO_DEPTH);
+    __set_PRIMASK(primask);
+#else
+    count = Gyro_Read_FIFO(samples, GYRO_FIFO_DEPTH);
+#endif
+
+    if(count == 0)
+        return;
+
+    for(uint8_t i = 0; i < count; i ++)
+    {
+        rates_x[i] = samples[i].x;
+        rates_y[i] = samples[i].y;
+    }
 
-    // Obtain angular velocity in mdps
-    double angular_velocity_x = ((double)gyro_velocity_x) * 0.07; 
-    double angular_velocity_y = ((double)gyro_velocity_y) * 0.07;
-    
-    gyro_angle_x += (int)(angular_velocity_x * 0.01);
-    gyro_angle_y += (int)(angular_velocity_y * 0.01);
+    GYRO_RATE_correct(&gyro_rate_x, rates_x, count);
+    GYRO_RATE_correct(&gyro_rate_y, rates_y, count);
+
+#if GYRO_FILTER
+    uint32_t start_cycles = DWT->CYCCNT;
+    FILTER_biquad_process(&gyro_low_pass_x, rates_x, rates_x, count);
+    FILTER_biquad_process(&gyro_low_pass_y, rates_y, rates_y, count);
+    gyro_filter_cycles = DWT->CYCCNT - start_cycles;
+    gyro_filter_samples = count;
+#endif
+
+    for(uint8_t i = 0; i < count; i ++)
+    {
+        sum_x += rates_x[i];
+        sum_y += rates_y[i];
+    }
+
+    int16_t gyro_velocity_x = GYRO_RATE_scale(&gyro_rate_x, sum_x, 1000, GYRO_DATA_RATE_HZ * GYRO_RATE_PERIOD);
+    int16_t gyro_velocity_y = GYRO_RATE_scale(&gyro_rate_y, sum_y, 1000, GYRO_DATA_RATE_HZ * GYRO_RATE_PERIOD);
+
+    RECORD_INPUT(RECORDER_gyro(&recorder, gyro_velocity_x, gyro_velocity_y));
+
+    // Integrate angular velocity
+    GAME_integrate_gyro(&gyro_angle_x, &gyro_angle_y, gyro_velocity_x, gyro_velocity_y);
 }
 
 /**
-  * @brief Turn on green led
+  * @brief Called from the gyro stream's transfer complete interrupt - wakes the gyro task to take the samples
+  * @param void *context - unused
   * @retval None
   */
-void APPLICATION_activate_green_led(void)
+void APPLICATION_notify_gyro_samples(void *context)
 {
-    HAL_GPIO_WritePin(GPIOG, GPIO_PIN_13, GPIO_PIN_SET);
+    (void) &context; // Remove warnings
+    [[maybe_unused]] uint32_t flags;
+
+    flags = osThreadFlagsSet(gyro_angle_task, GYRO_SAMPLES_FLAG);
 }
 
 /**
-  * @brief Turn on red led
+  * @brief Enable the DWT cycle counter - used to time map loading
   * @retval None
   */
-void APPLICATION_activate_red_led(void)
+void APPLICATION_enable_cycle_counter(void)
 {
-    HAL_GPIO_WritePin(GPIOG, GPIO_PIN_14, GPIO_PIN_SET);
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
 /**
-  * @brief Turn off green led
+  * @brief Shows the energy on the leds - the green led's brightness is the energy left, and the red led
+  *        blinks while the disruptor is locked, faster the closer the energy is to unlocking it. Both are off
+  *        once the game is over. The led tables are only rewritten when one of these changes.
   * @retval None
   */
-void APPLICATION_deactivate_green_led(void)
+void APPLICATION_update_leds(void)
 {
-    HAL_GPIO_WritePin(GPIOG, GPIO_PIN_13, GPIO_PIN_RESET);
+    int32_t locked_energy = CONFIG_DRONE_DISRUPTOR_MIN_ACTIVATION_ENERGY(game_config) - game.drone_energy;
+    uint32_t blink_period = LED_PWM_MS((locked_energy > 0) ? (uint32_t)locked_energy / 10 : 0); // 10 mJ a ms
+
+    if(game.won || game.lost)
+    {
+        LED_PWM_set_level(&led_pwm, 0);
+        LED_PWM_set_blink(&led_pwm, 0);
+        return;
+    }
+
+    LED_PWM_set_level(&led_pwm, (game.drone_energy * LED_PWM_GREEN_LEVELS) / CONFIG_DRONE_MAX_ENERGY(game_config));
+    LED_PWM_set_blink(&led_pwm, game.disruptor_can_be_activated ? 0 : (blink_period > UINT16_MAX ? UINT16_MAX : blink_period));
 }
 
+
 /**
-  * @brief Turn off red led
-  * @retval None
-  */
-void APPLICATION_deactivate_red_led(void)
+ * @brief Creates the initial map structure - determines where all the walls, waypoints and holes are -
+ *        and starts a game on it. The map only depends on the seed, which is recorded so the game can be
+ *        replayed.
+ * 
+ * @param uint32_t seed - MAP_xorshift_random seed, must not be 0
+ * @return void
+ */
+void APPLICATION_create_map(uint32_t seed)
 {
-    HAL_GPIO_WritePin(GPIOG, GPIO_PIN_14, GPIO_PIN_RESET);
+    uint32_t random_state = seed;
+
+    if(!MAP_create(&game.map, &game_config->map_config, MAP_xorshift_random, &random_state))
+        while(1);
+
+    if(!GAME_start(&game))
+        while(1);
+
+    APPLICATION_begin_game(seed, -1);
 }
 
 /**
-  * @brief Toggle green led
-  * @retval None
-  */
-void APPLICATION_toggle_green_led(void)
+ * @brief Loads a level from the level pack and starts a game on it. The level is decompressed into the
+ *        level pack scratch arena and copied into game.map. The time spent decoding is recorded in
+ *        level_decode_cycles.
+ * 
+ * @param uint16_t level_index - index of the level within level_pack_data
+ * @return bool - true if the level was loaded, false if it does not exist or does not fit this map
+ */
+bool APPLICATION_load_level(uint16_t level_index)
 {
-    if(green_led_state == 1)
-    {
-        green_led_state = 0;
-        APPLICATION_deactivate_green_led();
-    } else {
-        green_led_state = 1;
-        APPLICATION_activate_green_led();
-    }
+    LevelData_t level;
+
+    uint32_t start_cycles = DWT->CYCCNT;
+
+    if(!LEVEL_PACK_load(level_pack_data, level_index, &level))
+        return false;
+
+    level_decode_cycles = DWT->CYCCNT - start_cycles;
+
+    if(level_decode_cycles > (SystemCoreClock / 1000000) * LEVEL_DECODE_BUDGET_US)
+        level_decode_overruns ++;
+
+    // Drawing and collision assume the configured map size
+    if(level.cell_count != game_config->map_config.cell_count)
+        return false;
+
+    if(!MAP_load_level(&game.map, &level))
+        return false;
+
+    if(!GAME_start(&game))
+        return false;
+
+    current_level = level_index;
+
+    APPLICATION_begin_game(0, level_index);
+
+    return true;
 }
 
 /**
-  * @brief Toggle red led
-  * @retval None
-  */
-void APPLICATION_toggle_red_led(void)
+ * @brief Starts the game recorded in replay_log_data - rebuilds its map from the recorded seed or level
+ * 
+ * @param void
+ * @return bool - false if the log doesn't start with a game start record or the level can't be loaded
+ */
+bool APPLICATION_start_replay(void)
 {
-    if(red_led_state == 1)
-    {
-        red_led_state = 0;
-        APPLICATION_deactivate_red_led();
-    } else {
-        red_led_state = 1;
-        APPLICATION_activate_red_led();
-    }
+    RecordEvent_t event;
+
+    RECORDER_reader_init(&replay_reader, replay_log_data, replay_log_size);
+
+    if(!RECORDER_next(&replay_reader, &event) || event.type != RECORD_START)
+        return false;
+
+    if(event.level >= 0)
+        return APPLICATION_load_level(event.level);
+
+    APPLICATION_create_map(event.seed);
+
+    return true;
+}
+
+/**
+ * @brief Starts recording the game that was just started and plans the autopilot's route through it
+ * 
+ * @param uint32_t seed - map seed, for a generated map
+ * @param int32_t level - level pack index, -1 for a generated map
+ * @return void
+ */
+void APPLICATION_begin_game(uint32_t seed, int32_t level)
+{
+    RECORDER_init(&recorder);
+    RECORDER_start(&recorder, seed, level);
+
+    APPLICATION_plan_autopilot();
+    APPLICATION_update_leds();
 }
 
+/**
+ * @brief Plans the autopilot's route through the game just started. Without a route the autopilot holds the
+ *        board flat until the game times out.
+ * 
+ * @param void
+ * @return void
+ */
+void APPLICATION_plan_autopilot(void)
+{
+#if AUTOPILOT
+    if(!AUTOPILOT_plan(&autopilot, &game.map, game.map.waypoint_data[0].x, game.map.waypoint_data[0].y, 0))
+        autopilot_unplanned ++;
+#endif
+}
 
 /**
- * @brief Creates the initial map structure - determines where all the walls, waypoints and holes are.
- *        It loads these values into the global map data structure to be read by other threads. This also
- *         initializes the drone position to default (center of the map)
+ * @brief Called once when the game is won or lost - sets the level worker building the next level while the
+ *        result screen shows
  * 
  * @param void
  * @return void
  */
-void APPLICATION_create_map(void)
+void APPLICATION_game_over(void)
 {
-    uint32_t rand;
-    num_holes = 0;
+    [[maybe_unused]] uint32_t flags;
 
-    uint8_t num_waypoints = config.map_config.num_waypoints;
-    uint8_t increment;
+    APPLICATION_update_leds();
 
+#if !REPLAY_LOG
+    flags = osThreadFlagsSet(level_worker_task, PREPARE_LEVEL_FLAG);
+#endif
+}
 
-    // Create the map array
+/**
+ * @brief Builds the next level in next_game - generates a map (or decodes the next level of the pack), checks
+ *        every waypoint can be reached, bakes its collision data and places the drone, and routes the flow
+ *        field. Runs on the level worker. The time spent is recorded in next_level_prepare_cycles.
+ * 
+ * @param void
+ * @return bool - false if the level couldn't be built
+ */
+bool APPLICATION_prepare_next_level(void)
+{
+    uint32_t start_cycles = DWT->CYCCNT;
 
-    // For every cell in the map
-    for(int i = 0; i < config.map_config.cell_count; i++)
-    {
-        for(int j = 0; j < config.map_config.cell_count; j ++)
-        {
-            cell_data[i][j] = 0; // Initialize to 0
+    // next_game is about to be overwritten - the game task mustn't swap it in until it is complete again
+    next_level_ready = false;
 
-            // Get random number
-            rand = RNG_get_random_number(1000); 
+#if USE_LEVEL_PACK
+    LevelData_t level;
+    uint16_t level_index = (current_level + 1) % LEVEL_PACK_get_level_count(level_pack_data);
 
-            // Generate bottom wall
-            if(rand < config.map_config.wall_probability)           
-                cell_data[i][j] |= 0b00000010;
+    if(!LEVEL_PACK_load(level_pack_data, level_index, &level) || level.cell_count != game_config->map_config.cell_count ||
+       !MAP_load_level(&next_game.map, &level))
+        return false;
 
-            rand = RNG_get_random_number(1000); 
+    next_level_seed = 0;
+    next_level_index = level_index;
+#else
+    for(uint32_t attempt = 0; attempt < NEXT_LEVEL_MAX_ATTEMPTS; attempt ++)
+    {
+        uint32_t random_state;
 
-            // Generate right wall
-            if(rand < config.map_config.wall_probability)           
-                cell_data[i][j] |= 0b00001000;
+        // Never 0 - xorshift would get stuck
+        next_level_seed = RNG_get_random_number(UINT32_MAX) | 1;
+        random_state = next_level_seed;
 
-            rand = RNG_get_random_number(1000); 
+        if(!MAP_create(&next_game.map, &game_config->map_config, MAP_xorshift_random, &random_state))
+            return false;
 
-            // Generate hole
-            if(rand < config.map_config.hole_probability)
-            {
-                cell_data[i][j] |= 0b00010000;
-                num_holes ++;
-            }            
-                
-        }
+        if(AUTOPILOT_plan(&level_validator, &next_game.map, next_game.map.waypoint_data[0].x, next_game.map.waypoint_data[0].y, 0))
+            break;
+
+        next_level_rejected ++;
     }
 
-    // Waypoint generation
+    next_level_index = -1;
+#endif
 
-    increment = 0;
+    if(!GAME_start(&next_game))
+        return false;
 
-    while(increment < num_waypoints)
-    {
-        uint32_t randRow = RNG_get_random_number(config.map_config.cell_count);
-        uint32_t randCol = RNG_get_random_number(config.map_config.cell_count);
+    const WaypointData_t *target = &next_game.map.waypoint_data[next_game.current_waypoint];
 
-        // If a waypoint has already been generated in this cell
-        if(cell_data[randRow][randCol] & 0x20)
-            continue;
+    FLOW_FIELD_compute(&next_flow_field, &next_game.map, MAP_CELL_ROW(target->y), MAP_CELL_COL(target->x));
 
-        // If a hole has been generated in this cell, override it with a waypoint
-        if(cell_data[randRow][randCol] & 0x10)
-        {
-            cell_data[randRow][randCol] &= 0b11101111; // Clear hole data
-            num_holes --;
-        }
+    next_level_prepare_cycles = DWT->CYCCNT - start_cycles;
+    next_level_ready = true;
 
-        // If the cell is empty, generate a new waypoint
-        cell_data[randRow][randCol] |= 0x20; // Set waypoint data
-        waypoint_data[increment].x = (randCol * 40) + 20;
-        waypoint_data[increment].y = (randRow * 40) + 60;
-        waypoint_data[increment].number = increment;
-        waypoint_data[increment].reached = false;        
+    return true;
+}
 
-        increment ++;
-    }
+/**
+ * @brief Asks for the next level - the game task starts it as soon as it is ready
+ * 
+ * @param void
+ * @return void
+ */
+void APPLICATION_request_next_level(void)
+{
+    if(next_level_requested)
+        return;
 
-    // Create arrays of hole data
-    hole_data = (HoleData_t *)calloc(num_holes, sizeof(HoleData_t));
-    if(hole_data == NULL)
-        while(1);
-    
-    // Use increment to index the generated holes
-    increment = 0;
+    next_level_request_time = osKernelGetTickCount();
+    next_level_requested = true;
+}
 
-    // Get hole and waypoint location data 
-    for(int i = 0; i < config.map_config.cell_count; i ++)
-    {
-        for(int j = 0; j < config.map_config.cell_count; j ++)
-        {   
-            // If a hole is generated within this cell, place its center coordinate within the holes array
-            if(cell_data[i][j] & 0x10)
-            {
-                hole_data[increment].x = (j * 40) + 20;
-                hole_data[increment].y = (i * 40) + 60;
+/**
+ * @brief Swaps the prepared level in and starts playing it. Everything was built by the level worker, so
+ *        this is a copy. Runs on the game task. The time taken is recorded in level_swap_cycles and the
+ *        time since the level was asked for in time_to_playable.
+ * 
+ * @param void
+ * @return void
+ */
+void APPLICATION_start_next_level(void)
+{
+    [[maybe_unused]] osStatus_t status;
 
-                increment ++;
-            }
-        }
-    }
+    status = osMutexAcquire(drone_position_mutex, osWaitForever);
+
+    uint32_t start_cycles = DWT->CYCCNT;
+
+    memcpy(&game, &next_game, sizeof(game));
+    memcpy(&flow_field, &next_flow_field, sizeof(flow_field));
+
+    level_swap_cycles = DWT->CYCCNT - start_cycles;
+
+    if(next_level_index >= 0)
+        current_level = next_level_index;
+
+    next_level_ready = false;
+    next_level_requested = false;
+
+    APPLICATION_begin_game(next_level_seed, next_level_index);
+
+    time_to_playable = osKernelGetTickCount() - next_level_request_time;
+
+    status = osMutexRelease(drone_position_mutex);
+}
+
+/**
+ * @brief Rebuilds the flow field toward the current waypoint. The time spent is recorded in flow_field_cycles.
+ * 
+ * @param void
+ * @return void
+ */
+void APPLICATION_update_flow_field(void)
+{
+    uint32_t start_cycles = DWT->CYCCNT;
+
+    const WaypointData_t *target = &game.map.waypoint_data[game.current_waypoint];
+
+    FLOW_FIELD_compute(&flow_field, &game.map, MAP_CELL_ROW(target->y), MAP_CELL_COL(target->x));
+
+    flow_field_cycles = DWT->CYCCNT - start_cycles;
 }
 
 /**
@@ -425,6 +737,11 @@ void APPLICATION_create_map(void)
  */
 void APPLICATION_draw_map(void)
 {
+    // Read once - the drawing calls in the loop would otherwise make the compiler read them again every cell
+    int cell_count = CONFIG_MAP_CELL_COUNT(game_config);
+    uint8_t hole_radius = CONFIG_MAP_HOLE_RADIUS(game_config);
+    uint8_t waypoint_radius = CONFIG_MAP_WAYPOINT_RADIUS(game_config);
+
     // Map boundaries
     LCD_Draw_Line(0, 40, 239, 40, LCD_COLOR_BLACK);         // Top
     LCD_Draw_Line(0, 280, 239, 280, LCD_COLOR_BLACK);       // Bottom
@@ -432,51 +749,51 @@ void APPLICATION_draw_map(void)
     LCD_Draw_Line(239, 40, 239, 280, LCD_COLOR_BLACK);      // Right
 
     // Loop through matrix of map data and draw map accordingly
-    for(int i = 0; i < config.map_config.cell_count; i++)
+    for(int i = 0; i < cell_count; i++)
     {
-        for(int j = 0; j < config.map_config.cell_count; j ++)
+        for(int j = 0; j < cell_count; j ++)
         {
             // Top Line
-            if(cell_data[i][j] & 0x1)
+            if(game.map.cell_data[i][j] & 0x1)
                 LCD_Draw_Line(0 + (40 * j), 40 + (40 * i), 40 + (40 * j), 40 + (40 * i), LCD_COLOR_BLACK);  
                 
             // Bottom line
-            if(cell_data[i][j] & 0x2)
+            if(game.map.cell_data[i][j] & 0x2)
                 LCD_Draw_Line(0 + (40 * j), 80 + (40 * i), 40 + (40 * j), 80 + (40 * i), LCD_COLOR_BLACK);  
                 
             // Left line
-            if(cell_data[i][j] & 0x4)
+            if(game.map.cell_data[i][j] & 0x4)
                 LCD_Draw_Line(0 + (40 * j), 40 + (40 * i), 0 + (40 * j), 80 + (40 * i), LCD_COLOR_BLACK);   
 
             // Right line
-            if(cell_data[i][j] & 0x8)
+            if(game.map.cell_data[i][j] & 0x8)
                 LCD_Draw_Line(40 + (40 * j), 40 + (40 * i), 40 + (40 * j), 80 + (40 * i), LCD_COLOR_BLACK); 
 
             // Hole
-            if(cell_data[i][j] & 0x10)
-                LCD_Draw_Circle_Fill(20 + (40 * j), 60 + (40 * i), config.map_config.hole_radius, LCD_COLOR_BLACK);
+            if(game.map.cell_data[i][j] & 0x10)
+                LCD_Draw_Circle_Fill(20 + (40 * j), 60 + (40 * i), hole_radius, LCD_COLOR_BLACK);
 
             // Waypoints
-            if(cell_data[i][j] & 0x20)
+            if(game.map.cell_data[i][j] & 0x20)
             {
                 // Check which waypoint to draw
-                for(int k = 0; k < config.map_config.num_waypoints; k ++)
+                for(int k = 0; k < game.map.num_waypoints; k ++)
                 {
                     // If x and y coordinates match
-                    if(waypoint_data[k].x == (20 + (40 * j)) && waypoint_data[k].y == (60 + (40 * i)))
+                    if(game.map.waypoint_data[k].x == (20 + (40 * j)) && game.map.waypoint_data[k].y == (60 + (40 * i)))
                     {
                         // Waypoints are green if they've been reached previously
                         // Otherwise, they are red
-                        if(waypoint_data[k].reached)
+                        if(game.map.waypoint_data[k].reached)
                         {
-                            LCD_Draw_Circle_Fill(20 + (40 * j), 60 + (40 * i), config.map_config.waypoint_radius, LCD_COLOR_GREEN);
+                            LCD_Draw_Circle_Fill(20 + (40 * j), 60 + (40 * i), waypoint_radius, LCD_COLOR_GREEN);
                         }
                         else {
-                            LCD_Draw_Circle_Fill(20 + (40 * j), 60 + (40 * i), config.map_config.waypoint_radius, LCD_COLOR_RED);
+                            LCD_Draw_Circle_Fill(20 + (40 * j), 60 + (40 * i), waypoint_radius, LCD_COLOR_RED);
                         }
                         
                         // Display the waypoints number at its approximate center
-                        LCD_DisplayNumber(17 + (40 * j), 56 + (40 * i), waypoint_data[k].number);
+                        LCD_DisplayNumber(17 + (40 * j), 56 + (40 * i), game.map.waypoint_data[k].number);
                     }
                 }
                 
@@ -486,203 +803,6 @@ void APPLICATION_draw_map(void)
     }
 }
 
-/**
-  * @brief Depending on the angle of the board, figures out the adjusted force due to gravity
-  * @param int16_t - angle of board
-  * @retval int32_t - adjusted gravitational force
-  */
-int32_t APPLICATION_get_board_gravity_ratio(int16_t angle)
-{
-        int8_t mult = 1;
-        int32_t accel;
-
-        angle -= 180;
-        
-        if(angle < 0)
-        {
-            mult *= -1;
-            angle *= -1;
-        }
-
-        angle = (angle * config.physics_config.angle_gain) / 1000;
-
-        if(angle > 70)
-        {
-            exceeded_tilt = true;
-            game_lost = true;
-        }
-        
-        // Approximate sine of board angle 
-        if(angle <= 5)
-        {
-            accel = 0; 
-        } 
-        else if(angle <= 10)
-        {
-            accel = 15; 
-        }
-        else if(angle <= 20)
-        {
-            accel = 30; 
-        }
-        else if(angle <= 40)
-        {
-            accel = 50;
-        }
-        else 
-        {
-            accel = 75;
-        }
-
-        // Get acceleration ratio with gravity
-        accel *= (mult * config.physics_config.gravity);
-        accel /= 100;
-
-        return accel;
-}
-
-
-/**
-  * @brief Check if specified x and y coordinates are over a hole in the map
-  * @param int32_t xCoor, yCoor - coordinates to check
-  * @retval bool - True if coordinates lie over hole, false otherwise
-  */
-bool APPLICATION_is_over_hole(int32_t xCoor, int32_t yCoor)
-{
-    int32_t x_distance;
-    int32_t y_distance;
-    double distance;
-
-    for(int i = 0; i < num_holes; i ++)
-    {
-        // Distance formula for distance between coordinate and a hole
-
-        x_distance = xCoor - hole_data[i].x;
-        x_distance *= x_distance;
-
-        y_distance = yCoor - hole_data[i].y;
-        y_distance *= y_distance;
-
-        distance = sqrt(x_distance + y_distance);
-
-        if(distance < config.map_config.hole_radius)
-            return true;
-    }
-
-    return false;
-}
-
-/**
-  * @brief Determines if a point is over a waypoint and, if so, which waypoint
-  * @param int32_t xCoor, yCoor - Coordiante to check 
-  * @retval int8_t - -1 if not over waypoint, otherwise returns the waypoint number
-  */
-int8_t APPLICATION_is_over_waypoint(int32_t xCoor, int32_t yCoor)
-{
-    int32_t x_distance;
-    int32_t y_distance;
-    double distance;
-
-    for(int i = 0; i < config.map_config.num_waypoints; i ++)
-    {
-        // Distance formula for distance between coordinate and a waypoint
-
-        x_distance = xCoor - waypoint_data[i].x;
-        x_distance *= x_distance;
-
-        y_distance = yCoor - waypoint_data[i].y;
-        y_distance *= y_distance;
-
-        distance = sqrt(x_distance + y_distance);
-
-        if(distance < config.map_config.waypoint_radius)
-            return waypoint_data[i].number;
-    }
-
-    return -1;
-}
-
-/**
-  * @brief Check if the xCoor and yCoor are over a horizontal wall
-  * @param int32_t xCoor, yCoor - coordinates to check
-  * @retval bool - true if collision with wall is detected
-  */
-bool APPLICATION_check_horizontal_wall_collision(int32_t xCoor, int32_t yCoor)
-{
-    // Generate index from xCoor and yCoor
-    // xCoor and yCoor can be used to figure out which cell the drone is in as well as the neighboring cells
-    // These cells can then be checked to see if a part of the drone is lying within a wall
-    // 5 cells in total will be checked
-
-    // 6 x 6 cells - 40 pixels each
-
-    // Obtain the cell row and column information from the x and y coordinates of the drone's center
-    cellRow = (yCoor - 40) / 40;
-    cellCol = xCoor / 40;
-
-    // If cell right wall is collided with
-    if(cell_data[cellRow][cellCol] & 0x8)
-    {
-        if(APPLICATION_check_drone_overlap(xCoor, cellCol * 40 + 40))
-            return true;
-    }    
-
-    // Check if cell left wall is collided with
-    if(cellCol != 0)
-    {   
-        if(cell_data[cellRow][cellCol - 1] & 0x8)
-        {
-            if(APPLICATION_check_drone_overlap(xCoor, (cellCol - 1) * 40 + 40))
-                return true;
-        }   
-    }
-     
-    return false;
-}
-
-/**
-  * @brief Check if the coordinates overlap with a vertical wall
-  * @param int32_t xCoor, yCoor - coordinate to check
-  * @retval bool - True if overlapping with vertical wall, false otherwise
-  */
-bool APPLICATION_check_vertical_wall_collision(int32_t xCoor, int32_t yCoor)
-{
-    // Obtain the cell row and column information from the x and y coordinates of the drone's center
-    cellRow = (yCoor - 40) / 40;
-    cellCol = xCoor / 40;
-
-    // If cell bottom wall is collided with
-    if(cell_data[cellRow][cellCol] & 0x2)
-    {
-        if(APPLICATION_check_drone_overlap(yCoor, cellRow * 40 + 80))
-            return true;
-    }
-
-    if(cellRow != 0)
-    {
-        if(cell_data[cellRow - 1][cellCol] & 0x2)
-        {
-            if(APPLICATION_check_drone_overlap(yCoor, (cellRow - 1) * 40 + 80))
-                return true;
-        }
-    }
-
-    return false;
-}
-
-/**
-  * @brief Check overlap with a horizontal or vertical line
-  * @param uint32_t drone_pos, line_pos - the two locations to check for overlap
-  * @retval bool - true if overlap, false otherwise
-  */
-bool APPLICATION_check_drone_overlap(int32_t drone_pos, int32_t line_pos)
-{
-    if(abs(drone_pos - line_pos) <= config.drone_config.diameter / 2)
-        return true;
-
-    return false;
-}
-
 /**
   * @brief Function for the LCD thread - updates every frame
   * @param void *arg - pointer to argument array
@@ -692,10 +812,12 @@ void lcd_display_task_function(void *arg)
 {
 	(void) &arg; // Remove warnings
     [[maybe_unused]] osStatus_t status;
+    q16_t interpolation; // Fraction of a physics tick since the last one
+    q16_t draw_x, draw_y; // Drone position on screen
 
 	while(1)
 	{
-        if(game_won)
+        if(game.won)
         {   
             LCD_Clear(0, LCD_COLOR_WHITE);
             LCD_SetTextColor(LCD_COLOR_GREEN);
@@ -703,11 +825,15 @@ void lcd_display_task_function(void *arg)
 
             LCD_DisplayString(40, 148, "You Win!!!");
 
+            LCD_SetTextColor(LCD_COLOR_BLACK);
+            LCD_SetFont(&Font12x12);
+            LCD_DisplayString(36, 220, "Press to go on");
+
             osDelay(LCD_UPDATE_RATE);
             continue;
         }
 
-        if(game_lost)
+        if(game.lost)
         {
             LCD_Clear(0, LCD_COLOR_WHITE);
             LCD_SetTextColor(LCD_COLOR_RED);
@@ -717,20 +843,23 @@ void lcd_display_task_function(void *arg)
 
             LCD_SetFont(&Font12x12);
 
-            if(fell_into_hole)
+            if(game.fell_into_hole)
             {
                 LCD_DisplayString(10, 175, "Drone was lost!");
             } 
-            else if(ran_out_of_time)
+            else if(game.ran_out_of_time)
             {
                 LCD_DisplayString(35, 175, "Out of time!");
             }
-            else if(exceeded_tilt)
+            else if(game.exceeded_tilt)
             {
                 LCD_DisplayString(15, 175, "Drone fell off");
                 LCD_DisplayString(75, 190, "Board!");
             }
 
+            LCD_SetTextColor(LCD_COLOR_BLACK);
+            LCD_DisplayString(36, 220, "Press to go on");
+
             osDelay(LCD_UPDATE_RATE);
             continue;
         }
@@ -741,24 +870,36 @@ void lcd_display_task_function(void *arg)
 
         APPLICATION_draw_map();
 
+        // Draw the drone between its last two physics positions so it moves smoothly between ticks
         status = osMutexAcquire(drone_position_mutex, osWaitForever);
-        LCD_Draw_Circle_Fill(drone_position_x, drone_position_y, config.drone_config.diameter / 2, LCD_COLOR_BLUE);
+        interpolation = APPLICATION_get_interpolation_factor(osKernelGetTickCount());
+        draw_x = FIXED_add(game.entities.prev_x[DRONE_ENTITY], FIXED_mul(FIXED_sub(game.entities.pos_x[DRONE_ENTITY], game.entities.prev_x[DRONE_ENTITY]), interpolation));
+        draw_y = FIXED_add(game.entities.prev_y[DRONE_ENTITY], FIXED_mul(FIXED_sub(game.entities.pos_y[DRONE_ENTITY], game.entities.prev_y[DRONE_ENTITY]), interpolation));
         status = osMutexRelease(drone_position_mutex);
 
+        LCD_Draw_Circle_Fill(Q16_ROUND_TO_INT(draw_x), Q16_ROUND_TO_INT(draw_y), CONFIG_DRONE_DIAMETER(game_config) / 2, LCD_COLOR_BLUE);
+
         // Display disruptor energy level
         LCD_DisplayString(10, 300, "Energy: ");
-        LCD_DisplayNumber(110, 300, drone_energy);
+        LCD_DisplayNumber(110, 300, game.drone_energy);
 
         // Display time remaining
         LCD_DisplayString(10, 15, "Time: ");
-        LCD_DisplayNumber(92, 15, (config.game_config.time_to_complete - game_tick) / 1000 + 1);
+        LCD_DisplayNumber(92, 15, (CONFIG_GAME_TIME_TO_COMPLETE(game_config) - game.time) / 1000 + 1);
+
+        if(boot_first_frame_cycles == 0)
+        {
+            boot_first_frame_cycles = DWT->CYCCNT;
+            time_to_first_frame = boot_first_frame_cycles / (SystemCoreClock / 1000000);
+        }
 
 		osDelay(LCD_UPDATE_RATE);
 	}
 }
 
 /**
-  * @brief Function for disruptor thread - controls energy level of disruptor as well as its usability
+  * @brief Function for disruptor thread - shows the disruptor's energy on the leds whenever a physics tick
+  *        changes it. The energy itself is drained and recharged by the tick, so a replay gets the same.
   * @param void *arg - pointer to argument array
   * @retval None
   */
@@ -770,96 +911,18 @@ void disruptor_task_function(void *arg)
 
 	while(1)
 	{	
-        if(game_won || game_lost)
+        if(game.won || game.lost)
         {
             status = osThreadYield();
         }
 
-		flags = osEventFlagsWait(energy_event, 0x0003, osFlagsWaitAny, osWaitForever); // Wait for button event to occur
- 
-        if(flags & DEPLETE_ENERGY_EVENT)
-        {
-            
-            drone_energy -= config.drone_config.disruptor_power / 100;
-            if(drone_energy <= 0)
-            {
-                drone_energy = 0;
-                osTimerStop(energy_depletion_timer);
-            }
-
-            // Energy level below minimum activation 
-            if(drone_energy < config.drone_config.disruptor_min_activation_energy)
-            {
-                disruptor_can_be_activated = 0;
-                status = osTimerStart(red_led_timer, 1U);
-            }
-        }
+		flags = osEventFlagsWait(energy_event, ENERGY_CHANGED_EVENT, osFlagsWaitAny, osWaitForever);
 
-        if(flags & RECHARGE_ENERGY_EVENT)
-        {
-            drone_energy += config.drone_config.recharge_rate / 100;
-
-            if(drone_energy >= config.drone_config.max_energy)
-            {
-                drone_energy = config.drone_config.max_energy;
-                osTimerStop(energy_recharge_timer);
-            }
-
-            // Energy satisfies minimum activation
-            if(drone_energy >= config.drone_config.disruptor_min_activation_energy)
-            {
-                disruptor_can_be_activated = 1;
-                status = osTimerStop(red_led_timer);
-                flags = osEventFlagsSet(led_event, DISABLE_RED_LED_EVENT); // Disable red led
-            }
-        }
+        // Brightness and blink rate follow the energy
+        APPLICATION_update_leds();
 	}
 }
 
-/**
-  * @brief Function for led thread - controls led outputs
-  * @param void *arg - pointer to argument array
-  * @retval None
-  */
-void led_output_task_function(void *arg)
-{
-    (void) &arg; // Remove warnings
-    [[maybe_unused]] osStatus_t status;
-    uint32_t event_flags;
-
-    while(1)
-    {
-        if(game_won || game_lost)
-        {
-            APPLICATION_deactivate_red_led();
-            APPLICATION_deactivate_green_led();
-            status = osThreadYield();
-        }
-        
-        // Wait for an LED event 
-        event_flags = osEventFlagsWait(led_event, 0x000F, osFlagsWaitAny, osWaitForever);
-
-        if(event_flags & ENABLE_RED_LED_EVENT)
-        {
-            APPLICATION_activate_red_led();
-        } 
-        else if(event_flags & DISABLE_RED_LED_EVENT)
-        {
-            APPLICATION_deactivate_red_led();
-        }
-
-
-        if(event_flags & ENABLE_GREEN_LED_EVENT)
-        {
-            APPLICATION_activate_green_led();
-        }
-        else if(event_flags & DISABLE_GREEN_LED_EVENT)
-        {
-            APPLICATION_deactivate_green_led();
-        }
-    }
-}
-
 /**
   * @brief Function for button thread - Activates/deactivates disruptor
   * @param void *arg - pointer to argument array
@@ -872,33 +935,36 @@ void button_task_function(void *arg)
     
 	while(1)
 	{
-        if(game_won || game_lost)
+        if(game.won || game.lost)
         {
             status = osThreadYield();
         }
 
 		status = osSemaphoreAcquire(button_semaphore, osWaitForever); // Wait for button press
 
-		if(button_state == BUTTON_PRESSED)
+        // On the result screen a press asks for the next level
+        if(game.won || game.lost)
         {
-            // Start depleting energy level while button is pressed
-            status = osTimerStop(energy_recharge_timer);
-            status = osTimerStart(energy_depletion_timer, 10);
+            if(button_state == BUTTON_PRESSED)
+                APPLICATION_request_next_level();
 
-            if(disruptor_can_be_activated)
-            {
-                disruptor_active = true;
-            }
-            else {
-                disruptor_active = false;
-            }
+            continue;
+        }
+
+		if(button_state == BUTTON_PRESSED)
+        {
+            // Energy drains from the next physics tick while the button is held
+            status = osMutexAcquire(drone_position_mutex, osWaitForever);
+            GAME_set_button(&game, true);
+            RECORD_INPUT(RECORDER_button(&recorder, true));
+            status = osMutexRelease(drone_position_mutex);
         } 
         else if(button_state == BUTTON_NOT_PRESSED)
         {
-            status = osTimerStop(energy_depletion_timer);
-            status = osTimerStart(energy_recharge_timer, 10);
-
-            disruptor_active = false;
+            status = osMutexAcquire(drone_position_mutex, osWaitForever);
+            GAME_set_button(&game, false);
+            RECORD_INPUT(RECORDER_button(&recorder, false));
+            status = osMutexRelease(drone_position_mutex);
         }
 	}
 
@@ -913,260 +979,216 @@ void gyro_angle_task_function(void *arg)
 {
     (void) &arg; // Remove warnings
     [[maybe_unused]] osStatus_t status;
+    [[maybe_unused]] uint32_t flags;
 
     while(1)
     {
-        if(game_won || game_lost)
+        if(game.won || game.lost)
         {
             status = osThreadYield();
         }
 
+#if GYRO_ASYNC
+        // Sleep until the stream has read new samples
+        flags = osThreadFlagsWait(GYRO_SAMPLES_FLAG, osFlagsWaitAny, GYRO_STALL_TIMEOUT);
+
+        // None for a while - a read that couldn't be started has no interrupt left to retry it
+        if(flags == osFlagsErrorTimeout)
+        {
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            GYRO_STREAM_poll(&gyro_stream);
+            __set_PRIMASK(primask);
+            continue;
+        }
+#endif
+
         status = osMutexAcquire(gyro_angle_mutex, osWaitForever);
         APPLICATION_sample_gyro();
         status = osMutexRelease(gyro_angle_mutex);
 
+#if !GYRO_ASYNC
         osDelay(GYRO_SAMPLE_RATE);
+#endif
     }
 }
 
 /**
-  * @brief Main game thread - controls drone position, game collision, and physics updates
-  * @param void *arg - pointer to argument array
+  * @brief Advances the game by one physics tick - reads the board angle and steps the game rules. In replay
+  *        mode the inputs up to the tick come from the log instead, and in autopilot mode the board angle comes
+  *        from the autopilot. The time spent is recorded in physics_step_cycles.
+  * @param uint32_t tick_time - kernel tick this physics tick was due at
   * @retval None
   */
-void game_task_function(void *arg)
+void APPLICATION_step_physics(uint32_t tick_time)
 {
-    (void) &arg; // Remove warnings
     [[maybe_unused]] osStatus_t status;
 
-    [[maybe_unused]] int16_t board_angle_x, board_angle_y; // Angle of the board itself
-    [[maybe_unused]] int16_t accel_x, accel_y; // Axial acceleration for the drone
-   
-    while(1)
+    [[maybe_unused]] q16_t board_angle_x, board_angle_y; // Angle of the board itself
+    uint32_t events;
+
+    status = osMutexAcquire(drone_position_mutex, osWaitForever);
+
+    uint32_t start_cycles = DWT->CYCCNT;
+    int32_t energy = game.drone_energy;
+
+    physics_tick_time = tick_time;
+
+#if REPLAY_LOG
+    RECORDER_replay_tick(&replay_reader, &game, &events);
+#elif AUTOPILOT
+    AUTOPILOT_steer(&autopilot, &game, &board_angle_x, &board_angle_y);
+    events = GAME_advance_energy(&game, CONFIG_PHYSICS_UPDATE_PERIOD(game_config));
+    events |= GAME_advance_clock(&game, CONFIG_PHYSICS_UPDATE_PERIOD(game_config));
+    events |= GAME_step(&game, board_angle_x, board_angle_y);
+#else
+    // The tick is recorded while the angle is read, so every gyro sample lands on the right side of it
+    status = osMutexAcquire(gyro_angle_mutex, osWaitForever);
+    board_angle_x = gyro_angle_x;
+    board_angle_y = gyro_angle_y;
+    RECORD_INPUT(RECORDER_tick(&recorder));
+    status = osMutexRelease(gyro_angle_mutex);
+
+    // Energy and the clock move on with each tick, under the mutex like the rest of the game - the same order
+    // as a replay
+    events = GAME_advance_energy(&game, CONFIG_PHYSICS_UPDATE_PERIOD(game_config));
+    events |= GAME_advance_clock(&game, CONFIG_PHYSICS_UPDATE_PERIOD(game_config));
+    events |= GAME_step(&game, board_angle_x, board_angle_y);
+#endif
+
+    if(game.drone_energy != energy)
+        osEventFlagsSet(energy_event, ENERGY_CHANGED_EVENT);
+
+    // Route to the new target
+    if((events & GAME_EVENT_WAYPOINT_REACHED) && !(events & GAME_EVENT_WON))
+        APPLICATION_update_flow_field();
+
+    if(events & (GAME_EVENT_WON | GAME_EVENT_LOST))
+        APPLICATION_game_over();
+
+#if AUTOPILOT
+    // Unattended - straight on to the next map once it is ready
+    if((game.won || game.lost) && !next_level_requested)
     {
-        if(game_won || game_lost)
-        {
-            status = osTimerStop(green_led_pwm_timer);
-            status = osTimerStop(red_led_timer);
-            status = osTimerStop(energy_recharge_timer);
-            status = osTimerStop(energy_depletion_timer);
-
-            status = osThreadYield();
-        }
-
-        status = osMutexAcquire(gyro_angle_mutex, osWaitForever);
-        board_angle_x = gyro_angle_x;
-        board_angle_y = gyro_angle_y;
-        status = osMutexRelease(gyro_angle_mutex);
-
-        accel_x = APPLICATION_get_board_gravity_ratio(board_angle_x);
-        accel_y = APPLICATION_get_board_gravity_ratio(board_angle_y);
-
-        status = osMutexAcquire(drone_position_mutex, osWaitForever);
-
-        // Update drone velocity
-        drone_velocity_x += accel_x;
-        drone_velocity_y += accel_y;
-
-        // Limit drone velocity
-        
-        if(drone_velocity_x > config.drone_config.max_velocity)
-            drone_velocity_x = config.drone_config.max_velocity;
+        autopilot_games ++;
+        autopilot_wins += game.won;
 
-        if(drone_velocity_x < -config.drone_config.max_velocity)
-            drone_velocity_x = -config.drone_config.max_velocity;
-
-        if(drone_velocity_y > config.drone_config.max_velocity)
-            drone_velocity_y = config.drone_config.max_velocity;
-
-        if(drone_velocity_y < -config.drone_config.max_velocity)
-            drone_velocity_y = -config.drone_config.max_velocity;
-
-        // Check if drone collides with right map boundary
-        if(drone_position_x + (drone_velocity_y / 1000) > 238 - config.drone_config.diameter / 2)
-        {
-            drone_velocity_y = 0;
-        }
-
-        // Check if drone collides with left map boundary
-        if(drone_position_x + (drone_velocity_y / 1000) < 0 + config.drone_config.diameter / 2)
-        {
-            drone_velocity_y = 0;
-        }
-
-        // Check if drone collides with top map boundary
-        if(drone_position_y + (drone_velocity_x / 1000) < 40 + config.drone_config.diameter / 2)
-        {
-            drone_velocity_x = 0;
-        }
-
-        // Check if drone collides with bottom map boundary
-        if(drone_position_y + (drone_velocity_x / 1000) > 280 - config.drone_config.diameter / 2)
-        {
-            drone_velocity_x = 0;
-        }
-
-        // Check if drone collides with wall on x axis
-        if(APPLICATION_check_horizontal_wall_collision(drone_position_x + drone_velocity_y / 1000, drone_position_y))
-        {
-            if(disruptor_active)
-            {
-                drone_position_x += drone_velocity_y / 300;
-            }
-            else {
-                drone_velocity_y = 0;
-            }
-        } 
-        
-        // Check if drone collides with wall on y axis
-        if(APPLICATION_check_vertical_wall_collision(drone_position_x, drone_position_y + drone_velocity_x / 1000))
-        {
-            if(disruptor_active)
-            {
-                drone_position_y += drone_velocity_x / 300;
-            }
-            else {
-                drone_velocity_x = 0;
-            }
-        }
-
-        // Update drone position on x axis
-        drone_position_x += drone_velocity_y / 1000;
-
-        // Update drone position on y axis
-        drone_position_y += drone_velocity_x / 1000;
+        APPLICATION_request_next_level();
+    }
+#endif
 
-        // Check which waypoint the drone is over (if it is over any at all)
-        int8_t waypoint_number = APPLICATION_is_over_waypoint(drone_position_x, drone_position_y);
+    physics_step_cycles = DWT->CYCCNT - start_cycles;
 
-        // If the drone *is* over a waypoint and it is the right waypoint
-        if(waypoint_number != -1 && waypoint_number == current_waypoint)
-        {
-            // That waypoint has been reached by the drone
-            waypoint_data[waypoint_number].reached = true;
-            current_waypoint ++;
-        }
+    if(physics_step_cycles > physics_step_cycles_max)
+        physics_step_cycles_max = physics_step_cycles;
 
-        // If all waypoints have been reached
-        if(current_waypoint == config.map_config.num_waypoints)
-        {
-            game_won = true;
-        }
-
-        // Lost game if over hole and the disruptor is not active
-        if(APPLICATION_is_over_hole(drone_position_x, drone_position_y) && disruptor_active == false)
-        {
-            fell_into_hole = true;
-            game_lost = true;
-        }
-        
-        status = osMutexRelease(drone_position_mutex);
-
-        osDelay(config.physics_config.update_frequency);
-    }
+    status = osMutexRelease(drone_position_mutex);
 }
 
 /**
-  * @brief Periodically recharges disruptor energy
-  * @param void *arg - pointer to argument array
-  * @retval None
+  * @brief How far the current time is between the previous and the last physics tick, for drawing the drone
+  *        between the two positions. Must be called with drone_position_mutex held.
+  * @param uint32_t now - current kernel tick
+  * @retval q16_t - 0 at the last physics tick, Q16_ONE one period or more after it
   */
-void energy_recharge_timer_callback(void *arg)
+q16_t APPLICATION_get_interpolation_factor(uint32_t now)
 {
-    (void) &arg; // Remove warnings
-    [[maybe_unused]] uint32_t event_flags;
-    
-    event_flags = osEventFlagsSet(energy_event, RECHARGE_ENERGY_EVENT);
-}
+    uint32_t elapsed = now - physics_tick_time;
+    uint32_t period = CONFIG_PHYSICS_UPDATE_PERIOD(game_config);
 
-/**
-  * @brief Periodically deminishes disruptor energy
-  * @param void *arg - pointer to argument array
-  * @retval None
-  */
-void energy_depletion_timer_callback(void *arg)
-{
-    (void) &arg; // Remove warnings
-    [[maybe_unused]] uint32_t event_flags;
-    
-    event_flags = osEventFlagsSet(energy_event, DEPLETE_ENERGY_EVENT);
+    if(elapsed >= period)
+        return Q16_ONE;
+
+    return FIXED_div(Q16_FROM_INT(elapsed), Q16_FROM_INT(period));
 }
 
 /**
-  * @brief Controls the green LED's pwm implementation
+  * @brief Main game thread - runs physics ticks at a fixed period. Time since the last wake up is added to an
+  *        accumulator and a physics tick runs for every whole period in it, so the tick rate doesn't drift
+  *        with execution time or with other tasks delaying this one. The thread then sleeps until the next
+  *        tick is due.
   * @param void *arg - pointer to argument array
   * @retval None
   */
-void green_led_pwm_timer_callback(void *arg)
+void game_task_function(void *arg)
 {
     (void) &arg; // Remove warnings
-    [[maybe_unused]] uint32_t event_flags;
+    [[maybe_unused]] osStatus_t status;
 
-    if(green_led_timer_tick < (int)((drone_energy * 10) / config.drone_config.max_energy))
-    {
-        event_flags = osEventFlagsSet(led_event, ENABLE_GREEN_LED_EVENT); // Enable green led
-    } 
-    else
+    uint32_t period = CONFIG_PHYSICS_UPDATE_PERIOD(game_config);
+    uint32_t last_time = osKernelGetTickCount();
+    uint32_t accumulator = period; // First tick is due straight away
+    uint32_t now;
+    uint32_t steps;
+
+    status = osMutexAcquire(drone_position_mutex, osWaitForever);
+    physics_tick_time = last_time;
+    status = osMutexRelease(drone_position_mutex);
+   
+    while(1)
     {
-        event_flags = osEventFlagsSet(led_event, DISABLE_GREEN_LED_EVENT); // Disable green led
-    } 
+        if(next_level_requested && next_level_ready)
+            APPLICATION_start_next_level();
+
+        if(game.won || game.lost)
+        {
+            status = osThreadYield();
+        }
 
-    green_led_timer_tick ++; // Increment timer tick
+        now = osKernelGetTickCount();
+        accumulator += now - last_time;
+        last_time = now;
 
-    // Reset cycle
-    if(green_led_timer_tick == 10)
-    {
-        green_led_timer_tick = 0;
+        for(steps = 0; accumulator >= period; steps ++)
+        {
+            // Too far behind - drop the missed ticks instead of spending ever longer catching up
+            if(steps == GAME_MAX_CATCH_UP_TICKS)
+            {
+                game_ticks_dropped += accumulator / period;
+                accumulator %= period;
+                break;
+            }
+
+            accumulator -= period;
+            APPLICATION_step_physics(now - accumulator);
+        }
+
+        if(steps > 1)
+            game_tick_overruns ++;
+
+        // Sleep until the next tick is due - if it is already due, the next pass catches up
+        status = osDelayUntil(now + period - accumulator);
     }
 }
 
 /**
-  * @brief Controls red led flash rate
+  * @brief Function for the level worker thread - builds the next level each time a game ends, using the
+  *        time the other tasks leave idle while the result screen shows
   * @param void *arg - pointer to argument array
   * @retval None
   */
-void red_led_timer_callback(void *arg)
+void level_worker_task_function(void *arg)
 {
     (void) &arg; // Remove warnings
-    [[maybe_unused]] uint32_t event_flags;
-
-    red_led_timer_period = (config.drone_config.disruptor_min_activation_energy - drone_energy) / 10; // Number of ticks (ms)
+    [[maybe_unused]] uint32_t flags;
 
-    // Turn red led on for half a period, off for the other half
-    if(red_led_timer_tick < red_led_timer_period / 2)
-    {
-        event_flags = osEventFlagsSet(led_event, ENABLE_RED_LED_EVENT);
-    } 
-    else if(red_led_timer_tick >= red_led_timer_period / 2)
+    while(1)
     {
-        event_flags = osEventFlagsSet(led_event, DISABLE_RED_LED_EVENT);
-    }
+        flags = osThreadFlagsWait(PREPARE_LEVEL_FLAG, osFlagsWaitAny, osWaitForever);
 
-    red_led_timer_tick ++; // Increment timer tick
-
-    // Reset tick if needed
-    if(red_led_timer_tick >= red_led_timer_period)
-    {
-        red_led_timer_tick = 0;
+        if(!APPLICATION_prepare_next_level())
+            while(1);
     }
-
 }
 
 /**
-  * @brief Updates game tick 
-  * @param void *arg - pointer to argument array
+  * @brief EXTI2 interrupt handler - the gyro's FIFO reached the watermark
   * @retval None
   */
-void game_timer_callback(void *args)
+void EXTI2_IRQHandler()
 {
-    (void) &args; // Remove warnings
-    game_tick ++;
-
-    if(game_tick >= config.game_config.time_to_complete)
-    {
-        ran_out_of_time = true;
-        game_lost = true;
-    }
+    HAL_GPIO_EXTI_IRQHandler(INT2_PIN);
+    GYRO_STREAM_on_watermark(&gyro_stream);
 }
 
 /**
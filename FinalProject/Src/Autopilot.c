@@ -0,0 +1,324 @@
+/*
+ * Autopilot.c
+ *
+ * A* route planning over the map's cells and a tilt controller that follows the route.
+ */
+
+#include "Autopilot.h"
+
+#define CELL_NOT_SEEN   0
+#define CELL_OPEN       1
+#define CELL_CLOSED     2
+
+// 180 / pi - radians to degrees
+#define DEGREES_PER_RADIAN Q16_FROM_RATIO(572958, 10000)
+
+static uint16_t distance_left(uint16_t cell, uint16_t goal, uint8_t cell_count)
+{
+    int32_t rows = (cell / cell_count) - (goal / cell_count);
+    int32_t cols = (cell % cell_count) - (goal % cell_count);
+
+    return (rows < 0 ? -rows : rows) + (cols < 0 ? -cols : cols);
+}
+
+/**
+ * @brief Orders the heap on estimate, ties going to the cell furthest along - it is closest to the goal
+ */
+static bool heap_before(const Autopilot_t *pilot, uint16_t a, uint16_t b)
+{
+    if(pilot->estimate[a] != pilot->estimate[b])
+        return pilot->estimate[a] < pilot->estimate[b];
+
+    return pilot->cost[a] > pilot->cost[b];
+}
+
+static void heap_place(Autopilot_t *pilot, uint16_t position, uint16_t cell)
+{
+    pilot->heap[position] = cell;
+    pilot->heap_position[cell] = position;
+}
+
+/**
+ * @brief Moves a cell toward the top of the heap until its parent comes first
+ */
+static void heap_sift_up(Autopilot_t *pilot, uint16_t position)
+{
+    uint16_t cell = pilot->heap[position];
+
+    while(position > 0)
+    {
+        uint16_t parent = (position - 1) / 2;
+
+        if(!heap_before(pilot, cell, pilot->heap[parent]))
+            break;
+
+        heap_place(pilot, position, pilot->heap[parent]);
+        position = parent;
+    }
+
+    heap_place(pilot, position, cell);
+}
+
+/**
+ * @brief Takes the first cell off the heap
+ */
+static uint16_t heap_pop(Autopilot_t *pilot)
+{
+    uint16_t first = pilot->heap[0];
+    uint16_t cell = pilot->heap[-- pilot->heap_count];
+    uint16_t position = 0;
+
+    // Move the last cell down from the top until both children come after it
+    while(1)
+    {
+        uint16_t child = (2 * position) + 1;
+
+        if(child >= pilot->heap_count)
+            break;
+
+        if(child + 1 < pilot->heap_count && heap_before(pilot, pilot->heap[child + 1], pilot->heap[child]))
+            child ++;
+
+        if(!heap_before(pilot, pilot->heap[child], cell))
+            break;
+
+        heap_place(pilot, position, pilot->heap[child]);
+        position = child;
+    }
+
+    if(pilot->heap_count > 0)
+        heap_place(pilot, position, cell);
+
+    return first;
+}
+
+/**
+ * @brief Opens a neighbour, or moves it up the heap if this is a shorter way to it
+ */
+static void relax(Autopilot_t *pilot, const MapData_t *map, uint16_t from, uint16_t to, uint16_t goal)
+{
+    uint16_t cost = pilot->cost[from] + 1;
+
+    if(pilot->state[to] == CELL_CLOSED || (map->cell_data[to / pilot->cell_count][to % pilot->cell_count] & MAP_HOLE))
+        return;
+
+    if(pilot->state[to] == CELL_OPEN && cost >= pilot->cost[to])
+        return;
+
+    pilot->cost[to] = cost;
+    pilot->estimate[to] = cost + distance_left(to, goal, pilot->cell_count);
+    pilot->parent[to] = from;
+
+    if(pilot->state[to] == CELL_NOT_SEEN)
+    {
+        pilot->state[to] = CELL_OPEN;
+        heap_place(pilot, pilot->heap_count ++, to);
+    }
+
+    heap_sift_up(pilot, pilot->heap_position[to]);
+}
+
+/**
+ * @brief Finds a shortest path between two cells with an A* search - moves go to a neighbouring cell with
+ *        no wall in between and never into a hole. The path, without the start cell, is added to the route.
+ *
+ * @param Autopilot_t *pilot - autopilot with cell_count set
+ * @param const MapData_t *map - walls and holes
+ * @param uint16_t start, goal - cell indices
+ * @return bool - false if the goal can't be reached or the route is full
+ */
+bool AUTOPILOT_find_path(Autopilot_t *pilot, const MapData_t *map, uint16_t start, uint16_t goal)
+{
+    uint8_t cell_count = pilot->cell_count;
+    uint16_t size = cell_count * cell_count;
+
+    for(uint16_t cell = 0; cell < size; cell ++)
+        pilot->state[cell] = CELL_NOT_SEEN;
+
+    pilot->heap_count = 0;
+    pilot->cost[start] = 0;
+    pilot->estimate[start] = distance_left(start, goal, cell_count);
+    pilot->state[start] = CELL_OPEN;
+    heap_place(pilot, pilot->heap_count ++, start);
+
+    while(pilot->heap_count > 0)
+    {
+        uint16_t cell = heap_pop(pilot);
+        uint8_t row = cell / cell_count;
+        uint8_t col = cell % cell_count;
+        uint8_t walls = map->cell_data[row][col];
+
+        if(cell == goal)
+        {
+            uint32_t length = pilot->cost[goal];
+
+            if(pilot->route_length + length > AUTOPILOT_MAX_ROUTE)
+                return false;
+
+            // Walk back from the goal, filling the route from the end of the path
+            for(uint32_t i = length; i > 0; i --)
+            {
+                pilot->route[pilot->route_length + i - 1] = cell;
+                cell = pilot->parent[cell];
+            }
+
+            pilot->route_length += length;
+
+            return true;
+        }
+
+        pilot->state[cell] = CELL_CLOSED;
+
+        if(row > 0 && !(walls & MAP_TOP_WALL) && !(map->cell_data[row - 1][col] & MAP_BOTTOM_WALL))
+            relax(pilot, map, cell, cell - cell_count, goal);
+
+        if(row < cell_count - 1 && !(walls & MAP_BOTTOM_WALL) && !(map->cell_data[row + 1][col] & MAP_TOP_WALL))
+            relax(pilot, map, cell, cell + cell_count, goal);
+
+        if(col > 0 && !(walls & MAP_LEFT_WALL) && !(map->cell_data[row][col - 1] & MAP_RIGHT_WALL))
+            relax(pilot, map, cell, cell - 1, goal);
+
+        if(col < cell_count - 1 && !(walls & MAP_RIGHT_WALL) && !(map->cell_data[row][col + 1] & MAP_LEFT_WALL))
+            relax(pilot, map, cell, cell + 1, goal);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Plans the route from the drone through every waypoint it has left to reach, in order. Cells the
+ *        route passes straight through are dropped, so the drone is steered from one turning point to the next.
+ *
+ * @param Autopilot_t *pilot - autopilot to plan
+ * @param const MapData_t *map - map being played
+ * @param int32_t x, y - drone position in pixels
+ * @param uint8_t first_waypoint - the waypoint the drone must reach next
+ * @return bool - false if a waypoint can't be reached
+ */
+bool AUTOPILOT_plan(Autopilot_t *pilot, const MapData_t *map, int32_t x, int32_t y, uint8_t first_waypoint)
+{
+    uint8_t cell_count = MAP_CELL_COUNT(map);
+    int32_t row = MAP_CELL_ROW(y);
+    int32_t col = MAP_CELL_COL(x);
+
+    pilot->cell_count = cell_count;
+    pilot->route_length = 0;
+    pilot->route_index = 0;
+
+    if(row < 0 || col < 0 || row >= cell_count || col >= cell_count)
+        return false;
+
+    uint16_t cell = (row * cell_count) + col;
+
+    pilot->route[pilot->route_length ++] = cell;
+
+    for(uint8_t waypoint = first_waypoint; waypoint < map->num_waypoints; waypoint ++)
+    {
+        const WaypointData_t *target = &map->waypoint_data[waypoint];
+        uint16_t goal = (MAP_CELL_ROW(target->y) * cell_count) + MAP_CELL_COL(target->x);
+
+        if(!AUTOPILOT_find_path(pilot, map, cell, goal))
+            return false;
+
+        cell = goal;
+    }
+
+    // Keep the ends and every cell where the direction changes
+    uint32_t kept = 1;
+
+    for(uint32_t i = 1; i + 1 < pilot->route_length; i ++)
+    {
+        int32_t in = pilot->route[i] - pilot->route[i - 1];
+        int32_t out = pilot->route[i + 1] - pilot->route[i];
+
+        if(in != out)
+            pilot->route[kept ++] = pilot->route[i];
+    }
+
+    if(pilot->route_length > 1)
+        pilot->route[kept ++] = pilot->route[pilot->route_length - 1];
+
+    pilot->route_length = kept;
+
+    return true;
+}
+
+/**
+ * @brief Acceleration that brings one axis of the drone to the target - speed toward the target falls off
+ *        as it gets close, and the acceleration closes the gap to that speed
+ */
+static q16_t axis_acceleration(q16_t offset, q16_t velocity, q16_t max_acceleration)
+{
+    q16_t speed = FIXED_mul(offset, AUTOPILOT_POSITION_GAIN);
+
+    if(speed > AUTOPILOT_MAX_SPEED)
+        speed = AUTOPILOT_MAX_SPEED;
+    if(speed < -AUTOPILOT_MAX_SPEED)
+        speed = -AUTOPILOT_MAX_SPEED;
+
+    q16_t acceleration = FIXED_mul(FIXED_sub(speed, velocity), AUTOPILOT_VELOCITY_GAIN);
+
+    if(acceleration > max_acceleration)
+        acceleration = max_acceleration;
+    if(acceleration < -max_acceleration)
+        acceleration = -max_acceleration;
+
+    return acceleration;
+}
+
+/**
+ * @brief Board angle that gives an acceleration - the inverse of GAME_get_board_gravity_ratio, taking
+ *        sin(tilt) as tilt for the small tilts used
+ */
+static q16_t board_angle(const GameState_t *game, q16_t acceleration)
+{
+    q16_t tilt = FIXED_mul(FIXED_div(acceleration, game->gravity_gain), DEGREES_PER_RADIAN);
+
+    return FIXED_add(Q16_FROM_INT(180), FIXED_div(tilt, game->tilt_gain));
+}
+
+/**
+ * @brief Works out the board angle for the next physics tick - steers the drone to the route's next turning
+ *        point, moving on to the one after once it is close enough. The board is held flat without a route.
+ *
+ * @param Autopilot_t *pilot - planned autopilot
+ * @param const GameState_t *game - game being played
+ * @param q16_t *board_angle_x, *board_angle_y - board angle in degrees for GAME_step
+ * @return void
+ */
+void AUTOPILOT_steer(Autopilot_t *pilot, const GameState_t *game, q16_t *board_angle_x, q16_t *board_angle_y)
+{
+    const EntityStore_t *entities = &game->entities;
+    q16_t x = entities->pos_x[DRONE_ENTITY];
+    q16_t y = entities->pos_y[DRONE_ENTITY];
+    q16_t target_x, target_y;
+
+    *board_angle_x = Q16_FROM_INT(180);
+    *board_angle_y = Q16_FROM_INT(180);
+
+    if(pilot->route_length == 0)
+        return;
+
+    while(1)
+    {
+        uint16_t cell = pilot->route[pilot->route_index];
+
+        target_x = Q16_FROM_INT(MAP_CELL_CENTER_X(cell % pilot->cell_count));
+        target_y = Q16_FROM_INT(MAP_CELL_CENTER_Y(cell / pilot->cell_count));
+
+        if(pilot->route_index + 1 == pilot->route_length ||
+           FIXED_abs(FIXED_sub(target_x, x)) > AUTOPILOT_ARRIVE_RADIUS ||
+           FIXED_abs(FIXED_sub(target_y, y)) > AUTOPILOT_ARRIVE_RADIUS)
+            break;
+
+        pilot->route_index ++;
+    }
+
+    q16_t max_acceleration = FIXED_mul(SINE_TABLE_sin(AUTOPILOT_MAX_TILT), game->gravity_gain);
+    q16_t accel_x = axis_acceleration(FIXED_sub(target_x, x), entities->vel_x[DRONE_ENTITY], max_acceleration);
+    q16_t accel_y = axis_acceleration(FIXED_sub(target_y, y), entities->vel_y[DRONE_ENTITY], max_acceleration);
+
+    // Screen x moves with the board's y angle and screen y with its x angle
+    *board_angle_x = board_angle(game, accel_y);
+    *board_angle_y = board_angle(game, accel_x);
+}
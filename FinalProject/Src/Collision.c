@@ -0,0 +1,188 @@
+/*
+ * Collision.c
+ *
+ * Swept circle against segment. A circle moving along a segment's face hits it when its distance to the
+ * segment's line shrinks to the radius; a circle moving past an end of the segment hits it when its
+ * distance to that end point shrinks to the radius. The earliest of the three is the first contact.
+ */
+
+#include "Collision.h"
+
+/**
+ * @brief Dot product of two Q16.16 vectors
+ */
+static q16_t dot(q16_t ax, q16_t ay, q16_t bx, q16_t by)
+{
+    return (q16_t)((((int64_t)ax * bx) + ((int64_t)ay * by)) >> Q16_SHIFT);
+}
+
+/**
+ * @brief Keeps the earlier of two hits
+ */
+static void keep_earliest(bool *found, CollisionHit_t *best, const CollisionHit_t *hit)
+{
+    if(!*found || hit->time < best->time)
+    {
+        *best = *hit;
+        *found = true;
+    }
+}
+
+/**
+ * @brief Sweeps a circle against the face of a segment
+ */
+static bool sweep_face(q16_t x, q16_t y, q16_t dx, q16_t dy, q16_t radius, const CollisionSegment_t *segment, CollisionHit_t *hit)
+{
+    q16_t ex = segment->x2 - segment->x1;
+    q16_t ey = segment->y2 - segment->y1;
+    q16_t length = FIXED_sqrt_q32(((int64_t)ex * ex) + ((int64_t)ey * ey));
+
+    if(length == 0)
+        return false;
+
+    // Unit vector along the segment and its normal
+    q16_t ux = FIXED_div(ex, length);
+    q16_t uy = FIXED_div(ey, length);
+    q16_t nx = -uy;
+    q16_t ny = ux;
+
+    q16_t distance = dot(x - segment->x1, y - segment->y1, nx, ny);
+    q16_t speed = dot(dx, dy, nx, ny);
+
+    // Use the normal on the circle's side of the line
+    if(distance < 0)
+    {
+        distance = -distance;
+        speed = -speed;
+        nx = -nx;
+        ny = -ny;
+    }
+
+    // Moving parallel to or away from the line
+    if(speed >= 0)
+        return false;
+
+    q16_t time = 0;
+
+    if(distance > radius)
+    {
+        time = FIXED_div(distance - radius, -speed);
+
+        if(time > Q16_ONE)
+            return false;
+    }
+
+    // The contact has to be on the segment itself - past the ends, the end points are hit instead
+    q16_t along = dot(x + FIXED_mul(dx, time) - segment->x1, y + FIXED_mul(dy, time) - segment->y1, ux, uy);
+
+    if(along < 0 || along > length)
+        return false;
+
+    hit->time = time;
+    hit->normal_x = nx;
+    hit->normal_y = ny;
+
+    return true;
+}
+
+/**
+ * @brief Sweeps a circle against a single point (an end of a segment)
+ */
+static bool sweep_point(q16_t x, q16_t y, q16_t dx, q16_t dy, q16_t radius, q16_t point_x, q16_t point_y, CollisionHit_t *hit)
+{
+    q16_t qx = x - point_x;
+    q16_t qy = y - point_y;
+
+    // The move never comes within radius of the point on one of the axes
+    if((qx > radius && qx + dx > radius) || (qx < -radius && qx + dx < -radius) ||
+       (qy > radius && qy + dy > radius) || (qy < -radius && qy + dy < -radius))
+        return false;
+
+    // |q + t * d|^2 = radius^2  ->  a * t^2 + 2 * b * t + c = 0
+    q16_t a = dot(dx, dy, dx, dy);
+    q16_t b = dot(qx, qy, dx, dy);
+    q16_t c = dot(qx, qy, qx, qy) - FIXED_mul(radius, radius);
+    q16_t time = 0;
+
+    // Moving parallel to or away from the point
+    if(b >= 0)
+        return false;
+
+    if(c > 0)
+    {
+        int64_t discriminant = ((int64_t)b * b) - ((int64_t)a * c);
+
+        if(discriminant < 0)
+            return false;
+
+        time = FIXED_div(-b - FIXED_sqrt_q32(discriminant), a);
+
+        if(time > Q16_ONE)
+            return false;
+    }
+
+    // Normal points from the point to the circle's center at contact
+    q16_t nx = qx + FIXED_mul(dx, time);
+    q16_t ny = qy + FIXED_mul(dy, time);
+    q16_t length = FIXED_sqrt_q32(((int64_t)nx * nx) + ((int64_t)ny * ny));
+
+    if(length == 0)
+    {
+        // Circle centered on the point - push straight back along the move
+        nx = -dx;
+        ny = -dy;
+        length = FIXED_sqrt_q32(((int64_t)nx * nx) + ((int64_t)ny * ny));
+    }
+
+    hit->time = time;
+    hit->normal_x = FIXED_div(nx, length);
+    hit->normal_y = FIXED_div(ny, length);
+
+    return true;
+}
+
+/**
+ * @brief Finds the first contact between a moving circle and a segment
+ *
+ * @param q16_t x, y - circle center at the start of the move in pixels
+ * @param q16_t dx, dy - move in pixels
+ * @param q16_t radius - circle radius in pixels, at most COLLISION_MAX_RADIUS
+ * @param const CollisionSegment_t *segment - segment to test
+ * @param CollisionHit_t *hit - time of impact and contact normal, only written on a hit
+ * @return bool - true if the circle touches the segment during the move. A circle that already touches the
+ *                segment only collides if it moves further into it.
+ */
+bool COLLISION_sweep_circle_segment(q16_t x, q16_t y, q16_t dx, q16_t dy, q16_t radius, const CollisionSegment_t *segment, CollisionHit_t *hit)
+{
+    q16_t largest = (FIXED_abs(dx) > FIXED_abs(dy)) ? FIXED_abs(dx) : FIXED_abs(dy);
+    int32_t steps = 1 + (largest / COLLISION_MAX_STEP);
+    q16_t step_x = dx / steps;
+    q16_t step_y = dy / steps;
+
+    for(int32_t i = 0; i < steps; i ++)
+    {
+        CollisionHit_t step_hit;
+        CollisionHit_t best;
+        bool found = false;
+        q16_t start_x = x + (step_x * i);
+        q16_t start_y = y + (step_y * i);
+
+        if(sweep_face(start_x, start_y, step_x, step_y, radius, segment, &step_hit))
+            keep_earliest(&found, &best, &step_hit);
+
+        if(sweep_point(start_x, start_y, step_x, step_y, radius, segment->x1, segment->y1, &step_hit))
+            keep_earliest(&found, &best, &step_hit);
+
+        if(sweep_point(start_x, start_y, step_x, step_y, radius, segment->x2, segment->y2, &step_hit))
+            keep_earliest(&found, &best, &step_hit);
+
+        if(found)
+        {
+            *hit = best;
+            hit->time = ((Q16_ONE * i) + best.time) / steps;
+            return true;
+        }
+    }
+
+    return false;
+}
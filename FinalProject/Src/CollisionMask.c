@@ -0,0 +1,176 @@
+/*
+ * CollisionMask.c
+ *
+ * Baking and testing the playfield occupancy mask.
+ */
+
+#include <string.h>
+#include "CollisionMask.h"
+
+/**
+ * @brief Bits first_bit to last_bit (inclusive) of a word
+ */
+static uint32_t word_mask(int32_t first_bit, int32_t last_bit)
+{
+    return (0xFFFFFFFFu << first_bit) & (0xFFFFFFFFu >> (31 - last_bit));
+}
+
+/**
+ * @brief Sets pixels x0 to x1 (inclusive) of a row, clipped to the mask
+ */
+static void set_span(CollisionMask_t *mask, int32_t y, int32_t x0, int32_t x1)
+{
+    if(y < 0 || y >= COLLISION_MASK_HEIGHT)
+        return;
+
+    if(x0 < 0)
+        x0 = 0;
+    if(x1 >= COLLISION_MASK_WIDTH)
+        x1 = COLLISION_MASK_WIDTH - 1;
+
+    if(x0 > x1)
+        return;
+
+    for(int32_t word = x0 >> 5; word <= x1 >> 5; word ++)
+    {
+        int32_t first_bit = (word == x0 >> 5) ? (x0 & 31) : 0;
+        int32_t last_bit = (word == x1 >> 5) ? (x1 & 31) : 31;
+
+        mask->rows[y][word] |= word_mask(first_bit, last_bit);
+    }
+}
+
+/**
+ * @brief True if any pixel from x0 to x1 (inclusive) of a row is set, clipped to the mask
+ */
+static bool test_span(const CollisionMask_t *mask, int32_t y, int32_t x0, int32_t x1)
+{
+    if(y < 0 || y >= COLLISION_MASK_HEIGHT)
+        return false;
+
+    if(x0 < 0)
+        x0 = 0;
+    if(x1 >= COLLISION_MASK_WIDTH)
+        x1 = COLLISION_MASK_WIDTH - 1;
+
+    if(x0 > x1)
+        return false;
+
+    int32_t first_word = x0 >> 5;
+    int32_t last_word = x1 >> 5;
+
+    if(first_word == last_word)
+        return (mask->rows[y][first_word] & word_mask(x0 & 31, x1 & 31)) != 0;
+
+    // A disk row spans at most three words
+    uint32_t hits = mask->rows[y][first_word] & word_mask(x0 & 31, 31);
+
+    for(int32_t word = first_word + 1; word < last_word; word ++)
+        hits |= mask->rows[y][word];
+
+    hits |= mask->rows[y][last_word] & word_mask(0, x1 & 31);
+
+    return hits != 0;
+}
+
+/**
+ * @brief Precomputes the row half widths of a disk
+ *
+ * @param CollisionDisk_t *disk - disk to fill
+ * @param uint8_t radius - radius in pixels, clamped to COLLISION_MASK_MAX_RADIUS - a disk that must cover a
+ *                        distance, like an entity's reach, has to be checked against the limit first
+ * @return void
+ */
+void COLLISION_MASK_make_disk(CollisionDisk_t *disk, uint8_t radius)
+{
+    if(radius > COLLISION_MASK_MAX_RADIUS)
+        radius = COLLISION_MASK_MAX_RADIUS;
+
+    disk->radius = radius;
+
+    for(int32_t dy = -radius; dy <= radius; dy ++)
+    {
+        int32_t half_width = 0;
+
+        while(((half_width + 1) * (half_width + 1)) + (dy * dy) <= radius * radius)
+            half_width ++;
+
+        disk->half_width[dy + radius] = half_width;
+    }
+}
+
+/**
+ * @brief Draws the walls and holes of a map into the mask, matching what APPLICATION_draw_map puts on screen
+ *
+ * @param CollisionMask_t *mask - mask to fill
+ * @param const MapData_t *map - map to bake
+ * @param uint8_t hole_radius - hole radius in pixels
+ * @return void
+ */
+void COLLISION_MASK_bake(CollisionMask_t *mask, const MapData_t *map, uint8_t hole_radius)
+{
+    CollisionDisk_t hole;
+
+    memset(mask, 0, sizeof(CollisionMask_t));
+    COLLISION_MASK_make_disk(&hole, hole_radius);
+
+    for(int32_t i = 0; i < MAP_CELL_COUNT(map); i ++)
+    {
+        for(int32_t j = 0; j < MAP_CELL_COUNT(map); j ++)
+        {
+            uint8_t cell = map->cell_data[i][j];
+            int32_t left = j * MAP_CELL_SIZE;
+            int32_t top = i * MAP_CELL_SIZE;
+            int32_t right = left + MAP_CELL_SIZE;
+            int32_t bottom = top + MAP_CELL_SIZE;
+
+            if(cell & MAP_TOP_WALL)
+                set_span(mask, top, left, right);
+
+            if(cell & MAP_BOTTOM_WALL)
+                set_span(mask, bottom, left, right);
+
+            for(int32_t y = top; y <= bottom; y ++)
+            {
+                if(cell & MAP_LEFT_WALL)
+                    set_span(mask, y, left, left);
+
+                if(cell & MAP_RIGHT_WALL)
+                    set_span(mask, y, right, right);
+            }
+
+            if(cell & MAP_HOLE)
+            {
+                int32_t center_x = left + (MAP_CELL_SIZE / 2);
+                int32_t center_y = top + (MAP_CELL_SIZE / 2);
+
+                for(int32_t dy = -hole.radius; dy <= hole.radius; dy ++)
+                    set_span(mask, center_y + dy, center_x - hole.half_width[dy + hole.radius], center_x + hole.half_width[dy + hole.radius]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Checks if anything in the mask lies under a disk. Parts of the disk outside the playfield are ignored.
+ *
+ * @param const CollisionMask_t *mask - baked mask
+ * @param const CollisionDisk_t *disk - disk footprint
+ * @param int32_t x, y - screen position of the disk center
+ * @return bool - true if any wall or hole pixel is under the disk
+ */
+bool COLLISION_MASK_test_disk(const CollisionMask_t *mask, const CollisionDisk_t *disk, int32_t x, int32_t y)
+{
+    int32_t center_x = x - MAP_ORIGIN_X;
+    int32_t center_y = y - MAP_ORIGIN_Y;
+
+    for(int32_t dy = -disk->radius; dy <= disk->radius; dy ++)
+    {
+        int32_t half_width = disk->half_width[dy + disk->radius];
+
+        if(test_span(mask, center_y + dy, center_x - half_width, center_x + half_width))
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,17 @@
+/*
+ * Config.c
+ *
+ * The game config - one copy, shared by every module.
+ */
+
+#include "Config.h"
+
+#if CONFIG_STATIC_PROFILE
+#if CONFIG_PROFILE_PHYSICS_UPDATE_PERIOD == 0
+#error "The physics update period must be at least 1 ms - the game task's accumulator would never run down"
+#endif
+
+const struct ConfigData_t config = CONFIG_PROFILE;
+#else
+struct ConfigData_t config; // Filled in by GAME_default_config
+#endif
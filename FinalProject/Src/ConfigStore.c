@@ -0,0 +1,207 @@
+/*
+ * ConfigStore.c
+ *
+ * Versioned config records in two flash sectors.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "ConfigStore.h"
+
+#define RECORD_SPAN(size) (sizeof(ConfigRecord_t) + (((uint32_t)(size) + 3) & ~3u)) // Header and payload, in whole words
+
+/**
+ * @brief Walks the valid records of a sector - finds the highest sequence number, and the latest record of a
+ *        version and size if found is given
+ *
+ * @return uint32_t - offset of the free space after the last record, or the sector size if nothing more can be
+ *                    appended
+ */
+static uint32_t scan(const ConfigStore_t *store, uint8_t sector, uint16_t version, uint16_t size,
+                     uint32_t *sequence, const ConfigRecord_t **found)
+{
+    const uint8_t *base = store->sectors[sector];
+    uint32_t offset = 0;
+
+    while(offset + sizeof(ConfigRecord_t) <= store->sector_size)
+    {
+        const ConfigRecord_t *record = (const ConfigRecord_t *)(base + offset);
+
+        if(record->magic == CONFIG_STORE_ERASED && record->sequence == CONFIG_STORE_ERASED)
+            return offset;
+
+        // Cut short while its header was written, or not a record at all - can't tell where the next one starts
+        if(record->size > CONFIG_STORE_MAX_SIZE || offset + RECORD_SPAN(record->size) > store->sector_size)
+            return store->sector_size;
+
+        if(record->magic == CONFIG_STORE_MAGIC &&
+           record->crc == CONFIG_STORE_crc((const uint8_t *)(record + 1), record->size))
+        {
+            if(record->sequence > *sequence)
+                *sequence = record->sequence;
+
+            if(found != NULL && record->version == version && record->size == size &&
+               (*found == NULL || record->sequence > (*found)->sequence))
+                *found = record;
+        }
+
+        offset += RECORD_SPAN(record->size);
+    }
+
+    return store->sector_size;
+}
+
+/**
+ * @brief Programs one word and reads it back
+ */
+static bool program(ConfigStore_t *store, uintptr_t address, uint32_t word)
+{
+    return store->port.program(store->port.context, address, word) && *(const volatile uint32_t *)address == word;
+}
+
+/**
+ * @brief Writes a record at the end of the active sector - everything but the magic word first, so a record
+ *        cut short is never taken for a complete one
+ */
+static bool append(ConfigStore_t *store, uint16_t version, const uint8_t *data, uint16_t size)
+{
+    uintptr_t address = (uintptr_t)(store->sectors[store->active] + store->end);
+    uintptr_t payload = address + sizeof(ConfigRecord_t);
+    uint32_t sequence = store->sequence + 1;
+
+    if(!program(store, address + offsetof(ConfigRecord_t, sequence), sequence) ||
+       !program(store, address + offsetof(ConfigRecord_t, version), version | ((uint32_t)size << 16)) ||
+       !program(store, address + offsetof(ConfigRecord_t, crc), CONFIG_STORE_crc(data, size)))
+        return false;
+
+    for(uint32_t i = 0; i < size; i += 4)
+    {
+        uint32_t word = CONFIG_STORE_ERASED;
+
+        memcpy(&word, &data[i], (size - i < 4) ? size - i : 4);
+
+        if(!program(store, payload + i, word))
+            return false;
+    }
+
+    if(!program(store, address + offsetof(ConfigRecord_t, magic), CONFIG_STORE_MAGIC))
+        return false;
+
+    store->end += RECORD_SPAN(size);
+    store->sequence = sequence;
+
+    return true;
+}
+
+/**
+ * @brief Finds where the records end - the active sector is the one holding the highest sequence number
+ *
+ * @param ConfigStore_t *store - store to set up
+ * @param const ConfigStorePort_t *port - flash erase and program
+ * @param const uint8_t *sector_0, *sector_1 - the two sectors, memory mapped
+ * @param uint32_t sector_size - bytes in each sector
+ * @return void
+ */
+void CONFIG_STORE_init(ConfigStore_t *store, const ConfigStorePort_t *port, const uint8_t *sector_0,
+                       const uint8_t *sector_1, uint32_t sector_size)
+{
+    uint32_t sequence_0 = 0, sequence_1 = 0;
+    uint32_t end_0, end_1;
+
+    store->port = *port;
+    store->sectors[0] = sector_0;
+    store->sectors[1] = sector_1;
+    store->sector_size = sector_size;
+    store->erases = 0;
+
+    end_0 = scan(store, 0, 0, 0, &sequence_0, NULL);
+    end_1 = scan(store, 1, 0, 0, &sequence_1, NULL);
+
+    store->active = (sequence_1 > sequence_0) ? 1 : 0;
+    store->end = store->active ? end_1 : end_0;
+    store->sequence = store->active ? sequence_1 : sequence_0;
+}
+
+/**
+ * @brief Finds the latest complete record of a version
+ *
+ * @param const ConfigStore_t *store - store to look in
+ * @param uint16_t version - payload layout version
+ * @param uint16_t size - payload size the version has
+ * @return const void * - the payload in flash, word aligned, or NULL if there is no such record
+ */
+const void *CONFIG_STORE_find(const ConfigStore_t *store, uint16_t version, uint16_t size)
+{
+    const ConfigRecord_t *found = NULL;
+    uint32_t sequence = 0;
+
+    scan(store, 0, version, size, &sequence, &found);
+    scan(store, 1, version, size, &sequence, &found);
+
+    return (found != NULL) ? (const void *)(found + 1) : NULL;
+}
+
+/**
+ * @brief Appends a record - it becomes the latest. When the active sector is full, or a word in it won't
+ *        program, the other sector is erased and the record starts it. The sector holding the latest record
+ *        is never erased, so a failed save leaves the last one in place.
+ *
+ * @param ConfigStore_t *store - store to append to
+ * @param uint16_t version - payload layout version
+ * @param const void *data - payload
+ * @param uint16_t size - payload bytes, at most CONFIG_STORE_MAX_SIZE
+ * @return bool - false if the flash couldn't be erased or programmed
+ */
+bool CONFIG_STORE_save(ConfigStore_t *store, uint16_t version, const void *data, uint16_t size)
+{
+    uint8_t next = store->active ^ 1;
+
+    if(size > CONFIG_STORE_MAX_SIZE || RECORD_SPAN(size) > store->sector_size)
+        return false;
+
+    if(store->end + RECORD_SPAN(size) <= store->sector_size && append(store, version, data, size))
+        return true;
+
+    store->erases ++;
+
+    if(!store->port.erase(store->port.context, next))
+        return false;
+
+    store->active = next;
+    store->end = 0;
+
+    if(append(store, version, data, size))
+        return true;
+
+    // What was written is invalid without its magic word. Go back to the sector with the latest record, as
+    // full, so the next save erases this one again rather than that.
+    store->active = next ^ 1;
+    store->end = store->sector_size;
+
+    return false;
+}
+
+/**
+ * @brief CRC-32 (IEEE 802.3, as zlib) of a block of bytes
+ *
+ * @param const uint8_t *data - bytes to check
+ * @param uint32_t size - number of bytes
+ * @return uint32_t - CRC
+ */
+uint32_t CONFIG_STORE_crc(const uint8_t *data, uint32_t size)
+{
+    static const uint32_t nibble_table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    uint32_t crc = 0xFFFFFFFF;
+
+    for(uint32_t i = 0; i < size; i ++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ nibble_table[crc & 0xF];
+        crc = (crc >> 4) ^ nibble_table[crc & 0xF];
+    }
+
+    return ~crc;
+}
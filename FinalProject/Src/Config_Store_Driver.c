@@ -0,0 +1,83 @@
+/*
+ * Config_Store_Driver.c
+ *
+ * HAL port for the ConfigStore - sector erase and word programming.
+ */
+
+#include "Config_Store_Driver.h"
+
+ConfigStore_t config_store;
+
+/**
+  * @brief Erase one of the store's sectors
+  */
+static bool Config_Store_Erase(void *context, uint8_t sector)
+{
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase = FLASH_TYPEERASE_SECTORS,
+        .Sector = sector ? CONFIG_STORE_SECTOR_1 : CONFIG_STORE_SECTOR_0,
+        .NbSectors = 1,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3
+    };
+    uint32_t failed_sector;
+    HAL_StatusTypeDef status;
+
+    (void) context;
+
+    HAL_FLASH_Unlock();
+    status = HAL_FLASHEx_Erase(&erase, &failed_sector);
+    HAL_FLASH_Lock();
+
+    return status == HAL_OK;
+}
+
+/**
+  * @brief Program one word
+  */
+static bool Config_Store_Program(void *context, uintptr_t address, uint32_t word)
+{
+    HAL_StatusTypeDef status;
+
+    (void) context;
+
+    HAL_FLASH_Unlock();
+    status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address, word);
+    HAL_FLASH_Lock();
+
+    return status == HAL_OK;
+}
+
+/**
+  * @brief Find the end of the records in flash
+  * @retval None
+  */
+void Config_Store_Init(void)
+{
+    ConfigStorePort_t port = {
+        .erase = Config_Store_Erase,
+        .program = Config_Store_Program,
+        .context = NULL
+    };
+
+    CONFIG_STORE_init(&config_store, &port, (const uint8_t *) CONFIG_STORE_SECTOR_0_ADDRESS,
+                      (const uint8_t *) CONFIG_STORE_SECTOR_1_ADDRESS, CONFIG_STORE_SECTOR_SIZE);
+}
+
+/**
+  * @brief The latest saved config of this CONFIG_VERSION, in flash
+  * @retval const struct ConfigData_t * - NULL if none has been saved
+  */
+const struct ConfigData_t *Config_Store_Load(void)
+{
+    return CONFIG_STORE_find(&config_store, CONFIG_VERSION, sizeof(struct ConfigData_t));
+}
+
+/**
+  * @brief Save a config as the latest - erases a sector now and then, which stalls flash reads from bank 2 for
+  *        up to a couple of seconds
+  * @retval bool - false if the flash couldn't be erased or programmed
+  */
+bool Config_Store_Save(const struct ConfigData_t *data)
+{
+    return CONFIG_STORE_save(&config_store, CONFIG_VERSION, data, sizeof(struct ConfigData_t));
+}
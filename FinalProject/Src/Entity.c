@@ -0,0 +1,240 @@
+/*
+ * Entity.c
+ *
+ * Batch passes over the entity store. The per-property passes use plain integer arithmetic and
+ * conditional selects rather than the saturating FIXED_ calls, so they stay branch free - velocities are
+ * limited to max_velocity before anything is added, which keeps every sum far from overflowing.
+ */
+
+#include <string.h>
+#include "Entity.h"
+
+/**
+ * @brief Moves an entity by one tick of velocity, sweeping the move against the walls. On contact the
+ *        entity slides along the wall - the part of the move and of the velocity going into the wall is
+ *        removed. ENTITY_PASS_WALLS entities are pushed through instead. Takes the entity's properties
+ *        through the same pointers ENTITY_step uses, so nothing reaches them behind its back.
+ */
+static void move_against_walls(const EntityConfig_t *config, WallGrid_t *grid, q16_t *pos_x, q16_t *pos_y,
+                               q16_t *vel_x, q16_t *vel_y, uint8_t flags)
+{
+    q16_t move_x = *vel_x;
+    q16_t move_y = *vel_y;
+    q16_t into_wall;
+    CollisionHit_t hit;
+
+    for(int contacts = 0; ; contacts ++)
+    {
+        if(!WALL_GRID_sweep_circle(grid, *pos_x, *pos_y, move_x, move_y, config->radius, &hit))
+            break;
+
+        // Pushed through on top of the normal move
+        if(flags & ENTITY_PASS_WALLS)
+        {
+            *pos_x = FIXED_add(*pos_x, FIXED_mul(move_x, config->wall_pass_gain));
+            *pos_y = FIXED_add(*pos_y, FIXED_mul(move_y, config->wall_pass_gain));
+            break;
+        }
+
+        // Out of contacts for this tick - stay clear of the wall
+        if(contacts == ENTITY_MAX_WALL_CONTACTS)
+        {
+            move_x = FIXED_mul(move_x, hit.time);
+            move_y = FIXED_mul(move_y, hit.time);
+            break;
+        }
+
+        // Move up to the wall
+        *pos_x += FIXED_mul(move_x, hit.time);
+        *pos_y += FIXED_mul(move_y, hit.time);
+        move_x = FIXED_mul(move_x, Q16_ONE - hit.time);
+        move_y = FIXED_mul(move_y, Q16_ONE - hit.time);
+
+        // Slide along it with what is left of the move
+        into_wall = FIXED_mul(move_x, hit.normal_x) + FIXED_mul(move_y, hit.normal_y);
+        move_x -= FIXED_mul(into_wall, hit.normal_x);
+        move_y -= FIXED_mul(into_wall, hit.normal_y);
+
+        into_wall = FIXED_mul(*vel_x, hit.normal_x) + FIXED_mul(*vel_y, hit.normal_y);
+        if(into_wall < 0)
+        {
+            *vel_x -= FIXED_mul(into_wall, hit.normal_x);
+            *vel_y -= FIXED_mul(into_wall, hit.normal_y);
+        }
+    }
+
+    *pos_x = FIXED_add(*pos_x, move_x);
+    *pos_y = FIXED_add(*pos_y, move_y);
+}
+
+/**
+ * @brief Pixels around an entity's whole pixel position that it can touch within one tick
+ *
+ * @param const EntityConfig_t *config - size and speed limit of the entity
+ * @return int32_t - radius its broadphase disk must have
+ */
+int32_t ENTITY_reach(const EntityConfig_t *config)
+{
+    // Velocity is limited per axis, so one tick moves less than twice max_velocity. One extra pixel covers
+    // rounding the position down to whole pixels.
+    return Q16_TO_INT(config->radius) + (2 * (Q16_TO_INT(config->max_velocity) + 1)) + 1;
+}
+
+/**
+ * @brief Empties the store
+ *
+ * @param EntityStore_t *store - store to set up
+ * @param const EntityConfig_t *config - size, speed limit and bounds shared by every entity
+ * @return bool - false if an entity could reach further in a tick than the broadphase disk can cover
+ */
+bool ENTITY_init(EntityStore_t *store, const EntityConfig_t *config)
+{
+    int32_t reach = ENTITY_reach(config);
+
+    store->config = *config;
+    store->count = 0;
+
+    // A clamped disk would let the broadphase skip walls and holes the entity can touch
+    if(config->radius < 0 || config->max_velocity < 0 || reach > COLLISION_MASK_MAX_RADIUS)
+        return false;
+
+    COLLISION_MASK_make_disk(&store->reach, reach);
+
+    return true;
+}
+
+/**
+ * @brief Adds an entity at rest
+ *
+ * @param EntityStore_t *store - store to add to
+ * @param q16_t x, y - screen position in pixels
+ * @param uint8_t flags - ENTITY_ flags
+ * @return int32_t - index of the new entity, -1 if the store is full
+ */
+int32_t ENTITY_add(EntityStore_t *store, q16_t x, q16_t y, uint8_t flags)
+{
+    if(store->count == ENTITY_MAX_COUNT)
+        return -1;
+
+    uint16_t i = store->count ++;
+
+    store->pos_x[i] = x;
+    store->pos_y[i] = y;
+    store->prev_x[i] = x;
+    store->prev_y[i] = y;
+    store->vel_x[i] = 0;
+    store->vel_y[i] = 0;
+    store->flags[i] = flags;
+
+    return i;
+}
+
+/**
+ * @brief Removes an entity. The last entity takes its index.
+ *
+ * @param EntityStore_t *store - store to remove from
+ * @param uint16_t index - entity to remove
+ * @return void
+ */
+void ENTITY_remove(EntityStore_t *store, uint16_t index)
+{
+    if(index >= store->count)
+        return;
+
+    uint16_t last = -- store->count;
+
+    store->pos_x[index] = store->pos_x[last];
+    store->pos_y[index] = store->pos_y[last];
+    store->prev_x[index] = store->prev_x[last];
+    store->prev_y[index] = store->prev_y[last];
+    store->vel_x[index] = store->vel_x[last];
+    store->vel_y[index] = store->vel_y[last];
+    store->flags[index] = store->flags[last];
+}
+
+/**
+ * @brief Adds the same acceleration to every entity, then limits every velocity to max_velocity
+ *
+ * @param EntityStore_t *store - entities to accelerate
+ * @param q16_t accel_x, accel_y - screen acceleration in pixels per tick squared
+ * @return void
+ */
+void ENTITY_accelerate(EntityStore_t *store, q16_t accel_x, q16_t accel_y)
+{
+    q16_t max = store->config.max_velocity;
+    q16_t *restrict vel_x = store->vel_x;
+    q16_t *restrict vel_y = store->vel_y;
+
+    for(uint16_t i = 0; i < store->count; i ++)
+    {
+        q16_t vx = vel_x[i] + accel_x;
+        q16_t vy = vel_y[i] + accel_y;
+
+        vx = (vx > max) ? max : vx;
+        vx = (vx < -max) ? -max : vx;
+        vy = (vy > max) ? max : vy;
+        vy = (vy < -max) ? -max : vy;
+
+        vel_x[i] = vx;
+        vel_y[i] = vy;
+    }
+}
+
+/**
+ * @brief Moves every entity by one tick. Velocity toward a bound the entity would cross is stopped, then
+ *        entities with nothing in reach move freely while the rest are swept against the walls.
+ *
+ * @param EntityStore_t *store - entities to move
+ * @param const CollisionMask_t *mask - baked walls and holes, for the broadphase
+ * @param WallGrid_t *grid - wall segments
+ * @return void
+ */
+void ENTITY_step(EntityStore_t *store, const CollisionMask_t *mask, WallGrid_t *grid)
+{
+    uint16_t count = store->count;
+    q16_t *restrict pos_x = store->pos_x;
+    q16_t *restrict pos_y = store->pos_y;
+    q16_t *restrict vel_x = store->vel_x;
+    q16_t *restrict vel_y = store->vel_y;
+    uint8_t *restrict flags = store->flags;
+
+    memcpy(store->prev_x, pos_x, count * sizeof(q16_t));
+    memcpy(store->prev_y, pos_y, count * sizeof(q16_t));
+
+    q16_t min_x = store->config.min_x, max_x = store->config.max_x;
+    q16_t min_y = store->config.min_y, max_y = store->config.max_y;
+
+    // Stop at the bounds
+    for(uint16_t i = 0; i < count; i ++)
+    {
+        q16_t next_x = pos_x[i] + vel_x[i];
+        q16_t next_y = pos_y[i] + vel_y[i];
+
+        vel_x[i] = (next_x < min_x || next_x > max_x) ? 0 : vel_x[i];
+        vel_y[i] = (next_y < min_y || next_y > max_y) ? 0 : vel_y[i];
+    }
+
+    // Broadphase - which entities have a wall or hole within reach
+    for(uint16_t i = 0; i < count; i ++)
+    {
+        bool near = COLLISION_MASK_test_disk(mask, &store->reach, Q16_TO_INT(pos_x[i]), Q16_TO_INT(pos_y[i]));
+
+        flags[i] = (flags[i] & ~ENTITY_NEAR_HAZARD) | (near ? ENTITY_NEAR_HAZARD : 0);
+    }
+
+    // Entities with nothing in reach move freely
+    for(uint16_t i = 0; i < count; i ++)
+    {
+        q16_t free = (flags[i] & ENTITY_NEAR_HAZARD) ? 0 : -1;
+
+        pos_x[i] += vel_x[i] & free;
+        pos_y[i] += vel_y[i] & free;
+    }
+
+    // The rest are swept against the walls
+    for(uint16_t i = 0; i < count; i ++)
+    {
+        if(flags[i] & ENTITY_NEAR_HAZARD)
+            move_against_walls(&store->config, grid, &pos_x[i], &pos_y[i], &vel_x[i], &vel_y[i], flags[i]);
+    }
+}
@@ -0,0 +1,160 @@
+/*
+ * EntropyPool.c
+ *
+ * Interrupt filled ring of TRNG words with a xorshift fallback.
+ */
+
+#include "EntropyPool.h"
+
+#define ENTROPY_POOL_MASK (ENTROPY_POOL_SIZE - 1)
+
+/**
+ * @brief Next word of the fallback generator
+ */
+static uint32_t xorshift(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return x;
+}
+
+/**
+ * @brief Mixes a word into the fallback generator's state, keeping it away from 0
+ */
+static void stir(EntropyPool_t *pool, uint32_t word)
+{
+    pool->fallback ^= word;
+
+    if(pool->fallback == 0)
+        pool->fallback = 0x9E3779B9;
+
+    xorshift(&pool->fallback);
+}
+
+/**
+ * @brief Sets up an empty pool - call ENTROPY_POOL_start to begin filling it
+ *
+ * @param EntropyPool_t *pool - pool to set up
+ * @param const EntropyPoolPort_t *port - generator interrupt control
+ * @param uint32_t seed - fallback generator seed, a word read from the TRNG
+ * @return void
+ */
+void ENTROPY_POOL_init(EntropyPool_t *pool, const EntropyPoolPort_t *port, uint32_t seed)
+{
+    pool->port = *port;
+    pool->head = 0;
+    pool->tail = 0;
+    pool->running = false;
+    pool->primed = false;
+    pool->last = 0;
+    pool->fallback = 0;
+    pool->repeats = 0;
+    pool->fallbacks = 0;
+
+    stir(pool, seed);
+}
+
+/**
+ * @brief Starts filling the pool in the background
+ *
+ * @param EntropyPool_t *pool - pool to fill
+ * @return void
+ */
+void ENTROPY_POOL_start(EntropyPool_t *pool)
+{
+    pool->running = true;
+    pool->port.start(pool->port.context);
+}
+
+/**
+ * @brief Takes a new word from the generator into the ring - call from its data ready interrupt. Stops the
+ *        interrupt once the ring is full.
+ *
+ * @param EntropyPool_t *pool - pool to fill
+ * @param uint32_t word - word read from the generator
+ * @return void
+ */
+void ENTROPY_POOL_on_word(EntropyPool_t *pool, uint32_t word)
+{
+    uint16_t head = pool->head;
+
+    if(!pool->primed || word == pool->last)
+    {
+        pool->repeats += pool->primed;
+        pool->primed = true;
+        pool->last = word;
+        return;
+    }
+
+    pool->last = word;
+
+    if((uint16_t)(head - pool->tail) < ENTROPY_POOL_SIZE)
+    {
+        pool->words[head & ENTROPY_POOL_MASK] = word;
+        pool->head = ++ head;
+    }
+
+    if((uint16_t)(head - pool->tail) == ENTROPY_POOL_SIZE)
+    {
+        pool->running = false;
+        pool->port.stop(pool->port.context);
+    }
+}
+
+/**
+ * @brief The generator was restarted after an error - its next word is only kept for the continuous test
+ *
+ * @param EntropyPool_t *pool - pool the generator fills
+ * @return void
+ */
+void ENTROPY_POOL_on_restart(EntropyPool_t *pool)
+{
+    pool->primed = false;
+}
+
+/**
+ * @brief Takes a random word without waiting - from the ring, or from the fallback generator if the ring is
+ *        empty. Restarts the interrupt if it stopped on a full ring.
+ *
+ * @param EntropyPool_t *pool - pool to take from
+ * @return uint32_t - random word
+ */
+uint32_t ENTROPY_POOL_take(EntropyPool_t *pool)
+{
+    uint16_t tail = pool->tail;
+    uint32_t word;
+
+    if(tail == pool->head)
+    {
+        pool->fallbacks ++;
+        word = xorshift(&pool->fallback);
+    }
+    else
+    {
+        word = pool->words[tail & ENTROPY_POOL_MASK];
+        pool->tail = tail + 1;
+        stir(pool, word);
+    }
+
+    // If the interrupt stopped the generator just after this was read, it restarts on the next take
+    if(!pool->running)
+        ENTROPY_POOL_start(pool);
+
+    return word;
+}
+
+/**
+ * @brief Number of TRNG words waiting in the ring
+ *
+ * @param const EntropyPool_t *pool - pool to look at
+ * @return uint16_t - words that can be taken before falling back
+ */
+uint16_t ENTROPY_POOL_available(const EntropyPool_t *pool)
+{
+    return (uint16_t)(pool->head - pool->tail);
+}
@@ -0,0 +1,145 @@
+/*
+ * Filter.c
+ *
+ * Direct form I - the inputs are kept as they came in, so only the output state needs extra precision and
+ * the accumulator can't overflow before the feedback is applied. Products are 32x32 into a 64 bit
+ * accumulator, one multiply-accumulate each on the Cortex-M4.
+ */
+
+#include <string.h>
+#include "Filter.h"
+
+#define STATE_ROUND         ((int32_t)1 << (FILTER_STATE_SHIFT - 1))
+#define COEFFICIENT_ROUND   ((int64_t)1 << (FILTER_COEFFICIENT_SHIFT - 1))
+#define STATE_MAX           ((int32_t)INT16_MAX * (1 << FILTER_STATE_SHIFT))
+#define STATE_MIN           ((int32_t)INT16_MIN * (1 << FILTER_STATE_SHIFT))
+
+/**
+ * @brief Rounds a filter state to a sample, saturating
+ */
+static int16_t to_sample(int32_t state)
+{
+    int32_t sample = (state + STATE_ROUND) >> FILTER_STATE_SHIFT;
+
+    if(sample > INT16_MAX)
+        return INT16_MAX;
+    if(sample < INT16_MIN)
+        return INT16_MIN;
+
+    return sample;
+}
+
+/**
+ * @brief Keeps a filter state within what a sample can reach, so a full scale step can't wind it up past
+ *        what the accumulator holds
+ */
+static int32_t clamp_state(int64_t state)
+{
+    if(state > STATE_MAX)
+        return STATE_MAX;
+    if(state < STATE_MIN)
+        return STATE_MIN;
+
+    return state;
+}
+
+/**
+ * @brief Sets up a biquad at rest
+ *
+ * @param Biquad_t *filter - filter to set up
+ * @param const BiquadCoefficients_t *coefficients - must stay valid while the filter is used
+ * @return void
+ */
+void FILTER_biquad_init(Biquad_t *filter, const BiquadCoefficients_t *coefficients)
+{
+    memset(filter, 0, sizeof(*filter));
+    filter->coefficients = coefficients;
+}
+
+/**
+ * @brief Filters a block of samples
+ *
+ * @param Biquad_t *filter - filter, carries its state from block to block
+ * @param const int16_t *input - samples in
+ * @param int16_t *output - filtered samples, may be input
+ * @param uint16_t count - number of samples
+ * @return void
+ */
+void FILTER_biquad_process(Biquad_t *filter, const int16_t *input, int16_t *output, uint16_t count)
+{
+    const BiquadCoefficients_t coefficients = *filter->coefficients;
+    int32_t x1 = filter->x1, x2 = filter->x2;
+    int32_t y1 = filter->y1, y2 = filter->y2;
+
+    for(uint16_t i = 0; i < count; i ++)
+    {
+        int32_t x0 = input[i];
+
+        // Inputs scaled up to the state's fraction bits, so every term is Q30 above the state
+        int64_t accumulator = COEFFICIENT_ROUND;
+        accumulator += (int64_t)coefficients.b0 * (x0 * (1 << FILTER_STATE_SHIFT));
+        accumulator += (int64_t)coefficients.b1 * (x1 * (1 << FILTER_STATE_SHIFT));
+        accumulator += (int64_t)coefficients.b2 * (x2 * (1 << FILTER_STATE_SHIFT));
+        accumulator -= (int64_t)coefficients.a1 * y1;
+        accumulator -= (int64_t)coefficients.a2 * y2;
+
+        int32_t y0 = clamp_state(accumulator >> FILTER_COEFFICIENT_SHIFT);
+
+        output[i] = to_sample(y0);
+
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+    }
+
+    filter->x1 = x1;
+    filter->x2 = x2;
+    filter->y1 = y1;
+    filter->y2 = y2;
+}
+
+/**
+ * @brief Sets up a DC blocker at rest
+ *
+ * @param DcBlocker_t *filter - filter to set up
+ * @param int32_t pole - Q2.30 pole, just under 1
+ * @return void
+ */
+void FILTER_dc_blocker_init(DcBlocker_t *filter, int32_t pole)
+{
+    memset(filter, 0, sizeof(*filter));
+    filter->pole = pole;
+}
+
+/**
+ * @brief Removes the DC offset from a block of samples
+ *
+ * @param DcBlocker_t *filter - filter, carries its state from block to block
+ * @param const int16_t *input - samples in
+ * @param int16_t *output - filtered samples, may be input
+ * @param uint16_t count - number of samples
+ * @return void
+ */
+void FILTER_dc_blocker_process(DcBlocker_t *filter, const int16_t *input, int16_t *output, uint16_t count)
+{
+    int32_t pole = filter->pole;
+    int32_t x1 = filter->x1;
+    int32_t y1 = filter->y1;
+
+    for(uint16_t i = 0; i < count; i ++)
+    {
+        int32_t x0 = input[i];
+
+        int64_t accumulator = (((int64_t)pole * y1) + COEFFICIENT_ROUND) >> FILTER_COEFFICIENT_SHIFT;
+        int32_t y0 = clamp_state(accumulator + ((x0 - x1) * (1 << FILTER_STATE_SHIFT)));
+
+        output[i] = to_sample(y0);
+
+        x1 = x0;
+        y1 = y0;
+    }
+
+    filter->x1 = x1;
+    filter->y1 = y1;
+}
@@ -0,0 +1,19 @@
+/*
+ * FilterCoefficients.c
+ *
+ * Generated by Host/filter_design - do not edit.
+ */
+
+#include "Filter.h"
+
+// Butterworth low pass, 12 Hz at 190 Hz
+const BiquadCoefficients_t gyro_low_pass_coefficients = {
+    .b0 = 32765645,
+    .b1 = 65531289,
+    .b2 = 32765645,
+    .a1 = -1555492110,
+    .a2 = 612812864
+};
+
+// DC blocker, 0.05 Hz at 190 Hz
+const int32_t gyro_dc_block_pole = 1071967891;
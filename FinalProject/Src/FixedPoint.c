@@ -0,0 +1,158 @@
+/*
+ * FixedPoint.c
+ *
+ * Saturating Q16.16 and Q1.15 arithmetic.
+ */
+
+#include "FixedPoint.h"
+
+/**
+ * @brief Clamps a 64 bit intermediate into Q16.16 range
+ */
+static q16_t saturate(int64_t value)
+{
+    if(value > Q16_MAX)
+        return Q16_MAX;
+
+    if(value < Q16_MIN)
+        return Q16_MIN;
+
+    return (q16_t)value;
+}
+
+/**
+ * @brief Saturating a + b
+ */
+q16_t FIXED_add(q16_t a, q16_t b)
+{
+    return saturate((int64_t)a + b);
+}
+
+/**
+ * @brief Saturating a - b
+ */
+q16_t FIXED_sub(q16_t a, q16_t b)
+{
+    return saturate((int64_t)a - b);
+}
+
+/**
+ * @brief Saturating a * b, rounded to nearest
+ */
+q16_t FIXED_mul(q16_t a, q16_t b)
+{
+    int64_t product = (int64_t)a * b;
+
+    return saturate((product + Q16_HALF) >> Q16_SHIFT);
+}
+
+/**
+ * @brief Saturating a / b, truncated toward zero. Division by zero saturates toward the sign of a.
+ */
+q16_t FIXED_div(q16_t a, q16_t b)
+{
+    if(b == 0)
+        return (a < 0) ? Q16_MIN : Q16_MAX;
+
+    return saturate(((int64_t)a * Q16_ONE) / b);
+}
+
+/**
+ * @brief Saturating |a|
+ */
+q16_t FIXED_abs(q16_t a)
+{
+    if(a == Q16_MIN)
+        return Q16_MAX;
+
+    return (a < 0) ? -a : a;
+}
+
+/**
+ * @brief Square root, rounded down. Negative values return 0.
+ */
+q16_t FIXED_sqrt(q16_t a)
+{
+    // sqrt(a / 2^16) * 2^16 = sqrt(a * 2^16)
+    return FIXED_sqrt_q32((int64_t)a << Q16_SHIFT);
+}
+
+/**
+ * @brief Square root of a Q32.32 value (such as the product of two Q16.16 values), rounded down and
+ *        saturated. Negative values return 0.
+ */
+q16_t FIXED_sqrt_q32(int64_t a)
+{
+    if(a <= 0)
+        return 0;
+
+    // Integer square root one result bit at a time
+    uint64_t value = (uint64_t)a;
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while(bit > value)
+        bit >>= 2;
+
+    while(bit != 0)
+    {
+        if(value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+
+        bit >>= 2;
+    }
+
+    return (result > Q16_MAX) ? Q16_MAX : (q16_t)result;
+}
+
+/**
+ * @brief Saturating 1 / a
+ */
+q16_t FIXED_reciprocal(q16_t a)
+{
+    return FIXED_div(Q16_ONE, a);
+}
+
+/**
+ * @brief Saturating Q1.15 a * b, rounded to nearest
+ */
+q15_t FIXED_q15_mul(q15_t a, q15_t b)
+{
+    int32_t product = ((int32_t)a * b + (1 << (Q15_SHIFT - 1))) >> Q15_SHIFT;
+
+    if(product > Q15_MAX)
+        return Q15_MAX;
+
+    return (q15_t)product;
+}
+
+/**
+ * @brief Converts Q16.16 to Q1.15, saturating to the -1 to 1 range
+ */
+q15_t FIXED_q16_to_q15(q16_t a)
+{
+    int32_t value = a >> (Q16_SHIFT - Q15_SHIFT);
+
+    if(value > Q15_MAX)
+        return Q15_MAX;
+
+    if(value < Q15_MIN)
+        return Q15_MIN;
+
+    return (q15_t)value;
+}
+
+/**
+ * @brief Converts Q1.15 to Q16.16
+ */
+q16_t FIXED_q15_to_q16(q15_t a)
+{
+    return (q16_t)a * (1 << (Q16_SHIFT - Q15_SHIFT));
+}
@@ -0,0 +1,115 @@
+/*
+ * FlowField.c
+ *
+ * Breadth first search from the target cell outward over the map's walls.
+ */
+
+#include "FlowField.h"
+
+/**
+ * @brief Stores the route from a neighbouring cell into the current search cell if the neighbour is new
+ *        and the drone could move between them
+ */
+static void visit(FlowField_t *field, const MapData_t *map, uint8_t row, uint8_t col, uint8_t direction, uint8_t distance, uint16_t *tail, uint16_t *count)
+{
+    uint16_t size = field->cell_count * field->cell_count;
+
+    if(field->cells[row][col] != FLOW_NONE || (map->cell_data[row][col] & MAP_HOLE))
+        return;
+
+    field->cells[row][col] = direction | (distance << FLOW_FIELD_DISTANCE_SHIFT);
+
+    field->queue[*tail] = (row * field->cell_count) + col;
+    *tail = (*tail + 1 == size) ? 0 : *tail + 1;
+    (*count) ++;
+}
+
+/**
+ * @brief Builds the route from every cell of the map to the target cell
+ *
+ * @param FlowField_t *field - field to fill
+ * @param const MapData_t *map - walls and holes to route around
+ * @param uint8_t target_row, target_col - cell to route to
+ * @return void
+ */
+void FLOW_FIELD_compute(FlowField_t *field, const MapData_t *map, uint8_t target_row, uint8_t target_col)
+{
+    uint8_t cell_count = MAP_CELL_COUNT(map);
+    uint16_t size = cell_count * cell_count;
+    uint16_t head = 0, tail = 0, count = 0;
+    uint16_t layer_count, next_layer_count = 0;
+    uint8_t distance = 0;
+
+    field->cell_count = cell_count;
+    field->target_row = target_row;
+    field->target_col = target_col;
+
+    for(int i = 0; i < cell_count; i ++)
+    {
+        for(int j = 0; j < cell_count; j ++)
+            field->cells[i][j] = FLOW_NONE;
+    }
+
+    field->cells[target_row][target_col] = FLOW_TARGET;
+    field->queue[tail ++] = (target_row * cell_count) + target_col;
+    count = 1;
+    layer_count = 1;
+
+    while(count > 0)
+    {
+        uint16_t cell = field->queue[head];
+        uint8_t row = cell / cell_count;
+        uint8_t col = cell % cell_count;
+        uint8_t walls = map->cell_data[row][col];
+        uint8_t next_distance = (distance < FLOW_FIELD_MAX_DISTANCE) ? distance + 1 : FLOW_FIELD_MAX_DISTANCE;
+        uint16_t previous_count;
+
+        head = (head + 1 == size) ? 0 : head + 1;
+        count --;
+        previous_count = count;
+
+        // Neighbours route back through this cell, so their direction points at it
+        if(row > 0 && !(walls & MAP_TOP_WALL) && !(map->cell_data[row - 1][col] & MAP_BOTTOM_WALL))
+            visit(field, map, row - 1, col, FLOW_DOWN, next_distance, &tail, &count);
+
+        if(row < cell_count - 1 && !(walls & MAP_BOTTOM_WALL) && !(map->cell_data[row + 1][col] & MAP_TOP_WALL))
+            visit(field, map, row + 1, col, FLOW_UP, next_distance, &tail, &count);
+
+        if(col > 0 && !(walls & MAP_LEFT_WALL) && !(map->cell_data[row][col - 1] & MAP_RIGHT_WALL))
+            visit(field, map, row, col - 1, FLOW_RIGHT, next_distance, &tail, &count);
+
+        if(col < cell_count - 1 && !(walls & MAP_RIGHT_WALL) && !(map->cell_data[row][col + 1] & MAP_LEFT_WALL))
+            visit(field, map, row, col + 1, FLOW_LEFT, next_distance, &tail, &count);
+
+        next_layer_count += count - previous_count;
+
+        // Every cell of this distance has been expanded
+        if(-- layer_count == 0)
+        {
+            distance = next_distance;
+            layer_count = next_layer_count;
+            next_layer_count = 0;
+        }
+    }
+}
+
+/**
+ * @brief Looks up the route from the cell containing a pixel position
+ *
+ * @param const FlowField_t *field - computed field
+ * @param int32_t x, y - pixel position
+ * @return uint8_t - cell byte, FLOW_NONE if the position is off the map
+ */
+uint8_t FLOW_FIELD_get_cell(const FlowField_t *field, int32_t x, int32_t y)
+{
+    if(x < MAP_ORIGIN_X || y < MAP_ORIGIN_Y)
+        return FLOW_NONE;
+
+    int32_t col = MAP_CELL_COL(x);
+    int32_t row = MAP_CELL_ROW(y);
+
+    if(col >= field->cell_count || row >= field->cell_count)
+        return FLOW_NONE;
+
+    return field->cells[row][col];
+}
@@ -0,0 +1,391 @@
+/*
+ * Game.c
+ *
+ * Game rules, shared by the firmware and the host simulator.
+ */
+
+#include <string.h>
+#include "Game.h"
+
+/**
+ * @brief Fills in the default configuration
+ *
+ * @param struct ConfigData_t *config - config to fill
+ * @return void
+ */
+void GAME_default_config(struct ConfigData_t *config)
+{
+    config->version = CONFIG_VERSION;
+
+    // Game config
+    config->game_config.time_to_complete = 30000; // 30 sec
+    config->game_config.hard_edged = true;
+    config->game_config.reuse_waypoints = false; // All waypoints must be reached
+
+    // Map config
+    config->map_config.cell_count = GAME_MAP_CELL_COUNT;
+    config->map_config.wall_probability = 150;  // - 150 / 1000 = 15 %
+    config->map_config.hole_probability = 150;  // - 150 / 1000 = 15 %
+    config->map_config.num_waypoints = 4; 
+    config->map_config.hole_radius = 10;        // Pixels
+    config->map_config.waypoint_radius = 15;    // Pixels
+
+    // Drone config
+    config->drone_config.disruptor_max_time = 1000;                        
+    config->drone_config.disruptor_power = 10000;                           
+    config->drone_config.disruptor_min_activation_energy = 6000;           
+    config->drone_config.max_energy = 15000;                                
+    config->drone_config.recharge_rate = 1000;                             
+    config->drone_config.diameter = 10;
+    config->drone_config.max_velocity = 2500;
+
+    // Physics config
+    config->physics_config.gravity = 980;
+    config->physics_config.update_period = GAME_UPDATE_PERIOD;
+    config->physics_config.angle_gain = 500;
+    config->physics_config.pin_at_center = MAZE; // This does not actually affect the configuration in this version
+}
+
+/**
+ * @brief Checks a config the firmware didn't fill in itself, such as one read back from flash, before it is
+ *        played - a saved config could otherwise hang the board at every boot
+ *
+ * @param const struct ConfigData_t *config - config to check
+ * @return bool - false if it is laid out for another CONFIG_VERSION, isn't for the firmware's map size, has no
+ *                physics period, or has holes or a drone reach too big for the collision mask
+ */
+bool GAME_validate_config(const struct ConfigData_t *config)
+{
+    if(config->version != CONFIG_VERSION)
+        return false;
+
+    if(config->map_config.cell_count != GAME_MAP_CELL_COUNT)
+        return false;
+
+    // The game task's accumulator would never run down
+    if(config->physics_config.update_period == 0)
+        return false;
+
+    // The drone spawns on the first waypoint
+    if(config->map_config.num_waypoints == 0 || config->map_config.num_waypoints > GAME_MAP_MAX_WAYPOINTS)
+        return false;
+
+    if(config->map_config.hole_radius > COLLISION_MASK_MAX_RADIUS)
+        return false;
+
+    // Bounded first, so the reach can't overflow
+    if(config->drone_config.diameter > 2 * COLLISION_MASK_MAX_RADIUS || config->drone_config.max_velocity < 0 ||
+       config->drone_config.max_velocity > 1000 * COLLISION_MASK_MAX_RADIUS)
+        return false;
+
+    EntityConfig_t entity_config = {
+        .radius = Q16_FROM_INT(config->drone_config.diameter / 2),
+        .max_velocity = MILLI_PIXELS_TO_Q16(config->drone_config.max_velocity),
+    };
+
+    return ENTITY_reach(&entity_config) <= COLLISION_MASK_MAX_RADIUS;
+}
+
+/**
+ * @brief Attaches a configuration to a game. The map must be filled in and GAME_start called before playing.
+ *
+ * @param GameState_t *game - game to set up
+ * @param const struct ConfigData_t *config - configuration to play with, must outlive the game
+ * @return void
+ */
+void GAME_init(GameState_t *game, const struct ConfigData_t *config)
+{
+    game->config = config;
+
+    // gravity is in milli-pixels per tick squared
+    game->tilt_gain = Q16_FROM_RATIO(config->physics_config.angle_gain, 1000);
+    game->gravity_gain = Q16_FROM_RATIO(config->physics_config.gravity, 1000);
+}
+
+/**
+ * @brief Starts a game on the map in game->map - bakes the walls and holes into the collision mask and the
+ *        wall grid, puts the drone on the first waypoint with full energy and resets the clock
+ *
+ * @param GameState_t *game - game with its map filled in
+ * @return bool - false if the map's walls don't fit in the wall grid, or the holes or the drone's reach in a
+ *                tick are too big for the collision mask
+ */
+bool GAME_start(GameState_t *game)
+{
+    [[maybe_unused]] const struct ConfigData_t *config = game->config; // Unused with CONFIG_STATIC_PROFILE
+    int32_t radius = CONFIG_DRONE_DIAMETER(config) / 2;
+    EntityConfig_t entity_config = {
+        .radius = Q16_FROM_INT(radius),
+        .max_velocity = MILLI_PIXELS_TO_Q16(CONFIG_DRONE_MAX_VELOCITY(config)),
+        .wall_pass_gain = DISRUPTOR_WALL_SPEED_GAIN,
+        .min_x = Q16_FROM_INT(0 + radius),
+        .min_y = Q16_FROM_INT(40 + radius),
+        .max_x = Q16_FROM_INT(238 - radius),
+        .max_y = Q16_FROM_INT(280 - radius),
+    };
+
+    if(CONFIG_MAP_HOLE_RADIUS(config) > COLLISION_MASK_MAX_RADIUS)
+        return false;
+
+    COLLISION_MASK_bake(&game->collision_mask, &game->map, CONFIG_MAP_HOLE_RADIUS(config));
+
+    // One bucket per cell
+    if(!WALL_GRID_init(&game->wall_grid, Q16_FROM_INT(MAP_ORIGIN_X), Q16_FROM_INT(MAP_ORIGIN_Y), Q16_FROM_INT(MAP_CELL_SIZE), MAP_CELL_COUNT(&game->map), MAP_CELL_COUNT(&game->map)))
+        return false;
+
+    if(!WALL_GRID_add_map_walls(&game->wall_grid, &game->map) || !WALL_GRID_build(&game->wall_grid))
+        return false;
+
+    // Drone spawns on the first waypoint
+    if(!ENTITY_init(&game->entities, &entity_config))
+        return false;
+
+    if(ENTITY_add(&game->entities, Q16_FROM_INT(game->map.waypoint_data[0].x), Q16_FROM_INT(game->map.waypoint_data[0].y), 0) != DRONE_ENTITY)
+        return false;
+
+    game->current_waypoint = 0;
+    game->drone_energy = CONFIG_DRONE_MAX_ENERGY(config);
+    game->button_pressed = false;
+    game->disruptor_active = false;
+    game->disruptor_can_be_activated = true;
+
+    game->time = 0;
+    game->won = false;
+    game->lost = false;
+    game->fell_into_hole = false;
+    game->ran_out_of_time = false;
+    game->exceeded_tilt = false;
+
+    return true;
+}
+
+/**
+ * @brief Integrates one gyro sample into the board angle - fractions of a degree are kept
+ *
+ * @param q16_t *angle_x, *angle_y - board angle in degrees, updated
+ * @param int16_t rate_x, rate_y - raw angular rate read from the gyro
+ * @return void
+ */
+void GAME_integrate_gyro(q16_t *angle_x, q16_t *angle_y, int16_t rate_x, int16_t rate_y)
+{
+    *angle_x = FIXED_add(*angle_x, FIXED_mul(Q16_FROM_INT(rate_x), GYRO_DEGREES_PER_LSB));
+    *angle_y = FIXED_add(*angle_y, FIXED_mul(Q16_FROM_INT(rate_y), GYRO_DEGREES_PER_LSB));
+}
+
+/**
+ * @brief Depending on the angle of the board, figures out the adjusted force due to gravity - gravity times
+ *        the sine of the tilt, so the drone speeds up smoothly as the board tilts further. Up to
+ *        FLAT_TILT_ANGLE the board counts as flat, and the tilt is measured from there, so the pull starts from
+ *        nothing at the edge of the dead zone. Tilting too far loses the game.
+ *
+ * @param GameState_t *game - game being played
+ * @param q16_t angle - angle of board in degrees
+ * @return q16_t - adjusted gravitational acceleration in pixels per game tick squared
+ */
+q16_t GAME_get_board_gravity_ratio(GameState_t *game, q16_t angle)
+{
+    q16_t tilt = FIXED_mul(FIXED_sub(angle, Q16_FROM_INT(180)), game->tilt_gain);
+    q16_t magnitude = FIXED_abs(tilt);
+
+    if(magnitude > MAX_TILT_ANGLE)
+    {
+        game->exceeded_tilt = true;
+        game->lost = true;
+    }
+
+    if(magnitude <= FLAT_TILT_ANGLE)
+        return 0;
+
+    q16_t ratio = FIXED_mul(SINE_TABLE_sin(FIXED_sub(magnitude, FLAT_TILT_ANGLE)), game->gravity_gain);
+
+    return (tilt < 0) ? -ratio : ratio;
+}
+
+/**
+ * @brief Advances the game by one physics tick - updates the drone's velocity and position from the board
+ *        angle and checks for waypoints and holes. Does nothing once the game is over.
+ *
+ * @param GameState_t *game - game being played
+ * @param q16_t board_angle_x, board_angle_y - board angle in degrees, 180 is flat
+ * @return uint32_t - GAME_EVENT_ flags
+ */
+uint32_t GAME_step(GameState_t *game, q16_t board_angle_x, q16_t board_angle_y)
+{
+    EntityStore_t *entities = &game->entities;
+    uint32_t events = 0;
+
+    if(game->won || game->lost)
+        return 0;
+
+    q16_t accel_x = GAME_get_board_gravity_ratio(game, board_angle_x);
+    q16_t accel_y = GAME_get_board_gravity_ratio(game, board_angle_y);
+
+    // The disruptor pushes the drone through walls
+    if(game->disruptor_active)
+        entities->flags[DRONE_ENTITY] |= ENTITY_PASS_WALLS;
+    else
+        entities->flags[DRONE_ENTITY] &= ~ENTITY_PASS_WALLS;
+
+    // Screen x moves with the board's y angle and screen y with its x angle
+    ENTITY_accelerate(entities, accel_y, accel_x);
+
+    // Move everything, stopping or sliding at walls and the edges of the map
+    ENTITY_step(entities, &game->collision_mask, &game->wall_grid);
+
+    int32_t x = Q16_TO_INT(entities->pos_x[DRONE_ENTITY]);
+    int32_t y = Q16_TO_INT(entities->pos_y[DRONE_ENTITY]);
+
+    // Check which waypoint the drone is over (if it is over any at all)
+    int8_t waypoint_number = MAP_get_waypoint(&game->map, x, y, CONFIG_MAP_WAYPOINT_RADIUS(game->config));
+
+    // If the drone *is* over a waypoint and it is the right waypoint
+    if(waypoint_number != -1 && waypoint_number == game->current_waypoint)
+    {
+        game->map.waypoint_data[waypoint_number].reached = true;
+        game->current_waypoint ++;
+        events |= GAME_EVENT_WAYPOINT_REACHED;
+    }
+
+    // If all waypoints have been reached
+    if(game->current_waypoint == game->map.num_waypoints)
+    {
+        game->won = true;
+        events |= GAME_EVENT_WON;
+    }
+
+    // Lost game if over hole and the disruptor is not active. Nothing was within reach of the move if the
+    // drone isn't near a hazard, so the hole lookup can be skipped.
+    if((entities->flags[DRONE_ENTITY] & ENTITY_NEAR_HAZARD) && !game->disruptor_active &&
+       MAP_is_over_hole(&game->map, x, y, CONFIG_MAP_HOLE_RADIUS(game->config)))
+    {
+        game->fell_into_hole = true;
+        game->lost = true;
+    }
+
+    if(game->lost)
+        events |= GAME_EVENT_LOST;
+
+    return events;
+}
+
+/**
+ * @brief Advances the game clock. Running out of time loses the game. The clock stops once the game is won or
+ *        lost.
+ *
+ * @param GameState_t *game - game being played
+ * @param uint32_t ms - time passed
+ * @return uint32_t - GAME_EVENT_LOST when time runs out, otherwise 0
+ */
+uint32_t GAME_advance_clock(GameState_t *game, uint32_t ms)
+{
+    if(game->won || game->lost)
+        return 0;
+
+    game->time += ms;
+
+    if(game->time >= CONFIG_GAME_TIME_TO_COMPLETE(game->config))
+    {
+        game->ran_out_of_time = true;
+        game->lost = true;
+
+        return GAME_EVENT_LOST;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Records a button press or release. Pressing activates the disruptor if there is enough energy;
+ *        while the button is held, energy drains instead of recharging.
+ *
+ * @param GameState_t *game - game being played
+ * @param bool pressed - new button state
+ * @return void
+ */
+void GAME_set_button(GameState_t *game, bool pressed)
+{
+    game->button_pressed = pressed;
+    game->disruptor_active = pressed && game->disruptor_can_be_activated;
+}
+
+/**
+ * @brief Drains one GAME_ENERGY_PERIOD of disruptor power while the button is held
+ *
+ * @param GameState_t *game - game being played
+ * @return uint32_t - GAME_EVENT_ENERGY_EMPTY once energy runs out, GAME_EVENT_DISRUPTOR_LOCKED while energy
+ *                    is below the minimum to activate the disruptor
+ */
+uint32_t GAME_drain_energy(GameState_t *game)
+{
+    [[maybe_unused]] const struct ConfigData_t *config = game->config; // Unused with CONFIG_STATIC_PROFILE
+    uint32_t events = 0;
+
+    game->drone_energy -= CONFIG_DRONE_DISRUPTOR_POWER(config) / 100;
+
+    if(game->drone_energy <= 0)
+    {
+        game->drone_energy = 0;
+        events |= GAME_EVENT_ENERGY_EMPTY;
+    }
+
+    // Energy level below minimum activation
+    if(game->drone_energy < (int32_t)CONFIG_DRONE_DISRUPTOR_MIN_ACTIVATION_ENERGY(config))
+    {
+        game->disruptor_can_be_activated = false;
+        events |= GAME_EVENT_DISRUPTOR_LOCKED;
+    }
+
+    return events;
+}
+
+/**
+ * @brief Recharges one GAME_ENERGY_PERIOD of energy while the button is released
+ *
+ * @param GameState_t *game - game being played
+ * @return uint32_t - GAME_EVENT_ENERGY_FULL once energy is full, GAME_EVENT_DISRUPTOR_READY while energy is
+ *                    enough to activate the disruptor
+ */
+uint32_t GAME_recharge_energy(GameState_t *game)
+{
+    [[maybe_unused]] const struct ConfigData_t *config = game->config; // Unused with CONFIG_STATIC_PROFILE
+    uint32_t events = 0;
+
+    game->drone_energy += CONFIG_DRONE_RECHARGE_RATE(config) / 100;
+
+    if(game->drone_energy >= (int32_t)CONFIG_DRONE_MAX_ENERGY(config))
+    {
+        game->drone_energy = CONFIG_DRONE_MAX_ENERGY(config);
+        events |= GAME_EVENT_ENERGY_FULL;
+    }
+
+    // Energy satisfies minimum activation
+    if(game->drone_energy >= (int32_t)CONFIG_DRONE_DISRUPTOR_MIN_ACTIVATION_ENERGY(config))
+    {
+        game->disruptor_can_be_activated = true;
+        events |= GAME_EVENT_DISRUPTOR_READY;
+    }
+
+    return events;
+}
+
+/**
+ * @brief Drains or recharges the disruptor's energy once for every GAME_ENERGY_PERIOD in the time passed,
+ *        depending on the button. Driven by the physics tick, so a replay of the same ticks and button presses
+ *        ends up with the same energy. The energy stops once the game is won or lost.
+ *
+ * @param GameState_t *game - game being played
+ * @param uint32_t ms - time passed
+ * @return uint32_t - GAME_drain_energy or GAME_recharge_energy events of every period
+ */
+uint32_t GAME_advance_energy(GameState_t *game, uint32_t ms)
+{
+    uint32_t events = 0;
+
+    if(game->won || game->lost)
+        return 0;
+
+    for(uint32_t elapsed = 0; elapsed < ms; elapsed += GAME_ENERGY_PERIOD)
+        events |= game->button_pressed ? GAME_drain_energy(game) : GAME_recharge_energy(game);
+
+    return events;
+}
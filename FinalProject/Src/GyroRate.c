@@ -0,0 +1,167 @@
+/*
+ * GyroRate.c
+ *
+ * Calibration, bias tracking and scaling for one gyro axis.
+ */
+
+#include <string.h>
+#include "GyroRate.h"
+
+#define Q16_HALF_COUNT ((int32_t)1 << 15)
+
+/**
+ * @brief Starts a new still window
+ */
+static void reset_window(GyroRate_t *axis)
+{
+    axis->window_sum = 0;
+    axis->window_min = INT16_MAX;
+    axis->window_max = INT16_MIN;
+    axis->window_count = 0;
+}
+
+/**
+ * @brief A window is complete - calibrates or tracks the bias with it if the board was still
+ */
+static void close_window(GyroRate_t *axis)
+{
+    int32_t span = axis->window_max - axis->window_min;
+    bool still = span <= GYRO_RATE_STILL_BAND;
+
+    if(!axis->calibrated)
+    {
+        if(axis->calibration_attempts == 0 || span < axis->quietest_span)
+        {
+            axis->quietest_sum = axis->window_sum;
+            axis->quietest_span = span;
+        }
+
+        axis->calibration_attempts ++;
+
+        if(!still)
+        {
+            axis->restarts += axis->calibration_windows > 0;
+            axis->calibration_sum = 0;
+            axis->calibration_windows = 0;
+        }
+        else
+        {
+            axis->calibration_sum += axis->window_sum;
+            axis->calibration_windows ++;
+
+            if(axis->calibration_windows == GYRO_RATE_CALIBRATION_WINDOWS)
+            {
+                axis->bias = (int32_t)(((int64_t)axis->calibration_sum * 65536) /
+                                       (GYRO_RATE_CALIBRATION_WINDOWS * GYRO_RATE_WINDOW));
+                axis->calibrated = true;
+            }
+        }
+
+        // Never still for long enough - the quietest window is the best guess there is
+        if(!axis->calibrated && axis->calibration_attempts == GYRO_RATE_CALIBRATION_TIMEOUT)
+        {
+            axis->bias = (int32_t)(((int64_t)axis->quietest_sum * 65536) / GYRO_RATE_WINDOW);
+            axis->calibrated = true;
+            axis->timed_out = true;
+        }
+    }
+    else if(still)
+    {
+        int64_t error = ((int64_t)axis->window_sum * (65536 / GYRO_RATE_WINDOW)) - axis->bias;
+
+        if(error <= (GYRO_RATE_TRACK_LIMIT * 65536) && error >= -(GYRO_RATE_TRACK_LIMIT * 65536))
+        {
+            axis->bias += (int32_t)(error / (1 << GYRO_RATE_TRACK_SHIFT));
+            axis->updates ++;
+        }
+    }
+
+    reset_window(axis);
+}
+
+/**
+ * @brief Sets up an axis - uncalibrated, so its rate reads zero until the board has been still long enough
+ *
+ * @param GyroRate_t *axis - axis to set up
+ * @return void
+ */
+void GYRO_RATE_init(GyroRate_t *axis)
+{
+    memset(axis, 0, sizeof(*axis));
+    reset_window(axis);
+}
+
+/**
+ * @brief Takes a batch of raw samples into the calibration and bias tracking, then removes the bias from
+ *        them in place
+ *
+ * @param GyroRate_t *axis - axis the samples are from
+ * @param int16_t *samples - raw samples, oldest first - replaced by the corrected samples
+ * @param uint16_t count - number of samples
+ * @return void
+ */
+void GYRO_RATE_correct(GyroRate_t *axis, int16_t *samples, uint16_t count)
+{
+    for(uint16_t i = 0; i < count; i ++)
+    {
+        int16_t sample = samples[i];
+
+        axis->window_sum += sample;
+        if(sample < axis->window_min)
+            axis->window_min = sample;
+        if(sample > axis->window_max)
+            axis->window_max = sample;
+
+        if(++ axis->window_count == GYRO_RATE_WINDOW)
+            close_window(axis);
+
+        if(!axis->calibrated)
+        {
+            samples[i] = 0;
+            continue;
+        }
+
+        // Round to the nearest count and carry what was rounded off to the next sample
+        int64_t corrected = ((int64_t)sample * 65536) - axis->bias + axis->residual;
+        int64_t rounded = (corrected + Q16_HALF_COUNT) >> 16;
+
+        if(rounded > INT16_MAX)
+            rounded = INT16_MAX;
+        if(rounded < INT16_MIN)
+            rounded = INT16_MIN;
+
+        axis->residual = (int32_t)(corrected - (rounded * 65536));
+        if(axis->residual > Q16_HALF_COUNT || axis->residual < -Q16_HALF_COUNT)
+            axis->residual = 0; // Saturated - nothing sensible to carry
+
+        samples[i] = rounded;
+    }
+}
+
+/**
+ * @brief Scales a batch's sum of corrected samples to a rate, rounding to the nearest and carrying what was
+ *        rounded off into the next batch
+ *
+ * @param GyroRate_t *axis - axis the sum is from
+ * @param int32_t sum - sum of the batch's corrected samples
+ * @param int32_t multiplier, divisor - rate = sum * multiplier / divisor
+ * @return int16_t - rate, saturated
+ */
+int16_t GYRO_RATE_scale(GyroRate_t *axis, int32_t sum, int32_t multiplier, int32_t divisor)
+{
+    int64_t total = ((int64_t)sum * multiplier) + axis->remainder;
+    int64_t rate = total + (divisor / 2);
+
+    // Floor division, so the remainder stays within half a divisor either way
+    rate = (rate >= 0) ? rate / divisor : -((-rate + divisor - 1) / divisor);
+
+    if(rate > INT16_MAX || rate < INT16_MIN)
+    {
+        axis->remainder = 0;
+        return (rate > INT16_MAX) ? INT16_MAX : INT16_MIN;
+    }
+
+    axis->remainder = total - (rate * divisor);
+
+    return rate;
+}
@@ -0,0 +1,212 @@
+/*
+ * GyroStream.c
+ *
+ * Interrupt driven L3GD20 FIFO reads - watermark, level read, sample burst, notify.
+ */
+
+#include <string.h>
+#include "GyroStream.h"
+
+/**
+ * @brief Number of samples a FIFO_SRC value says are queued
+ *
+ * @param uint8_t fifo_src - FIFO_SRC register
+ * @param bool *overrun - set if the FIFO overran and samples were lost
+ * @return uint8_t - queued samples, up to GYRO_FIFO_DEPTH
+ */
+uint8_t GYRO_STREAM_fifo_level(uint8_t fifo_src, bool *overrun)
+{
+    *overrun = (fifo_src & GYRO_FIFO_OVERRUN) != 0;
+
+    // The level field only counts to 31 - a full FIFO shows as overrun
+    if(*overrun)
+        return GYRO_FIFO_DEPTH;
+
+    if(fifo_src & GYRO_FIFO_EMPTY)
+        return 0;
+
+    return fifo_src & GYRO_FIFO_LEVEL_MASK;
+}
+
+/**
+ * @brief Unpacks samples read from OUT_X_L onward
+ *
+ * @param const uint8_t *data - GYRO_SAMPLE_SIZE bytes per sample
+ * @param GyroSample_t *samples - filled with the samples
+ * @param uint8_t count - number of samples
+ * @return void
+ */
+void GYRO_STREAM_decode(const uint8_t *data, GyroSample_t *samples, uint8_t count)
+{
+    for(uint8_t i = 0; i < count; i ++)
+    {
+        const uint8_t *sample = &data[i * GYRO_SAMPLE_SIZE];
+
+        samples[i].x = (int16_t)((sample[1] << 8) | sample[0]);
+        samples[i].y = (int16_t)((sample[3] << 8) | sample[2]);
+        samples[i].z = (int16_t)((sample[5] << 8) | sample[4]);
+    }
+}
+
+/**
+ * @brief Starts a transfer with the gyro selected - size bytes of tx are sent while rx fills. One that can't be
+ *        started isn't retried here - the stream goes idle with the read pending, for the next interrupt or
+ *        GYRO_STREAM_poll to pick up.
+ */
+static void start_transfer(GyroStream_t *stream, uint8_t state, uint16_t size)
+{
+    stream->state = state;
+    stream->transfers ++;
+    stream->port.chip_select(stream->port.context, true);
+
+    if(!stream->port.start_transfer(stream->port.context, stream->tx, stream->rx, size))
+    {
+        stream->port.chip_select(stream->port.context, false);
+        stream->state = GYRO_STREAM_IDLE;
+        stream->pending = true;
+        stream->errors ++;
+    }
+}
+
+/**
+ * @brief Sets up a stream, idle until the first watermark
+ *
+ * @param GyroStream_t *stream - stream to set up
+ * @param const GyroStreamPort_t *port - SPI, DMA and chip select of the gyro
+ * @return void
+ */
+void GYRO_STREAM_init(GyroStream_t *stream, const GyroStreamPort_t *port)
+{
+    memset(stream, 0, sizeof(*stream));
+    stream->port = *port;
+    stream->state = GYRO_STREAM_IDLE;
+}
+
+/**
+ * @brief Called from the FIFO watermark interrupt - starts reading the FIFO level, or remembers to once the
+ *        transfer under way is done
+ *
+ * @param GyroStream_t *stream - stream of the gyro that interrupted
+ * @return void
+ */
+void GYRO_STREAM_on_watermark(GyroStream_t *stream)
+{
+    if(stream->state != GYRO_STREAM_IDLE)
+    {
+        stream->pending = true;
+        return;
+    }
+
+    stream->pending = false;
+    stream->tx[0] = GYRO_STREAM_LEVEL_COMMAND;
+    stream->tx[1] = 0;
+
+    start_transfer(stream, GYRO_STREAM_READING_LEVEL, 2);
+}
+
+/**
+ * @brief Called from the DMA transfer complete interrupt - moves on from the level read to the sample burst,
+ *        or hands the samples over and wakes the task that takes them
+ *
+ * @param GyroStream_t *stream - stream whose transfer finished
+ * @return void
+ */
+void GYRO_STREAM_on_transfer_complete(GyroStream_t *stream)
+{
+    stream->port.chip_select(stream->port.context, false);
+
+    if(stream->state == GYRO_STREAM_READING_LEVEL)
+    {
+        bool overrun;
+        uint8_t count = GYRO_STREAM_fifo_level(stream->rx[1], &overrun);
+
+        stream->overruns += overrun;
+        stream->state = GYRO_STREAM_IDLE;
+
+        if(count > 0)
+        {
+            stream->transfer_count = count;
+            memset(stream->tx, 0, 1 + (count * GYRO_SAMPLE_SIZE));
+            stream->tx[0] = GYRO_STREAM_SAMPLES_COMMAND;
+
+            start_transfer(stream, GYRO_STREAM_READING_SAMPLES, 1 + (count * GYRO_SAMPLE_SIZE));
+            return;
+        }
+    }
+    else if(stream->state == GYRO_STREAM_READING_SAMPLES)
+    {
+        uint8_t count = stream->transfer_count;
+        uint8_t room = GYRO_FIFO_DEPTH - stream->sample_count;
+
+        // Samples not taken yet stay - the newest ones are dropped
+        if(count > room)
+        {
+            stream->lost += count - room;
+            count = room;
+        }
+
+        GYRO_STREAM_decode(&stream->rx[1], &stream->samples[stream->sample_count], count);
+        stream->sample_count += count;
+        stream->state = GYRO_STREAM_IDLE;
+
+        stream->port.notify(stream->port.context);
+    }
+
+    // An edge missed during the transfer, or the FIFO filled back up to the watermark while it ran
+    if(stream->state == GYRO_STREAM_IDLE && (stream->pending || stream->port.watermark_pending(stream->port.context)))
+        GYRO_STREAM_on_watermark(stream);
+}
+
+/**
+ * @brief Called from the SPI error interrupt - the transfer is abandoned and the FIFO read again from its level
+ *
+ * @param GyroStream_t *stream - stream whose transfer failed
+ * @return void
+ */
+void GYRO_STREAM_on_transfer_error(GyroStream_t *stream)
+{
+    stream->port.chip_select(stream->port.context, false);
+    stream->state = GYRO_STREAM_IDLE;
+    stream->errors ++;
+
+    // Samples left in the FIFO raise the watermark again
+    if(stream->pending || stream->port.watermark_pending(stream->port.context))
+        GYRO_STREAM_on_watermark(stream);
+}
+
+/**
+ * @brief Called from a task now and then - starts the read a failed start left pending, or one the watermark
+ *        line asks for with no edge left to raise the interrupt. Call with the stream's interrupts masked.
+ *
+ * @param GyroStream_t *stream - stream to check on
+ * @return void
+ */
+void GYRO_STREAM_poll(GyroStream_t *stream)
+{
+    if(stream->state == GYRO_STREAM_IDLE && (stream->pending || stream->port.watermark_pending(stream->port.context)))
+        GYRO_STREAM_on_watermark(stream);
+}
+
+/**
+ * @brief Takes the samples read so far, oldest first. Call with the stream's interrupts masked.
+ *
+ * @param GyroStream_t *stream - stream to take from
+ * @param GyroSample_t *samples - filled with the samples
+ * @param uint8_t max_samples - room in samples
+ * @return uint8_t - number of samples taken
+ */
+uint8_t GYRO_STREAM_take(GyroStream_t *stream, GyroSample_t *samples, uint8_t max_samples)
+{
+    uint8_t count = stream->sample_count;
+
+    if(count > max_samples)
+        count = max_samples;
+
+    memcpy(samples, stream->samples, count * sizeof(GyroSample_t));
+
+    // Keep any that didn't fit, still oldest first
+    memmove(stream->samples, &stream->samples[count], (stream->sample_count - count) * sizeof(GyroSample_t));
+    stream->sample_count -= count;
+
+    return count;
+}
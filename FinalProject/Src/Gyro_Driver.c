@@ -10,8 +10,10 @@
 
 
 
-extern SPI_HandleTypeDef hspi5;
+static const SpiDevice_t gyro_spi_device = {CS_PORT, CS_PIN, GYRO_SPI_PRESCALER};
+static SpiTransaction_t stream_transaction; // A stream's transfers - one at a time
 static HAL_StatusTypeDef HAL_Status;
+static uint32_t fifo_overruns; // Drains that found the FIFO full - samples were lost
 
 
 /**
@@ -19,42 +21,37 @@ static HAL_StatusTypeDef HAL_Status;
   * @retval None
   */
 void Gyro_Init(){
+	SPI_Bus_Init();
 	Gyro_Power_On();
-	osDelay(100);
+	osDelay(GYRO_POWER_ON_TIME);
 	Gyro_Config_Regs();
 	Gyro_Reboot();
 
 
 }
 
+/**
+  * @brief Initialise the gyro to queue samples in its FIFO, to be drained with Gyro_Read_FIFO
+  * @param data_rate - GYRO_ODR_ output data rate
+  * @param bandwidth - GYRO_BANDWIDTH() low pass cut-off
+  * @param axes - GYRO_X_AXIS, GYRO_Y_AXIS and GYRO_Z_AXIS to enable
+  * @retval None
+  */
+void Gyro_Init_FIFO(uint8_t data_rate, uint8_t bandwidth, uint8_t axes){
+	SPI_Bus_Init();
+	Gyro_Power_On();
+	osDelay(GYRO_POWER_ON_TIME);
+	Gyro_Config_FIFO(data_rate, bandwidth, axes);
+}
+
 /**
   * @brief Power on the Gyro
   * @retval None
   */
 
 void Gyro_Power_On(){
-	//get data from register
-	uint8_t cmd = (GYRO_READ | CTRL_REG1);
-	uint8_t rx_buff = 0;
-	Gyro_Slave_Enable();
-	while(HAL_GPIO_ReadPin(CS_PORT, CS_PIN) != GPIO_PIN_RESET);
-	Gyro_Transmit_Data(&cmd);
-	Gyro_Receive_Data(&rx_buff);
-	Gyro_Slave_Disable();
-	cmd = (GYRO_WRITE | CTRL_REG1);
-	uint8_t tx_buff = (rx_buff | (1 << 3));
-	Gyro_Slave_Enable();
-	while(HAL_GPIO_ReadPin(CS_PORT, CS_PIN) != GPIO_PIN_RESET);
-	Gyro_Transmit_Data(&cmd);
-	Gyro_Transmit_Data(&tx_buff);
-	Gyro_Slave_Disable();
-
-
-	if(HAL_Status != HAL_OK)
-	{
-		while(1);
-	}
-	}
+	Gyro_Write_Reg(CTRL_REG1, Gyro_Read_Reg(CTRL_REG1) | GYRO_POWER_ON);
+}
 
 
 /**
@@ -63,21 +60,7 @@ void Gyro_Power_On(){
   */
 
 void Gyro_Reboot(){
-	uint8_t cmd = (GYRO_READ | CTRL_REG5);
-	uint8_t rx_buff = 0;
-	Gyro_Slave_Enable();
-	while(HAL_GPIO_ReadPin(CS_PORT, CS_PIN) != GPIO_PIN_RESET);
-	Gyro_Transmit_Data(&cmd);
-	Gyro_Receive_Data(&rx_buff);
-	Gyro_Slave_Disable();
-	cmd = (GYRO_WRITE | CTRL_REG5);
-	uint8_t tx_buff = (rx_buff | (1 << 7));
-	Gyro_Slave_Enable();
-	while(HAL_GPIO_ReadPin(CS_PORT, CS_PIN) != GPIO_PIN_RESET);
-	Gyro_Transmit_Data(&cmd);
-	Gyro_Transmit_Data(&tx_buff);
-	Gyro_Slave_Disable();
-
+	Gyro_Write_Reg(CTRL_REG5, Gyro_Read_Reg(CTRL_REG5) | (1 << 7));
 }
 
 /**
@@ -86,23 +69,12 @@ void Gyro_Reboot(){
   */
 
 int16_t Gyro_Get_Velocity_Y(){
-	int16_t yval = 0;
-
-	uint8_t cmd = (GYRO_READ| MS_BIT | OUT_Y_L);
-	uint8_t rxbuff_yl = 0;
-	uint8_t rxbuff_yh = 0;
+	uint8_t tx_buff[3] = {(GYRO_READ | MS_BIT | OUT_Y_L), 0, 0};
+	uint8_t rx_buff[3] = {0};
 
-	Gyro_Slave_Enable();
-	while(HAL_GPIO_ReadPin(CS_PORT, CS_PIN) != GPIO_PIN_RESET);
-	Gyro_Transmit_Data(&cmd);
-	Gyro_Receive_Data(&rxbuff_yl);
-	Gyro_Receive_Data(&rxbuff_yh);
-	Gyro_Slave_Disable();
+	Gyro_Transfer(tx_buff, rx_buff, sizeof(rx_buff));
 
-
-	yval = (int16_t) ((rxbuff_yh << 8) | rxbuff_yl);
-
-	return yval;
+	return (int16_t) ((rx_buff[2] << 8) | rx_buff[1]);
 }
 
 /**
@@ -111,23 +83,12 @@ int16_t Gyro_Get_Velocity_Y(){
   */
 
 int16_t Gyro_Get_Velocity_X(){
-	int16_t xval = 0;
-
-	uint8_t cmd = (GYRO_READ| MS_BIT | OUT_X_L);
-	uint8_t rxbuff_xl = 0;
-	uint8_t rxbuff_xh = 0;
-
-	Gyro_Slave_Enable();
-	while(HAL_GPIO_ReadPin(CS_PORT, CS_PIN) != GPIO_PIN_RESET);
-	Gyro_Transmit_Data(&cmd);
-	Gyro_Receive_Data(&rxbuff_xl);
-	Gyro_Receive_Data(&rxbuff_xh);
-	Gyro_Slave_Disable();
+	uint8_t tx_buff[3] = {(GYRO_READ | MS_BIT | OUT_X_L), 0, 0};
+	uint8_t rx_buff[3] = {0};
 
+	Gyro_Transfer(tx_buff, rx_buff, sizeof(rx_buff));
 
-	xval = (int16_t) ((rxbuff_xh << 8) | rxbuff_xl);
-
-	return xval;
+	return (int16_t) ((rx_buff[2] << 8) | rx_buff[1]);
 }
 
 /**
@@ -135,100 +96,207 @@ int16_t Gyro_Get_Velocity_X(){
   * @retval None
   */
 void Gyro_Config_Regs(){
+	Gyro_Write_Reg(CTRL_REG1, 0x1A); // 0001 1010 - Gyro Data rate is 100hz, gyro enabled on y-axis only
+	Gyro_Write_Reg(CTRL_REG4, 0x10); // 0001 0000 - Full scale rate of 500dps
+	Gyro_Write_Reg(CTRL_REG5, 0xC0); // 1100 0000 - Reboot initially and enable FIFO
+	Gyro_Write_Reg(FIFO_CTRL_REG, 0x00); // FIFO in bypass mode
+}
 
-	//CR1
-	uint8_t addr_cmd = (GYRO_WRITE | CTRL_REG1);
-	uint8_t reg_cmd = 0x1A; // 0001 1010 - Gyro Data rate is 100hz, gyro enabled on y-axis only
-	Gyro_Slave_Enable();
-	while(HAL_GPIO_ReadPin(CS_PORT, CS_PIN) != GPIO_PIN_RESET);
-	Gyro_Transmit_Data(&addr_cmd);
-	Gyro_Transmit_Data(&reg_cmd);
-	Gyro_Slave_Disable();
-
+/**
+  * @brief Configure the gyro's data rate, bandwidth and axes, and put its FIFO in stream mode - it keeps
+  *        the latest GYRO_FIFO_DEPTH samples, overwriting the oldest when it isn't drained in time
+  * @param data_rate - GYRO_ODR_ output data rate
+  * @param bandwidth - GYRO_BANDWIDTH() low pass cut-off
+  * @param axes - GYRO_X_AXIS, GYRO_Y_AXIS and GYRO_Z_AXIS to enable
+  * @retval None
+  */
+void Gyro_Config_FIFO(uint8_t data_rate, uint8_t bandwidth, uint8_t axes){
 
+	Gyro_Write_Reg(CTRL_REG1, data_rate | bandwidth | GYRO_POWER_ON | axes);
+	Gyro_Write_Reg(CTRL_REG4, 0x10); //0001 0000 - Full scale rate of 500dps
+	Gyro_Write_Reg(CTRL_REG5, GYRO_FIFO_ENABLE);
+	Gyro_Write_Reg(FIFO_CTRL_REG, GYRO_FIFO_STREAM_MODE);
+}
 
+/**
+  * @brief Drain the samples queued in the gyro's FIFO, oldest first. Reads the FIFO level, then every
+  *        sample in one auto-increment burst - with the FIFO enabled the address rolls back from OUT_Z_H
+  *        to OUT_X_L, so each 6 bytes read pop the next XYZ sample.
+  * @param samples - filled with the samples read
+  * @param max_samples - room in samples, at most GYRO_FIFO_DEPTH
+  * @retval Number of samples read
+  */
+uint8_t Gyro_Read_FIFO(GyroSample_t *samples, uint8_t max_samples){
+	uint8_t rx_buff[GYRO_FIFO_DEPTH * GYRO_SAMPLE_SIZE];
+	uint8_t cmd = (GYRO_READ | MS_BIT | OUT_X_L);
+	bool overrun;
+	uint8_t count = GYRO_STREAM_fifo_level(Gyro_Read_Reg(FIFO_SRC_REG), &overrun);
 
-	//CR4
-	addr_cmd = (GYRO_WRITE | CTRL_REG4);
-	reg_cmd = 0x10; //0001 0000 - Full scale rate of 500dps
-	Gyro_Slave_Enable();
-	while(HAL_GPIO_ReadPin(CS_PORT, CS_PIN) != GPIO_PIN_RESET);
-	Gyro_Transmit_Data(&addr_cmd);
-	Gyro_Transmit_Data(&reg_cmd);
-	Gyro_Slave_Disable();
+	fifo_overruns += overrun;
 
+	if(count == 0){
+		return 0;
+	}
 
-	//CR5
-	addr_cmd = (GYRO_WRITE | CTRL_REG5);
-	reg_cmd = 0xC0; //1100 0000 - Reboot initially and enable FIFO
-	Gyro_Slave_Enable();
-	while(HAL_GPIO_ReadPin(CS_PORT, CS_PIN) != GPIO_PIN_RESET);
-	Gyro_Transmit_Data(&addr_cmd);
-	Gyro_Transmit_Data(&reg_cmd);
-	Gyro_Slave_Disable();
+	if(count > max_samples){
+		count = max_samples;
+	}
 
+	//Command and burst under one chip select
+	SPI_BUS_acquire(&spi5_bus, &gyro_spi_device);
+	HAL_Status = SPI_BUS_exchange(&spi5_bus, &cmd, NULL, 1) &&
+	             SPI_BUS_exchange(&spi5_bus, NULL, rx_buff, count * GYRO_SAMPLE_SIZE) ? HAL_OK : HAL_ERROR;
+	SPI_BUS_release(&spi5_bus);
+	Gyro_HAL_Check();
 
-	//FIFO_CTRL
-	addr_cmd = (GYRO_WRITE | FIFO_CTRL_REG);
-	reg_cmd = 0x00; //0100 0000 FIFO in stream mode
-	Gyro_Slave_Enable();
-	while(HAL_GPIO_ReadPin(CS_PORT, CS_PIN) != GPIO_PIN_RESET);
-	Gyro_Transmit_Data(&addr_cmd);
-	Gyro_Transmit_Data(&reg_cmd);
-	Gyro_Slave_Disable();
+	GYRO_STREAM_decode(rx_buff, samples, count);
 
+	return count;
+}
 
+/**
+  * @brief Queue a stream's transfer on the shared SPI5 bus
+  * @retval true if the transfer was queued
+  */
+static bool Gyro_Stream_Start_Transfer(void *context, const uint8_t *tx, uint8_t *rx, uint16_t size){
+	(void) &context;
 
+	stream_transaction.tx = tx;
+	stream_transaction.rx = rx;
+	stream_transaction.size = size;
 
+	return SPI_BUS_submit(&spi5_bus, &stream_transaction);
 }
 
 /**
-  * @brief Check the status of the HAL
+  * @brief A stream's transfer on the bus has finished - pass it on to the stream
   * @retval None
   */
-void Gyro_HAL_Check(){
-	if(HAL_Status != HAL_OK){
-		while(1);
+static void Gyro_Stream_Transfer_Done(void *context, bool ok){
+	if(ok){
+		GYRO_STREAM_on_transfer_complete(context);
+	}
+	else{
+		GYRO_STREAM_on_transfer_error(context);
 	}
 }
 
 /**
-  * @brief Enable the Chip Select pin
+  * @brief Chip select for a stream - nothing to do, the bus selects the gyro for each queued transfer
   * @retval None
   */
-void Gyro_Slave_Enable(){
-	HAL_GPIO_WritePin(CS_PORT,CS_PIN,GPIO_PIN_RESET);
+static void Gyro_Stream_Chip_Select(void *context, bool selected){
+	(void) &context;
+	(void) &selected;
+}
+
+/**
+  * @brief Check if the watermark interrupt line is still high for a stream
+  * @retval true if the FIFO is at or above the watermark
+  */
+static bool Gyro_Stream_Watermark_Pending(void *context){
+	(void) &context;
+
+	return HAL_GPIO_ReadPin(INT2_PORT, INT2_PIN) == GPIO_PIN_SET;
 }
 
 /**
-  * @brief Disable the Chip Select pin
+  * @brief Read the gyro's FIFO in the background - the watermark interrupt on INT2 starts DMA transfers on
+  *        SPI5 and notify is called from the transfer complete interrupt once new samples are in the stream.
+  *        Call after Gyro_Init_FIFO. EXTI2_IRQHandler must pass its interrupt on to the stream.
+  * @param stream - stream to set up
+  * @param watermark - FIFO level in samples that raises the interrupt, 1 to GYRO_FIFO_DEPTH - 1
+  * @param notify - called from the interrupt when samples can be taken
+  * @param context - passed to notify
   * @retval None
   */
-void Gyro_Slave_Disable(){
-	HAL_GPIO_WritePin(CS_PORT,CS_PIN,GPIO_PIN_SET);
+void Gyro_Init_Stream(GyroStream_t *stream, uint8_t watermark, void (*notify)(void *context), void *context){
+	GyroStreamPort_t port = {
+		.start_transfer = Gyro_Stream_Start_Transfer,
+		.chip_select = Gyro_Stream_Chip_Select,
+		.watermark_pending = Gyro_Stream_Watermark_Pending,
+		.notify = notify,
+		.context = context
+	};
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	GYRO_STREAM_init(stream, &port);
+
+	stream_transaction.device = &gyro_spi_device;
+	stream_transaction.done = Gyro_Stream_Transfer_Done;
+	stream_transaction.context = stream;
+
+	//Watermark on INT2
+	Gyro_Write_Reg(FIFO_CTRL_REG, GYRO_FIFO_STREAM_MODE | (watermark & GYRO_FIFO_WATERMARK_MASK));
+	Gyro_Write_Reg(CTRL_REG3, GYRO_INT2_WATERMARK);
+
+	GPIO_InitStruct.Pin = INT2_PIN;
+	GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	HAL_GPIO_Init(INT2_PORT, &GPIO_InitStruct);
+
+	HAL_NVIC_SetPriority(INT2_IRQ_NUMBER, SPI_BUS_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(INT2_IRQ_NUMBER);
+
+	//The FIFO may already be past the watermark - its edge has been missed
+	if(Gyro_Stream_Watermark_Pending(context)){
+		GYRO_STREAM_on_watermark(stream);
+	}
 }
 
+/**
+  * @brief Number of FIFO drains that found the FIFO overrun since power on
+  * @retval Overrun count
+  */
+uint32_t Gyro_Get_FIFO_Overruns(){
+	return fifo_overruns;
+}
 
 /**
-  * @brief Recieve one bit of data from the Gyro
-  * @param rx_buff- pointer to a data buffer, recieved data will appear here
-  * @retval None
+  * @brief Read one register of the gyro
+  * @param reg - register address
+  * @retval Register value
   */
-void Gyro_Receive_Data(uint8_t *rx_buff){
+uint8_t Gyro_Read_Reg(uint8_t reg){
+	uint8_t tx_buff[2] = {(GYRO_READ | reg), 0};
+	uint8_t rx_buff[2] = {0};
 
-	HAL_Status = HAL_SPI_Receive(&hspi5, rx_buff, 1, TIMEOUT);
-	Gyro_HAL_Check();
+	Gyro_Transfer(tx_buff, rx_buff, sizeof(rx_buff));
 
+	return rx_buff[1];
 }
 
 /**
-  * @brief Send one bit of data to the Gyro
-  * @param tx_buff- pointer to a data buffer.
+  * @brief Write one register of the gyro
+  * @param reg - register address
+  * @param value - value to write
   * @retval None
   */
-void Gyro_Transmit_Data(uint8_t *tx_buff){
+void Gyro_Write_Reg(uint8_t reg, uint8_t value){
+	uint8_t tx_buff[2] = {(GYRO_WRITE | reg), value};
 
-	HAL_Status = HAL_SPI_Transmit(&hspi5,tx_buff, 1, TIMEOUT);
+	Gyro_Transfer(tx_buff, NULL, sizeof(tx_buff));
+}
+
+/**
+  * @brief One transaction with the gyro on the shared SPI5 bus - chip select stays low for all of it
+  * @param tx_buff - bytes to send
+  * @param rx_buff - filled with the bytes received, NULL to drop them
+  * @param size - number of bytes
+  * @retval None
+  */
+void Gyro_Transfer(const uint8_t *tx_buff, uint8_t *rx_buff, uint16_t size){
+
+	HAL_Status = SPI_BUS_transfer(&spi5_bus, &gyro_spi_device, tx_buff, rx_buff, size) ? HAL_OK : HAL_ERROR;
 	Gyro_HAL_Check();
 }
 
+/**
+  * @brief Check the status of the HAL
+  * @retval None
+  */
+void Gyro_HAL_Check(){
+	if(HAL_Status != HAL_OK){
+		while(1);
+	}
+}
@@ -15,16 +15,14 @@ static RCC_PeriphCLKInitTypeDef  PeriphClkInitStruct;
 static FONT_t *LCD_Currentfonts;
 static uint16_t CurrentTextColor   = 0xFFFF;
 
-static SPI_HandleTypeDef SpiHandle;
-uint32_t SpiTimeout = SPI_TIMEOUT_MAX; /*<! Value of Timeout when SPI communication fails */
+/* LCD on the SPI5 bus it shares with the gyro - selected with NCS */
+static const SpiDevice_t lcd_spi_device = {LCD_NCS_GPIO_PORT, LCD_NCS_PIN, LCD_SPI_PRESCALER};
 
 //Someone from STM said it was "often accessed" a 1-dim array, and not a 2d array. However you still access it like a 2dim array,  using fb[y*W+x] instead of fb[y][x].
 uint16_t frameBuffer[LCD_PIXEL_WIDTH*LCD_PIXEL_HEIGHT] = {0};			//16bpp pixel format.
 
 //static void MX_LTDC_Init(void);
 //static void MX_SPI5_Init(void);
-static void SPI_MspInit(SPI_HandleTypeDef *hspi);
-static void SPI_Error(void);
 
 /* Provided Functions and API  - MOTIFY ONLY WITH EXTREME CAUTION!!! */
 
@@ -410,137 +408,73 @@ void QuickDemo(void)
 /* Lower Level Functions for LTCD. 	MOTIFY ONLY WITH EXTREME CAUTION!!  */
 static uint8_t Is_LCD_IO_Initialized = 0;
 
+/* ILI9341 power on sequence - command, parameter count, parameters. A count with ILI9341_INIT_DELAY set is
+   followed by a wait in ms after the parameters. Ends with ILI9341_INIT_END. */
+#define ILI9341_INIT_DELAY 0x80
+#define ILI9341_INIT_END   0x00 /* NOP - never part of the sequence */
+
+static const uint8_t ili9341_init_sequence[] = {
+  0xCA,              3,  0xC3, 0x08, 0x50,
+  LCD_POWERB,        3,  0x00, 0xC1, 0x30,
+  LCD_POWER_SEQ,     4,  0x64, 0x03, 0x12, 0x81,
+  LCD_DTCA,          3,  0x85, 0x00, 0x78,
+  LCD_POWERA,        5,  0x39, 0x2C, 0x00, 0x34, 0x02,
+  LCD_PRC,           1,  0x20,
+  LCD_DTCB,          2,  0x00, 0x00,
+  LCD_FRMCTR1,       2,  0x00, 0x1B,
+  LCD_DFC,           2,  0x0A, 0xA2,
+  LCD_POWER1,        1,  0x10,
+  LCD_POWER2,        1,  0x10,
+  LCD_VCOM1,         2,  0x45, 0x15,
+  LCD_VCOM2,         1,  0x90,
+  LCD_MAC,           1,  0xC8,
+  LCD_3GAMMA_EN,     1,  0x00,
+  LCD_RGB_INTERFACE, 1,  0xC2,
+  LCD_DFC,           4,  0x0A, 0xA7, 0x27, 0x04,
+  LCD_COLUMN_ADDR,   4,  0x00, 0x00, 0x00, 0xEF, /* Colomn address set */
+  LCD_PAGE_ADDR,     4,  0x00, 0x00, 0x01, 0x3F, /* Page address set */
+  LCD_INTERFACE,     3,  0x01, 0x00, 0x06,
+  LCD_GRAM,          0,
+  LCD_GAMMA,         1,  0x01,
+  LCD_PGAMMA,        15, 0x0F, 0x29, 0x24, 0x0C, 0x0E, 0x09, 0x4E, 0x78, 0x3C, 0x09, 0x13, 0x05, 0x17, 0x11, 0x00,
+  LCD_NGAMMA,        15, 0x00, 0x16, 0x1B, 0x04, 0x11, 0x07, 0x31, 0x33, 0x42, 0x05, 0x0C, 0x0A, 0x28, 0x2F, 0x0F,
+  LCD_SLEEP_OUT,     0 | ILI9341_INIT_DELAY, 120, /* The panel takes 120 ms to come out of sleep */
+  LCD_DISPLAY_ON,    0,
+  LCD_GRAM,          0,  /* GRAM start writing */
+  ILI9341_INIT_END
+};
+
 
 
 
 /**
-  * @brief  Power on the LCD.
+  * @brief  Power on the LCD - streams ili9341_init_sequence to the panel. Waits with LCD_Delay, so it must
+  *         run in a task once the kernel has started.
   * @param  None
   * @retval None
   */
 void ili9341_Init(void)
 {
+  const uint8_t *entry = ili9341_init_sequence;
+
   /* Initialize ILI9341 low level bus layer ----------------------------------*/
   LCD_IO_Init();
 
-  /* Configure LCD */
-  ili9341_Write_Reg(0xCA);
-  ili9341_Send_Data(0xC3);				//param 1
-  ili9341_Send_Data(0x08);				//param 2
-  ili9341_Send_Data(0x50);				//param 3
-  ili9341_Write_Reg(LCD_POWERB); //CF
-  ili9341_Send_Data(0x00);				//param 1
-  ili9341_Send_Data(0xC1);				//param 2
-  ili9341_Send_Data(0x30);				//param 3
-  ili9341_Write_Reg(LCD_POWER_SEQ); //ED
-  ili9341_Send_Data(0x64);
-  ili9341_Send_Data(0x03);
-  ili9341_Send_Data(0x12);
-  ili9341_Send_Data(0x81);
-  ili9341_Write_Reg(LCD_DTCA);
-  ili9341_Send_Data(0x85);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0x78);
-  ili9341_Write_Reg(LCD_POWERA);
-  ili9341_Send_Data(0x39);
-  ili9341_Send_Data(0x2C);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0x34);
-  ili9341_Send_Data(0x02);
-  ili9341_Write_Reg(LCD_PRC);
-  ili9341_Send_Data(0x20);
-  ili9341_Write_Reg(LCD_DTCB);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0x00);
-  ili9341_Write_Reg(LCD_FRMCTR1);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0x1B);
-  ili9341_Write_Reg(LCD_DFC);
-  ili9341_Send_Data(0x0A);
-  ili9341_Send_Data(0xA2);
-  ili9341_Write_Reg(LCD_POWER1);
-  ili9341_Send_Data(0x10);
-  ili9341_Write_Reg(LCD_POWER2);
-  ili9341_Send_Data(0x10);
-  ili9341_Write_Reg(LCD_VCOM1);
-  ili9341_Send_Data(0x45);
-  ili9341_Send_Data(0x15);
-  ili9341_Write_Reg(LCD_VCOM2);
-  ili9341_Send_Data(0x90);
-  ili9341_Write_Reg(LCD_MAC);
-  ili9341_Send_Data(0xC8);
-  ili9341_Write_Reg(LCD_3GAMMA_EN);
-  ili9341_Send_Data(0x00);
-  ili9341_Write_Reg(LCD_RGB_INTERFACE);
-  ili9341_Send_Data(0xC2);
-  ili9341_Write_Reg(LCD_DFC);
-  ili9341_Send_Data(0x0A);
-  ili9341_Send_Data(0xA7);
-  ili9341_Send_Data(0x27);
-  ili9341_Send_Data(0x04);
-
-  /* Colomn address set */
-  ili9341_Write_Reg(LCD_COLUMN_ADDR);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0xEF);
-
-  /* Page address set */
-  ili9341_Write_Reg(LCD_PAGE_ADDR);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0x01);
-  ili9341_Send_Data(0x3F);
-  ili9341_Write_Reg(LCD_INTERFACE);
-  ili9341_Send_Data(0x01);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0x06);
-
-  ili9341_Write_Reg(LCD_GRAM);
-  LCD_Delay(200);
-
-  ili9341_Write_Reg(LCD_GAMMA);
-  ili9341_Send_Data(0x01);
-
-  ili9341_Write_Reg(LCD_PGAMMA);
-  ili9341_Send_Data(0x0F);
-  ili9341_Send_Data(0x29);
-  ili9341_Send_Data(0x24);
-  ili9341_Send_Data(0x0C);
-  ili9341_Send_Data(0x0E);
-  ili9341_Send_Data(0x09);
-  ili9341_Send_Data(0x4E);
-  ili9341_Send_Data(0x78);
-  ili9341_Send_Data(0x3C);
-  ili9341_Send_Data(0x09);
-  ili9341_Send_Data(0x13);
-  ili9341_Send_Data(0x05);
-  ili9341_Send_Data(0x17);
-  ili9341_Send_Data(0x11);
-  ili9341_Send_Data(0x00);
-  ili9341_Write_Reg(LCD_NGAMMA);
-  ili9341_Send_Data(0x00);
-  ili9341_Send_Data(0x16);
-  ili9341_Send_Data(0x1B);
-  ili9341_Send_Data(0x04);
-  ili9341_Send_Data(0x11);
-  ili9341_Send_Data(0x07);
-  ili9341_Send_Data(0x31);
-  ili9341_Send_Data(0x33);
-  ili9341_Send_Data(0x42);
-  ili9341_Send_Data(0x05);
-  ili9341_Send_Data(0x0C);
-  ili9341_Send_Data(0x0A);
-  ili9341_Send_Data(0x28);
-  ili9341_Send_Data(0x2F);
-  ili9341_Send_Data(0x0F);
-
-  ili9341_Write_Reg(LCD_SLEEP_OUT);
-  LCD_Delay(200);
-  ili9341_Write_Reg(LCD_DISPLAY_ON);
-  /* GRAM start writing */
-  ili9341_Write_Reg(LCD_GRAM);
+  /* Configure LCD - each command goes out with its parameters in one transfer */
+  while(entry[0] != ILI9341_INIT_END)
+  {
+    uint8_t count = entry[1] & ~ILI9341_INIT_DELAY;
+
+    LCD_IO_WriteCommand(entry[0], &entry[2], count);
+
+    if(entry[1] & ILI9341_INIT_DELAY)
+    {
+      LCD_Delay(entry[2 + count]);
+      entry ++;
+    }
+
+    entry += 2 + count;
+  }
 }
 
 
@@ -599,120 +533,6 @@ uint32_t ili9341_ReadData(uint16_t RegValue, uint8_t ReadSize)
 }
 
 
-/******************************* SPI Routines *********************************/
-
-/**
-  * @brief  SPI Bus initialization
-  */
-static void SPI_Init(void)
-{
-  if(HAL_SPI_GetState(&SpiHandle) == HAL_SPI_STATE_RESET)
-  {
-    /* SPI configuration -----------------------------------------------------*/
-    SpiHandle.Instance = DISCOVERY_SPI;
-    /* SPI baudrate is set to 5.6 MHz (PCLK2/SPI_BaudRatePrescaler = 90/16 = 5.625 MHz)
-       to verify these constraints:
-       - ILI9341 LCD SPI interface max baudrate is 10MHz for write and 6.66MHz for read
-       - l3gd20 SPI interface max baudrate is 10MHz for write/read
-       - PCLK2 frequency is set to 90 MHz
-    */
-    SpiHandle.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
-
-    /* On STM32F429I-Discovery, LCD ID cannot be read then keep a common configuration */
-    /* for LCD and GYRO (SPI_DIRECTION_2LINES) */
-    /* Note: To read a register a LCD, SPI_DIRECTION_1LINE should be set */
-    SpiHandle.Init.Direction      = SPI_DIRECTION_2LINES;
-    SpiHandle.Init.CLKPhase       = SPI_PHASE_1EDGE;
-    SpiHandle.Init.CLKPolarity    = SPI_POLARITY_LOW;
-    SpiHandle.Init.CRCCalculation = SPI_CRCCALCULATION_DISABLED;
-    SpiHandle.Init.CRCPolynomial  = 7;
-    SpiHandle.Init.DataSize       = SPI_DATASIZE_8BIT;
-    SpiHandle.Init.FirstBit       = SPI_FIRSTBIT_MSB;
-    SpiHandle.Init.NSS            = SPI_NSS_SOFT;
-    SpiHandle.Init.TIMode         = SPI_TIMODE_DISABLED;
-    SpiHandle.Init.Mode           = SPI_MODE_MASTER;
-
-    SPI_MspInit(&SpiHandle);
-    HAL_SPI_Init(&SpiHandle);
-  }
-}
-
-/**
-  * @brief  Reads 4 bytes from device.
-  * @param  ReadSize: Number of bytes to read (max 4 bytes)
-  * @retval Value read on the SPI
-  */
-static uint32_t SPI_Read(uint8_t ReadSize)
-{
-  HAL_StatusTypeDef status = HAL_OK;
-  uint32_t readvalue;
-
-  status = HAL_SPI_Receive(&SpiHandle, (uint8_t*) &readvalue, ReadSize, SpiTimeout);
-
-  /* Check the communication status */
-  if(status != HAL_OK)
-  {
-    /* Re-Initialize the BUS */
-    SPI_Error();
-  }
-
-  return readvalue;
-}
-
-/**
-  * @brief  Writes a byte to device.
-  * @param  Value: value to be written
-  */
-static void SPI_Write(uint16_t Value)
-{
-  HAL_StatusTypeDef status = HAL_OK;
-
-  status = HAL_SPI_Transmit(&SpiHandle, (uint8_t*) &Value, 1, SpiTimeout);
-
-  /* Check the communication status */
-  if(status != HAL_OK)
-  {
-    /* Re-Initialize the BUS */
-    SPI_Error();
-  }
-}
-
-
-/**
-  * @brief  SPI error treatment function.
-  */
-static void SPI_Error(void)
-{
-  /* De-initialize the SPI communication BUS */
-  HAL_SPI_DeInit(&SpiHandle);
-
-  /* Re- Initialize the SPI communication BUS */
-  SPI_Init();
-}
-
-/**
-  * @brief  SPI MSP Init.
-  * @param  hspi: SPI handle
-  */
-static void SPI_MspInit(SPI_HandleTypeDef *hspi)
-{
-  GPIO_InitTypeDef   GPIO_InitStructure;
-
-  /* Enable SPI clock */
-  DISCOVERY_SPI_CLK_ENABLE();
-
-  /* Enable DISCOVERY_SPI GPIO clock */
-  DISCOVERY_SPI_GPIO_CLK_ENABLE();
-
-  /* configure SPI SCK, MOSI and MISO */
-  GPIO_InitStructure.Pin    = (DISCOVERY_SPI_SCK_PIN | DISCOVERY_SPI_MOSI_PIN | DISCOVERY_SPI_MISO_PIN);
-  GPIO_InitStructure.Mode   = GPIO_MODE_AF_PP;
-  GPIO_InitStructure.Pull   = GPIO_PULLDOWN;
-  GPIO_InitStructure.Speed  = GPIO_SPEED_MEDIUM;
-  GPIO_InitStructure.Alternate = DISCOVERY_SPI_AF;
-  HAL_GPIO_Init(DISCOVERY_SPI_GPIO_PORT, &GPIO_InitStructure);
-}
-
 /********************************* LINK LCD ***********************************/
 
 /**
@@ -755,7 +575,7 @@ void LCD_IO_Init(void)
     LCD_CS_LOW();
     LCD_CS_HIGH();
 
-    SPI_Init();
+    SPI_Bus_Init();
   }
 }
 
@@ -764,15 +584,26 @@ void LCD_IO_Init(void)
   */
 void LCD_IO_WriteData(uint16_t RegValue)
 {
+  uint8_t data = (uint8_t) RegValue;
+
+  LCD_IO_WriteMultipleData(&data, 1);
+}
+
+/**
+  * @brief  Writes a run of data bytes with the bus and chip select held throughout - send a command's
+  *         parameters or pixels this way rather than a byte at a time.
+  * @param  data: Bytes to write
+  * @param  count: Number of bytes
+  */
+void LCD_IO_WriteMultipleData(const uint8_t *data, uint16_t count)
+{
+  SPI_BUS_acquire(&spi5_bus, &lcd_spi_device);
+
   /* Set WRX to send data */
   LCD_WRX_HIGH();
+  SPI_BUS_exchange(&spi5_bus, data, NULL, count);
 
-  /* Reset LCD control line(/CS) and Send data */
-  LCD_CS_LOW();
-  SPI_Write(RegValue);
-
-  /* Deselect: Chip Select high */
-  LCD_CS_HIGH();
+  SPI_BUS_release(&spi5_bus);
 }
 
 /**
@@ -780,42 +611,58 @@ void LCD_IO_WriteData(uint16_t RegValue)
   */
 void LCD_IO_WriteReg(uint8_t Reg)
 {
+  LCD_IO_WriteCommand(Reg, NULL, 0);
+}
+
+/**
+  * @brief  Writes a command and its parameters with chip select held low throughout.
+  * @param  Reg: Command
+  * @param  params: Parameter bytes
+  * @param  count: Number of parameter bytes, may be 0
+  */
+void LCD_IO_WriteCommand(uint8_t Reg, const uint8_t *params, uint16_t count)
+{
+  SPI_BUS_acquire(&spi5_bus, &lcd_spi_device);
+
   /* Reset WRX to send command */
   LCD_WRX_LOW();
+  SPI_BUS_exchange(&spi5_bus, &Reg, NULL, 1);
 
-  /* Reset LCD control line(/CS) and Send command */
-  LCD_CS_LOW();
-  SPI_Write(Reg);
+  if(count > 0)
+  {
+    /* Set WRX to send data */
+    LCD_WRX_HIGH();
+    SPI_BUS_exchange(&spi5_bus, params, NULL, count);
+  }
 
-  /* Deselect: Chip Select high */
-  LCD_CS_HIGH();
+  SPI_BUS_release(&spi5_bus);
 }
 
 /**
   * @brief  Reads register value.
   * @param  RegValue Address of the register to read
-  * @param  ReadSize Number of bytes to read
+  * @param  ReadSize Number of bytes to read (max 4 bytes)
   * @retval Content of the register value
   */
 uint32_t LCD_IO_ReadData(uint16_t RegValue, uint8_t ReadSize)
 {
+  uint8_t reg = (uint8_t) RegValue;
   uint32_t readvalue = 0;
 
-  /* Select: Chip Select low */
-  LCD_CS_LOW();
+  SPI_BUS_acquire(&spi5_bus, &lcd_spi_device);
 
   /* Reset WRX to send command */
   LCD_WRX_LOW();
 
-  SPI_Write(RegValue);
-
-  readvalue = SPI_Read(ReadSize);
+  if(SPI_BUS_exchange(&spi5_bus, &reg, NULL, 1))
+  {
+    SPI_BUS_exchange(&spi5_bus, NULL, (uint8_t*) &readvalue, ReadSize);
+  }
 
   /* Set WRX to send data */
   LCD_WRX_HIGH();
 
-  /* Deselect: Chip Select high */
-  LCD_CS_HIGH();
+  SPI_BUS_release(&spi5_bus);
 
   return readvalue;
 }
@@ -0,0 +1,134 @@
+/*
+ * LED_PWM_Driver.c
+ *
+ * HAL port for the status led PWM - TIM3 compare interrupts write the led pins.
+ */
+
+#include "LED_PWM_Driver.h"
+
+LedPwm_t led_pwm;
+
+/**
+  * @brief Set and reset led pins
+  */
+static void LED_PWM_Write(void *context, uint32_t bsrr)
+{
+    (void) &context;
+
+    LED_PWM_GPIO_PORT->BSRR = bsrr;
+}
+
+/**
+  * @brief Enable a channel's compare interrupt, first matching delay ticks from now
+  */
+static void LED_PWM_Start(void *context, uint8_t channel, uint16_t delay)
+{
+    (void) &context;
+    uint16_t compare = LED_PWM_TIMER->CNT + delay;
+
+    if(channel == LED_PWM_GREEN)
+    {
+        LED_PWM_TIMER->CCR1 = compare;
+        LED_PWM_TIMER->SR = ~TIM_SR_CC1IF;
+        LED_PWM_TIMER->DIER |= TIM_DIER_CC1IE;
+    }
+    else
+    {
+        LED_PWM_TIMER->CCR2 = compare;
+        LED_PWM_TIMER->SR = ~TIM_SR_CC2IF;
+        LED_PWM_TIMER->DIER |= TIM_DIER_CC2IE;
+    }
+}
+
+/**
+  * @brief Disable a channel's compare interrupt and drop a match that is already pending
+  */
+static void LED_PWM_Stop(void *context, uint8_t channel)
+{
+    (void) &context;
+    uint32_t flag = (channel == LED_PWM_GREEN) ? TIM_SR_CC1IF : TIM_SR_CC2IF;
+
+    LED_PWM_TIMER->DIER &= (channel == LED_PWM_GREEN) ? ~TIM_DIER_CC1IE : ~TIM_DIER_CC2IE;
+    LED_PWM_TIMER->SR = ~flag;
+}
+
+/**
+  * @brief Mask interrupts while a led's table changes
+  */
+static uint32_t LED_PWM_Lock(void *context)
+{
+    (void) &context;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    return primask;
+}
+
+/**
+  * @brief Restore interrupts masked by LED_PWM_Lock
+  */
+static void LED_PWM_Unlock(void *context, uint32_t state)
+{
+    (void) &context;
+
+    __set_PRIMASK(state);
+}
+
+/**
+  * @brief Start TIM3 free running at LED_PWM_TICK_HZ, both leds off
+  * @retval None
+  */
+void LED_PWM_Init(void)
+{
+    LedPwmPort_t port = {
+        .write = LED_PWM_Write,
+        .start = LED_PWM_Start,
+        .stop = LED_PWM_Stop,
+        .lock = LED_PWM_Lock,
+        .unlock = LED_PWM_Unlock,
+        .context = NULL
+    };
+    uint32_t clock = HAL_RCC_GetPCLK1Freq();
+
+    // APB1 timers run at twice the bus clock when it is divided down
+    if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+        clock *= 2;
+
+    __HAL_RCC_TIM3_CLK_ENABLE();
+
+    LED_PWM_TIMER->CR1 = 0;
+    LED_PWM_TIMER->DIER = 0;
+    LED_PWM_TIMER->PSC = (clock / LED_PWM_TICK_HZ) - 1;
+    LED_PWM_TIMER->ARR = 0xFFFF; // Compares are scheduled with 16 bit wrap around
+    LED_PWM_TIMER->EGR = TIM_EGR_UG; // Load the prescaler
+    LED_PWM_TIMER->SR = 0;
+
+    LED_PWM_init(&led_pwm, &port, LED_PWM_GREEN_PIN, LED_PWM_RED_PIN);
+
+    NVIC_SetPriority(LED_PWM_IRQ_NUMBER, LED_PWM_IRQ_PRIORITY);
+    NVIC_EnableIRQ(LED_PWM_IRQ_NUMBER);
+
+    LED_PWM_TIMER->CR1 = TIM_CR1_CEN;
+}
+
+/**
+  * @brief TIM3 interrupt handler - a led reached an edge
+  * @retval None
+  */
+void TIM3_IRQHandler(void)
+{
+    uint32_t status = LED_PWM_TIMER->SR & LED_PWM_TIMER->DIER;
+
+    if(status & TIM_SR_CC1IF)
+    {
+        LED_PWM_TIMER->SR = ~TIM_SR_CC1IF;
+        LED_PWM_TIMER->CCR1 = (uint16_t)(LED_PWM_TIMER->CCR1 + LED_PWM_on_compare(&led_pwm, LED_PWM_GREEN));
+    }
+
+    if(status & TIM_SR_CC2IF)
+    {
+        LED_PWM_TIMER->SR = ~TIM_SR_CC2IF;
+        LED_PWM_TIMER->CCR2 = (uint16_t)(LED_PWM_TIMER->CCR2 + LED_PWM_on_compare(&led_pwm, LED_PWM_RED));
+    }
+}
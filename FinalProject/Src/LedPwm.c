@@ -0,0 +1,130 @@
+/*
+ * LedPwm.c
+ *
+ * Edge scheduled software PWM for the status leds.
+ */
+
+#include "LedPwm.h"
+
+/**
+ * @brief Sets up both leds off, with no interrupts running
+ *
+ * @param LedPwm_t *pwm - pwm to set up
+ * @param const LedPwmPort_t *port - timer and GPIO
+ * @param uint16_t green_pin, red_pin - GPIO pin masks of the leds, on the same port
+ * @return void
+ */
+void LED_PWM_init(LedPwm_t *pwm, const LedPwmPort_t *port, uint16_t green_pin, uint16_t red_pin)
+{
+    const uint16_t pins[LED_PWM_CHANNELS] = {green_pin, red_pin};
+
+    pwm->port = *port;
+    pwm->wakeups = 0;
+
+    for(uint8_t i = 0; i < LED_PWM_CHANNELS; i ++)
+    {
+        LedPwmChannel_t *channel = &pwm->channels[i];
+
+        channel->ticks[0] = 0;
+        channel->ticks[1] = 1;
+        channel->bsrr[0] = pins[i];
+        channel->bsrr[1] = (uint32_t)pins[i] << 16;
+        channel->phase = 1;
+        channel->running = false;
+
+        pwm->port.write(pwm->port.context, channel->bsrr[1]);
+    }
+}
+
+/**
+ * @brief Sets a led's table. A running led picks up the new ticks at its next edge; one that was held on or off
+ *        starts a period now. Does nothing if the table hasn't changed.
+ *
+ * @param LedPwm_t *pwm - pwm the led is on
+ * @param uint8_t channel - LED_PWM_GREEN or LED_PWM_RED
+ * @param uint16_t on_ticks - ticks on each period, 0 to hold the led off
+ * @param uint16_t off_ticks - ticks off each period, 0 to hold the led on
+ * @return void
+ */
+void LED_PWM_set(LedPwm_t *pwm, uint8_t channel, uint16_t on_ticks, uint16_t off_ticks)
+{
+    LedPwmChannel_t *led = &pwm->channels[channel];
+
+    if(on_ticks == 0)
+        off_ticks = 1; // Held off however long the period was
+
+    if(led->ticks[0] == on_ticks && led->ticks[1] == off_ticks)
+        return;
+
+    uint32_t state = pwm->port.lock(pwm->port.context);
+
+    led->ticks[0] = on_ticks;
+    led->ticks[1] = off_ticks;
+
+    if(on_ticks == 0 || off_ticks == 0)
+    {
+        if(led->running)
+            pwm->port.stop(pwm->port.context, channel);
+
+        led->running = false;
+        led->phase = (on_ticks == 0);
+        pwm->port.write(pwm->port.context, led->bsrr[led->phase]);
+    }
+    else if(!led->running)
+    {
+        led->running = true;
+        led->phase = 0;
+        pwm->port.write(pwm->port.context, led->bsrr[0]);
+        pwm->port.start(pwm->port.context, channel, on_ticks);
+    }
+
+    pwm->port.unlock(pwm->port.context, state);
+}
+
+/**
+ * @brief Sets the green led's brightness
+ *
+ * @param LedPwm_t *pwm - pwm the led is on
+ * @param uint8_t level - 0 (off) to LED_PWM_GREEN_LEVELS (fully on)
+ * @return void
+ */
+void LED_PWM_set_level(LedPwm_t *pwm, uint8_t level)
+{
+    if(level > LED_PWM_GREEN_LEVELS)
+        level = LED_PWM_GREEN_LEVELS;
+
+    uint16_t on_ticks = (level * LED_PWM_GREEN_PERIOD) / LED_PWM_GREEN_LEVELS;
+
+    LED_PWM_set(pwm, LED_PWM_GREEN, on_ticks, LED_PWM_GREEN_PERIOD - on_ticks);
+}
+
+/**
+ * @brief Blinks the red led - on for the first half of each period, off for the rest
+ *
+ * @param LedPwm_t *pwm - pwm the led is on
+ * @param uint16_t period - ticks per blink, under 2 to turn the led off
+ * @return void
+ */
+void LED_PWM_set_blink(LedPwm_t *pwm, uint16_t period)
+{
+    LED_PWM_set(pwm, LED_PWM_RED, period / 2, period - (period / 2));
+}
+
+/**
+ * @brief Called from a channel's compare interrupt - moves the led to its next phase
+ *
+ * @param LedPwm_t *pwm - pwm the led is on
+ * @param uint8_t channel - channel whose compare matched
+ * @return uint16_t - ticks to the next compare
+ */
+uint16_t LED_PWM_on_compare(LedPwm_t *pwm, uint8_t channel)
+{
+    LedPwmChannel_t *led = &pwm->channels[channel];
+    uint8_t phase = led->phase ^ 1;
+
+    pwm->wakeups ++;
+    led->phase = phase;
+    pwm->port.write(pwm->port.context, led->bsrr[phase]);
+
+    return led->ticks[phase];
+}
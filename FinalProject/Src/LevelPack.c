@@ -0,0 +1,286 @@
+/*
+ * LevelPack.c
+ *
+ * Level pack index lookup and PackBits decompression into the level scratch arena.
+ */
+
+#include "LevelPack.h"
+
+static uint8_t level_pack_arena[LEVEL_PACK_ARENA_SIZE]; // Every level is decompressed here when started
+
+/**
+  * @brief Read a little endian 16 bit value from a byte stream
+  * @param const uint8_t *src - location of the value
+  * @retval uint16_t - decoded value
+  */
+static uint16_t LEVEL_PACK_read_u16(const uint8_t *src)
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+/**
+  * @brief Read a little endian 32 bit value from a byte stream
+  * @param const uint8_t *src - location of the value
+  * @retval uint32_t - decoded value
+  */
+static uint32_t LEVEL_PACK_read_u32(const uint8_t *src)
+{
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+/**
+  * @brief Check the header and every index entry of a pack
+  * @param const uint8_t *pack - start of the pack
+  * @param uint32_t size - size of the pack in bytes
+  * @retval bool - true if every level in the pack lies within the pack and fits the scratch arena
+  */
+bool LEVEL_PACK_is_valid(const uint8_t *pack, uint32_t size)
+{
+    if(size < LEVEL_PACK_HEADER_SIZE)
+        return false;
+
+    if(LEVEL_PACK_read_u32(pack) != LEVEL_PACK_MAGIC || pack[4] != LEVEL_PACK_VERSION)
+        return false;
+
+    uint16_t level_count = LEVEL_PACK_get_level_count(pack);
+
+    if(LEVEL_PACK_HEADER_SIZE + (uint32_t)level_count * LEVEL_PACK_INDEX_ENTRY_SIZE > size)
+        return false;
+
+    for(int i = 0; i < level_count; i ++)
+    {
+        const uint8_t *entry = pack + LEVEL_PACK_HEADER_SIZE + (i * LEVEL_PACK_INDEX_ENTRY_SIZE);
+
+        uint32_t offset = LEVEL_PACK_read_u32(entry);
+        uint16_t compressed_size = LEVEL_PACK_read_u16(entry + 4);
+        uint8_t cell_count = entry[6];
+        uint8_t num_waypoints = entry[7];
+
+        // Checked this way round so a huge offset can't wrap past the size
+        if(offset > size || compressed_size > size - offset)
+            return false;
+
+        if(cell_count == 0 || cell_count > LEVEL_PACK_MAX_CELL_COUNT || num_waypoints > LEVEL_PACK_MAX_WAYPOINTS)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+  * @brief Get the number of levels stored in a pack
+  * @param const uint8_t *pack - start of the pack
+  * @retval uint16_t - number of levels
+  */
+uint16_t LEVEL_PACK_get_level_count(const uint8_t *pack)
+{
+    return LEVEL_PACK_read_u16(pack + 6);
+}
+
+/**
+  * @brief Decompress a level into the scratch arena. The pack is assumed to have been checked with
+  *        LEVEL_PACK_is_valid.
+  * @param const uint8_t *pack - start of the pack
+  * @param uint16_t index - level to load
+  * @param LevelData_t *level - filled with the decoded level on success
+  * @retval bool - true if the level was decoded, false if the index or payload is bad
+  */
+bool LEVEL_PACK_load(const uint8_t *pack, uint16_t index, LevelData_t *level)
+{
+    if(index >= LEVEL_PACK_get_level_count(pack))
+        return false;
+
+    const uint8_t *entry = pack + LEVEL_PACK_HEADER_SIZE + (index * LEVEL_PACK_INDEX_ENTRY_SIZE);
+
+    uint32_t offset = LEVEL_PACK_read_u32(entry);
+    uint16_t compressed_size = LEVEL_PACK_read_u16(entry + 4);
+    uint8_t cell_count = entry[6];
+    uint8_t num_waypoints = entry[7];
+
+    uint32_t level_size = LEVEL_PACK_LEVEL_SIZE(cell_count, num_waypoints);
+    uint8_t *cells = level_pack_arena + level_size;
+
+    if(LEVEL_PACK_decode(pack + offset, compressed_size, level_pack_arena, level_size) != level_size)
+        return false;
+
+    LEVEL_PACK_payload_to_cells(level_pack_arena, cell_count, num_waypoints, cells);
+
+    level->cell_count = cell_count;
+    level->num_waypoints = num_waypoints;
+    level->cell_data = cells;
+    level->waypoint_cells = level_pack_arena + (LEVEL_PACK_PLANE_COUNT * LEVEL_PACK_PLANE_SIZE(cell_count));
+
+    return true;
+}
+
+/**
+  * @brief Split cell bytes into the wall/hole bitsets of a payload and append the waypoint list
+  * @param const uint8_t *cells - cell_count * cell_count cell bytes, row major
+  * @param uint8_t cell_count - number of cells in each row and column
+  * @param const uint8_t *waypoint_cells, uint8_t num_waypoints - (row, col) pairs in waypoint order
+  * @param uint8_t *payload - output, LEVEL_PACK_LEVEL_SIZE bytes
+  * @retval None
+  */
+void LEVEL_PACK_cells_to_payload(const uint8_t *cells, uint8_t cell_count, const uint8_t *waypoint_cells, uint8_t num_waypoints, uint8_t *payload)
+{
+    uint32_t num_cells = (uint32_t)cell_count * cell_count;
+    uint32_t plane_size = LEVEL_PACK_PLANE_SIZE(cell_count);
+
+    for(uint32_t i = 0; i < LEVEL_PACK_PLANE_COUNT * plane_size; i ++)
+        payload[i] = 0;
+
+    for(int plane = 0; plane < LEVEL_PACK_PLANE_COUNT; plane ++)
+    {
+        uint8_t *bits = payload + (plane * plane_size);
+
+        for(uint32_t i = 0; i < num_cells; i ++)
+        {
+            if(cells[i] & (1 << plane))
+                bits[i / 8] |= 1 << (i % 8);
+        }
+    }
+
+    for(int i = 0; i < 2 * num_waypoints; i ++)
+        payload[(LEVEL_PACK_PLANE_COUNT * plane_size) + i] = waypoint_cells[i];
+}
+
+/**
+  * @brief Expand the bitsets of a payload back into cell bytes and mark the waypoint cells
+  * @param const uint8_t *payload - decompressed payload
+  * @param uint8_t cell_count, uint8_t num_waypoints - level dimensions from the index entry
+  * @param uint8_t *cells - output, cell_count * cell_count cell bytes
+  * @retval None
+  */
+void LEVEL_PACK_payload_to_cells(const uint8_t *payload, uint8_t cell_count, uint8_t num_waypoints, uint8_t *cells)
+{
+    uint32_t num_cells = (uint32_t)cell_count * cell_count;
+    uint32_t plane_size = LEVEL_PACK_PLANE_SIZE(cell_count);
+
+    for(uint32_t i = 0; i < num_cells; i ++)
+        cells[i] = 0;
+
+    for(int plane = 0; plane < LEVEL_PACK_PLANE_COUNT; plane ++)
+    {
+        const uint8_t *bits = payload + (plane * plane_size);
+
+        for(uint32_t byte = 0; byte < plane_size; byte ++)
+        {
+            // Skip empty bytes - most of every bitset
+            if(bits[byte] == 0)
+                continue;
+
+            for(int bit = 0; bit < 8; bit ++)
+            {
+                if((bits[byte] & (1 << bit)) && (byte * 8) + bit < num_cells)
+                    cells[(byte * 8) + bit] |= 1 << plane;
+            }
+        }
+    }
+
+    const uint8_t *waypoint_cells = payload + (LEVEL_PACK_PLANE_COUNT * plane_size);
+
+    for(int i = 0; i < num_waypoints; i ++)
+    {
+        uint32_t cell = (waypoint_cells[2 * i] * cell_count) + waypoint_cells[(2 * i) + 1];
+
+        if(cell < num_cells)
+            cells[cell] = (cells[cell] & ~0x10) | 0x20; // A waypoint replaces any hole in its cell
+    }
+}
+
+/**
+  * @brief PackBits compress a buffer. A control byte n in 0..127 is followed by n + 1 literal bytes,
+  *        a control byte n in 129..255 is followed by one byte that is repeated 257 - n times.
+  * @param const uint8_t *src, uint32_t src_size - data to compress
+  * @param uint8_t *dst, uint32_t dst_size - output buffer
+  * @retval uint32_t - compressed size, 0 if the output buffer is too small
+  */
+uint32_t LEVEL_PACK_encode(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size)
+{
+    uint32_t in = 0;
+    uint32_t out = 0;
+
+    while(in < src_size)
+    {
+        // Measure the run starting at the current byte
+        uint32_t run = 1;
+        while(in + run < src_size && run < 128 && src[in + run] == src[in])
+            run ++;
+
+        if(run >= 2)
+        {
+            if(out + 2 > dst_size)
+                return 0;
+
+            dst[out ++] = (uint8_t)(257 - run);
+            dst[out ++] = src[in];
+            in += run;
+            continue;
+        }
+
+        // Collect literals until the next run of at least two bytes
+        uint32_t literals = 1;
+        while(in + literals < src_size && literals < 128)
+        {
+            if(in + literals + 1 < src_size && src[in + literals] == src[in + literals + 1])
+                break;
+
+            literals ++;
+        }
+
+        if(out + 1 + literals > dst_size)
+            return 0;
+
+        dst[out ++] = (uint8_t)(literals - 1);
+
+        for(uint32_t i = 0; i < literals; i ++)
+            dst[out ++] = src[in + i];
+
+        in += literals;
+    }
+
+    return out;
+}
+
+/**
+  * @brief PackBits decompress a buffer
+  * @param const uint8_t *src, uint32_t src_size - compressed data
+  * @param uint8_t *dst, uint32_t dst_size - output buffer
+  * @retval uint32_t - decompressed size, 0 if the stream is truncated or overflows the output
+  */
+uint32_t LEVEL_PACK_decode(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size)
+{
+    uint32_t in = 0;
+    uint32_t out = 0;
+
+    while(in < src_size)
+    {
+        uint8_t control = src[in ++];
+
+        if(control < 128)
+        {
+            uint32_t count = control + 1;
+
+            if(in + count > src_size || out + count > dst_size)
+                return 0;
+
+            for(uint32_t i = 0; i < count; i ++)
+                dst[out ++] = src[in ++];
+        }
+        else if(control > 128)
+        {
+            uint32_t count = 257 - control;
+
+            if(in >= src_size || out + count > dst_size)
+                return 0;
+
+            uint8_t value = src[in ++];
+
+            for(uint32_t i = 0; i < count; i ++)
+                dst[out ++] = value;
+        }
+        // 128 is a no-op
+    }
+
+    return out;
+}
@@ -0,0 +1,25 @@
+/*
+ * LevelPackData.c
+ *
+ * Generated by Host/level_packer from Host/levels.txt - do not edit.
+ */
+
+#include "LevelPack.h"
+
+const uint32_t level_pack_size = 156;
+
+const uint8_t level_pack_data[] = {
+    0x4C, 0x56, 0x50, 0x4B, 0x01, 0x00, 0x04, 0x00, 0x28, 0x00, 0x00, 0x00,
+    0x1D, 0x00, 0x06, 0x04, 0x45, 0x00, 0x00, 0x00, 0x1D, 0x00, 0x06, 0x04,
+    0x62, 0x00, 0x00, 0x00, 0x1D, 0x00, 0x06, 0x04, 0x7F, 0x00, 0x00, 0x00,
+    0x1D, 0x00, 0x06, 0x04, 0xFC, 0x00, 0x03, 0x04, 0x24, 0x10, 0x20, 0xFB,
+    0x00, 0x03, 0x80, 0x20, 0x21, 0x80, 0xFF, 0x00, 0x02, 0x02, 0x04, 0x10,
+    0xFE, 0x00, 0x05, 0x02, 0x03, 0x05, 0x01, 0x04, 0x05, 0xFC, 0x00, 0x03,
+    0x02, 0x64, 0x00, 0x09, 0xFB, 0x00, 0x09, 0x48, 0x02, 0x50, 0x00, 0x01,
+    0x80, 0x00, 0x22, 0x80, 0x00, 0xFF, 0x05, 0x05, 0x00, 0x02, 0x03, 0x00,
+    0x01, 0x05, 0xFC, 0x00, 0x03, 0x03, 0x80, 0x01, 0x06, 0xFB, 0x00, 0x03,
+    0x90, 0x24, 0x20, 0x08, 0xFF, 0x00, 0x09, 0x01, 0x84, 0x00, 0x04, 0x00,
+    0x03, 0x05, 0x00, 0x02, 0x04, 0xFF, 0x05, 0xFC, 0x00, 0x01, 0x40, 0x02,
+    0xFF, 0x12, 0xFB, 0x00, 0x08, 0x40, 0x44, 0x10, 0x01, 0x00, 0x04, 0x20,
+    0x40, 0x00, 0xFF, 0x02, 0xFF, 0x00, 0xFF, 0x05, 0x00, 0x02, 0xFF, 0x03,
+};
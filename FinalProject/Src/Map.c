@@ -0,0 +1,289 @@
+/*
+ * Map.c
+ *
+ * Map generation and level loading.
+ */
+
+#include "Map.h"
+
+/**
+ * @brief Creates a random map - determines where all the walls, waypoints and holes are.
+ *
+ * @param MapData_t *map - map to fill
+ * @param const MapConfig_t *map_config - size of the map and wall/hole/waypoint generation parameters
+ * @param MapRandom_t random, void *random_context - random number source used for every decision
+ * @return bool - false if the configuration does not fit in MapData_t
+ */
+bool MAP_create(MapData_t *map, const MapConfig_t *map_config, MapRandom_t random, void *random_context)
+{
+    uint32_t rand;
+    uint8_t cell_count = map_config->cell_count;
+    uint8_t num_waypoints = map_config->num_waypoints;
+    uint8_t increment;
+
+    if(cell_count > MAP_MAX_CELL_COUNT || num_waypoints > MAP_MAX_WAYPOINTS || num_waypoints > cell_count * cell_count)
+        return false;
+
+#if CONFIG_STATIC_PROFILE
+    if(cell_count != CONFIG_PROFILE_MAP_CELL_COUNT)
+        return false;
+#endif
+
+    map->cell_count = cell_count;
+    map->num_waypoints = num_waypoints;
+    map->num_holes = 0;
+
+    // For every cell in the map
+    for(int i = 0; i < cell_count; i++)
+    {
+        for(int j = 0; j < cell_count; j ++)
+        {
+            map->cell_data[i][j] = 0; // Initialize to 0
+
+            // Get random number
+            rand = random(random_context, 1000);
+
+            // Generate bottom wall
+            if(rand < map_config->wall_probability)
+                map->cell_data[i][j] |= MAP_BOTTOM_WALL;
+
+            rand = random(random_context, 1000);
+
+            // Generate right wall
+            if(rand < map_config->wall_probability)
+                map->cell_data[i][j] |= MAP_RIGHT_WALL;
+
+            rand = random(random_context, 1000);
+
+            // Generate hole
+            if(rand < map_config->hole_probability)
+            {
+                map->cell_data[i][j] |= MAP_HOLE;
+                map->num_holes ++;
+            }
+
+        }
+    }
+
+    // Waypoint generation
+
+    increment = 0;
+
+    while(increment < num_waypoints)
+    {
+        uint32_t randRow = random(random_context, cell_count);
+        uint32_t randCol = random(random_context, cell_count);
+
+        // If a waypoint has already been generated in this cell
+        if(map->cell_data[randRow][randCol] & MAP_WAYPOINT)
+            continue;
+
+        // If a hole has been generated in this cell, override it with a waypoint
+        if(map->cell_data[randRow][randCol] & MAP_HOLE)
+        {
+            map->cell_data[randRow][randCol] &= ~MAP_HOLE; // Clear hole data
+            map->num_holes --;
+        }
+
+        // If the cell is empty, generate a new waypoint
+        map->cell_data[randRow][randCol] |= MAP_WAYPOINT; // Set waypoint data
+        map->waypoint_number[randRow][randCol] = increment;
+        map->waypoint_data[increment].x = MAP_CELL_CENTER_X(randCol);
+        map->waypoint_data[increment].y = MAP_CELL_CENTER_Y(randRow);
+        map->waypoint_data[increment].number = increment;
+        map->waypoint_data[increment].reached = false;
+
+        increment ++;
+    }
+
+    MAP_create_hole_data(map);
+
+    return true;
+}
+
+/**
+ * @brief Fills a map from a level decoded out of a level pack
+ *
+ * @param MapData_t *map - map to fill
+ * @param const LevelData_t *level - decoded level
+ * @return bool - false if the level does not fit in MapData_t, or has a waypoint off its grid
+ */
+bool MAP_load_level(MapData_t *map, const LevelData_t *level)
+{
+    if(level->cell_count > MAP_MAX_CELL_COUNT || level->num_waypoints > MAP_MAX_WAYPOINTS)
+        return false;
+
+#if CONFIG_STATIC_PROFILE
+    if(level->cell_count != CONFIG_PROFILE_MAP_CELL_COUNT)
+        return false;
+#endif
+
+    // Checked before anything is written, so a bad level leaves the map as it was
+    for(int i = 0; i < level->num_waypoints; i ++)
+    {
+        if(level->waypoint_cells[2 * i] >= level->cell_count || level->waypoint_cells[(2 * i) + 1] >= level->cell_count)
+            return false;
+    }
+
+    map->cell_count = level->cell_count;
+    map->num_waypoints = level->num_waypoints;
+    map->num_holes = 0;
+
+    for(int i = 0; i < level->cell_count; i ++)
+    {
+        for(int j = 0; j < level->cell_count; j ++)
+        {
+            map->cell_data[i][j] = level->cell_data[(i * level->cell_count) + j];
+
+            if(map->cell_data[i][j] & MAP_HOLE)
+                map->num_holes ++;
+        }
+    }
+
+    for(int i = 0; i < level->num_waypoints; i ++)
+    {
+        uint8_t row = level->waypoint_cells[2 * i];
+        uint8_t col = level->waypoint_cells[(2 * i) + 1];
+
+        map->waypoint_data[i].x = MAP_CELL_CENTER_X(col);
+        map->waypoint_data[i].y = MAP_CELL_CENTER_Y(row);
+        map->waypoint_data[i].number = i;
+        map->waypoint_data[i].reached = false;
+        map->waypoint_number[row][col] = i;
+    }
+
+    MAP_create_hole_data(map);
+
+    return true;
+}
+
+/**
+ * @brief Builds the array of hole center coordinates from the hole bits in the cell data
+ *
+ * @param MapData_t *map - map to update
+ * @return void
+ */
+void MAP_create_hole_data(MapData_t *map)
+{
+    uint16_t increment = 0;
+
+    for(int i = 0; i < MAP_CELL_COUNT(map); i ++)
+    {
+        for(int j = 0; j < MAP_CELL_COUNT(map); j ++)
+        {
+            // If a hole is generated within this cell, place its center coordinate within the holes array
+            if(map->cell_data[i][j] & MAP_HOLE)
+            {
+                map->hole_data[increment].x = MAP_CELL_CENTER_X(j);
+                map->hole_data[increment].y = MAP_CELL_CENTER_Y(i);
+
+                increment ++;
+            }
+        }
+    }
+
+    map->num_holes = increment;
+}
+
+/**
+ * @brief Finds a cell with the given bit whose center lies within radius of a point. Only the cell containing
+ *        the point and its neighbours can be close enough, so the cost does not depend on the number of holes
+ *        or waypoints.
+ *
+ * @param const MapData_t *map - map to search
+ * @param int32_t x, y - pixel position
+ * @param uint32_t radius - radius around the cell center in pixels
+ * @param uint8_t bit - MAP_HOLE or MAP_WAYPOINT
+ * @param int32_t *found_row, *found_col - cell that was found
+ * @return bool - true if a cell was found
+ */
+static bool find_cell(const MapData_t *map, int32_t x, int32_t y, uint32_t radius, uint8_t bit, int32_t *found_row, int32_t *found_col)
+{
+    int32_t radius_squared = radius * radius;
+
+    if(x < MAP_ORIGIN_X || y < MAP_ORIGIN_Y)
+        return false;
+
+    int32_t row = MAP_CELL_ROW(y);
+    int32_t col = MAP_CELL_COL(x);
+
+    if(row >= MAP_CELL_COUNT(map) || col >= MAP_CELL_COUNT(map))
+        return false;
+
+    for(int32_t i = row - 1; i <= row + 1; i ++)
+    {
+        if(i < 0 || i >= MAP_CELL_COUNT(map))
+            continue;
+
+        for(int32_t j = col - 1; j <= col + 1; j ++)
+        {
+            if(j < 0 || j >= MAP_CELL_COUNT(map) || !(map->cell_data[i][j] & bit))
+                continue;
+
+            int32_t x_distance = x - MAP_CELL_CENTER_X(j);
+            int32_t y_distance = y - MAP_CELL_CENTER_Y(i);
+
+            // Compare squared distances - no square root needed
+            if((x_distance * x_distance) + (y_distance * y_distance) < radius_squared)
+            {
+                *found_row = i;
+                *found_col = j;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Checks if a pixel position is over a hole
+ *
+ * @param const MapData_t *map - map to check
+ * @param int32_t x, y - pixel position
+ * @param uint32_t radius - hole radius in pixels
+ * @return bool - true if the position is within radius of a hole center
+ */
+bool MAP_is_over_hole(const MapData_t *map, int32_t x, int32_t y, uint32_t radius)
+{
+    int32_t row, col;
+
+    return find_cell(map, x, y, radius, MAP_HOLE, &row, &col);
+}
+
+/**
+ * @brief Determines if a pixel position is over a waypoint and, if so, which waypoint
+ *
+ * @param const MapData_t *map - map to check
+ * @param int32_t x, y - pixel position
+ * @param uint32_t radius - waypoint radius in pixels
+ * @return int8_t - -1 if not over a waypoint, otherwise the waypoint number
+ */
+int8_t MAP_get_waypoint(const MapData_t *map, int32_t x, int32_t y, uint32_t radius)
+{
+    int32_t row, col;
+
+    if(!find_cell(map, x, y, radius, MAP_WAYPOINT, &row, &col))
+        return -1;
+
+    return map->waypoint_number[row][col];
+}
+
+/**
+ * @brief Seeded random source for MAP_create - the same seed always gives the same map, so a game can be
+ *        replayed from the seed alone
+ *
+ * @param void *context - uint32_t xorshift32 state, must not be 0
+ * @param uint32_t max - max value that can be returned
+ * @return uint32_t - random value from 0 to max - 1
+ */
+uint32_t MAP_xorshift_random(void *context, uint32_t max)
+{
+    uint32_t *state = context;
+
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state % max;
+}
@@ -1,12 +1,59 @@
 #include "RNG.h"
+#include "EntropyPool.h"
+
+static EntropyPool_t rng_pool; // Words read by the interrupt, waiting to be taken
+
+/**
+ * @brief Enables the data ready interrupt - the pool wants more words
+*/
+static void RNG_start_interrupt(void *context)
+{
+    (void) context;
+    RNG->CR |= (RNG_CR_IE);
+}
 
 /**
- * @brief Enables RNG peripheral
+ * @brief Disables the data ready interrupt - the pool is full
+*/
+static void RNG_stop_interrupt(void *context)
+{
+    (void) context;
+    RNG->CR &= ~(RNG_CR_IE);
+}
+
+/**
+ * @brief Waits for a word from the generator - only used for the seed at start up
+ * 
+ * @return uint32_t word read, or whatever is in the data register if none came within RNG_POLL_LIMIT
+*/
+static uint32_t RNG_poll_word()
+{
+    for(uint32_t i = 0; i < RNG_POLL_LIMIT && !(RNG->SR & RNG_SR_DRDY); i ++);
+
+    return RNG->DR;
+}
+
+/**
+ * @brief Enables RNG peripheral and starts filling the pool. The first word is only good for comparing with
+ *        the next, so the fallback generator is seeded with the second.
 */
 void RNG_enable()
 {
+    EntropyPoolPort_t port = {
+        .start = RNG_start_interrupt,
+        .stop = RNG_stop_interrupt,
+        .context = (void *)0
+    };
+
     RNG_enable_clock();
     RNG->CR |= (RNG_CR_RNGEN);
+
+    RNG_poll_word();
+    ENTROPY_POOL_init(&rng_pool, &port, RNG_poll_word());
+
+    NVIC_SetPriority(HASH_RNG_IRQn, RNG_IRQ_PRIORITY);
+    NVIC_EnableIRQ(HASH_RNG_IRQn);
+    ENTROPY_POOL_start(&rng_pool);
 }
 
 /**
@@ -14,7 +61,8 @@ void RNG_enable()
 */
 void RNG_disable()
 {
-    RNG->CR &= ~(RNG_CR_RNGEN);
+    NVIC_DisableIRQ(HASH_RNG_IRQn);
+    RNG->CR &= ~(RNG_CR_RNGEN | RNG_CR_IE);
     RNG_disable_clock();
 }
 
@@ -44,7 +92,7 @@ void RNG_disable_clock()
 }
 
 /**
- * @brief Get random number from RNG peripheral
+ * @brief Get random number from RNG peripheral - taken from the pool, so it doesn't wait for the generator
  * 
  * @param max - max value that can be returned
  * 
@@ -52,5 +100,32 @@ void RNG_disable_clock()
 */
 uint32_t RNG_get_random_number(uint32_t max)
 {
-    return RNG->DR % max;
+    return ENTROPY_POOL_take(&rng_pool) % max;
+}
+
+/**
+ * @brief RNG interrupt handler - a new word is ready, or the generator hit an error. A seed error needs the
+ *        generator restarting; a clock error clears once the clock is back.
+*/
+void HASH_RNG_IRQHandler()
+{
+    uint32_t status = RNG->SR;
+
+    if(status & RNG_SR_SEIS)
+    {
+        RNG->SR &= ~(RNG_SR_SEIS);
+        RNG->CR &= ~(RNG_CR_RNGEN);
+        RNG->CR |= (RNG_CR_RNGEN);
+        ENTROPY_POOL_on_restart(&rng_pool);
+        return;
+    }
+
+    if(status & RNG_SR_CEIS)
+    {
+        RNG->SR &= ~(RNG_SR_CEIS);
+        return;
+    }
+
+    if(status & RNG_SR_DRDY)
+        ENTROPY_POOL_on_word(&rng_pool, RNG->DR);
 }
\ No newline at end of file
@@ -0,0 +1,410 @@
+/*
+ * Recorder.c
+ *
+ * Compact input recording and playback.
+ */
+
+#include "Recorder.h"
+
+#define RECORD_TICK_FLAG        0x40    // Gyro record - a physics tick ran before the sample
+#define RECORD_TICKS            0x80    // 1000nnnn
+#define RECORD_BUTTON_EDGE      0x90    // 1001000p
+#define RECORD_LARGE_GYRO       0xA0    // 1010000t
+#define RECORD_GAME_START       0xFF
+
+#define RECORD_MAX_TICKS        16      // Ticks in one 1000nnnn record
+
+#define SMALL_DELTA_MIN         (-4)
+#define SMALL_DELTA_MAX         3
+
+/**
+ * @brief Appends a whole record to the ring buffer, or drops it if there isn't room
+ */
+static bool write_record(Recorder_t *recorder, const uint8_t *bytes, uint32_t length)
+{
+    if(RECORDER_BUFFER_SIZE - (recorder->head - recorder->tail) < length)
+    {
+        recorder->dropped ++;
+        return false;
+    }
+
+    for(uint32_t i = 0; i < length; i ++)
+        recorder->buffer[(recorder->head + i) & (RECORDER_BUFFER_SIZE - 1)] = bytes[i];
+
+    recorder->head += length;
+
+    return true;
+}
+
+/**
+ * @brief Writes a varint - 7 bits per byte, low bits first, top bit set on every byte but the last
+ * @return uint32_t - bytes written
+ */
+static uint32_t put_varint(uint8_t *bytes, uint32_t value)
+{
+    uint32_t length = 0;
+
+    while(value >= 0x80)
+    {
+        bytes[length ++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+
+    bytes[length ++] = value;
+
+    return length;
+}
+
+/**
+ * @brief Maps a signed value to an unsigned one with small magnitudes first - 0, -1, 1, -2, 2...
+ */
+static uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/**
+ * @brief Writes out the pending physics ticks, keeping back the given number
+ */
+static bool write_ticks(Recorder_t *recorder, uint32_t keep)
+{
+    bool written = true;
+
+    while(recorder->pending_ticks > keep)
+    {
+        uint32_t count = recorder->pending_ticks - keep;
+
+        if(count > RECORD_MAX_TICKS)
+            count = RECORD_MAX_TICKS;
+
+        uint8_t record = RECORD_TICKS | (count - 1);
+
+        written &= write_record(recorder, &record, 1);
+        recorder->pending_ticks -= count;
+    }
+
+    return written;
+}
+
+/**
+ * @brief Empties the recorder
+ *
+ * @param Recorder_t *recorder - recorder to set up
+ * @return void
+ */
+void RECORDER_init(Recorder_t *recorder)
+{
+    recorder->head = 0;
+    recorder->tail = 0;
+    recorder->dropped = 0;
+    recorder->last_x = 0;
+    recorder->last_y = 0;
+    recorder->pending_ticks = 0;
+}
+
+/**
+ * @brief Records the start of a game - everything needed to rebuild the map it is played on
+ *
+ * @param Recorder_t *recorder - recorder
+ * @param uint32_t seed - MAP_xorshift_random seed the map was generated from
+ * @param int32_t level - level pack index, -1 for a generated map
+ * @return bool - false if the record was dropped
+ */
+bool RECORDER_start(Recorder_t *recorder, uint32_t seed, int32_t level)
+{
+    uint8_t record[RECORDER_MAX_RECORD_SIZE];
+    uint32_t length = 0;
+
+    write_ticks(recorder, 0);
+
+    record[length ++] = RECORD_GAME_START;
+    length += put_varint(&record[length], seed);
+    length += put_varint(&record[length], (uint32_t)(level + 1));
+
+    // Every game starts its gyro deltas from 0
+    recorder->last_x = 0;
+    recorder->last_y = 0;
+
+    return write_record(recorder, record, length);
+}
+
+/**
+ * @brief Records a gyro sample
+ *
+ * @param Recorder_t *recorder - recorder
+ * @param int16_t rate_x, rate_y - raw angular rate read from the gyro
+ * @return bool - false if the record was dropped
+ */
+bool RECORDER_gyro(Recorder_t *recorder, int16_t rate_x, int16_t rate_y)
+{
+    uint8_t record[RECORDER_MAX_RECORD_SIZE];
+    uint32_t length = 0;
+    int32_t dx = rate_x - recorder->last_x;
+    int32_t dy = rate_y - recorder->last_y;
+    uint8_t tick = 0;
+
+    // The last pending tick rides along in the gyro record
+    write_ticks(recorder, 1);
+
+    if(recorder->pending_ticks == 1)
+        tick = RECORD_TICK_FLAG;
+
+    if(dx >= SMALL_DELTA_MIN && dx <= SMALL_DELTA_MAX && dy >= SMALL_DELTA_MIN && dy <= SMALL_DELTA_MAX)
+    {
+        record[length ++] = tick | ((dx & 0x7) << 3) | (dy & 0x7);
+    }
+    else
+    {
+        record[length ++] = RECORD_LARGE_GYRO | (tick ? 1 : 0);
+        length += put_varint(&record[length], zigzag(dx));
+        length += put_varint(&record[length], zigzag(dy));
+    }
+
+    recorder->pending_ticks = 0;
+
+    // Later deltas are taken from the last sample that made it into the buffer
+    if(!write_record(recorder, record, length))
+        return false;
+
+    recorder->last_x = rate_x;
+    recorder->last_y = rate_y;
+
+    return true;
+}
+
+/**
+ * @brief Records a physics tick. Ticks are held back and written with the next record.
+ *
+ * @param Recorder_t *recorder - recorder
+ * @return void
+ */
+void RECORDER_tick(Recorder_t *recorder)
+{
+    recorder->pending_ticks ++;
+}
+
+/**
+ * @brief Records a button edge
+ *
+ * @param Recorder_t *recorder - recorder
+ * @param bool pressed - new button state
+ * @return bool - false if the record was dropped
+ */
+bool RECORDER_button(Recorder_t *recorder, bool pressed)
+{
+    uint8_t record = RECORD_BUTTON_EDGE | (pressed ? 1 : 0);
+
+    write_ticks(recorder, 0);
+
+    return write_record(recorder, &record, 1);
+}
+
+/**
+ * @brief Writes out any physics ticks still held back - call before reading out the buffer
+ *
+ * @param Recorder_t *recorder - recorder
+ * @return bool - false if a record was dropped
+ */
+bool RECORDER_flush(Recorder_t *recorder)
+{
+    return write_ticks(recorder, 0);
+}
+
+/**
+ * @brief Takes recorded bytes out of the ring buffer, making room for more
+ *
+ * @param Recorder_t *recorder - recorder
+ * @param uint8_t *output - where to copy the bytes
+ * @param uint32_t max - size of output
+ * @return uint32_t - bytes copied
+ */
+uint32_t RECORDER_read(Recorder_t *recorder, uint8_t *output, uint32_t max)
+{
+    uint32_t count = 0;
+
+    RECORDER_flush(recorder);
+
+    while(count < max && recorder->tail != recorder->head)
+    {
+        output[count ++] = recorder->buffer[recorder->tail & (RECORDER_BUFFER_SIZE - 1)];
+        recorder->tail ++;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Starts reading a recorded log
+ *
+ * @param RecordReader_t *reader - reader to set up
+ * @param const uint8_t *data, uint32_t size - log bytes, as taken out of the recorder
+ * @return void
+ */
+void RECORDER_reader_init(RecordReader_t *reader, const uint8_t *data, uint32_t size)
+{
+    reader->data = data;
+    reader->size = size;
+    reader->position = 0;
+    reader->last_x = 0;
+    reader->last_y = 0;
+    reader->pending_ticks = 0;
+    reader->gyro_pending = false;
+    reader->angle_x = Q16_FROM_INT(INITIAL_BOARD_ANGLE);
+    reader->angle_y = Q16_FROM_INT(INITIAL_BOARD_ANGLE);
+}
+
+static bool get_varint(RecordReader_t *reader, uint32_t *value)
+{
+    *value = 0;
+
+    for(uint32_t shift = 0; shift < 35; shift += 7)
+    {
+        if(reader->position >= reader->size)
+            return false;
+
+        uint8_t byte = reader->data[reader->position ++];
+
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+
+        if(!(byte & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Decodes the next input, in the order it was recorded
+ *
+ * @param RecordReader_t *reader - reader
+ * @param RecordEvent_t *event - the decoded input
+ * @return bool - false at the end of the log or if the log is corrupt
+ */
+bool RECORDER_next(RecordReader_t *reader, RecordEvent_t *event)
+{
+    uint32_t dx, dy;
+
+    while(1)
+    {
+        if(reader->pending_ticks > 0)
+        {
+            reader->pending_ticks --;
+            event->type = RECORD_TICK;
+            return true;
+        }
+
+        if(reader->gyro_pending)
+        {
+            reader->gyro_pending = false;
+            event->type = RECORD_GYRO;
+            event->rate_x = reader->last_x;
+            event->rate_y = reader->last_y;
+            return true;
+        }
+
+        if(reader->position >= reader->size)
+            return false;
+
+        uint8_t byte = reader->data[reader->position ++];
+
+        if(!(byte & 0x80))
+        {
+            // Sign extend the 3 bit deltas
+            reader->last_x += (int8_t)((byte << 2) & 0xE0) >> 5;
+            reader->last_y += (int8_t)(byte << 5) >> 5;
+            reader->pending_ticks = (byte & RECORD_TICK_FLAG) ? 1 : 0;
+            reader->gyro_pending = true;
+        }
+        else if((byte & 0xF0) == RECORD_TICKS)
+        {
+            reader->pending_ticks = (byte & 0x0F) + 1;
+        }
+        else if((byte & 0xFE) == RECORD_BUTTON_EDGE)
+        {
+            event->type = RECORD_BUTTON;
+            event->pressed = byte & 1;
+            return true;
+        }
+        else if((byte & 0xFE) == RECORD_LARGE_GYRO)
+        {
+            if(!get_varint(reader, &dx) || !get_varint(reader, &dy))
+                return false;
+
+            reader->last_x += unzigzag(dx);
+            reader->last_y += unzigzag(dy);
+            reader->pending_ticks = byte & 1;
+            reader->gyro_pending = true;
+        }
+        else if(byte == RECORD_GAME_START)
+        {
+            uint32_t level;
+
+            if(!get_varint(reader, &event->seed) || !get_varint(reader, &level))
+                return false;
+
+            event->type = RECORD_START;
+            event->level = (int32_t)level - 1;
+
+            reader->last_x = 0;
+            reader->last_y = 0;
+            reader->angle_x = Q16_FROM_INT(INITIAL_BOARD_ANGLE);
+            reader->angle_y = Q16_FROM_INT(INITIAL_BOARD_ANGLE);
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Plays the recorded inputs up to the next physics tick, then runs that tick. Between ticks the
+ *        disruptor's energy and the game clock are advanced by one physics period, as the firmware's tick does.
+ *
+ * @param RecordReader_t *reader - reader positioned after the game's start record
+ * @param GameState_t *game - game started on the recorded map
+ * @param uint32_t *events - GAME_EVENT_ flags of the tick
+ * @return bool - false once the log runs out or reaches the next game
+ */
+bool RECORDER_replay_tick(RecordReader_t *reader, GameState_t *game, uint32_t *events)
+{
+    uint32_t period = CONFIG_PHYSICS_UPDATE_PERIOD(game->config);
+    RecordEvent_t event;
+
+    *events = 0;
+
+    while(reader->position < reader->size || reader->pending_ticks > 0 || reader->gyro_pending)
+    {
+        // Leave the next game's start record for the caller
+        if(reader->pending_ticks == 0 && !reader->gyro_pending && reader->data[reader->position] == RECORD_GAME_START)
+            return false;
+
+        if(!RECORDER_next(reader, &event))
+            return false;
+
+        switch(event.type)
+        {
+            case RECORD_GYRO:
+                GAME_integrate_gyro(&reader->angle_x, &reader->angle_y, event.rate_x, event.rate_y);
+                break;
+
+            case RECORD_BUTTON:
+                GAME_set_button(game, event.pressed);
+                break;
+
+            case RECORD_TICK:
+                *events |= GAME_advance_energy(game, period);
+                *events |= GAME_advance_clock(game, period);
+                *events |= GAME_step(game, reader->angle_x, reader->angle_y);
+                return true;
+        }
+    }
+
+    return false;
+}
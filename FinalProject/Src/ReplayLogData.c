@@ -0,0 +1,13 @@
+/*
+ * ReplayLogData.c
+ *
+ * Generated by Host/replay from a recorded log - do not edit. Played back when REPLAY_LOG is 1.
+ */
+
+#include "Recorder.h"
+
+const uint32_t replay_log_size = 0;
+
+const uint8_t replay_log_data[] = {
+    0x00
+};
@@ -0,0 +1,222 @@
+/*
+ * SPI_Bus_Driver.c
+ *
+ * HAL port for the shared SPI5 bus - DMA for queued transactions, polled transfers for blocking ones.
+ */
+
+#include "SPI_Bus_Driver.h"
+
+extern SPI_HandleTypeDef hspi5;
+
+SpiBus_t spi5_bus;
+DMA_HandleTypeDef hdma_spi5_rx;
+DMA_HandleTypeDef hdma_spi5_tx;
+
+static bool Is_SPI_Bus_Initialized = false;
+
+/**
+  * @brief Set SPI5's clock prescaler for a device - the peripheral is disabled while the prescaler changes
+  *        and the HAL enables it again on the next transfer
+  */
+static void SPI_Bus_Configure(void *context, const SpiDevice_t *device)
+{
+    SPI_HandleTypeDef *hspi = context;
+
+    __HAL_SPI_DISABLE(hspi);
+    hspi->Init.BaudRatePrescaler = device->prescaler;
+    MODIFY_REG(hspi->Instance->CR1, SPI_CR1_BR, device->prescaler);
+}
+
+/**
+  * @brief Drive a device's chip select
+  */
+static void SPI_Bus_Chip_Select(void *context, const SpiDevice_t *device, bool selected)
+{
+    (void) &context;
+
+    HAL_GPIO_WritePin((GPIO_TypeDef *) device->cs_port, device->cs_pin, selected ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+/**
+  * @brief Start a DMA transfer - completes in one of the HAL_SPI_ callbacks below
+  */
+static bool SPI_Bus_Start_Transfer(void *context, const uint8_t *tx, uint8_t *rx, uint16_t size)
+{
+    SPI_HandleTypeDef *hspi = context;
+    HAL_StatusTypeDef status;
+
+    if(rx == NULL)
+        status = HAL_SPI_Transmit_DMA(hspi, (uint8_t *) tx, size);
+    else if(tx == NULL)
+        status = HAL_SPI_Receive_DMA(hspi, rx, size);
+    else
+        status = HAL_SPI_TransmitReceive_DMA(hspi, (uint8_t *) tx, rx, size);
+
+    return status == HAL_OK;
+}
+
+/**
+  * @brief Polled transfer, for blocking transactions
+  */
+static bool SPI_Bus_Transfer(void *context, const uint8_t *tx, uint8_t *rx, uint16_t size)
+{
+    SPI_HandleTypeDef *hspi = context;
+    HAL_StatusTypeDef status;
+
+    if(rx == NULL)
+        status = HAL_SPI_Transmit(hspi, (uint8_t *) tx, size, SPI_BUS_TIMEOUT);
+    else if(tx == NULL)
+        status = HAL_SPI_Receive(hspi, rx, size, SPI_BUS_TIMEOUT);
+    else
+        status = HAL_SPI_TransmitReceive(hspi, (uint8_t *) tx, rx, size, SPI_BUS_TIMEOUT);
+
+    return status == HAL_OK;
+}
+
+/**
+  * @brief Mask interrupts while the bus's queue changes
+  */
+static uint32_t SPI_Bus_Lock(void *context)
+{
+    (void) &context;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    return primask;
+}
+
+/**
+  * @brief Restore interrupts masked by SPI_Bus_Lock
+  */
+static void SPI_Bus_Unlock(void *context, uint32_t state)
+{
+    (void) &context;
+
+    __set_PRIMASK(state);
+}
+
+/**
+  * @brief Wait for a DMA transfer to finish before a blocking transaction - sleeps once the kernel runs,
+  *        before that the transfer complete interrupt is all that can run
+  */
+static void SPI_Bus_Wait(void *context)
+{
+    (void) &context;
+
+    if(osKernelGetState() == osKernelRunning)
+    {
+        osDelay(1);
+    }
+}
+
+/**
+  * @brief Set up the shared SPI5 bus and its DMA streams. SPI5 itself is set up by MX_SPI5_Init.
+  *        Every driver on the bus calls this before using it - only the first call does anything.
+  * @retval None
+  */
+void SPI_Bus_Init(void)
+{
+    if(Is_SPI_Bus_Initialized)
+        return;
+
+    Is_SPI_Bus_Initialized = true;
+
+    SpiBusPort_t port = {
+        .configure = SPI_Bus_Configure,
+        .chip_select = SPI_Bus_Chip_Select,
+        .start_transfer = SPI_Bus_Start_Transfer,
+        .transfer = SPI_Bus_Transfer,
+        .lock = SPI_Bus_Lock,
+        .unlock = SPI_Bus_Unlock,
+        .wait = SPI_Bus_Wait,
+        .context = &hspi5
+    };
+
+    SPI_BUS_init(&spi5_bus, &port);
+
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    hdma_spi5_rx.Instance = SPI_BUS_DMA_RX_STREAM;
+    hdma_spi5_rx.Init.Channel = SPI_BUS_DMA_CHANNEL;
+    hdma_spi5_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_spi5_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi5_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi5_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi5_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi5_rx.Init.Mode = DMA_NORMAL;
+    hdma_spi5_rx.Init.Priority = DMA_PRIORITY_HIGH;
+    hdma_spi5_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+
+    if(HAL_DMA_Init(&hdma_spi5_rx) != HAL_OK)
+        while(1);
+
+    __HAL_LINKDMA(&hspi5, hdmarx, hdma_spi5_rx);
+
+    hdma_spi5_tx.Instance = SPI_BUS_DMA_TX_STREAM;
+    hdma_spi5_tx.Init = hdma_spi5_rx.Init;
+    hdma_spi5_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_spi5_tx.Init.Priority = DMA_PRIORITY_MEDIUM;
+
+    if(HAL_DMA_Init(&hdma_spi5_tx) != HAL_OK)
+        while(1);
+
+    __HAL_LINKDMA(&hspi5, hdmatx, hdma_spi5_tx);
+
+    HAL_NVIC_SetPriority(SPI_BUS_DMA_RX_IRQ_NUMBER, SPI_BUS_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(SPI_BUS_DMA_RX_IRQ_NUMBER);
+    HAL_NVIC_SetPriority(SPI_BUS_DMA_TX_IRQ_NUMBER, SPI_BUS_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(SPI_BUS_DMA_TX_IRQ_NUMBER);
+}
+
+/**
+  * @brief DMA2 stream 3 interrupt handler - SPI5 receive
+  * @retval None
+  */
+void DMA2_Stream3_IRQHandler()
+{
+    HAL_DMA_IRQHandler(&hdma_spi5_rx);
+}
+
+/**
+  * @brief DMA2 stream 4 interrupt handler - SPI5 transmit
+  * @retval None
+  */
+void DMA2_Stream4_IRQHandler()
+{
+    HAL_DMA_IRQHandler(&hdma_spi5_tx);
+}
+
+/**
+  * @brief SPI transfer complete callbacks - the bus moves on to its next transaction
+  * @param SPI_HandleTypeDef *hspi - SPI whose transfer finished
+  * @retval None
+  */
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if(hspi->Instance == SPI5)
+        SPI_BUS_on_transfer_complete(&spi5_bus, true);
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if(hspi->Instance == SPI5)
+        SPI_BUS_on_transfer_complete(&spi5_bus, true);
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if(hspi->Instance == SPI5)
+        SPI_BUS_on_transfer_complete(&spi5_bus, true);
+}
+
+/**
+  * @brief SPI error callback - the transaction is dropped and the bus moves on
+  * @param SPI_HandleTypeDef *hspi - SPI whose transfer failed
+  * @retval None
+  */
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    if(hspi->Instance == SPI5)
+        SPI_BUS_on_transfer_complete(&spi5_bus, false);
+}
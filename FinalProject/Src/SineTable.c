@@ -0,0 +1,31 @@
+/*
+ * SineTable.c
+ *
+ * Table lookup with linear interpolation between neighbouring entries. With one entry per degree the
+ * error is below 4e-5.
+ */
+
+#include "SineTable.h"
+
+/**
+ * @brief Sine of an angle
+ *
+ * @param q16_t degrees - angle in degrees, any value
+ * @return q16_t - sine of the angle, -1 to 1
+ */
+q16_t SINE_TABLE_sin(q16_t degrees)
+{
+    // Sine is odd - look up the magnitude and give the result the angle's sign, so tilting either way
+    // gives exactly the same response. sign is 0 or -1 (all ones).
+    int32_t sign = degrees >> 31;
+    q16_t angle = ((degrees ^ sign) - sign) % Q16_FROM_INT(360);
+
+    int32_t index = angle / Q16_FROM_INT(SINE_TABLE_STEP_DEGREES);
+    q16_t fraction = angle % Q16_FROM_INT(SINE_TABLE_STEP_DEGREES);
+    q16_t low = sine_table[index];
+    q16_t high = sine_table[index + 1];
+
+    q16_t sine = low + (q16_t)((((int64_t)(high - low)) * fraction) / Q16_FROM_INT(SINE_TABLE_STEP_DEGREES));
+
+    return (sine ^ sign) - sign;
+}
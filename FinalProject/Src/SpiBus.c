@@ -0,0 +1,216 @@
+/*
+ * SpiBus.c
+ *
+ * Shared SPI bus - transaction queue, blocking transactions and lazy reconfiguration per device.
+ */
+
+#include <string.h>
+#include "SpiBus.h"
+
+/**
+ * @brief Sets the peripheral up for a device, unless it already runs at the device's prescaler
+ */
+static void select_device(SpiBus_t *bus, const SpiDevice_t *device)
+{
+    if(!bus->configured || bus->prescaler != device->prescaler)
+    {
+        bus->port.configure(bus->port.context, device);
+        bus->configured = true;
+        bus->prescaler = device->prescaler;
+        bus->reconfigurations ++;
+    }
+
+    bus->port.chip_select(bus->port.context, device, true);
+}
+
+/**
+ * @brief Starts queued transactions until one is in flight or the queue is empty. Called with the bus locked.
+ *        A transaction that can't be started is told through its done callback - except the one just submitted,
+ *        whose submit returns false instead, so a done callback that resubmits can't recurse.
+ */
+static bool start_next(SpiBus_t *bus, const SpiTransaction_t *submitted)
+{
+    bool started = true;
+
+    while(bus->active == NULL && !bus->claimed && bus->tail != bus->head)
+    {
+        const SpiTransaction_t *transaction = bus->queue[bus->tail % SPI_BUS_QUEUE_SIZE];
+
+        bus->tail ++;
+        bus->active = transaction;
+        select_device(bus, transaction->device);
+
+        if(!bus->port.start_transfer(bus->port.context, transaction->tx, transaction->rx, transaction->size))
+        {
+            bus->port.chip_select(bus->port.context, transaction->device, false);
+            bus->active = NULL;
+            bus->errors ++;
+
+            if(transaction == submitted)
+                started = false;
+            else
+                transaction->done(transaction->context, false);
+        }
+    }
+
+    return started;
+}
+
+/**
+ * @brief Sets up a bus with nothing queued. The peripheral is configured for the first device used.
+ *
+ * @param SpiBus_t *bus - bus to set up
+ * @param const SpiBusPort_t *port - the SPI peripheral
+ * @return void
+ */
+void SPI_BUS_init(SpiBus_t *bus, const SpiBusPort_t *port)
+{
+    memset(bus, 0, sizeof(*bus));
+    bus->port = *port;
+}
+
+/**
+ * @brief Queues a transaction - it starts straight away if the bus is free. The transaction must stay valid
+ *        until its done callback. Safe to call from an interrupt, including from a done callback. If the bus
+ *        is free but the transfer can't be started, false is returned and the done callback isn't called.
+ *
+ * @param SpiBus_t *bus - bus to queue on
+ * @param const SpiTransaction_t *transaction - transaction to run
+ * @return bool - false if the queue is full or the transfer couldn't be started
+ */
+bool SPI_BUS_submit(SpiBus_t *bus, const SpiTransaction_t *transaction)
+{
+    uint32_t state = bus->port.lock(bus->port.context);
+
+    if(bus->head - bus->tail == SPI_BUS_QUEUE_SIZE)
+    {
+        bus->queue_full ++;
+        bus->port.unlock(bus->port.context, state);
+        return false;
+    }
+
+    bus->queue[bus->head % SPI_BUS_QUEUE_SIZE] = transaction;
+    bus->head ++;
+
+    bool started = start_next(bus, transaction);
+
+    bus->port.unlock(bus->port.context, state);
+
+    return started;
+}
+
+/**
+ * @brief Called from the transfer complete (or error) interrupt - deselects the device, tells the transaction
+ *        it is done and starts the next one queued
+ *
+ * @param SpiBus_t *bus - bus whose transfer finished
+ * @param bool ok - false if the transfer failed
+ * @return void
+ */
+void SPI_BUS_on_transfer_complete(SpiBus_t *bus, bool ok)
+{
+    uint32_t state = bus->port.lock(bus->port.context);
+    const SpiTransaction_t *transaction = bus->active;
+
+    if(transaction != NULL)
+    {
+        bus->port.chip_select(bus->port.context, transaction->device, false);
+        bus->active = NULL;
+        bus->transactions ++;
+        bus->errors += !ok;
+
+        transaction->done(transaction->context, ok);
+    }
+
+    start_next(bus, NULL);
+
+    bus->port.unlock(bus->port.context, state);
+}
+
+/**
+ * @brief Takes the bus for a blocking transaction with a device - waits for the queued transaction in flight
+ *        to finish, sets the bus up for the device and selects it. Call from a task, or before the kernel starts.
+ *
+ * @param SpiBus_t *bus - bus to take
+ * @param const SpiDevice_t *device - device to talk to
+ * @return void
+ */
+void SPI_BUS_acquire(SpiBus_t *bus, const SpiDevice_t *device)
+{
+    while(1)
+    {
+        uint32_t state = bus->port.lock(bus->port.context);
+
+        if(bus->active == NULL && !bus->claimed)
+        {
+            bus->claimed = true;
+            bus->port.unlock(bus->port.context, state);
+            break;
+        }
+
+        bus->port.unlock(bus->port.context, state);
+        bus->port.wait(bus->port.context);
+    }
+
+    bus->claimed_device = device;
+    select_device(bus, device);
+}
+
+/**
+ * @brief Sends and receives bytes within a blocking transaction - the device stays selected
+ *
+ * @param SpiBus_t *bus - bus taken with SPI_BUS_acquire
+ * @param const uint8_t *tx - bytes to send, NULL to send zeros
+ * @param uint8_t *rx - filled with the bytes received, NULL to drop them
+ * @param uint16_t size - number of bytes
+ * @return bool - false if the transfer failed
+ */
+bool SPI_BUS_exchange(SpiBus_t *bus, const uint8_t *tx, uint8_t *rx, uint16_t size)
+{
+    if(bus->port.transfer(bus->port.context, tx, rx, size))
+        return true;
+
+    bus->errors ++;
+
+    return false;
+}
+
+/**
+ * @brief Ends a blocking transaction - deselects the device and starts any transactions queued meanwhile
+ *
+ * @param SpiBus_t *bus - bus taken with SPI_BUS_acquire
+ * @return void
+ */
+void SPI_BUS_release(SpiBus_t *bus)
+{
+    bus->port.chip_select(bus->port.context, bus->claimed_device, false);
+
+    uint32_t state = bus->port.lock(bus->port.context);
+
+    bus->claimed = false;
+    bus->transactions ++;
+    start_next(bus, NULL);
+
+    bus->port.unlock(bus->port.context, state);
+}
+
+/**
+ * @brief A blocking transaction of one transfer
+ *
+ * @param SpiBus_t *bus - bus to use
+ * @param const SpiDevice_t *device - device to talk to
+ * @param const uint8_t *tx - bytes to send, NULL to send zeros
+ * @param uint8_t *rx - filled with the bytes received, NULL to drop them
+ * @param uint16_t size - number of bytes
+ * @return bool - false if the transfer failed
+ */
+bool SPI_BUS_transfer(SpiBus_t *bus, const SpiDevice_t *device, const uint8_t *tx, uint8_t *rx, uint16_t size)
+{
+    SPI_BUS_acquire(bus, device);
+
+    bool ok = SPI_BUS_exchange(bus, tx, rx, size);
+
+    SPI_BUS_release(bus);
+
+    return ok;
+}
@@ -0,0 +1,263 @@
+/*
+ * WallGrid.c
+ *
+ * Segment wall store with a uniform grid broadphase.
+ */
+
+#include <string.h>
+#include "WallGrid.h"
+
+/**
+ * @brief Bucket containing an offset from the grid origin along one axis, clamped to the grid. Clamping keeps
+ *        the mapping monotonic, so segments and queries outside the grid still meet in the edge buckets.
+ */
+static int32_t bucket_index(q16_t position, q16_t origin, q16_t bucket_size, uint16_t count)
+{
+    int64_t offset = (int64_t)position - origin;
+    int64_t index = offset / bucket_size;
+
+    // Round toward -infinity
+    if(offset < 0 && (offset % bucket_size) != 0)
+        index --;
+
+    if(index < 0)
+        return 0;
+
+    if(index >= count)
+        return count - 1;
+
+    return (int32_t)index;
+}
+
+/**
+ * @brief Buckets overlapped by a bounding box
+ */
+static void bucket_range(const WallGrid_t *grid, q16_t min_x, q16_t min_y, q16_t max_x, q16_t max_y,
+                         int32_t *first_col, int32_t *first_row, int32_t *last_col, int32_t *last_row)
+{
+    *first_col = bucket_index(min_x, grid->origin_x, grid->bucket_size, grid->columns);
+    *last_col = bucket_index(max_x, grid->origin_x, grid->bucket_size, grid->columns);
+    *first_row = bucket_index(min_y, grid->origin_y, grid->bucket_size, grid->rows);
+    *last_row = bucket_index(max_y, grid->origin_y, grid->bucket_size, grid->rows);
+}
+
+/**
+ * @brief Buckets overlapped by a segment's bounding box
+ */
+static void segment_buckets(const WallGrid_t *grid, const CollisionSegment_t *segment,
+                            int32_t *first_col, int32_t *first_row, int32_t *last_col, int32_t *last_row)
+{
+    bucket_range(grid,
+                 (segment->x1 < segment->x2) ? segment->x1 : segment->x2,
+                 (segment->y1 < segment->y2) ? segment->y1 : segment->y2,
+                 (segment->x1 < segment->x2) ? segment->x2 : segment->x1,
+                 (segment->y1 < segment->y2) ? segment->y2 : segment->y1,
+                 first_col, first_row, last_col, last_row);
+}
+
+/**
+ * @brief Empties the grid and sets up its buckets
+ *
+ * @param WallGrid_t *grid - grid to set up
+ * @param q16_t origin_x, origin_y - top left corner of the grid in pixels
+ * @param q16_t bucket_size - width and height of a bucket in pixels
+ * @param uint16_t columns, rows - number of buckets
+ * @return bool - false if the buckets don't fit in WALL_GRID_MAX_BUCKETS
+ */
+bool WALL_GRID_init(WallGrid_t *grid, q16_t origin_x, q16_t origin_y, q16_t bucket_size, uint16_t columns, uint16_t rows)
+{
+    if(columns == 0 || rows == 0 || bucket_size <= 0 || (uint32_t)columns * rows > WALL_GRID_MAX_BUCKETS)
+        return false;
+
+    grid->origin_x = origin_x;
+    grid->origin_y = origin_y;
+    grid->bucket_size = bucket_size;
+    grid->columns = columns;
+    grid->rows = rows;
+    grid->segment_count = 0;
+    grid->query_stamp = 0;
+
+    memset(grid->bucket_start, 0, sizeof(grid->bucket_start));
+
+    return true;
+}
+
+/**
+ * @brief Adds a wall segment. WALL_GRID_build must be called before the next query.
+ *
+ * @param WallGrid_t *grid - grid to add to
+ * @param const CollisionSegment_t *segment - wall in pixels
+ * @return bool - false if the grid is full
+ */
+bool WALL_GRID_add_segment(WallGrid_t *grid, const CollisionSegment_t *segment)
+{
+    if(grid->segment_count == WALL_GRID_MAX_SEGMENTS)
+        return false;
+
+    grid->segments[grid->segment_count] = *segment;
+    grid->segment_stamp[grid->segment_count] = 0;
+    grid->segment_count ++;
+
+    return true;
+}
+
+/**
+ * @brief Adds every wall of a map as a segment. A wall shared by two cells (the bottom of one and the top of the
+ *        next) is only added once.
+ *
+ * @param WallGrid_t *grid - grid to add to
+ * @param const MapData_t *map - map with the walls
+ * @return bool - false if the grid is full
+ */
+bool WALL_GRID_add_map_walls(WallGrid_t *grid, const MapData_t *map)
+{
+    uint8_t cell_count = MAP_CELL_COUNT(map);
+
+    for(int32_t row = 0; row <= cell_count; row ++)
+    {
+        for(int32_t col = 0; col <= cell_count; col ++)
+        {
+            q16_t x = Q16_FROM_INT(MAP_ORIGIN_X + (col * MAP_CELL_SIZE));
+            q16_t y = Q16_FROM_INT(MAP_ORIGIN_Y + (row * MAP_CELL_SIZE));
+            CollisionSegment_t segment;
+
+            // Horizontal edge along the top of cell (row, col)
+            if(col < cell_count &&
+               ((row < cell_count && (map->cell_data[row][col] & MAP_TOP_WALL)) ||
+                (row > 0 && (map->cell_data[row - 1][col] & MAP_BOTTOM_WALL))))
+            {
+                segment = (CollisionSegment_t){x, y, x + Q16_FROM_INT(MAP_CELL_SIZE), y};
+
+                if(!WALL_GRID_add_segment(grid, &segment))
+                    return false;
+            }
+
+            // Vertical edge along the left of cell (row, col)
+            if(row < cell_count &&
+               ((col < cell_count && (map->cell_data[row][col] & MAP_LEFT_WALL)) ||
+                (col > 0 && (map->cell_data[row][col - 1] & MAP_RIGHT_WALL))))
+            {
+                segment = (CollisionSegment_t){x, y, x, y + Q16_FROM_INT(MAP_CELL_SIZE)};
+
+                if(!WALL_GRID_add_segment(grid, &segment))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Builds the bucket lists from the segments
+ *
+ * @param WallGrid_t *grid - grid to build
+ * @return bool - false if the bucket lists don't fit in WALL_GRID_MAX_ENTRIES
+ */
+bool WALL_GRID_build(WallGrid_t *grid)
+{
+    uint32_t bucket_count = (uint32_t)grid->columns * grid->rows;
+    int32_t first_col, first_row, last_col, last_row;
+
+    memset(grid->bucket_start, 0, sizeof(grid->bucket_start));
+
+    // Count the segments of every bucket into the slot after it
+    for(uint16_t i = 0; i < grid->segment_count; i ++)
+    {
+        segment_buckets(grid, &grid->segments[i], &first_col, &first_row, &last_col, &last_row);
+
+        for(int32_t row = first_row; row <= last_row; row ++)
+        {
+            for(int32_t col = first_col; col <= last_col; col ++)
+                grid->bucket_start[(row * grid->columns) + col + 1] ++;
+        }
+    }
+
+    // Running total - the slot after every bucket now holds where that bucket ends
+    for(uint32_t bucket = 1; bucket <= bucket_count; bucket ++)
+        grid->bucket_start[bucket] += grid->bucket_start[bucket - 1];
+
+    uint32_t entry_count = grid->bucket_start[bucket_count];
+
+    if(entry_count > WALL_GRID_MAX_ENTRIES)
+        return false;
+
+    // Fill every bucket from its end backwards - the slot after it ends up holding where it starts
+    for(uint16_t i = 0; i < grid->segment_count; i ++)
+    {
+        segment_buckets(grid, &grid->segments[i], &first_col, &first_row, &last_col, &last_row);
+
+        for(int32_t row = first_row; row <= last_row; row ++)
+        {
+            for(int32_t col = first_col; col <= last_col; col ++)
+                grid->entries[-- grid->bucket_start[(row * grid->columns) + col + 1]] = i;
+        }
+    }
+
+    // Shift the starts into place and close the last bucket
+    for(uint32_t bucket = 0; bucket < bucket_count; bucket ++)
+        grid->bucket_start[bucket] = grid->bucket_start[bucket + 1];
+
+    grid->bucket_start[bucket_count] = entry_count;
+
+    return true;
+}
+
+/**
+ * @brief Finds the first wall a moving circle touches. Only segments in the buckets covered by the move are
+ *        tested.
+ *
+ * @param WallGrid_t *grid - built grid
+ * @param q16_t x, y - circle center at the start of the move in pixels
+ * @param q16_t dx, dy - move in pixels
+ * @param q16_t radius - circle radius in pixels, at most COLLISION_MAX_RADIUS
+ * @param CollisionHit_t *hit - time of impact and contact normal of the first wall hit
+ * @return bool - true if a wall is hit
+ */
+bool WALL_GRID_sweep_circle(WallGrid_t *grid, q16_t x, q16_t y, q16_t dx, q16_t dy, q16_t radius, CollisionHit_t *hit)
+{
+    int32_t first_col, first_row, last_col, last_row;
+    bool found = false;
+
+    bucket_range(grid,
+                 ((dx < 0) ? x + dx : x) - radius,
+                 ((dy < 0) ? y + dy : y) - radius,
+                 ((dx < 0) ? x : x + dx) + radius,
+                 ((dy < 0) ? y : y + dy) + radius,
+                 &first_col, &first_row, &last_col, &last_row);
+
+    // New stamp for this query - on wrap around, forget every old stamp
+    if(++ grid->query_stamp == 0)
+    {
+        memset(grid->segment_stamp, 0, sizeof(grid->segment_stamp));
+        grid->query_stamp = 1;
+    }
+
+    for(int32_t row = first_row; row <= last_row; row ++)
+    {
+        for(int32_t col = first_col; col <= last_col; col ++)
+        {
+            uint32_t bucket = (row * grid->columns) + col;
+
+            for(uint32_t entry = grid->bucket_start[bucket]; entry < grid->bucket_start[bucket + 1]; entry ++)
+            {
+                uint16_t segment = grid->entries[entry];
+                CollisionHit_t segment_hit;
+
+                if(grid->segment_stamp[segment] == grid->query_stamp)
+                    continue;
+
+                grid->segment_stamp[segment] = grid->query_stamp;
+
+                if(COLLISION_sweep_circle_segment(x, y, dx, dy, radius, &grid->segments[segment], &segment_hit) &&
+                   (!found || segment_hit.time < hit->time))
+                {
+                    *hit = segment_hit;
+                    found = true;
+                }
+            }
+        }
+    }
+
+    return found;
+}